@@ -7,75 +7,192 @@
  */
 
 #include <stdint.h>
+#include <math.h>
 #include "freertos/FreeRTOS.h"
 #include <freertos/task.h>
+#include <freertos/semphr.h>
+#ifdef CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
 #include "buzzer/buzzer.h"
+#include "buzzer/buzzer_tuning.h"
+#include "buzzer/buzzer_trace.h"
+#include "buzzer_cycles.h"
 
 #define BUZZER_TAG "BUZZER" ///< Tag for usage with the ESP_LOG functions
 
 #define BUZZER_SPEED_MODE LEDC_LOW_SPEED_MODE ///< Speed mode to be used with the buzzer
-#define BUZZER_DUTY_RESOLUTION LEDC_TIMER_15_BIT    ///< Duty resolution to be used with the buzzer's timer. Can't be
-                                                    ///< set too high, because then we won't be able to play high
-                                                    ///< frequencies
-#define BUZZER_DUTY_RES_BITS 15u ///< Bits of resolution set in the buzzer's timer. Same as above, but in number form
+#ifdef CONFIG_PM_ENABLE
+#define BUZZER_CLK_CONFIG LEDC_USE_APB_CLK ///< Clock to use with the buzzer's timer. With dynamic frequency scaling we
+                                           ///< use the APB clock, and keep it at its maximum while sound is on
+                                           ///< with a PM lock. REF_TICK would be stable too, but it's too slow for
+                                           ///< the default duty resolution.
+#else
 #define BUZZER_CLK_CONFIG LEDC_AUTO_CLK ///< Clock to use with the buzzer's timer. We let it be set automatically.
+#endif
 #define BUZZER_MAX_VOL 100u ///< Upper boundary of the volume value
 
 #define BUZZER_1_MIN_MS 60000u ///< Amount of milliseconds in 1 minute
 
+#if BUZZER_THREAD_SAFE
+// Pausing and resuming only write a timer register, so they're done inside a critical section together with the update
+// of the structure. Changing the frequency goes through a longer driver path that may log, which isn't allowed inside
+// a critical section, so it's serialized with a mutex instead.
+#define BUZZER_ENTER_CRITICAL(buzzer) portENTER_CRITICAL(&(buzzer)->lock) ///< Locks the buzzer's playing state
+#define BUZZER_EXIT_CRITICAL(buzzer) portEXIT_CRITICAL(&(buzzer)->lock) ///< Unlocks the buzzer's playing state
+#define BUZZER_FREQ_LOCK(buzzer) xSemaphoreTake((buzzer)->freq_mutex, portMAX_DELAY) ///< Locks the buzzer's frequency
+#define BUZZER_FREQ_UNLOCK(buzzer) xSemaphoreGive((buzzer)->freq_mutex) ///< Unlocks the buzzer's frequency
+#else
+#define BUZZER_ENTER_CRITICAL(buzzer)
+#define BUZZER_EXIT_CRITICAL(buzzer)
+#define BUZZER_FREQ_LOCK(buzzer)
+#define BUZZER_FREQ_UNLOCK(buzzer)
+#endif
+
 /**
  * Array containing the base frequencies for each musical note. Final frequencies can then be calculated from these
  * by dividing depending on the octave.
  */
 const uint16_t note_base_freq[12] = {
-        4186, ///< C
-        4435, ///< C#
-        4699, ///< D
-        4978, ///< D#
-        5274, ///< E
-        5588, ///< F
-        5920, ///< F#
-        6272, ///< G
-        6645, ///< G#
-        7040, ///< A
-        7459, ///< A#
-        7902  ///< B
+        BUZZER_NOTE_BASE_FREQS
 };
 
 /**
  * Struct storing the information required to work with a buzzer
  */
 struct _buzzer_t {
+#if BUZZER_COMPACT
+    // The channel and timer never change after initialization, so the playing flag can share their byte: rewriting
+    // it (under the lock) writes the same channel and timer back
+    uint8_t channel: 4; ///< LEDC channel to use with this buzzer (should be free)
+    uint8_t timer: 2; ///< LEDC timer to use with this buzzer (should be free)
+    bool playing: 1; ///< Indicates whether the buzzer is currently playing. Updated when the buzzer is paused or resumed.
+    uint8_t clk_index: 2; ///< Clock source of the timer, as an index into buzzer_clk_sources
+    uint8_t duty_res_bits: 5; ///< Duty resolution of the timer, in bits
+    uint16_t freq_hz; ///< Indicates the current frequency the buzzer is set to. Updated when the frequency is changed.
+    uint8_t duty; ///< Duty of the output in percent, without modulation
+    uint16_t out_hz; ///< Frequency last written to the timer, modulated or not. 0 if the last write failed or didn't
+                     ///< fit.
+#else
     ledc_channel_t channel; ///< LEDC channel to use with this buzzer (should be free)
     ledc_timer_t timer; ///< LEDC timer to use with this buzzer (should be free)
     bool playing; ///< Indicates whether the buzzer is currently playing. Updated when the buzzer is paused or resumed.
+    uint8_t duty_res_bits; ///< Duty resolution of the timer, in bits
+    uint8_t duty; ///< Duty of the output in percent, without modulation
     int32_t freq_hz; ///< Indicates the current frequency the buzzer is set to. Updated when the frequency is changed.
+    uint32_t out_hz; ///< Frequency last written to the timer, modulated or not. 0 if the last write failed.
+    ledc_clk_cfg_t clk_cfg; ///< Clock source of the timer
+#endif
+#if BUZZER_THREAD_SAFE
+    portMUX_TYPE lock; ///< Protects the playing state and the timer pause/resume that goes with it
+    SemaphoreHandle_t freq_mutex; ///< Serializes frequency changes, so freq_hz always matches the timer
+#endif
+#ifdef CONFIG_PM_ENABLE
+    esp_pm_lock_handle_t pm_lock; ///< Keeps the chip awake while the buzzer plays, and the APB clock at its maximum if
+                                  ///< the timer runs from it
+#endif
+};
+
+#if BUZZER_COMPACT
+_Static_assert(sizeof(buzzer_note_t) == 1 && sizeof(buzzer_note_type_t) == 1, "Compact enumerations must take a byte");
+_Static_assert(sizeof(buzzer_musical_note_t) == 4, "Compact musical notes must take 4 bytes");
+_Static_assert(LEDC_CHANNEL_MAX <= 16 && LEDC_TIMER_MAX <= 4, "LEDC channels or timers don't fit the bitfields");
+_Static_assert(LEDC_TIMER_BIT_MAX <= 32, "Duty resolutions don't fit the bitfield");
+#define BUZZER_GET_CLK(buzzer) (buzzer_clk_sources[(buzzer)->clk_index]) ///< Clock source of a buzzer's timer
+#else
+#define BUZZER_GET_CLK(buzzer) ((buzzer)->clk_cfg) ///< Clock source of a buzzer's timer
+#endif
+_Static_assert(sizeof(buzzer_compiled_note_t) == 3, "Compiled notes must take 3 bytes");
+
+/**
+ * Array containing the clock sources a buzzer's timer can use. Compact buzzers store the index into it.
+ */
+static const ledc_clk_cfg_t buzzer_clk_sources[] = {
+        LEDC_AUTO_CLK,
+        LEDC_USE_APB_CLK,
+        LEDC_USE_REF_TICK,
+        BUZZER_TUNING_RTC8M_CLK
 };
 
+static portMUX_TYPE group_lock = portMUX_INITIALIZER_UNLOCKED; ///< Serializes group operations, so two of them never
+                                                                ///< wait for each other's buzzer locks
 
 // Private function declarations
-double buzzer_get_note_freq(buzzer_note_t note, uint8_t octave);
+static esp_err_t buzzer_check_group(buzzer_t *const *buzzers, uint32_t count);
+static esp_err_t buzzer_play_note_gated(buzzer_t *buzzer, const buzzer_musical_note_t *note, uint32_t bpm,
+                                        uint8_t gate);
+static uint32_t buzzer_get_duty_reg(const buzzer_t *buzzer, uint8_t duty, uint32_t scale);
+static esp_err_t buzzer_set_divider(buzzer_t *buzzer, uint32_t freq_hz);
 
 // Public functions
 
 buzzer_t *buzzer_init(ledc_channel_t channel, ledc_timer_t timer, gpio_num_t gpio_num) {
+    return buzzer_init_ex(channel, timer, gpio_num, NULL);
+}
+
+buzzer_t *buzzer_init_ex(ledc_channel_t channel, ledc_timer_t timer, gpio_num_t gpio_num,
+                         const buzzer_config_t *config) {
+    ledc_clk_cfg_t clk_cfg = config && config->clk_cfg != LEDC_AUTO_CLK ? config->clk_cfg : BUZZER_CLK_CONFIG;
+    uint8_t duty_res_bits = config && config->duty_res_bits ? config->duty_res_bits : BUZZER_DUTY_RES_BITS;
+    if (duty_res_bits >= LEDC_TIMER_BIT_MAX) return NULL;
+    uint32_t clk_index = 0;
+    while (clk_index < sizeof(buzzer_clk_sources) / sizeof(buzzer_clk_sources[0]) &&
+           buzzer_clk_sources[clk_index] != clk_cfg) {
+        clk_index++;
+    }
+    if (clk_index == sizeof(buzzer_clk_sources) / sizeof(buzzer_clk_sources[0])) return NULL;
+
     buzzer_t *buzzer = malloc(sizeof(buzzer_t)); // Allocate space for the structure
+    if (!buzzer) return NULL;
+
+#if BUZZER_THREAD_SAFE
+    buzzer->freq_mutex = xSemaphoreCreateMutex();
+    if (!buzzer->freq_mutex) {
+        free(buzzer);
+        return NULL;
+    }
+    portMUX_INITIALIZE(&buzzer->lock);
+#endif
+
+#ifdef CONFIG_PM_ENABLE
+    // Only the APB clock changes with DFS. Timers running from other clocks just need the chip to stay awake.
+    esp_pm_lock_type_t pm_lock_type = clk_cfg == LEDC_USE_APB_CLK ? ESP_PM_APB_FREQ_MAX : ESP_PM_NO_LIGHT_SLEEP;
+    if (esp_pm_lock_create(pm_lock_type, 0, BUZZER_TAG, &buzzer->pm_lock) != ESP_OK) {
+#if BUZZER_THREAD_SAFE
+        vSemaphoreDelete(buzzer->freq_mutex);
+#endif
+        free(buzzer);
+        return NULL;
+    }
+#endif
 
     // Initialize the fields in the structure
     buzzer->channel = channel;
     buzzer->timer = timer;
     buzzer->playing = false;
     buzzer->freq_hz = BUZZER_INTIIAL_FREQ;
+    buzzer->out_hz = BUZZER_INTIIAL_FREQ;
+    buzzer->duty_res_bits = duty_res_bits;
+    buzzer->duty = BUZZER_DUTY_SQUARE;
+#if BUZZER_COMPACT
+    buzzer->clk_index = clk_index;
+#else
+    buzzer->clk_cfg = clk_cfg;
+#endif
 
     // Timer configuration
     ledc_timer_config_t led_conf = {
             .speed_mode = BUZZER_SPEED_MODE,
             .timer_num = timer,
             .freq_hz = buzzer->freq_hz,
-            .duty_resolution = BUZZER_DUTY_RESOLUTION,
-            .clk_cfg = BUZZER_CLK_CONFIG
+            .duty_resolution = (ledc_timer_bit_t) duty_res_bits,
+            .clk_cfg = clk_cfg
     };
-    ledc_timer_config(&led_conf);
+    if (ledc_timer_config(&led_conf) != ESP_OK) {
+        // The initial frequency can't be output with this clock source and resolution
+        buzzer_destroy(buzzer);
+        return NULL;
+    }
 
     // Channel configuration
     ledc_channel_config_t channel_conf = {
@@ -83,7 +200,7 @@ buzzer_t *buzzer_init(ledc_channel_t channel, ledc_timer_t timer, gpio_num_t gpi
             .intr_type = LEDC_INTR_DISABLE,
             .channel = channel,
             .gpio_num = gpio_num,
-            .duty = (1u << 14u),
+            .duty = buzzer_get_duty_reg(buzzer, buzzer->duty, BUZZER_MODULATION_UNITY),
             .timer_sel = timer,
             .hpoint = 0
     };
@@ -97,42 +214,49 @@ buzzer_t *buzzer_init(ledc_channel_t channel, ledc_timer_t timer, gpio_num_t gpi
 esp_err_t buzzer_play_test(buzzer_t *buzzer, uint16_t bpm) {
     if (!buzzer || bpm == 0) return ESP_FAIL;
 
-    // Definition of the test melody
-    buzzer_melody_t melody;
-    buzzer_musical_note_t melody_notes[] = {
-            {BUZZER_NOTE_C,  4, BUZZER_NTYPE_QUAVER_DOTTED},
-            {BUZZER_NOTE_C,  4, BUZZER_NTYPE_SEMIQUAVER},
-            {BUZZER_NOTE_D,  4, BUZZER_NTYPE_CROTCHET},
-            {BUZZER_NOTE_C,  4, BUZZER_NTYPE_CROTCHET},
-            {BUZZER_NOTE_F,  4, BUZZER_NTYPE_CROTCHET},
-            {BUZZER_NOTE_E,  4, BUZZER_NTYPE_MINIM},
-            {BUZZER_NOTE_C,  4, BUZZER_NTYPE_QUAVER_DOTTED},
-            {BUZZER_NOTE_C,  4, BUZZER_NTYPE_SEMIQUAVER},
-            {BUZZER_NOTE_D,  4, BUZZER_NTYPE_CROTCHET},
-            {BUZZER_NOTE_C,  4, BUZZER_NTYPE_CROTCHET},
-            {BUZZER_NOTE_G,  4, BUZZER_NTYPE_CROTCHET},
-            {BUZZER_NOTE_F,  4, BUZZER_NTYPE_MINIM},
-            {BUZZER_NOTE_C,  4, BUZZER_NTYPE_QUAVER_DOTTED},
-            {BUZZER_NOTE_C,  4, BUZZER_NTYPE_SEMIQUAVER},
-            {BUZZER_NOTE_C,  5, BUZZER_NTYPE_CROTCHET},
-            {BUZZER_NOTE_A,  4, BUZZER_NTYPE_CROTCHET},
-            {BUZZER_NOTE_F,  4, BUZZER_NTYPE_CROTCHET},
-            {BUZZER_NOTE_E,  4, BUZZER_NTYPE_CROTCHET},
-            {BUZZER_NOTE_D,  4, BUZZER_NTYPE_CROTCHET},
-            {BUZZER_NOTE_As, 4, BUZZER_NTYPE_QUAVER_DOTTED},
-            {BUZZER_NOTE_As, 4, BUZZER_NTYPE_SEMIQUAVER},
-            {BUZZER_NOTE_A,  4, BUZZER_NTYPE_CROTCHET},
-            {BUZZER_NOTE_F,  4, BUZZER_NTYPE_CROTCHET},
-            {BUZZER_NOTE_G,  4, BUZZER_NTYPE_CROTCHET},
-            {BUZZER_NOTE_F,  4, BUZZER_NTYPE_MINIM}
+    // Definition of the test melody, which is played straight from flash
+    static const buzzer_musical_note_t melody_notes[] = {
+            {.note = BUZZER_NOTE_C,  .octave = 4, .type = BUZZER_NTYPE_QUAVER_DOTTED},
+            {.note = BUZZER_NOTE_C,  .octave = 4, .type = BUZZER_NTYPE_SEMIQUAVER},
+            {.note = BUZZER_NOTE_D,  .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+            {.note = BUZZER_NOTE_C,  .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+            {.note = BUZZER_NOTE_F,  .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+            {.note = BUZZER_NOTE_E,  .octave = 4, .type = BUZZER_NTYPE_MINIM},
+            {.note = BUZZER_NOTE_C,  .octave = 4, .type = BUZZER_NTYPE_QUAVER_DOTTED},
+            {.note = BUZZER_NOTE_C,  .octave = 4, .type = BUZZER_NTYPE_SEMIQUAVER},
+            {.note = BUZZER_NOTE_D,  .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+            {.note = BUZZER_NOTE_C,  .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+            {.note = BUZZER_NOTE_G,  .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+            {.note = BUZZER_NOTE_F,  .octave = 4, .type = BUZZER_NTYPE_MINIM},
+            {.note = BUZZER_NOTE_C,  .octave = 4, .type = BUZZER_NTYPE_QUAVER_DOTTED},
+            {.note = BUZZER_NOTE_C,  .octave = 4, .type = BUZZER_NTYPE_SEMIQUAVER},
+            {.note = BUZZER_NOTE_C,  .octave = 5, .type = BUZZER_NTYPE_CROTCHET},
+            {.note = BUZZER_NOTE_A,  .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+            {.note = BUZZER_NOTE_F,  .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+            {.note = BUZZER_NOTE_E,  .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+            {.note = BUZZER_NOTE_D,  .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+            {.note = BUZZER_NOTE_As, .octave = 4, .type = BUZZER_NTYPE_QUAVER_DOTTED},
+            {.note = BUZZER_NOTE_As, .octave = 4, .type = BUZZER_NTYPE_SEMIQUAVER},
+            {.note = BUZZER_NOTE_A,  .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+            {.note = BUZZER_NOTE_F,  .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+            {.note = BUZZER_NOTE_G,  .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+            {.note = BUZZER_NOTE_F,  .octave = 4, .type = BUZZER_NTYPE_MINIM}
     };
-    melody.melody = melody_notes;
-    melody.length = sizeof(melody_notes) / sizeof(buzzer_musical_note_t);
+    static const buzzer_melody_t melody = BUZZER_MELODY_INIT(melody_notes,
+                                                             sizeof(melody_notes) / sizeof(buzzer_musical_note_t));
 
     return buzzer_play_melody(buzzer, &melody, bpm);
 }
 
 void buzzer_destroy(buzzer_t *buzzer) {
+    if (!buzzer) return;
+#ifdef CONFIG_PM_ENABLE
+    buzzer_pause(buzzer); // Releases the PM lock if it's being held, so it can be deleted
+    esp_pm_lock_delete(buzzer->pm_lock);
+#endif
+#if BUZZER_THREAD_SAFE
+    vSemaphoreDelete(buzzer->freq_mutex);
+#endif
     free(buzzer);
 }
 
@@ -142,11 +266,96 @@ const char *buzzer_get_tag() {
 
 esp_err_t buzzer_play(buzzer_t *buzzer) {
     if (!buzzer) return ESP_FAIL;
-    if (buzzer->playing == true) return ESP_OK; // If we're already playing, no need to do anything
-    esp_err_t ret = ledc_timer_resume(BUZZER_SPEED_MODE, buzzer->timer); // Resume playing
-    if (ret == ESP_FAIL) return ret;
-    buzzer->playing = true; // Update the structure
-    return ESP_OK;
+    esp_err_t ret = ESP_OK;
+    bool started = false;
+#ifdef CONFIG_PM_ENABLE
+    // The lock is taken before the timer is resumed, so the APB clock is already at its maximum when the sound starts.
+    // PM locks are counted, so if we turn out to be playing already it's just released again below.
+    esp_pm_lock_acquire(buzzer->pm_lock);
+#endif
+    BUZZER_ENTER_CRITICAL(buzzer);
+    if (buzzer->playing == false) { // If we're already playing, no need to do anything
+        ret = ledc_timer_resume(BUZZER_SPEED_MODE, buzzer->timer); // Resume playing
+        if (ret != ESP_FAIL) { // Update the structure
+            buzzer->playing = true;
+            started = true;
+        }
+    }
+    BUZZER_EXIT_CRITICAL(buzzer);
+#ifdef CONFIG_PM_ENABLE
+    if (!started) esp_pm_lock_release(buzzer->pm_lock);
+#endif
+    if (started) BUZZER_TRACE(BUZZER_TRACE_PLAY, buzzer, 0);
+    return ret;
+}
+
+esp_err_t buzzer_play_group(buzzer_t *const *buzzers, uint32_t count, uint32_t *skew_ns) {
+    if (buzzer_check_group(buzzers, count) != ESP_OK) return ESP_FAIL;
+    esp_err_t ret = ESP_OK;
+    bool started[BUZZER_GROUP_MAX] = {false};
+#ifdef CONFIG_PM_ENABLE
+    // Same as in buzzer_play: the clock must be stable before the first sound starts
+    for (uint32_t i = 0; i < count; i++) esp_pm_lock_acquire(buzzers[i]->pm_lock);
+#endif
+    portENTER_CRITICAL(&group_lock);
+    for (uint32_t i = 0; i < count; i++) BUZZER_ENTER_CRITICAL(buzzers[i]);
+
+    // Reset the counters first, so every output starts a new period when it's resumed, and then resume them with
+    // nothing else in between
+    for (uint32_t i = 0; i < count; i++) {
+        if (!buzzers[i]->playing) ledc_timer_rst(BUZZER_SPEED_MODE, buzzers[i]->timer);
+    }
+    uint32_t first_cycles = BUZZER_CYCLES();
+    for (uint32_t i = 0; i < count; i++) {
+        if (buzzers[i]->playing) continue;
+        if (ledc_timer_resume(BUZZER_SPEED_MODE, buzzers[i]->timer) == ESP_FAIL) {
+            ret = ESP_FAIL;
+            continue;
+        }
+        buzzers[i]->playing = true;
+        started[i] = true;
+    }
+    uint32_t last_cycles = BUZZER_CYCLES();
+
+    for (uint32_t i = count; i > 0; i--) BUZZER_EXIT_CRITICAL(buzzers[i - 1]);
+    portEXIT_CRITICAL(&group_lock);
+
+    for (uint32_t i = 0; i < count; i++) {
+#ifdef CONFIG_PM_ENABLE
+        if (!started[i]) esp_pm_lock_release(buzzers[i]->pm_lock);
+#endif
+        if (started[i]) BUZZER_TRACE(BUZZER_TRACE_PLAY, buzzers[i], 0);
+    }
+    if (skew_ns) *skew_ns = (uint32_t) BUZZER_CYCLES_TO_NS(last_cycles - first_cycles);
+    return ret;
+}
+
+esp_err_t buzzer_pause_group(buzzer_t *const *buzzers, uint32_t count) {
+    if (buzzer_check_group(buzzers, count) != ESP_OK) return ESP_FAIL;
+    esp_err_t ret = ESP_OK;
+    bool stopped[BUZZER_GROUP_MAX] = {false};
+
+    portENTER_CRITICAL(&group_lock);
+    for (uint32_t i = 0; i < count; i++) BUZZER_ENTER_CRITICAL(buzzers[i]);
+    for (uint32_t i = 0; i < count; i++) {
+        if (!buzzers[i]->playing) continue;
+        if (ledc_timer_pause(BUZZER_SPEED_MODE, buzzers[i]->timer) == ESP_FAIL) {
+            ret = ESP_FAIL;
+            continue;
+        }
+        buzzers[i]->playing = false;
+        stopped[i] = true;
+    }
+    for (uint32_t i = count; i > 0; i--) BUZZER_EXIT_CRITICAL(buzzers[i - 1]);
+    portEXIT_CRITICAL(&group_lock);
+
+    for (uint32_t i = 0; i < count; i++) {
+#ifdef CONFIG_PM_ENABLE
+        if (stopped[i]) esp_pm_lock_release(buzzers[i]->pm_lock);
+#endif
+        if (stopped[i]) BUZZER_TRACE(BUZZER_TRACE_PAUSE, buzzers[i], 0);
+    }
+    return ret;
 }
 
 bool buzzer_is_playing(buzzer_t *buzzer) {
@@ -156,11 +365,22 @@ bool buzzer_is_playing(buzzer_t *buzzer) {
 
 esp_err_t buzzer_pause(buzzer_t *buzzer) {
     if (!buzzer) return ESP_FAIL;
-    if (buzzer->playing == false) return ESP_OK; // If the buzzer is already paused, no need to do anything
-    esp_err_t ret = ledc_timer_pause(BUZZER_SPEED_MODE, buzzer->timer); // Pause the buzzer
-    if (ret == ESP_FAIL) return ret;
-    buzzer->playing = false; // Update the structure
-    return ESP_OK;
+    esp_err_t ret = ESP_OK;
+    bool stopped = false;
+    BUZZER_ENTER_CRITICAL(buzzer);
+    if (buzzer->playing == true) { // If the buzzer is already paused, no need to do anything
+        ret = ledc_timer_pause(BUZZER_SPEED_MODE, buzzer->timer); // Pause the buzzer
+        if (ret != ESP_FAIL) { // Update the structure
+            buzzer->playing = false;
+            stopped = true;
+        }
+    }
+    BUZZER_EXIT_CRITICAL(buzzer);
+#ifdef CONFIG_PM_ENABLE
+    if (stopped) esp_pm_lock_release(buzzer->pm_lock); // Silence doesn't need a stable clock, let the chip sleep
+#endif
+    if (stopped) BUZZER_TRACE(BUZZER_TRACE_PAUSE, buzzer, 0);
+    return ret;
 }
 
 esp_err_t buzzer_play_ms(buzzer_t *buzzer, uint32_t time_ms) {
@@ -199,17 +419,61 @@ esp_err_t buzzer_rest_ms(buzzer_t *buzzer, uint32_t time_ms) {
 }
 
 esp_err_t buzzer_set_freq(buzzer_t *buzzer, uint32_t freq_hz) {
-    if (!buzzer || freq_hz == 0) return ESP_FAIL;
+    if (!buzzer || freq_hz == 0 || freq_hz > BUZZER_FREQ_MAX) return ESP_FAIL;
 
     // When playing the same frequency two consecutive times, this commented statement causes no distinct sounds to be
     // played. When it's commented, the change of frequency causes a small interruption (even if the frequency is the
     // same)
     //if (freq_hz == buzzer->freq_hz) return ESP_OK;
 
+    BUZZER_FREQ_LOCK(buzzer);
     esp_err_t ret = ledc_set_freq(BUZZER_SPEED_MODE, buzzer->timer, freq_hz);
-    if (ret == ESP_FAIL) return ret;
-    buzzer->freq_hz = freq_hz; // Update the structure
-    return ESP_OK;
+    if (ret != ESP_FAIL) buzzer->freq_hz = freq_hz; // Update the structure
+    buzzer->out_hz = ret != ESP_FAIL ? freq_hz : 0;
+    BUZZER_FREQ_UNLOCK(buzzer);
+    if (ret != ESP_FAIL) BUZZER_TRACE(BUZZER_TRACE_FREQ, buzzer, freq_hz);
+    return ret;
+}
+
+esp_err_t buzzer_set_duty(buzzer_t *buzzer, uint8_t duty) {
+    if (!buzzer || duty == 0 || duty > BUZZER_DUTY_MAX) return ESP_FAIL;
+
+    // The duty register is also written when modulating, which happens under the frequency lock
+    BUZZER_FREQ_LOCK(buzzer);
+    esp_err_t ret = ledc_set_duty(BUZZER_SPEED_MODE, buzzer->channel,
+                                  buzzer_get_duty_reg(buzzer, duty, BUZZER_MODULATION_UNITY));
+    if (ret != ESP_FAIL) ret = ledc_update_duty(BUZZER_SPEED_MODE, buzzer->channel);
+    if (ret != ESP_FAIL) buzzer->duty = duty; // Update the structure
+    BUZZER_FREQ_UNLOCK(buzzer);
+    return ret;
+}
+
+uint8_t buzzer_get_duty(buzzer_t *buzzer) {
+    if (!buzzer) return 0;
+    return buzzer->duty;
+}
+
+esp_err_t buzzer_modulate(buzzer_t *buzzer, uint32_t freq_scale, uint32_t duty_scale) {
+    if (!buzzer || freq_scale == 0 || duty_scale > BUZZER_MODULATION_UNITY) return ESP_FAIL;
+
+    // Scale the frequency the buzzer is set to under its lock, so a note starting at the same time is never modulated
+    // from the previous one. The base frequency is left untouched.
+    BUZZER_FREQ_LOCK(buzzer);
+    uint64_t freq_hz = ((uint64_t) buzzer->freq_hz * freq_scale + BUZZER_MODULATION_UNITY / 2) /
+                       BUZZER_MODULATION_UNITY;
+    if (freq_hz == 0) freq_hz = 1;
+    // Oscillators call this hundreds of times per second, often with the same frequency (like tremolo on its own),
+    // so the timer is only touched when the frequency changes
+    esp_err_t ret = ESP_OK;
+    if (freq_hz != buzzer->out_hz) {
+        ret = buzzer_set_divider(buzzer, (uint32_t) freq_hz);
+        buzzer->out_hz = ret != ESP_FAIL && freq_hz <= BUZZER_FREQ_MAX ? freq_hz : 0;
+    }
+    uint32_t duty = buzzer_get_duty_reg(buzzer, buzzer->duty, duty_scale);
+    if (ret != ESP_FAIL) ret = ledc_set_duty(BUZZER_SPEED_MODE, buzzer->channel, duty);
+    if (ret != ESP_FAIL) ret = ledc_update_duty(BUZZER_SPEED_MODE, buzzer->channel);
+    BUZZER_FREQ_UNLOCK(buzzer);
+    return ret;
 }
 
 uint32_t buzzer_get_freq(buzzer_t *buzzer) {
@@ -217,30 +481,35 @@ uint32_t buzzer_get_freq(buzzer_t *buzzer) {
     return buzzer->freq_hz;
 }
 
+double buzzer_get_actual_freq(buzzer_t *buzzer) {
+    if (!buzzer) return 0;
+    return buzzer_tuning_actual_freq(BUZZER_GET_CLK(buzzer), buzzer->duty_res_bits, buzzer->freq_hz);
+}
+
 esp_err_t buzzer_set_note(buzzer_t *buzzer, buzzer_note_t note, uint8_t octave) {
+    return buzzer_set_transposed_note(buzzer, note, octave, NULL);
+}
+
+esp_err_t buzzer_set_transposed_note(buzzer_t *buzzer, buzzer_note_t note, uint8_t octave,
+                                     const buzzer_transpose_t *transpose) {
     if (!buzzer) return ESP_FAIL;
-    return buzzer_set_freq(buzzer, buzzer_get_note_freq(note, octave));
+    return buzzer_set_freq(buzzer, buzzer_get_note_request(buzzer, note, octave, transpose));
 }
 
-esp_err_t buzzer_play_note(buzzer_t *buzzer, buzzer_musical_note_t *note, uint32_t bpm) {
-    if (!buzzer || !note || bpm == 0) return ESP_FAIL;
-    esp_err_t ret;
+uint32_t buzzer_get_note_request(buzzer_t *buzzer, buzzer_note_t note, uint8_t octave,
+                                 const buzzer_transpose_t *transpose) {
+    if (!buzzer) return 0;
+    double target_hz = buzzer_get_transposed_freq(transpose, note, octave);
 
-    // When the note is not a rest, we just play the note. When it's a rest, we don't need to change the frequency, as
-    // the rest doesn't have an associated frequency.
-    if (note->note != BUZZER_NOTE_REST) {
-        ret = buzzer_set_note(buzzer, note->note, note->octave);
-        if (ret == ESP_FAIL) return ret;
-    }
-    uint32_t time_ms = buzzer_note_type_to_ms(note->type, bpm);
+    // Truncating the note frequency to whole Hertzs can be off by tens of cents in the lowest octaves, so request the
+    // frequency whose quantized output is the closest to the note instead. If the note can't be reached at all, let
+    // the driver report the error.
+    uint32_t freq_hz = buzzer_tuning_best_request(BUZZER_GET_CLK(buzzer), buzzer->duty_res_bits, target_hz);
+    return freq_hz ? freq_hz : (uint32_t) target_hz;
+}
 
-    // When the note is a rest, rest during the set time. When it's a normal note, play it for the set time.
-    if (note->note == BUZZER_NOTE_REST) {
-        ret = buzzer_rest_ms(buzzer, time_ms);
-    } else {
-        ret = buzzer_play_ms(buzzer, time_ms);
-    }
-    return ret;
+esp_err_t buzzer_play_note(buzzer_t *buzzer, const buzzer_musical_note_t *note, uint32_t bpm) {
+    return buzzer_play_note_gated(buzzer, note, bpm, note ? note->gate : 0);
 }
 
 
@@ -253,17 +522,55 @@ esp_err_t buzzer_play_note_ms(buzzer_t *buzzer, buzzer_note_t note, uint8_t octa
     return ret;
 }
 
-esp_err_t buzzer_play_melody(buzzer_t *buzzer, buzzer_melody_t *melody, uint32_t bpm) {
-    if (!buzzer || !melody || bpm == 0) return ESP_FAIL;
-
-    // Sequentially play all the notes in the melody
-    for (uint i = 0; i < melody->length; i++) {
-        esp_err_t ret = buzzer_play_note(buzzer, &melody->melody[i], bpm);
-        if (ret == ESP_FAIL) return ret;
+esp_err_t buzzer_play_melody(buzzer_t *buzzer, const buzzer_melody_t *melody, uint32_t bpm) {
+    if (!buzzer || buzzer_check_melody(melody) != ESP_OK || bpm == 0) return ESP_FAIL;
+
+    uint8_t duty = buzzer->duty; // Set back at the end, so later melodies without a duty don't inherit this one
+    if (melody->duty && buzzer_set_duty(buzzer, melody->duty) == ESP_FAIL) return ESP_FAIL;
+
+    // Sequentially play all the notes in the melody, jumping back to the start of the loop while repeats are left
+    esp_err_t ret = ESP_OK;
+    uint32_t repeats = melody->loop_start < melody->loop_end ? melody->loop_count : 0;
+    for (uint i = 0; i < melody->length && ret != ESP_FAIL;) {
+        const buzzer_musical_note_t *note = &melody->melody[i];
+        ret = buzzer_play_note_gated(buzzer, note, bpm, note->gate ? note->gate : melody->gate);
+        if (++i == melody->loop_end && repeats > 0) {
+            i = melody->loop_start;
+            if (repeats != BUZZER_LOOP_FOREVER) repeats--;
+        }
     }
+    if (melody->duty) buzzer_set_duty(buzzer, duty);
+    return ret;
+}
+
+esp_err_t buzzer_check_melody(const buzzer_melody_t *melody) {
+    if (!melody || (!melody->melody && melody->length)) return ESP_FAIL;
+    if (melody->loop_end > melody->length || melody->loop_start > melody->loop_end) return ESP_FAIL;
     return ESP_OK;
 }
 
+esp_err_t buzzer_play_compiled_melody(buzzer_t *buzzer, const buzzer_compiled_melody_t *melody, uint32_t bpm) {
+    if (!buzzer || !melody || bpm == 0) return ESP_FAIL;
+    uint8_t duty = buzzer->duty; // Set back at the end, like buzzer_play_melody does
+    if (melody->duty && buzzer_set_duty(buzzer, melody->duty) == ESP_FAIL) return ESP_FAIL;
+
+    esp_err_t ret = ESP_OK;
+    for (uint32_t i = 0; i < melody->length && ret != ESP_FAIL; i++) {
+        const buzzer_compiled_note_t *note = &melody->notes[i];
+        uint32_t time_ms = buzzer_note_type_to_ms((buzzer_note_type_t) note->type, bpm);
+
+        // Rests don't have a frequency, so there's nothing to set for them
+        if (note->freq_hz == 0) {
+            ret = buzzer_rest_ms(buzzer, time_ms);
+        } else {
+            ret = buzzer_set_freq(buzzer, note->freq_hz);
+            if (ret != ESP_FAIL) ret = buzzer_play_ms(buzzer, time_ms);
+        }
+    }
+    if (melody->duty) buzzer_set_duty(buzzer, duty);
+    return ret;
+}
+
 //esp_err_t buzzer_set_volume(buzzer_t *buzzer, uint8_t volume) {
 //    if (!buzzer) return ESP_FAIL;
 //    if (volume > BUZZER_MAX_VOL) volume = BUZZER_MAX_VOL;
@@ -280,6 +587,11 @@ uint32_t buzzer_note_type_to_ms(buzzer_note_type_t type, uint32_t bpm) {
     return (ms_per_beat * type) / BUZZER_BASE_PULSE_DIVISIONS;
 }
 
+uint32_t buzzer_gate_to_ms(uint32_t duration_ms, uint8_t gate) {
+    if (gate == 0 || gate >= BUZZER_GATE_LEGATO) return duration_ms;
+    return (uint32_t) (((uint64_t) duration_ms * gate) / BUZZER_GATE_LEGATO);
+}
+
 double buzzer_get_note_freq(buzzer_note_t note, uint8_t octave) {
     if (octave > 8) octave = 8;
     double divider = (double) (1u << (8u - octave)); // Divide the base frequency by 2^(8-octave)
@@ -288,4 +600,107 @@ double buzzer_get_note_freq(buzzer_note_t note, uint8_t octave) {
     // out of bounds errors when indexing the array.
     if (note == BUZZER_NOTE_REST || note == BUZZER_NOTE_MAX) return 0;
     return (double) note_base_freq[note] / divider;
-}
\ No newline at end of file
+}
+
+esp_err_t buzzer_transpose_init(buzzer_transpose_t *transpose, int32_t cents) {
+    if (!transpose || cents > BUZZER_TRANSPOSE_MAX_CENTS || cents < -BUZZER_TRANSPOSE_MAX_CENTS) return ESP_FAIL;
+
+    // Round the semitones down, so the cents left over are always positive and the ratio is never below 1
+    int32_t semitones = cents >= 0 ? cents / 100 : -((-cents + 99) / 100);
+    transpose->semitones = (int16_t) semitones;
+    transpose->ratio = exp2f((float) (cents - semitones * 100) / 1200.0f);
+    return ESP_OK;
+}
+
+double buzzer_get_transposed_freq(const buzzer_transpose_t *transpose, buzzer_note_t note, uint8_t octave) {
+    if (note == BUZZER_NOTE_REST || note == BUZZER_NOTE_MAX) return 0;
+    if (!transpose) return buzzer_get_note_freq(note, octave);
+
+    // Move through the table in whole semitones, carrying into the octave
+    int32_t pitch = (int32_t) octave * BUZZER_NOTE_MAX + (int32_t) note + transpose->semitones;
+    int32_t moved_octave = pitch >= 0 ? pitch / BUZZER_NOTE_MAX : -((-pitch + BUZZER_NOTE_MAX - 1) / BUZZER_NOTE_MAX);
+    int32_t moved_note = pitch - moved_octave * BUZZER_NOTE_MAX;
+    if (moved_octave < 0) moved_octave = 0;
+    if (moved_octave > 8) moved_octave = 8; // Octaves past 255 would wrap around when narrowed
+    return buzzer_get_note_freq((buzzer_note_t) moved_note, (uint8_t) moved_octave) * transpose->ratio;
+}
+
+// Private functions
+
+/**
+ * Checks the arguments of the group functions.
+ * @param buzzers Buzzers of the group
+ * @param count Amount of buzzers
+ * @return ESP_OK if the group can be used, ESP_FAIL otherwise
+ */
+static esp_err_t buzzer_check_group(buzzer_t *const *buzzers, uint32_t count) {
+    if (!buzzers || count == 0 || count > BUZZER_GROUP_MAX) return ESP_FAIL;
+    for (uint32_t i = 0; i < count; i++) {
+        if (!buzzers[i]) return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/**
+ * Plays the provided musical note at the given speed, sounding only for the gated part of its duration.
+ * @param buzzer Buzzer to play the note on
+ * @param note Musical note to play
+ * @param bpm Speed to play the note at (in beats per minute)
+ * @param gate Part of the duration that sounds, in percent (0 for the whole duration)
+ * @return ESP_OK if the operation was executed successfully, ESP_FAIL if something went wrong
+ */
+static esp_err_t buzzer_play_note_gated(buzzer_t *buzzer, const buzzer_musical_note_t *note, uint32_t bpm,
+                                        uint8_t gate) {
+    if (!buzzer || !note || bpm == 0) return ESP_FAIL;
+    esp_err_t ret;
+
+    // When the note is not a rest, we just play the note. When it's a rest, we don't need to change the frequency, as
+    // the rest doesn't have an associated frequency.
+    if (note->note != BUZZER_NOTE_REST) {
+        ret = buzzer_set_note(buzzer, note->note, note->octave);
+        if (ret == ESP_FAIL) return ret;
+    }
+    uint32_t time_ms = buzzer_note_type_to_ms(note->type, bpm);
+
+    // When the note is a rest, rest during the set time. When it's a normal note, play it for the gated part of the
+    // set time, and rest for the remaining part.
+    if (note->note == BUZZER_NOTE_REST) return buzzer_rest_ms(buzzer, time_ms);
+
+    uint32_t sound_ms = buzzer_gate_to_ms(time_ms, gate);
+    ret = buzzer_play_ms(buzzer, sound_ms);
+    if (ret == ESP_FAIL || sound_ms == time_ms) return ret;
+    return buzzer_rest_ms(buzzer, time_ms - sound_ms);
+}
+
+/**
+ * Returns the value of the duty register which outputs the given duty with the buzzer's duty resolution.
+ * @param buzzer Buzzer whose duty resolution is used
+ * @param duty Duty in percent
+ * @param scale Factor the duty is multiplied by, in Q16 fixed point (BUZZER_MODULATION_UNITY for none)
+ * @return Value of the duty register
+ */
+static uint32_t buzzer_get_duty_reg(const buzzer_t *buzzer, uint8_t duty, uint32_t scale) {
+    uint64_t full_scale = (uint64_t) 1u << buzzer->duty_res_bits;
+    return (uint32_t) ((full_scale * duty * scale) / (100u * (uint64_t) BUZZER_MODULATION_UNITY));
+}
+
+/**
+ * Writes a modulated frequency to the buzzer's timer by setting its divider directly, which unlike ledc_set_freq
+ * doesn't reset the timer, so the period being output isn't cut short and the modulation doesn't click. Timers running
+ * from the RTC8M clock, which is calibrated at boot and may differ from its nominal frequency, and frequencies out of
+ * the divider's range go through ledc_set_freq instead.
+ * @param buzzer Buzzer whose timer is written, with its frequency lock held
+ * @param freq_hz Frequency to output
+ * @return ESP_OK if the operation was executed successfully, ESP_FAIL if something went wrong
+ */
+static esp_err_t buzzer_set_divider(buzzer_t *buzzer, uint32_t freq_hz) {
+    ledc_clk_cfg_t clk_cfg = BUZZER_GET_CLK(buzzer);
+    uint32_t divider = buzzer_tuning_divider(buzzer_tuning_clk_hz(clk_cfg), buzzer->duty_res_bits, freq_hz);
+    if (clk_cfg == BUZZER_TUNING_RTC8M_CLK || divider == 0) {
+        return ledc_set_freq(BUZZER_SPEED_MODE, buzzer->timer, freq_hz);
+    }
+
+    // The automatic clock picks APB for the resolutions buzzers use, like buzzer_tuning_clk_hz assumes
+    ledc_clk_src_t clk_src = clk_cfg == LEDC_USE_REF_TICK ? LEDC_REF_TICK : LEDC_APB_CLK;
+    return ledc_timer_set(BUZZER_SPEED_MODE, buzzer->timer, divider, buzzer->duty_res_bits, clk_src);
+}
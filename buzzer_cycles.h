@@ -0,0 +1,33 @@
+/**
+ * @file buzzer_cycles.h
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief Private header giving access to the CPU cycle counter, used to timestamp trace events and to measure the skew
+ * of group starts.
+ */
+
+#ifndef GYRO_READER_BUZZER_CYCLES_H
+#define GYRO_READER_BUZZER_CYCLES_H
+
+#include <stdint.h>
+#include <esp_idf_version.h>
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#include <esp_cpu.h>
+#define BUZZER_CYCLES() esp_cpu_get_cycle_count() ///< Reads the cycle counter of the current core
+#else
+#include <hal/cpu_hal.h>
+#define BUZZER_CYCLES() cpu_hal_get_cycle_count() ///< Reads the cycle counter of the current core
+#endif
+
+#if defined(CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ)
+#define BUZZER_CPU_MHZ CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ ///< CPU frequency used to convert cycles into time
+#elif defined(CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ)
+#define BUZZER_CPU_MHZ CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ ///< CPU frequency used to convert cycles into time
+#else
+#define BUZZER_CPU_MHZ 240 ///< CPU frequency used to convert cycles into time
+#endif
+
+#define BUZZER_CYCLES_TO_NS(cycles) (((uint64_t) (cycles) * 1000u) / BUZZER_CPU_MHZ) ///< Converts cycles into ns
+
+#endif //GYRO_READER_BUZZER_CYCLES_H
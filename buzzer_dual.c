@@ -0,0 +1,281 @@
+/**
+ * @file buzzer_dual.c
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the definitions for dual-tone output. Like the callback engine, each output is a small state
+ * machine advanced by its one-shot esp_timer, which ends the current tones and starts the next digit.
+ *
+ * The state is only modified from the timer callback, which runs in the esp_timer task, so it needs no locks. The
+ * control functions leave their request in an atomic word and fire the timer right away, so the callback applies it.
+ * What to play is stored along with the request under a spinlock, so the callback always copies a whole request.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <esp_log.h>
+#include "buzzer/buzzer_dual.h"
+#include "buzzer_timer_task.h"
+
+#define BUZZER_DUAL_TIMER_NAME "buzzer_dual" ///< Name of the dual-tone timers
+#define BUZZER_DUAL_COUNT 2 ///< Buzzers in a dual-tone output
+
+#define BUZZER_DUAL_REQ_PLAY (1u << 0u) ///< New tones or digits must be started
+#define BUZZER_DUAL_REQ_STOP (1u << 1u) ///< The tones or digits must be stopped
+#define BUZZER_DUAL_REQ_RELEASE (1u << 2u) ///< The output is being destroyed, so the callback must let it go
+#define BUZZER_DUAL_RELEASED (1u << 3u) ///< Set by the callback once it won't touch the output again
+
+#define BUZZER_DTMF_KEYS "123A456B789C*0#D" ///< DTMF keypad, row by row
+#define BUZZER_DTMF_COLUMNS 4 ///< Columns of the DTMF keypad
+
+static const uint16_t buzzer_dtmf_rows_hz[] = {697, 770, 852, 941}; ///< Frequencies of the keypad rows
+static const uint16_t buzzer_dtmf_columns_hz[] = {1209, 1336, 1477, 1633}; ///< Frequencies of the keypad columns
+
+/**
+ * Play request, copied by the callback in one piece
+ */
+typedef struct {
+    const char *digits; ///< Digits to start, or NULL to play hz
+    uint32_t hz[BUZZER_DUAL_COUNT]; ///< Tones to start
+    uint32_t tone_ms; ///< Duration of the tones, or of each digit
+    uint16_t gap_ms; ///< Silence between digits
+    buzzer_dual_done_cb_t done; ///< Callback to invoke when they end
+    void *arg; ///< User argument for done
+} buzzer_dual_play_t;
+
+/**
+ * Struct storing the state of a dual-tone output
+ */
+struct _buzzer_dual_t {
+    buzzer_t *buzzers[BUZZER_DUAL_COUNT]; ///< Buzzers playing the lower and the higher tone
+    esp_timer_handle_t timer; ///< One-shot timer firing at the end of every tone and gap
+    atomic_uint requests; ///< Pending requests, as BUZZER_DUAL_REQ_* flags
+    portMUX_TYPE request_lock; ///< Lock of request, taken along with the play request flag
+    buzzer_dual_play_t request; ///< What to start with the next play request
+
+    const char *digits; ///< Digits being played, or NULL
+    uint32_t hz[BUZZER_DUAL_COUNT]; ///< Tones being played, if there are no digits
+    uint32_t tone_ms; ///< Duration of the tones, or of each digit
+    uint16_t gap_ms; ///< Silence between digits
+    bool active; ///< Whether tones or digits are being played
+    bool tone_on; ///< Whether the next firing ends a tone instead of a gap
+    int64_t deadline_us; ///< End of the current tone or gap, accumulated so timing errors don't add up
+    int64_t fire_us; ///< Time the callback last armed the timer for, so early firings can be told apart
+    buzzer_dual_done_cb_t done; ///< Callback invoked when the tones or digits being played end
+    void *arg; ///< User argument for done
+};
+
+// Private function declarations
+static void buzzer_dual_timer_cb(void *arg);
+static void buzzer_dual_request(buzzer_dual_t *dual, uint32_t request, const buzzer_dual_play_t *play);
+static void buzzer_dual_finish(buzzer_dual_t *dual);
+static void buzzer_dual_arm(buzzer_dual_t *dual, int64_t at_us);
+
+// Public functions
+
+buzzer_dual_t *buzzer_dual_create(buzzer_t *low, buzzer_t *high) {
+    if (!low || !high || low == high) return NULL;
+
+    buzzer_dual_t *dual = calloc(1, sizeof(buzzer_dual_t));
+    if (!dual) return NULL;
+
+    dual->buzzers[0] = low;
+    dual->buzzers[1] = high;
+    atomic_init(&dual->requests, 0);
+    portMUX_INITIALIZE(&dual->request_lock);
+    esp_timer_create_args_t timer_args = {
+            .callback = buzzer_dual_timer_cb,
+            .arg = dual,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = BUZZER_DUAL_TIMER_NAME
+    };
+    if (esp_timer_create(&timer_args, &dual->timer) != ESP_OK) {
+        free(dual);
+        return NULL;
+    }
+    return dual;
+}
+
+void buzzer_dual_destroy(buzzer_dual_t *dual) {
+    if (!dual) return;
+    if (buzzer_in_timer_task()) {
+        // The callback can't run while this task waits for it, so waiting would never end
+        ESP_LOGE(buzzer_get_tag(), "buzzer_dual_destroy can't be called from an esp_timer callback");
+        return;
+    }
+
+    // The callback may be running right now, so let it stop the output and wait until it confirms it's done with it
+    buzzer_dual_request(dual, BUZZER_DUAL_REQ_RELEASE, NULL);
+    while (!(atomic_load(&dual->requests) & BUZZER_DUAL_RELEASED)) vTaskDelay(1);
+
+    esp_timer_delete(dual->timer);
+    free(dual);
+}
+
+esp_err_t buzzer_dual_play_ms(buzzer_dual_t *dual, uint32_t low_hz, uint32_t high_hz, uint32_t time_ms,
+                              buzzer_dual_done_cb_t done, void *arg) {
+    if (!dual || low_hz == 0 || high_hz == 0 || time_ms == 0) return ESP_FAIL;
+
+    buzzer_dual_play_t play = {.hz = {low_hz, high_hz}, .tone_ms = time_ms, .done = done, .arg = arg};
+    buzzer_dual_request(dual, BUZZER_DUAL_REQ_PLAY, &play);
+    return ESP_OK;
+}
+
+esp_err_t buzzer_dual_play_dtmf(buzzer_dual_t *dual, const char *digits, uint16_t tone_ms, uint16_t gap_ms,
+                                buzzer_dual_done_cb_t done, void *arg) {
+    if (!dual || !digits || tone_ms == 0) return ESP_FAIL;
+    for (const char *digit = digits; *digit; digit++) {
+        if (buzzer_dtmf_get_freqs(*digit, NULL, NULL) != ESP_OK) return ESP_FAIL;
+    }
+
+    buzzer_dual_play_t play = {.digits = digits, .tone_ms = tone_ms, .gap_ms = gap_ms, .done = done, .arg = arg};
+    buzzer_dual_request(dual, BUZZER_DUAL_REQ_PLAY, &play);
+    return ESP_OK;
+}
+
+esp_err_t buzzer_dual_stop(buzzer_dual_t *dual) {
+    if (!dual) return ESP_FAIL;
+    buzzer_dual_request(dual, BUZZER_DUAL_REQ_STOP, NULL);
+    return ESP_OK;
+}
+
+bool buzzer_dual_is_playing(buzzer_dual_t *dual) {
+    if (!dual) return false;
+    uint32_t requests = atomic_load(&dual->requests);
+    if (requests & BUZZER_DUAL_REQ_PLAY) return true;
+    return !(requests & BUZZER_DUAL_REQ_STOP) && dual->active;
+}
+
+esp_err_t buzzer_dtmf_get_freqs(char digit, uint16_t *low_hz, uint16_t *high_hz) {
+    if (digit >= 'a' && digit <= 'd') digit = (char) (digit - 'a' + 'A');
+    const char *key = digit ? strchr(BUZZER_DTMF_KEYS, digit) : NULL;
+    if (!key) return ESP_FAIL;
+
+    uint32_t index = key - BUZZER_DTMF_KEYS;
+    if (low_hz) *low_hz = buzzer_dtmf_rows_hz[index / BUZZER_DTMF_COLUMNS];
+    if (high_hz) *high_hz = buzzer_dtmf_columns_hz[index % BUZZER_DTMF_COLUMNS];
+    return ESP_OK;
+}
+
+// Private functions
+
+/**
+ * Callback of the output's timer. Applies the pending requests, and then either ends the current tones (followed by
+ * the gap before the next digit, if any) or starts the next ones, in phase.
+ * @param arg Dual-tone output the timer belongs to
+ */
+static void buzzer_dual_timer_cb(void *arg) {
+    buzzer_dual_t *dual = arg;
+
+    // The play request is taken along with its flag, so it's never a mix of two requests
+    buzzer_dual_play_t play = {0};
+    portENTER_CRITICAL(&dual->request_lock);
+    uint32_t requests = atomic_fetch_and(&dual->requests, ~(BUZZER_DUAL_REQ_PLAY | BUZZER_DUAL_REQ_STOP));
+    if (requests & BUZZER_DUAL_REQ_PLAY) play = dual->request;
+    portEXIT_CRITICAL(&dual->request_lock);
+
+    if (requests & (BUZZER_DUAL_REQ_STOP | BUZZER_DUAL_REQ_RELEASE)) {
+        dual->active = false;
+        buzzer_pause_group(dual->buzzers, BUZZER_DUAL_COUNT);
+    }
+    if (requests & BUZZER_DUAL_REQ_RELEASE) {
+        atomic_fetch_or(&dual->requests, BUZZER_DUAL_RELEASED); // The output may be freed from now on
+        return;
+    }
+    if (!(requests & BUZZER_DUAL_REQ_PLAY) && dual->active && esp_timer_get_time() < dual->fire_us) {
+        // Fired by a control function whose request an earlier firing already applied (see buzzer_dual_request):
+        // there's nothing to do until the time the timer was armed for
+        buzzer_dual_arm(dual, dual->fire_us);
+        return;
+    }
+    if (requests & BUZZER_DUAL_REQ_PLAY) {
+        dual->digits = play.digits;
+        dual->hz[0] = play.hz[0];
+        dual->hz[1] = play.hz[1];
+        dual->tone_ms = play.tone_ms;
+        dual->gap_ms = play.gap_ms;
+        dual->done = play.done;
+        dual->arg = play.arg;
+        dual->active = true;
+        dual->tone_on = false;
+        dual->deadline_us = esp_timer_get_time();
+        // Tones replacing the ones being played are started in phase too
+        buzzer_pause_group(dual->buzzers, BUZZER_DUAL_COUNT);
+    }
+    if (!dual->active) return;
+
+    if (dual->tone_on) {
+        dual->tone_on = false;
+        buzzer_pause_group(dual->buzzers, BUZZER_DUAL_COUNT);
+        if (!dual->digits || *dual->digits == '\0') {
+            buzzer_dual_finish(dual);
+            return;
+        }
+        dual->deadline_us += (int64_t) dual->gap_ms * 1000;
+        buzzer_dual_arm(dual, dual->deadline_us);
+        return;
+    }
+
+    uint32_t low_hz = dual->hz[0], high_hz = dual->hz[1];
+    if (dual->digits) {
+        if (*dual->digits == '\0') {
+            buzzer_dual_finish(dual);
+            return;
+        }
+        uint16_t row_hz, column_hz;
+        buzzer_dtmf_get_freqs(*dual->digits++, &row_hz, &column_hz); // Checked when the digits were requested
+        low_hz = row_hz;
+        high_hz = column_hz;
+    }
+    buzzer_set_freq(dual->buzzers[0], low_hz);
+    buzzer_set_freq(dual->buzzers[1], high_hz);
+    buzzer_play_group(dual->buzzers, BUZZER_DUAL_COUNT, NULL);
+    dual->tone_on = true;
+    dual->deadline_us += (int64_t) dual->tone_ms * 1000;
+    buzzer_dual_arm(dual, dual->deadline_us);
+}
+
+/**
+ * Leaves a request for the callback and fires the timer right away, so the request is applied from the esp_timer task.
+ * Play requests are stored under the request lock along with their flag, replacing any play request still pending.
+ *
+ * @details As in the callback engine, a firing which applies the request before the timer is stopped makes the one
+ * started here come early, with no request left, so the callback only arms the timer again.
+ * @param dual Dual-tone output the request is for
+ * @param request Request, as a BUZZER_DUAL_REQ_* flag
+ * @param play What to start for BUZZER_DUAL_REQ_PLAY, or NULL for other requests
+ */
+static void buzzer_dual_request(buzzer_dual_t *dual, uint32_t request, const buzzer_dual_play_t *play) {
+    if (play) {
+        portENTER_CRITICAL(&dual->request_lock);
+        dual->request = *play;
+        atomic_fetch_or(&dual->requests, request);
+        portEXIT_CRITICAL(&dual->request_lock);
+    } else {
+        atomic_fetch_or(&dual->requests, request);
+    }
+    buzzer_timer_fire_now(dual->timer);
+}
+
+/**
+ * Finishes the tones or digits being played and lets the user know. The buzzers are already paused.
+ * @param dual Dual-tone output which finished
+ */
+static void buzzer_dual_finish(buzzer_dual_t *dual) {
+    dual->active = false;
+    if (dual->done) dual->done(dual, dual->arg);
+}
+
+/**
+ * Arms the timer to fire at the provided time, or right away if it has already passed.
+ * @param dual Dual-tone output whose timer must be armed
+ * @param at_us Time to fire at, in the esp_timer time base (microseconds)
+ */
+static void buzzer_dual_arm(buzzer_dual_t *dual, int64_t at_us) {
+    dual->fire_us = at_us;
+    int64_t wait_us = at_us - esp_timer_get_time();
+    esp_timer_start_once(dual->timer, wait_us > 0 ? (uint64_t) wait_us : 0);
+}
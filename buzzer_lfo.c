@@ -0,0 +1,253 @@
+/**
+ * @file buzzer_lfo.c
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the definitions for the low-frequency oscillator. Like the callback engine, each oscillator
+ * is advanced by its one-shot esp_timer, which is armed again at every update with accumulated deadlines.
+ *
+ * The phase is a 32 bit accumulator, where a whole period wraps it around, and its top 8 bits index a quarter-wave
+ * sine table in Q15. The depths are turned into Q16 scales when the oscillator is configured, so updates don't need
+ * any floating point.
+ *
+ * The configuration of a start request is stored along with its flag under a spinlock, so the callback always copies
+ * a whole configuration.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <esp_log.h>
+#include "buzzer/buzzer_lfo.h"
+#include "buzzer_timer_task.h"
+
+#define BUZZER_LFO_TIMER_NAME "buzzer_lfo" ///< Name of the oscillator timers
+
+#define BUZZER_LFO_REQ_START (1u << 0u) ///< The oscillator must be (re)configured and started
+#define BUZZER_LFO_REQ_STOP (1u << 1u) ///< The oscillator must be stopped
+#define BUZZER_LFO_REQ_RELEASE (1u << 2u) ///< The oscillator is being destroyed, so the callback must let it go
+#define BUZZER_LFO_RELEASED (1u << 3u) ///< Set by the callback once it won't touch the oscillator again
+
+#define BUZZER_LFO_QUARTER_STEPS 64u ///< Steps in a quarter of a period of the sine table
+#define BUZZER_LFO_PHASE_SHIFT 24u ///< Shift leaving the top 8 bits of the phase, which index the sine table
+#define BUZZER_LFO_SINE_ONE 32768 ///< Value of 1 in the Q15 sine table (which peaks at 32767)
+
+/**
+ * First quarter of a period of a sine, in Q15. The rest of the period is mirrored from it.
+ */
+static const int16_t buzzer_lfo_sine[BUZZER_LFO_QUARTER_STEPS + 1] = {
+        0, 804, 1608, 2410, 3212, 4011, 4808, 5602,
+        6393, 7179, 7962, 8739, 9512, 10278, 11039, 11793,
+        12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+        18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+        23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+        27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+        30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+        32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+        32767
+};
+
+/**
+ * Struct storing the state of an oscillator
+ */
+struct _buzzer_lfo_t {
+    buzzer_t *buzzer; ///< Buzzer being modulated
+    esp_timer_handle_t timer; ///< One-shot timer firing at every update
+    atomic_uint requests; ///< Pending requests, as BUZZER_LFO_REQ_* flags
+    portMUX_TYPE request_lock; ///< Lock of request_config, taken along with the start request flag
+    buzzer_lfo_config_t request_config; ///< Modulation to apply with the next start request
+
+    bool active; ///< Whether the oscillator is modulating the buzzer
+    uint32_t phase; ///< Phase of the oscillator, where 2^32 is a whole period
+    uint32_t phase_step; ///< Phase advanced on every update
+    uint32_t period_us; ///< Time between updates
+    uint32_t vibrato_up; ///< Frequency scale at the top of the vibrato minus 1, in Q16
+    uint32_t vibrato_down; ///< 1 minus the frequency scale at the bottom of the vibrato, in Q16
+    uint32_t tremolo_depth; ///< Largest duty reduction, in Q16
+    int64_t deadline_us; ///< Time of the next update, accumulated so the rate doesn't drift
+};
+
+// Private function declarations
+static void buzzer_lfo_timer_cb(void *arg);
+static void buzzer_lfo_request(buzzer_lfo_t *lfo, uint32_t request, const buzzer_lfo_config_t *config);
+static void buzzer_lfo_configure(buzzer_lfo_t *lfo, const buzzer_lfo_config_t *config);
+static void buzzer_lfo_update(buzzer_lfo_t *lfo);
+static int32_t buzzer_lfo_get_sine(uint32_t phase);
+
+// Public functions
+
+buzzer_lfo_t *buzzer_lfo_create(buzzer_t *buzzer) {
+    if (!buzzer) return NULL;
+
+    buzzer_lfo_t *lfo = calloc(1, sizeof(buzzer_lfo_t));
+    if (!lfo) return NULL;
+
+    lfo->buzzer = buzzer;
+    atomic_init(&lfo->requests, 0);
+    portMUX_INITIALIZE(&lfo->request_lock);
+    esp_timer_create_args_t timer_args = {
+            .callback = buzzer_lfo_timer_cb,
+            .arg = lfo,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = BUZZER_LFO_TIMER_NAME
+    };
+    if (esp_timer_create(&timer_args, &lfo->timer) != ESP_OK) {
+        free(lfo);
+        return NULL;
+    }
+    return lfo;
+}
+
+void buzzer_lfo_destroy(buzzer_lfo_t *lfo) {
+    if (!lfo) return;
+    if (buzzer_in_timer_task()) {
+        // The callback can't run while this task waits for it, so waiting would never end
+        ESP_LOGE(buzzer_get_tag(), "buzzer_lfo_destroy can't be called from an esp_timer callback");
+        return;
+    }
+
+    // The callback may be running right now, so let it restore the buzzer and wait until it's done with the oscillator
+    buzzer_lfo_request(lfo, BUZZER_LFO_REQ_RELEASE, NULL);
+    while (!(atomic_load(&lfo->requests) & BUZZER_LFO_RELEASED)) vTaskDelay(1);
+
+    esp_timer_delete(lfo->timer);
+    free(lfo);
+}
+
+esp_err_t buzzer_lfo_start(buzzer_lfo_t *lfo, const buzzer_lfo_config_t *config) {
+    if (!lfo || !config) return ESP_FAIL;
+    uint32_t update_hz = config->update_hz ? config->update_hz : BUZZER_LFO_DEFAULT_UPDATE_HZ;
+    if (update_hz > BUZZER_LFO_MAX_UPDATE_HZ || config->rate_centihz == 0 ||
+        config->rate_centihz * 2u >= update_hz * 100u || config->vibrato_cents > BUZZER_LFO_MAX_VIBRATO_CENTS ||
+        config->tremolo_percent > 100) {
+        return ESP_FAIL;
+    }
+
+    buzzer_lfo_config_t request = *config;
+    request.update_hz = (uint16_t) update_hz;
+    buzzer_lfo_request(lfo, BUZZER_LFO_REQ_START, &request);
+    return ESP_OK;
+}
+
+esp_err_t buzzer_lfo_stop(buzzer_lfo_t *lfo) {
+    if (!lfo) return ESP_FAIL;
+    buzzer_lfo_request(lfo, BUZZER_LFO_REQ_STOP, NULL);
+    return ESP_OK;
+}
+
+// Private functions
+
+/**
+ * Callback of the oscillator's timer. Applies the pending requests, and then updates the modulation if its time has
+ * come (requests fire the timer early).
+ * @param arg Oscillator the timer belongs to
+ */
+static void buzzer_lfo_timer_cb(void *arg) {
+    buzzer_lfo_t *lfo = arg;
+
+    // The configuration is taken along with its flag, so it's never a mix of two start requests
+    buzzer_lfo_config_t config = {0};
+    portENTER_CRITICAL(&lfo->request_lock);
+    uint32_t requests = atomic_fetch_and(&lfo->requests, ~(BUZZER_LFO_REQ_START | BUZZER_LFO_REQ_STOP));
+    if (requests & BUZZER_LFO_REQ_START) config = lfo->request_config;
+    portEXIT_CRITICAL(&lfo->request_lock);
+
+    if (requests & (BUZZER_LFO_REQ_STOP | BUZZER_LFO_REQ_RELEASE)) {
+        if (lfo->active) buzzer_modulate(lfo->buzzer, BUZZER_MODULATION_UNITY, BUZZER_MODULATION_UNITY);
+        lfo->active = false;
+    }
+    if (requests & BUZZER_LFO_REQ_RELEASE) {
+        atomic_fetch_or(&lfo->requests, BUZZER_LFO_RELEASED); // The oscillator may be freed from now on
+        return;
+    }
+    if (requests & BUZZER_LFO_REQ_START) {
+        buzzer_lfo_configure(lfo, &config);
+        if (!lfo->active) lfo->deadline_us = esp_timer_get_time();
+        lfo->active = true;
+    }
+    if (!lfo->active) return;
+
+    int64_t now_us = esp_timer_get_time();
+    if (now_us >= lfo->deadline_us) {
+        buzzer_lfo_update(lfo);
+        lfo->deadline_us += lfo->period_us;
+        // After a long stall of the esp_timer task, skip the missed updates instead of rushing through them
+        if (lfo->deadline_us < now_us) lfo->deadline_us = now_us + lfo->period_us;
+    }
+    esp_timer_start_once(lfo->timer, (uint64_t) (lfo->deadline_us - now_us));
+}
+
+/**
+ * Leaves a request for the callback and fires the timer right away, so the request is applied from the esp_timer task.
+ * Start requests are stored under the request lock along with their flag, replacing any start request still pending.
+ *
+ * @details A firing which applies the request before the timer is stopped makes the one started here come before the
+ * next update, so the callback only arms the timer again.
+ * @param lfo Oscillator the request is for
+ * @param request Request, as a BUZZER_LFO_REQ_* flag
+ * @param config Modulation for BUZZER_LFO_REQ_START, or NULL for other requests
+ */
+static void buzzer_lfo_request(buzzer_lfo_t *lfo, uint32_t request, const buzzer_lfo_config_t *config) {
+    if (config) {
+        portENTER_CRITICAL(&lfo->request_lock);
+        lfo->request_config = *config;
+        atomic_fetch_or(&lfo->requests, request);
+        portEXIT_CRITICAL(&lfo->request_lock);
+    } else {
+        atomic_fetch_or(&lfo->requests, request);
+    }
+    buzzer_timer_fire_now(lfo->timer);
+}
+
+/**
+ * Turns the configuration into the fixed-point values used by the updates. The phase is kept.
+ * @param lfo Oscillator to configure
+ * @param config Modulation to apply, already checked
+ */
+static void buzzer_lfo_configure(buzzer_lfo_t *lfo, const buzzer_lfo_config_t *config) {
+    lfo->period_us = 1000000u / config->update_hz;
+    lfo->phase_step = (uint32_t) (((uint64_t) config->rate_centihz << 32u) / (100u * config->update_hz));
+
+    // The vibrato is symmetric in cents, so the frequency goes further up than down
+    float ratio = exp2f((float) config->vibrato_cents / 1200.0f);
+    lfo->vibrato_up = (uint32_t) lroundf((ratio - 1.0f) * (float) BUZZER_MODULATION_UNITY);
+    lfo->vibrato_down = (uint32_t) lroundf((1.0f - 1.0f / ratio) * (float) BUZZER_MODULATION_UNITY);
+    lfo->tremolo_depth = (uint32_t) config->tremolo_percent * BUZZER_MODULATION_UNITY / 100u;
+}
+
+/**
+ * Advances the oscillator by one update and modulates the buzzer with its new value.
+ * @param lfo Oscillator to update
+ */
+static void buzzer_lfo_update(buzzer_lfo_t *lfo) {
+    lfo->phase += lfo->phase_step;
+    int32_t sine = buzzer_lfo_get_sine(lfo->phase);
+
+    // Between the peaks, the vibrato is interpolated linearly in frequency, which is close enough to cents for the
+    // depths used in practice
+    int64_t freq_scale = BUZZER_MODULATION_UNITY;
+    freq_scale += ((int64_t) (sine >= 0 ? lfo->vibrato_up : lfo->vibrato_down) * sine) / BUZZER_LFO_SINE_ONE;
+
+    // The tremolo only lowers the duty, as the square wave is already the loudest: from none at the bottom of the sine
+    // to the whole depth at its top
+    uint64_t reduction = ((uint64_t) lfo->tremolo_depth * (uint32_t) (BUZZER_LFO_SINE_ONE + sine)) /
+                         (2u * BUZZER_LFO_SINE_ONE);
+    buzzer_modulate(lfo->buzzer, (uint32_t) freq_scale, BUZZER_MODULATION_UNITY - (uint32_t) reduction);
+}
+
+/**
+ * Looks up the sine of a phase in the quarter-wave table.
+ * @param phase Phase, where 2^32 is a whole period
+ * @return Sine of the phase, in Q15
+ */
+static int32_t buzzer_lfo_get_sine(uint32_t phase) {
+    uint32_t step = phase >> BUZZER_LFO_PHASE_SHIFT;
+    uint32_t quadrant = step / BUZZER_LFO_QUARTER_STEPS;
+    uint32_t index = step % BUZZER_LFO_QUARTER_STEPS;
+    if (quadrant & 1u) index = BUZZER_LFO_QUARTER_STEPS - index; // The second half of each lobe is mirrored
+    int32_t sine = buzzer_lfo_sine[index];
+    return quadrant & 2u ? -sine : sine;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file buzzer_morse.c
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the definitions for the Morse code encoder.
+ */
+
+#include "buzzer/buzzer_morse.h"
+
+#define BUZZER_MORSE_FIRST_CHAR ' ' ///< First character in the code table
+#define BUZZER_MORSE_LAST_CHAR '_' ///< Last character in the code table
+#define BUZZER_MORSE_DIT_US_WPM 1200000u ///< Length of a dit in microseconds at one word per minute
+#define BUZZER_MORSE_WORD_US_WPM 60000000ull ///< Length of a word in microseconds at one word per minute
+#define BUZZER_MORSE_ELEMENTS_US_WPM 37200000ull ///< Time taken by the elements of PARIS at one word per minute
+#define BUZZER_MORSE_EXTRA_UNITS 19u ///< Units of space in PARIS that Farnsworth spacing stretches (3:7 ratio)
+
+/**
+ * Codes of the characters from BUZZER_MORSE_FIRST_CHAR to BUZZER_MORSE_LAST_CHAR, 0 meaning the character has no code.
+ * Lower case letters are folded into this range.
+ */
+static const uint8_t buzzer_morse_codes[BUZZER_MORSE_LAST_CHAR - BUZZER_MORSE_FIRST_CHAR + 1] = {
+        0x00, 0x75, 0x52, 0x00, 0xC8, 0x00, 0x22, 0x5E, //  !"#$%&'
+        0x2D, 0x6D, 0x00, 0x2A, 0x73, 0x61, 0x6A, 0x29, // ()*+,-./
+        0x3F, 0x3E, 0x3C, 0x38, 0x30, 0x20, 0x21, 0x23, // 01234567
+        0x27, 0x2F, 0x47, 0x55, 0x00, 0x31, 0x00, 0x4C, // 89:;<=>?
+        0x56, 0x06, 0x11, 0x15, 0x09, 0x02, 0x14, 0x0B, // @ABCDEFG
+        0x10, 0x04, 0x1E, 0x0D, 0x12, 0x07, 0x05, 0x0F, // HIJKLMNO
+        0x16, 0x1B, 0x0A, 0x08, 0x03, 0x0C, 0x18, 0x0E, // PQRSTUVW
+        0x19, 0x1D, 0x13, 0x00, 0x00, 0x00, 0x00, 0x6C  // XYZ[\]^_
+};
+
+// Public functions
+
+uint8_t buzzer_morse_encode(char c) {
+    if (c >= 'a' && c <= 'z') c = (char) (c - 'a' + 'A');
+    if (c < BUZZER_MORSE_FIRST_CHAR || c > BUZZER_MORSE_LAST_CHAR) return 0;
+    return buzzer_morse_codes[c - BUZZER_MORSE_FIRST_CHAR];
+}
+
+uint32_t buzzer_morse_duration_us(const buzzer_morse_t *morse, buzzer_morse_timing_t timing) {
+    if (!morse || morse->wpm == 0) return 0;
+
+    uint32_t dit_us = BUZZER_MORSE_DIT_US_WPM / morse->wpm;
+    switch (timing) {
+        case BUZZER_MORSE_DIT:
+        case BUZZER_MORSE_ELEMENT_GAP:
+            return dit_us;
+        case BUZZER_MORSE_DAH:
+            return 3 * dit_us;
+        default:
+            break;
+    }
+
+    uint32_t units = timing == BUZZER_MORSE_CHAR_GAP ? 3 : 7;
+    uint32_t c = morse->wpm, s = morse->farnsworth_wpm;
+    if (s == 0 || s >= c) return units * dit_us;
+
+    // Time left in a word once its elements are sent at the character speed, spread over the 19 units of spaces
+    uint64_t extra_us = (BUZZER_MORSE_WORD_US_WPM * c - BUZZER_MORSE_ELEMENTS_US_WPM * s) / (s * c);
+    return (uint32_t) (units * extra_us / BUZZER_MORSE_EXTRA_UNITS);
+}
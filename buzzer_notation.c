@@ -0,0 +1,225 @@
+/**
+ * @file buzzer_notation.c
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the definitions for the text notation parser. Each byte advances a small state machine,
+ * which only keeps the note being read.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "buzzer/buzzer_notation.h"
+
+#define BUZZER_NOTATION_MAX_OCTAVE 8 ///< Highest octave buzzer_get_note_freq supports
+
+/**
+ * Enumeration containing the states of the parser
+ */
+typedef enum _buzzer_notation_state_t {
+    BUZZER_NOTATION_IDLE, ///< Between notes
+    BUZZER_NOTATION_PITCH, ///< The pitch letter was read
+    BUZZER_NOTATION_ACCIDENTAL, ///< The accidental was read
+    BUZZER_NOTATION_NAME, ///< The octave was read, or the note is a rest, so only the duration may follow
+    BUZZER_NOTATION_SPACE, ///< Spaces were read after the pitch, so only the duration may follow
+    BUZZER_NOTATION_DURATION, ///< The duration letter was read, so only the dot may follow
+    BUZZER_NOTATION_SKIP, ///< An invalid note is being skipped up to the next separator
+} buzzer_notation_state_t;
+
+/**
+ * Struct storing the state of a parser
+ */
+struct _buzzer_notation_t {
+    buzzer_player_t *player; ///< Player the notes are queued in
+    uint32_t bpm; ///< Speed to play the notes at (in beats per minute)
+    buzzer_notation_state_t state; ///< State of the parser
+    bool rest; ///< Whether the note being read is a rest
+    int8_t semitone; ///< Semitone of the note being read within its octave, which accidentals may take out of range
+    uint8_t octave; ///< Octave of the note being read, kept for the following notes
+    buzzer_note_type_t type; ///< Duration of the note being read, kept for the following notes
+};
+
+static const int8_t buzzer_notation_semitones[] = {9, 11, 0, 2, 4, 5, 7}; ///< Semitones of the pitches from A to G
+
+// Private function declarations
+static esp_err_t buzzer_notation_put(buzzer_notation_t *parser, char c);
+static esp_err_t buzzer_notation_emit(buzzer_notation_t *parser);
+static buzzer_note_type_t buzzer_notation_get_type(char c);
+
+// Public functions
+
+buzzer_notation_t *buzzer_notation_create(buzzer_player_t *player, uint32_t bpm) {
+    if (!player || bpm == 0) return NULL;
+
+    buzzer_notation_t *parser = calloc(1, sizeof(buzzer_notation_t));
+    if (!parser) return NULL;
+
+    parser->player = player;
+    parser->bpm = bpm;
+    parser->state = BUZZER_NOTATION_IDLE;
+    parser->octave = BUZZER_NOTATION_DEFAULT_OCTAVE;
+    parser->type = BUZZER_NTYPE_CROTCHET;
+    return parser;
+}
+
+void buzzer_notation_destroy(buzzer_notation_t *parser) {
+    free(parser);
+}
+
+esp_err_t buzzer_notation_feed(buzzer_notation_t *parser, const char *data, size_t length) {
+    if (!parser || (!data && length)) return ESP_FAIL;
+
+    esp_err_t ret = ESP_OK;
+    for (size_t i = 0; i < length; i++) {
+        if (buzzer_notation_put(parser, data[i]) != ESP_OK) ret = ESP_FAIL;
+    }
+    return ret;
+}
+
+esp_err_t buzzer_notation_feed_stream(buzzer_notation_t *parser, FILE *stream) {
+    if (!parser || !stream) return ESP_FAIL;
+
+    esp_err_t ret = ESP_OK;
+    int c;
+    while ((c = fgetc(stream)) != EOF) {
+        if (buzzer_notation_put(parser, (char) c) != ESP_OK) ret = ESP_FAIL;
+    }
+    if (ferror(stream)) ret = ESP_FAIL;
+    if (buzzer_notation_flush(parser) != ESP_OK) ret = ESP_FAIL;
+    return ret;
+}
+
+esp_err_t buzzer_notation_flush(buzzer_notation_t *parser) {
+    if (!parser) return ESP_FAIL;
+
+    switch (parser->state) {
+        case BUZZER_NOTATION_IDLE:
+            return ESP_OK;
+        case BUZZER_NOTATION_SKIP:
+            parser->state = BUZZER_NOTATION_IDLE;
+            return ESP_OK;
+        default:
+            return buzzer_notation_emit(parser);
+    }
+}
+
+// Private functions
+
+/**
+ * Advances the parser with a single character, queueing the pending note if the character completes it.
+ * @param parser Parser to advance
+ * @param c Character to parse
+ * @return ESP_OK if the character was valid and the completed note (if any) was queued, ESP_FAIL otherwise
+ */
+static esp_err_t buzzer_notation_put(buzzer_notation_t *parser, char c) {
+    bool separator = c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',' || c == '|';
+    bool pitch = (c >= 'A' && c <= 'G') || c == 'R';
+    esp_err_t ret = ESP_OK;
+
+    switch (parser->state) {
+        case BUZZER_NOTATION_DURATION:
+            if (c == '.') {
+                // Every dotted duration is one and a half times the plain one, so the enumeration has them all
+                parser->type = (buzzer_note_type_t) (parser->type * 3 / 2);
+                return buzzer_notation_emit(parser);
+            }
+            ret = buzzer_notation_emit(parser); // Anything else starts whatever follows the note
+            break;
+        case BUZZER_NOTATION_PITCH:
+            if (c == '#' || c == 'b') {
+                parser->semitone += c == '#' ? 1 : -1;
+                parser->state = BUZZER_NOTATION_ACCIDENTAL;
+                return ESP_OK;
+            }
+            // fall through
+        case BUZZER_NOTATION_ACCIDENTAL:
+            if (c >= '0' && c <= '0' + BUZZER_NOTATION_MAX_OCTAVE) {
+                parser->octave = c - '0';
+                parser->state = BUZZER_NOTATION_NAME;
+                return ESP_OK;
+            }
+            // fall through
+        case BUZZER_NOTATION_NAME:
+        case BUZZER_NOTATION_SPACE:
+            if (buzzer_notation_get_type(c)) {
+                parser->type = buzzer_notation_get_type(c);
+                parser->state = BUZZER_NOTATION_DURATION;
+                return ESP_OK;
+            }
+            if (c == ' ' || c == '\t') {
+                parser->state = BUZZER_NOTATION_SPACE; // The duration may still follow
+                return ESP_OK;
+            }
+            if (!separator && !pitch) {
+                parser->state = BUZZER_NOTATION_SKIP;
+                return ESP_FAIL;
+            }
+            ret = buzzer_notation_emit(parser); // Without a duration, the previous one is kept
+            break;
+        default:
+            break;
+    }
+
+    // Between notes, or skipping an invalid one
+    if (separator) {
+        parser->state = BUZZER_NOTATION_IDLE;
+        return ret;
+    }
+    if (parser->state == BUZZER_NOTATION_SKIP) return ret;
+    if (!pitch) {
+        parser->state = BUZZER_NOTATION_SKIP;
+        return ESP_FAIL;
+    }
+
+    parser->rest = c == 'R';
+    parser->semitone = parser->rest ? 0 : buzzer_notation_semitones[c - 'A'];
+    parser->state = parser->rest ? BUZZER_NOTATION_NAME : BUZZER_NOTATION_PITCH;
+    return ret;
+}
+
+/**
+ * Queues the note being read into the player, moving it to the neighbouring octave if its accidental crosses one.
+ * @param parser Parser whose note is complete
+ * @return ESP_OK if the note was queued, ESP_FAIL if it's out of range or the player's ring buffer was full
+ */
+static esp_err_t buzzer_notation_emit(buzzer_notation_t *parser) {
+    parser->state = BUZZER_NOTATION_IDLE;
+
+    buzzer_musical_note_t note = {.note = BUZZER_NOTE_REST, .octave = parser->octave, .type = parser->type};
+    if (!parser->rest) {
+        int32_t octave = parser->octave;
+        int32_t semitone = parser->semitone;
+        if (semitone < 0) {
+            semitone += BUZZER_NOTE_MAX;
+            octave--;
+        } else if (semitone >= BUZZER_NOTE_MAX) {
+            semitone -= BUZZER_NOTE_MAX;
+            octave++;
+        }
+        if (octave < 0 || octave > BUZZER_NOTATION_MAX_OCTAVE) return ESP_FAIL;
+        note.note = (buzzer_note_t) semitone;
+        note.octave = (uint8_t) octave;
+    }
+    return buzzer_player_push_note(parser->player, &note, parser->bpm);
+}
+
+/**
+ * Returns the duration written with the provided letter.
+ * @param c Character to check
+ * @return The duration, or 0 if the character isn't a duration letter
+ */
+static buzzer_note_type_t buzzer_notation_get_type(char c) {
+    switch (c) {
+        case 'w':
+            return BUZZER_NTYPE_SEMIBREVE;
+        case 'h':
+            return BUZZER_NTYPE_MINIM;
+        case 'q':
+            return BUZZER_NTYPE_CROTCHET;
+        case 'e':
+            return BUZZER_NTYPE_QUAVER;
+        case 's':
+            return BUZZER_NTYPE_SEMIQUAVER;
+        default:
+            return 0;
+    }
+}
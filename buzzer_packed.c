@@ -0,0 +1,131 @@
+/**
+ * @file buzzer_packed.c
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the definitions for the packed melody decoder. See buzzer_packed.h for the format.
+ */
+
+#include <stdint.h>
+#include "buzzer/buzzer_packed.h"
+
+#define BUZZER_PACKED_OP_NOTE_MAX 0x3Fu ///< Last delta note operation
+#define BUZZER_PACKED_DELTA_BIAS 32 ///< Value subtracted from delta note operations to get the signed delta
+#define BUZZER_PACKED_OP_TYPE 0x40u ///< First set type operation
+#define BUZZER_PACKED_OP_REST 0x50u ///< First rest operation
+#define BUZZER_PACKED_OP_ABS 0x60u ///< Absolute pitch operation
+#define BUZZER_PACKED_OP_REF 0x80u ///< Flag of the back-reference operations
+#define BUZZER_PACKED_NOTES_PER_OCTAVE 12u ///< Semitones in an octave
+#define BUZZER_PACKED_MAX_PITCH (9u * BUZZER_PACKED_NOTES_PER_OCTAVE) ///< First pitch out of the playable range
+
+/**
+ * Array with the note types, indexed by the type index used in packed melodies
+ */
+static const buzzer_note_type_t packed_note_types[] = {
+        BUZZER_NTYPE_SEMIBREVE_DOTTED,
+        BUZZER_NTYPE_SEMIBREVE,
+        BUZZER_NTYPE_MINIM_DOTTED,
+        BUZZER_NTYPE_MINIM,
+        BUZZER_NTYPE_CROTCHET_DOTTED,
+        BUZZER_NTYPE_CROTCHET,
+        BUZZER_NTYPE_QUAVER_DOTTED,
+        BUZZER_NTYPE_QUAVER,
+        BUZZER_NTYPE_SEMIQUAVER_DOTTED,
+        BUZZER_NTYPE_SEMIQUAVER
+};
+
+#define BUZZER_PACKED_TYPES (sizeof(packed_note_types) / sizeof(packed_note_types[0])) ///< Amount of type indexes
+#define BUZZER_PACKED_INITIAL_TYPE 5u ///< Type index the decoder starts at (crotchet)
+
+// Private function declarations
+static bool buzzer_unpacker_fail(buzzer_unpacker_t *unpacker);
+
+// Public functions
+
+void buzzer_unpacker_init(buzzer_unpacker_t *unpacker, const buzzer_packed_melody_t *melody) {
+    if (!unpacker) return;
+    unpacker->data = melody ? melody->data : NULL;
+    unpacker->size = (melody && melody->data) ? melody->size : 0;
+    unpacker->pos = 0;
+    unpacker->ref_pos = 0;
+    unpacker->ref_left = 0;
+    unpacker->pitch = BUZZER_PACKED_INITIAL_PITCH;
+    unpacker->type_idx = BUZZER_PACKED_INITIAL_TYPE;
+    unpacker->malformed = false;
+}
+
+bool buzzer_unpacker_next(buzzer_unpacker_t *unpacker, buzzer_musical_note_t *note) {
+    if (!unpacker || !note || unpacker->malformed) return false;
+
+    for (;;) {
+        // Operations are taken from the back-reference being replayed, if any, or from the main stream otherwise. Only
+        // the main stream can end: a back-reference running past the end is as malformed as any other operation.
+        bool replaying = unpacker->ref_left > 0;
+        uint32_t *pos = replaying ? &unpacker->ref_pos : &unpacker->pos;
+        if (*pos >= unpacker->size) return replaying ? buzzer_unpacker_fail(unpacker) : false;
+        if (replaying) unpacker->ref_left--;
+
+        uint32_t op_pos = (*pos)++;
+        uint8_t op = unpacker->data[op_pos];
+        int32_t pitch = unpacker->pitch;
+
+        if (op & BUZZER_PACKED_OP_REF) {
+            if (replaying || *pos + 2 > unpacker->size) return buzzer_unpacker_fail(unpacker); // Nested or truncated
+            uint32_t distance = unpacker->data[*pos] | ((uint32_t) unpacker->data[*pos + 1] << 8u);
+            *pos += 2;
+            if (distance == 0 || distance > op_pos) return buzzer_unpacker_fail(unpacker);
+            unpacker->ref_pos = op_pos - distance;
+            unpacker->ref_left = (op & ~BUZZER_PACKED_OP_REF) + 1;
+            continue;
+        } else if (op <= BUZZER_PACKED_OP_NOTE_MAX) {
+            pitch += (int32_t) op - BUZZER_PACKED_DELTA_BIAS;
+        } else if (op == BUZZER_PACKED_OP_ABS) {
+            if (*pos >= unpacker->size) return buzzer_unpacker_fail(unpacker);
+            pitch = unpacker->data[(*pos)++];
+        } else if (op >= BUZZER_PACKED_OP_TYPE && op < BUZZER_PACKED_OP_TYPE + BUZZER_PACKED_TYPES) {
+            unpacker->type_idx = op - BUZZER_PACKED_OP_TYPE;
+            continue; // Setting the type doesn't produce a note
+        } else if (op >= BUZZER_PACKED_OP_REST && op < BUZZER_PACKED_OP_REST + BUZZER_PACKED_TYPES) {
+            note->note = BUZZER_NOTE_REST;
+            note->octave = 0;
+            note->type = packed_note_types[op - BUZZER_PACKED_OP_REST];
+            note->gate = 0;
+            return true;
+        } else {
+            return buzzer_unpacker_fail(unpacker); // Reserved operation
+        }
+
+        if (pitch < 0 || pitch >= (int32_t) BUZZER_PACKED_MAX_PITCH) return buzzer_unpacker_fail(unpacker);
+        unpacker->pitch = pitch;
+        note->note = (buzzer_note_t) (pitch % BUZZER_PACKED_NOTES_PER_OCTAVE);
+        note->octave = pitch / BUZZER_PACKED_NOTES_PER_OCTAVE;
+        note->type = packed_note_types[unpacker->type_idx];
+        note->gate = 0; // The packed format doesn't store articulation
+        return true;
+    }
+}
+
+esp_err_t buzzer_play_packed_melody(buzzer_t *buzzer, const buzzer_packed_melody_t *melody, uint32_t bpm) {
+    if (!buzzer || !melody || bpm == 0) return ESP_FAIL;
+
+    // Only the decoder state and the current note are kept in RAM, no matter how long the melody is
+    buzzer_unpacker_t unpacker;
+    buzzer_musical_note_t note;
+    buzzer_unpacker_init(&unpacker, melody);
+    while (buzzer_unpacker_next(&unpacker, &note)) {
+        esp_err_t ret = buzzer_play_note(buzzer, &note, bpm);
+        if (ret == ESP_FAIL) return ret;
+    }
+    return unpacker.malformed ? ESP_FAIL : ESP_OK;
+}
+
+// Private functions
+
+/**
+ * Marks a decoder as stopped at malformed data, so it doesn't unpack anything else.
+ * @param unpacker Decoder which found malformed data
+ * @return Always false, to be returned by buzzer_unpacker_next
+ */
+static bool buzzer_unpacker_fail(buzzer_unpacker_t *unpacker) {
+    unpacker->malformed = true;
+    return false;
+}
@@ -0,0 +1,894 @@
+/**
+ * @file buzzer_player.c
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the definitions for the asynchronous buzzer player. Events are passed from the producer to
+ * the player task through a lock-free single-producer/single-consumer ring buffer, and note boundaries are timed with
+ * an esp_timer so they aren't limited to the FreeRTOS tick resolution.
+ *
+ * To play nicely with power management, the task only wakes up at event boundaries (consecutive rests are merged into
+ * a single wait), and the buzzer is paused whenever there's silence so its PM lock is released and the chip can enter
+ * light sleep until the next sound.
+ *
+ * Control requests for loaded melodies (play, pause, resume, seek and stop) are stored under a spinlock and flagged in
+ * an atomic word, which the task checks whenever it wakes up. The task publishes the melody position back under the
+ * same spinlock. The transposition and the tempo are single atomic words instead, so pushing notes never waits for a
+ * control function.
+ */
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_timer.h>
+#include <esp_log.h>
+#include "buzzer/buzzer_player.h"
+#include "buzzer/buzzer_trace.h"
+
+#define BUZZER_PLAYER_TASK_NAME "buzzer_player" ///< Name of the player task
+#define BUZZER_PLAYER_GATE_TIMER_NAME "buzzer_gate" ///< Name of the timer which silences notes at their gate
+#define BUZZER_PLAYER_MIN_QUEUE_LEN 2u ///< Smallest ring buffer that can be created
+
+#define BUZZER_PLAYER_CTRL_LOAD (1u << 0u) ///< A melody must be loaded
+#define BUZZER_PLAYER_CTRL_STOP (1u << 1u) ///< The melody must be unloaded
+#define BUZZER_PLAYER_CTRL_SEEK (1u << 2u) ///< The melody must be moved to ctrl_seek_ms
+#define BUZZER_PLAYER_CTRL_PAUSE (1u << 3u) ///< The melody must be paused or resumed, according to ctrl_paused
+
+/**
+ * Struct storing the information required by a player
+ */
+struct _buzzer_player_t {
+    buzzer_t *buzzer; ///< Buzzer the events are played on
+    TaskHandle_t task; ///< Player task, which is the only consumer of the ring buffer
+    SemaphoreHandle_t done; ///< Given by the player task right before it deletes itself
+    esp_timer_handle_t timer; ///< One-shot timer used to wake up the player task at the end of each event
+    esp_timer_handle_t gate_timer; ///< One-shot timer which silences the buzzer at the gate of articulated events
+
+    buzzer_event_t *ring; ///< Storage for the ring buffer
+    uint32_t mask; ///< Capacity of the ring buffer minus one (the capacity is a power of two)
+    atomic_uint head; ///< Index where the next event will be pushed. Only written by the producer.
+    atomic_uint tail; ///< Index of the next event to be played. Only written by the player task.
+    atomic_bool waiting; ///< Set by the player task while it sleeps waiting for events
+    atomic_bool running; ///< Cleared to make the player task finish
+
+    uint32_t low_watermark; ///< Level at which on_low_watermark is called
+    buzzer_player_watermark_cb_t on_low_watermark; ///< Callback to request more events from the producer
+    void *arg; ///< User argument for on_low_watermark
+
+    buzzer_player_stats_t stats; ///< Counters. Each one is only written by either the producer or the player task.
+    bool sounding; ///< Whether the player left the buzzer sounding. Only used by the player task.
+    int64_t sound_since_us; ///< Time at which the buzzer started sounding, if it is
+    uint32_t run_sound_us; ///< Sounding time accumulated during the current run
+    bool streaming; ///< Whether the previous iteration played something, so the current run continues
+    int64_t deadline_us; ///< Time at which the event being played ends
+    int64_t run_start_us; ///< Time at which the current run started
+    uint32_t run_wakeups; ///< Wakeups during the current run
+    uint32_t run_awake_us; ///< Time the task was awake during the current run
+    uint32_t run_max_late_us; ///< Largest wakeup delay during the current run
+    int64_t awake_since_us; ///< Time at which the player task last woke up
+    bool gate_armed; ///< Whether the gate timer was started for the event being played
+    int64_t gate_off_us; ///< Time at which the gate timer silences the buzzer, if it's armed
+
+    portMUX_TYPE ctrl_lock; ///< Protects the control requests and the published state
+    atomic_uint ctrl_flags; ///< Pending control requests, as BUZZER_PLAYER_CTRL_* flags
+    const buzzer_melody_t *ctrl_melody; ///< Melody requested by buzzer_player_play_melody
+    uint32_t *ctrl_offsets; ///< Time index built for ctrl_melody, owned by the request until the task takes it
+    uint32_t ctrl_seek_ms; ///< Position requested by buzzer_player_seek
+    bool ctrl_paused; ///< State requested by buzzer_player_pause and buzzer_player_resume
+    atomic_int ctrl_cents; ///< Transposition set by buzzer_player_set_transpose, in cents. Read without the lock.
+    atomic_uint ctrl_tempo; ///< Tempo set by buzzer_player_set_tempo, in percent. Read without the lock.
+    int32_t push_cents; ///< Transposition push_transpose was prepared for. Only used by the producer.
+    buzzer_transpose_t push_transpose; ///< Transposition applied by buzzer_player_push_note
+    uint16_t position_tempo; ///< Tempo the published position advances at, in percent
+    buzzer_player_state_t state; ///< Published state of the melody playback
+    uint32_t position_ms; ///< Published melody position, at position_since_us
+    int64_t position_since_us; ///< Time of the published position, from which it advances while playing
+
+    const buzzer_melody_t *melody; ///< Melody being played. The rest of the melody fields are only used by the task.
+    uint32_t *offsets; ///< Start of every note of the melody in milliseconds, followed by the total duration
+    uint32_t note; ///< Index of the next note of the melody to play
+    uint32_t note_skip_ms; ///< Part of that note which has already been played (after a pause or a seek)
+    uint32_t loops_left; ///< Times the looped section of the melody has yet to be repeated
+    bool paused; ///< Whether the melody is paused
+    uint8_t restore_duty; ///< Duty the buzzer had before the melody set its own, set back once it's unloaded. 0 for
+                          ///< none.
+    uint16_t tempo; ///< Tempo the current note is played at, in percent. Melody times are divided by it when played.
+    int32_t cents; ///< Transposition transpose was prepared for
+    buzzer_transpose_t transpose; ///< Transposition applied to the notes of the melody
+};
+
+// Private function declarations
+static void buzzer_player_task(void *arg);
+static void buzzer_player_timer_cb(void *arg);
+static void buzzer_player_gate_cb(void *arg);
+static bool buzzer_player_pop(buzzer_player_t *player, buzzer_event_t *event);
+static const buzzer_event_t *buzzer_player_peek(buzzer_player_t *player);
+static bool buzzer_player_wait_until(buzzer_player_t *player, int64_t deadline_us);
+static void buzzer_player_wait_for_events(buzzer_player_t *player);
+static void buzzer_player_wait_for_control(buzzer_player_t *player);
+static esp_err_t buzzer_player_request(buzzer_player_t *player, uint32_t flags, uint32_t seek_ms, bool paused);
+static void buzzer_player_apply_controls(buzzer_player_t *player);
+static void buzzer_player_publish(buzzer_player_t *player, int64_t since_us);
+static uint32_t buzzer_player_find_note(const uint32_t *offsets, uint32_t length, uint32_t position_ms);
+static void buzzer_player_play_queued(buzzer_player_t *player);
+static void buzzer_player_play_melody_note(buzzer_player_t *player);
+static void buzzer_player_run_begin(buzzer_player_t *player);
+static void buzzer_player_run_end(buzzer_player_t *player);
+static void buzzer_player_restore_duty(buzzer_player_t *player);
+static esp_err_t buzzer_player_output(buzzer_player_t *player, const buzzer_event_t *event);
+static esp_err_t buzzer_player_silence(buzzer_player_t *player);
+static esp_err_t buzzer_player_start_event(buzzer_player_t *player, const buzzer_event_t *event);
+static void buzzer_player_end_gate(buzzer_player_t *player);
+static void buzzer_player_account_sound(buzzer_player_t *player, int64_t until_us);
+static void buzzer_player_sleep(buzzer_player_t *player);
+static void buzzer_player_account_awake(buzzer_player_t *player);
+static int64_t buzzer_player_scale_us(const buzzer_player_t *player, uint32_t melody_ms);
+
+// Public functions
+
+buzzer_player_t *buzzer_player_create(buzzer_t *buzzer, const buzzer_player_config_t *config) {
+    uint32_t requested = (config && config->queue_len) ? config->queue_len : BUZZER_PLAYER_DEFAULT_QUEUE_LEN;
+    if (!buzzer || requested > BUZZER_PLAYER_MAX_QUEUE_LEN) return NULL;
+    if (config && config->task_pinned && config->task_core >= portNUM_PROCESSORS) return NULL; // ESP-IDF asserts
+
+    buzzer_player_t *player = calloc(1, sizeof(buzzer_player_t));
+    if (!player) return NULL;
+
+    // Round the requested capacity up to a power of two, so indexes can wrap with a mask instead of a division. The
+    // cap keeps the capacity from overflowing, and so does the size of the ring.
+    uint32_t capacity = BUZZER_PLAYER_MIN_QUEUE_LEN;
+    while (capacity < requested) capacity <<= 1u;
+
+    player->buzzer = buzzer;
+    player->mask = capacity - 1;
+    player->ring = malloc(capacity * sizeof(buzzer_event_t));
+    player->done = xSemaphoreCreateBinary();
+    atomic_init(&player->head, 0);
+    atomic_init(&player->tail, 0);
+    atomic_init(&player->waiting, false);
+    atomic_init(&player->running, true);
+    atomic_init(&player->ctrl_flags, 0);
+    portMUX_INITIALIZE(&player->ctrl_lock);
+    atomic_init(&player->ctrl_cents, 0);
+    atomic_init(&player->ctrl_tempo, BUZZER_TEMPO_NORMAL);
+    buzzer_transpose_init(&player->push_transpose, 0);
+    buzzer_transpose_init(&player->transpose, 0);
+    player->position_tempo = player->tempo = BUZZER_TEMPO_NORMAL;
+    if (config) {
+        player->low_watermark = config->low_watermark;
+        player->on_low_watermark = config->on_low_watermark;
+        player->arg = config->arg;
+    }
+
+    esp_timer_create_args_t timer_args = {
+            .callback = buzzer_player_timer_cb,
+            .arg = player,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = BUZZER_PLAYER_TASK_NAME
+    };
+    if (!player->ring || !player->done || esp_timer_create(&timer_args, &player->timer) != ESP_OK) goto fail;
+    timer_args.callback = buzzer_player_gate_cb;
+    timer_args.name = BUZZER_PLAYER_GATE_TIMER_NAME;
+    if (esp_timer_create(&timer_args, &player->gate_timer) != ESP_OK) goto fail;
+
+    uint32_t stack = (config && config->task_stack) ? config->task_stack : BUZZER_PLAYER_TASK_STACK;
+    UBaseType_t priority = (config && config->task_priority) ? config->task_priority : BUZZER_PLAYER_TASK_PRIORITY;
+    BaseType_t core = (config && config->task_pinned) ? config->task_core : tskNO_AFFINITY;
+    if (xTaskCreatePinnedToCore(buzzer_player_task, BUZZER_PLAYER_TASK_NAME, stack, player, priority, &player->task,
+                                core) != pdPASS) {
+        goto fail;
+    }
+    return player;
+
+fail:
+    if (player->gate_timer) esp_timer_delete(player->gate_timer);
+    if (player->timer) esp_timer_delete(player->timer);
+    if (player->done) vSemaphoreDelete(player->done);
+    free(player->ring);
+    free(player);
+    return NULL;
+}
+
+void buzzer_player_destroy(buzzer_player_t *player) {
+    if (!player) return;
+    if (xTaskGetCurrentTaskHandle() == player->task) {
+        // The task can't finish while it waits for itself, so waiting would never end
+        ESP_LOGE(buzzer_get_tag(), "buzzer_player_destroy can't be called from the player task");
+        return;
+    }
+
+    // Ask the task to finish, and wait until it has silenced the buzzer and stopped using the player
+    atomic_store(&player->running, false);
+    xTaskNotifyGive(player->task);
+    xSemaphoreTake(player->done, portMAX_DELAY);
+
+    esp_timer_delete(player->gate_timer);
+    esp_timer_delete(player->timer);
+    vSemaphoreDelete(player->done);
+    free(player->ctrl_offsets);
+    free(player->offsets);
+    free(player->ring);
+    free(player);
+}
+
+esp_err_t buzzer_player_push(buzzer_player_t *player, const buzzer_event_t *event) {
+    if (!player || !event) return ESP_FAIL;
+
+    // Only this function writes the head, so it can be read relaxed. The tail must be read with acquire ordering so
+    // the slot we're about to overwrite has really been consumed.
+    uint32_t head = atomic_load_explicit(&player->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&player->tail, memory_order_acquire);
+    if (head - tail > player->mask) {
+        player->stats.overruns++;
+        return ESP_FAIL;
+    }
+
+    player->ring[head & player->mask] = *event;
+    // Publishing the head must be sequentially consistent with respect to the load of the waiting flag below, which
+    // the player task sets before checking the ring buffer one last time. Otherwise a wakeup could be lost.
+    atomic_store(&player->head, head + 1);
+
+    uint32_t level = head + 1 - tail;
+    if (level > player->stats.high_watermark) player->stats.high_watermark = level;
+    player->stats.pushed++;
+
+    if (atomic_load(&player->waiting)) xTaskNotifyGive(player->task); // Wake up the player if it ran out of events
+    return ESP_OK;
+}
+
+esp_err_t buzzer_player_push_note(buzzer_player_t *player, const buzzer_musical_note_t *note, uint32_t bpm) {
+    if (!player || !note || bpm == 0) return ESP_FAIL;
+
+    // The transposition is a single atomic word, so pushing never waits for a control function. It's only prepared
+    // again when it changes, which the producer can keep track of alone.
+    int32_t cents = atomic_load_explicit(&player->ctrl_cents, memory_order_relaxed);
+    if (cents != player->push_cents) {
+        buzzer_transpose_init(&player->push_transpose, cents);
+        player->push_cents = cents;
+    }
+
+    buzzer_event_t event = {
+            // Rests have a frequency of 0
+            .freq_hz = buzzer_get_note_request(player->buzzer, note->note, note->octave, &player->push_transpose),
+            .duration_ms = buzzer_note_type_to_ms(note->type, bpm)
+    };
+    event.gate_ms = buzzer_gate_to_ms(event.duration_ms, note->gate);
+    return buzzer_player_push(player, &event);
+}
+
+uint32_t buzzer_player_get_level(buzzer_player_t *player) {
+    if (!player) return 0;
+    return atomic_load(&player->head) - atomic_load(&player->tail);
+}
+
+esp_err_t buzzer_player_get_stats(buzzer_player_t *player, buzzer_player_stats_t *stats) {
+    if (!player || !stats) return ESP_FAIL;
+    *stats = player->stats;
+    stats->stack_free_min = uxTaskGetStackHighWaterMark(player->task); // ESP-IDF measures stacks in bytes
+    return ESP_OK;
+}
+
+esp_err_t buzzer_player_play_melody(buzzer_player_t *player, const buzzer_melody_t *melody, uint32_t bpm) {
+    if (!player || buzzer_check_melody(melody) != ESP_OK || bpm == 0) return ESP_FAIL;
+
+    // Prefix sums of the note durations, so the note at any position can be found with a binary search. They're
+    // accumulated in milliseconds note by note, so the melody lasts exactly as long as with buzzer_play_melody.
+    uint32_t *offsets = malloc((melody->length + 1) * sizeof(uint32_t));
+    if (!offsets) return ESP_FAIL;
+    offsets[0] = 0;
+    for (uint32_t i = 0; i < melody->length; i++) {
+        offsets[i + 1] = offsets[i] + buzzer_note_type_to_ms(melody->melody[i].type, bpm);
+    }
+
+    // A new melody overrides every request which hasn't been handled yet, including a previous melody
+    portENTER_CRITICAL(&player->ctrl_lock);
+    uint32_t *discarded = player->ctrl_offsets;
+    player->ctrl_melody = melody;
+    player->ctrl_offsets = offsets;
+    atomic_store(&player->ctrl_flags, BUZZER_PLAYER_CTRL_LOAD);
+    portEXIT_CRITICAL(&player->ctrl_lock);
+
+    free(discarded);
+    xTaskNotifyGive(player->task);
+    return ESP_OK;
+}
+
+esp_err_t buzzer_player_pause(buzzer_player_t *player) {
+    return buzzer_player_request(player, BUZZER_PLAYER_CTRL_PAUSE, 0, true);
+}
+
+esp_err_t buzzer_player_resume(buzzer_player_t *player) {
+    return buzzer_player_request(player, BUZZER_PLAYER_CTRL_PAUSE, 0, false);
+}
+
+esp_err_t buzzer_player_seek(buzzer_player_t *player, uint32_t position_ms) {
+    return buzzer_player_request(player, BUZZER_PLAYER_CTRL_SEEK, position_ms, false);
+}
+
+esp_err_t buzzer_player_stop(buzzer_player_t *player) {
+    if (!player) return ESP_FAIL;
+
+    portENTER_CRITICAL(&player->ctrl_lock);
+    uint32_t *discarded = player->ctrl_offsets; // A melody which hasn't been loaded yet is dropped
+    player->ctrl_offsets = NULL;
+    // With no melody there's nothing to stop, and the queued events mustn't be interrupted
+    bool loaded = discarded || player->state != BUZZER_PLAYER_IDLE;
+    if (loaded) atomic_store(&player->ctrl_flags, BUZZER_PLAYER_CTRL_STOP);
+    portEXIT_CRITICAL(&player->ctrl_lock);
+
+    free(discarded);
+    if (loaded) xTaskNotifyGive(player->task);
+    return ESP_OK;
+}
+
+esp_err_t buzzer_player_set_transpose(buzzer_player_t *player, int32_t cents) {
+    buzzer_transpose_t transpose;
+    if (!player || buzzer_transpose_init(&transpose, cents) != ESP_OK) return ESP_FAIL;
+
+    // The task takes it at the next note boundary, so there's no need to wake it up
+    atomic_store_explicit(&player->ctrl_cents, cents, memory_order_relaxed);
+    return ESP_OK;
+}
+
+esp_err_t buzzer_player_set_tempo(buzzer_player_t *player, uint16_t percent) {
+    if (!player || percent == 0) return ESP_FAIL;
+
+    atomic_store_explicit(&player->ctrl_tempo, percent, memory_order_relaxed);
+    return ESP_OK;
+}
+
+buzzer_player_state_t buzzer_player_get_state(buzzer_player_t *player) {
+    if (!player) return BUZZER_PLAYER_IDLE;
+
+    portENTER_CRITICAL(&player->ctrl_lock);
+    buzzer_player_state_t state = player->state;
+    portEXIT_CRITICAL(&player->ctrl_lock);
+    return state;
+}
+
+uint32_t buzzer_player_get_position_ms(buzzer_player_t *player) {
+    if (!player) return 0;
+
+    portENTER_CRITICAL(&player->ctrl_lock);
+    buzzer_player_state_t state = player->state;
+    uint32_t position_ms = player->position_ms;
+    int64_t since_us = player->position_since_us;
+    uint16_t tempo = player->position_tempo;
+    portEXIT_CRITICAL(&player->ctrl_lock);
+
+    if (state == BUZZER_PLAYER_PLAYING) {
+        int64_t elapsed_us = esp_timer_get_time() - since_us;
+        if (elapsed_us > 0) position_ms += (uint32_t) (elapsed_us * tempo / BUZZER_TEMPO_NORMAL / 1000);
+    }
+    return position_ms;
+}
+
+// Private functions
+
+/**
+ * Body of the player task. Plays the loaded melody, if any, and otherwise takes events from the ring buffer one by
+ * one, outputs them, and sleeps until their end.
+ * @param arg Player the task belongs to
+ */
+static void buzzer_player_task(void *arg) {
+    buzzer_player_t *player = arg;
+    player->awake_since_us = esp_timer_get_time();
+
+    while (atomic_load(&player->running)) {
+        buzzer_player_apply_controls(player);
+        if (!player->melody) {
+            buzzer_player_play_queued(player);
+        } else if (player->note < player->melody->length) {
+            if (player->paused) {
+                buzzer_player_wait_for_control(player);
+            } else {
+                buzzer_player_play_melody_note(player);
+            }
+        } else {
+            // The melody finished (or was moved past its end, even while paused), so unload it and go back to the
+            // queued events
+            buzzer_player_run_end(player);
+            free(player->offsets);
+            player->offsets = NULL;
+            player->melody = NULL;
+            buzzer_player_restore_duty(player);
+            buzzer_player_publish(player, esp_timer_get_time());
+        }
+    }
+
+    esp_timer_stop(player->timer);
+    buzzer_player_end_gate(player);
+    buzzer_player_silence(player);
+    buzzer_player_restore_duty(player);
+    xSemaphoreGive(player->done);
+    vTaskDelete(NULL);
+}
+
+/**
+ * Plays the next event from the ring buffer, or waits for one if it's empty.
+ * @param player Player whose task is running
+ */
+static void buzzer_player_play_queued(buzzer_player_t *player) {
+    buzzer_event_t event;
+    uint32_t level = buzzer_player_get_level(player);
+    if (!buzzer_player_pop(player, &event)) {
+        if (player->streaming) player->stats.underruns++;
+        buzzer_player_run_end(player);
+        buzzer_player_wait_for_events(player);
+        return;
+    }
+
+    buzzer_player_run_begin(player);
+    player->stats.played++;
+
+    // Merge the rests that follow a rest, so the whole silence is slept through with a single wakeup
+    const buzzer_event_t *next;
+    buzzer_event_t rest;
+    while (event.freq_hz == 0 && (next = buzzer_player_peek(player)) && next->freq_hz == 0) {
+        buzzer_player_pop(player, &rest);
+        event.duration_ms += rest.duration_ms;
+        player->stats.played++;
+    }
+
+    buzzer_player_start_event(player, &event);
+    player->deadline_us += (int64_t) event.duration_ms * 1000;
+    BUZZER_TRACE(BUZZER_TRACE_DEADLINE, player->buzzer, player->deadline_us);
+
+    // Let the producer know it should push more events when the level crosses the low watermark
+    uint32_t new_level = buzzer_player_get_level(player);
+    if (player->on_low_watermark && level > player->low_watermark && new_level <= player->low_watermark) {
+        player->on_low_watermark(player, player->arg);
+    }
+    buzzer_player_wait_until(player, player->deadline_us);
+    buzzer_player_end_gate(player);
+    player->run_wakeups++;
+    player->stats.wakeups++;
+}
+
+/**
+ * Plays the next note of the loaded melody, starting note_skip_ms into it. If a control request interrupts it, the
+ * position reached is stored so the melody can continue from there.
+ * @param player Player whose task is running
+ */
+static void buzzer_player_play_melody_note(buzzer_player_t *player) {
+    const buzzer_melody_t *melody = player->melody;
+    const buzzer_musical_note_t *note = &melody->melody[player->note];
+    uint32_t end = player->note + 1;
+
+    // The transposition and tempo are taken at every note boundary, so they can change while the melody plays
+    int32_t cents = atomic_load_explicit(&player->ctrl_cents, memory_order_relaxed);
+    if (cents != player->cents) {
+        buzzer_transpose_init(&player->transpose, cents);
+        player->cents = cents;
+    }
+    player->tempo = (uint16_t) atomic_load_explicit(&player->ctrl_tempo, memory_order_relaxed);
+
+    buzzer_event_t event = {
+            .freq_hz = buzzer_get_note_request(player->buzzer, note->note, note->octave, &player->transpose)
+    };
+    uint32_t full_ms = player->offsets[end] - player->offsets[player->note];
+
+    // Merge the rests that follow a rest, like with queued events, but not past the end of the looped section
+    bool looping = player->loops_left > 0 && player->note < melody->loop_end;
+    uint32_t limit = looping ? melody->loop_end : melody->length;
+    while (event.freq_hz == 0 && end < limit && melody->melody[end].note == BUZZER_NOTE_REST) end++;
+    event.duration_ms = player->offsets[end] - player->offsets[player->note] - player->note_skip_ms;
+
+    // The gate is measured from the start of the note, even if it was resumed from the middle
+    uint32_t gate_ms = buzzer_gate_to_ms(full_ms, note->gate ? note->gate : melody->gate);
+    if (event.freq_hz != 0 && gate_ms < full_ms) {
+        if (player->note_skip_ms >= gate_ms) {
+            event.freq_hz = 0; // Only the silence after the gate is left
+        } else {
+            event.gate_ms = gate_ms - player->note_skip_ms;
+        }
+    }
+
+    // Everything up to here is in the time of the melody, which the tempo stretches into the time it's played in
+    int64_t duration_us = buzzer_player_scale_us(player, event.duration_ms);
+    event.duration_ms = (uint32_t) (duration_us / 1000);
+    event.gate_ms = (uint32_t) (buzzer_player_scale_us(player, event.gate_ms) / 1000);
+
+    buzzer_player_run_begin(player);
+    buzzer_player_publish(player, player->deadline_us);
+    buzzer_player_start_event(player, &event);
+    player->deadline_us += duration_us;
+    BUZZER_TRACE(BUZZER_TRACE_DEADLINE, player->buzzer, player->deadline_us);
+
+    bool finished = buzzer_player_wait_until(player, player->deadline_us);
+    buzzer_player_end_gate(player);
+    player->run_wakeups++;
+    player->stats.wakeups++;
+    int64_t left_us = player->deadline_us - esp_timer_get_time();
+    if (finished || left_us <= 0) {
+        // Jumping back to the start of the loop is just another note boundary, so the deadlines keep accumulating
+        player->note = end;
+        player->note_skip_ms = 0;
+        if (looping && end == melody->loop_end) {
+            player->note = melody->loop_start;
+            if (player->loops_left != BUZZER_LOOP_FOREVER) player->loops_left--;
+        }
+        return;
+    }
+
+    // Round the time left up, so the position stays within the interrupted note
+    uint32_t left_ms = (uint32_t) ((left_us * player->tempo / BUZZER_TEMPO_NORMAL + 999) / 1000);
+    uint32_t position_ms = player->offsets[end] - left_ms;
+    player->deadline_us -= buzzer_player_scale_us(player, left_ms); // Keep the timeline in step with the position
+    player->note = buzzer_player_find_note(player->offsets, melody->length, position_ms);
+    player->note_skip_ms = position_ms - player->offsets[player->note];
+}
+
+/**
+ * Starts a run of back to back events, unless one is already going on.
+ * @param player Player whose task is running
+ */
+static void buzzer_player_run_begin(buzzer_player_t *player) {
+    if (player->streaming) return;
+
+    // Deadlines are accumulated instead of measured from the current time, so the small delays introduced by waking
+    // up and changing the frequency don't add up along a run
+    player->deadline_us = player->run_start_us = esp_timer_get_time();
+    player->run_wakeups = 0;
+    player->run_sound_us = 0;
+    player->run_awake_us = 0;
+    player->run_max_late_us = 0;
+    player->streaming = true;
+}
+
+/**
+ * Finishes the current run, if any, silencing the buzzer and storing the run counters.
+ * @param player Player whose task is running
+ */
+static void buzzer_player_run_end(buzzer_player_t *player) {
+    if (!player->streaming) return;
+
+    buzzer_player_silence(player); // Don't keep the last frequency sounding while there's nothing to play
+    buzzer_player_account_awake(player);
+    player->stats.run_us = (uint32_t) (esp_timer_get_time() - player->run_start_us);
+    player->stats.run_sound_us = player->run_sound_us;
+    player->stats.run_wakeups = player->run_wakeups;
+    player->stats.run_awake_us = player->run_awake_us;
+    player->stats.run_max_late_us = player->run_max_late_us;
+    player->streaming = false;
+}
+
+/**
+ * Callback of the player's one-shot timer. Wakes up the player task when the current event ends.
+ * @param arg Player the timer belongs to
+ */
+static void buzzer_player_timer_cb(void *arg) {
+    buzzer_player_t *player = arg;
+    xTaskNotifyGive(player->task);
+}
+
+/**
+ * Callback of the player's gate timer. Silences the buzzer at the gate of an articulated event, without waking up the
+ * player task, which accounts for the sound time when the event ends.
+ * @param arg Player the timer belongs to
+ */
+static void buzzer_player_gate_cb(void *arg) {
+    buzzer_player_t *player = arg;
+    buzzer_pause(player->buzzer);
+}
+
+/**
+ * Takes the oldest event from the ring buffer. Must only be called from the player task.
+ * @param player Player to take the event from
+ * @param event Where the event is copied
+ * @return true if an event was taken, false if the ring buffer was empty
+ */
+static bool buzzer_player_pop(buzzer_player_t *player, buzzer_event_t *event) {
+    uint32_t tail = atomic_load_explicit(&player->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&player->head, memory_order_acquire);
+    if (head == tail) return false;
+
+    *event = player->ring[tail & player->mask];
+    atomic_store_explicit(&player->tail, tail + 1, memory_order_release); // Hand the slot back to the producer
+    return true;
+}
+
+/**
+ * Returns the oldest event in the ring buffer without taking it. Must only be called from the player task.
+ * @param player Player to check
+ * @return Pointer to the event, which stays valid until it's popped, or NULL if the ring buffer was empty
+ */
+static const buzzer_event_t *buzzer_player_peek(buzzer_player_t *player) {
+    uint32_t tail = atomic_load_explicit(&player->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&player->head, memory_order_acquire);
+    if (head == tail) return NULL;
+    return &player->ring[tail & player->mask];
+}
+
+/**
+ * Sleeps until the provided deadline, until a control request arrives, or until the player is asked to finish.
+ * @param player Player whose task is sleeping
+ * @param deadline_us Time to wake up at, in the esp_timer time base (microseconds)
+ * @return true if the deadline was reached, false if the wait was interrupted
+ */
+static bool buzzer_player_wait_until(buzzer_player_t *player, int64_t deadline_us) {
+    int64_t remaining_us = deadline_us - esp_timer_get_time();
+    if (remaining_us > 0) { // Otherwise we're running late, so the next event must start right away
+        esp_timer_start_once(player->timer, remaining_us);
+        // Spurious notifications (a late wakeup from the producer) are possible, so check the time after each one
+        while (esp_timer_get_time() < deadline_us) {
+            if (!atomic_load(&player->running) || atomic_load(&player->ctrl_flags)) {
+                // A stale notification left by the timer is taken as a spurious one later
+                esp_timer_stop(player->timer);
+                return false;
+            }
+            buzzer_player_sleep(player);
+        }
+    }
+
+    // How late the task is to start the next event, due to the wakeup latency or the previous event taking too long
+    uint32_t late_us = (uint32_t) (esp_timer_get_time() - deadline_us);
+    if (late_us > player->stats.max_late_us) player->stats.max_late_us = late_us;
+    if (late_us > player->run_max_late_us) player->run_max_late_us = late_us;
+    return true;
+}
+
+/**
+ * Sleeps until the producer pushes a new event, until a control request arrives, or until the player is asked to
+ * finish.
+ * @param player Player whose task is sleeping
+ */
+static void buzzer_player_wait_for_events(buzzer_player_t *player) {
+    atomic_store(&player->waiting, true);
+    // Check again after announcing that we're waiting: an event pushed right before the flag was set wouldn't have
+    // notified us
+    if (buzzer_player_get_level(player) == 0 && atomic_load(&player->running) && !atomic_load(&player->ctrl_flags)) {
+        buzzer_player_sleep(player);
+    }
+    atomic_store(&player->waiting, false);
+}
+
+/**
+ * Sleeps until a control request arrives, or until the player is asked to finish. Used while the melody is paused, so
+ * queued events don't wake up the task.
+ * @param player Player whose task is sleeping
+ */
+static void buzzer_player_wait_for_control(buzzer_player_t *player) {
+    // Requests notify the task after setting their flags, and notifications aren't lost if they arrive before we sleep
+    if (atomic_load(&player->running) && !atomic_load(&player->ctrl_flags)) buzzer_player_sleep(player);
+}
+
+/**
+ * Stores a pause, resume or seek request for the player task, if a melody is loaded or about to be.
+ * @param player Player the request is for
+ * @param flags Request, as BUZZER_PLAYER_CTRL_* flags
+ * @param seek_ms Position requested, for seeks
+ * @param paused State requested, for pauses and resumes
+ * @return ESP_OK if the request was stored, ESP_FAIL if no melody is loaded or the arguments are invalid
+ */
+static esp_err_t buzzer_player_request(buzzer_player_t *player, uint32_t flags, uint32_t seek_ms, bool paused) {
+    if (!player) return ESP_FAIL;
+
+    portENTER_CRITICAL(&player->ctrl_lock);
+    uint32_t pending = atomic_load(&player->ctrl_flags);
+    bool loaded = (pending & BUZZER_PLAYER_CTRL_LOAD) ||
+                  (player->state != BUZZER_PLAYER_IDLE && !(pending & BUZZER_PLAYER_CTRL_STOP));
+    if (loaded) {
+        if (flags & BUZZER_PLAYER_CTRL_SEEK) player->ctrl_seek_ms = seek_ms;
+        if (flags & BUZZER_PLAYER_CTRL_PAUSE) player->ctrl_paused = paused;
+        atomic_fetch_or(&player->ctrl_flags, flags);
+    }
+    portEXIT_CRITICAL(&player->ctrl_lock);
+
+    if (!loaded) return ESP_FAIL;
+    xTaskNotifyGive(player->task);
+    return ESP_OK;
+}
+
+/**
+ * Handles the pending control requests, in the order stop, load, seek and pause/resume.
+ * @param player Player whose task is running
+ */
+static void buzzer_player_apply_controls(buzzer_player_t *player) {
+    if (!atomic_load(&player->ctrl_flags)) return;
+
+    portENTER_CRITICAL(&player->ctrl_lock);
+    uint32_t flags = atomic_exchange(&player->ctrl_flags, 0);
+    const buzzer_melody_t *melody = player->ctrl_melody;
+    uint32_t *offsets = player->ctrl_offsets;
+    uint32_t seek_ms = player->ctrl_seek_ms;
+    bool paused = player->ctrl_paused;
+    if (flags & BUZZER_PLAYER_CTRL_LOAD) player->ctrl_offsets = NULL; // The task owns the time index from now on
+    portEXIT_CRITICAL(&player->ctrl_lock);
+
+    if (flags & (BUZZER_PLAYER_CTRL_STOP | BUZZER_PLAYER_CTRL_LOAD)) {
+        free(player->offsets);
+        player->offsets = NULL;
+        player->melody = NULL;
+        player->paused = false;
+        player->note = 0;
+        player->note_skip_ms = 0;
+        buzzer_player_run_end(player);
+        buzzer_player_restore_duty(player);
+    }
+    if (flags & BUZZER_PLAYER_CTRL_LOAD) {
+        player->melody = melody;
+        player->offsets = offsets;
+        player->loops_left = melody->loop_start < melody->loop_end ? melody->loop_count : 0;
+        if (melody->duty) { // Once, before its first note
+            player->restore_duty = buzzer_get_duty(player->buzzer);
+            buzzer_set_duty(player->buzzer, melody->duty);
+        }
+    }
+    if (player->melody && (flags & BUZZER_PLAYER_CTRL_SEEK)) {
+        const buzzer_melody_t *loaded = player->melody;
+        player->note = buzzer_player_find_note(player->offsets, loaded->length, seek_ms);
+        player->note_skip_ms = player->note < loaded->length ? seek_ms - player->offsets[player->note] : 0;
+        // Positions don't tell the passes of the loop apart, so the position is taken as reached for the first time
+        player->loops_left = loaded->loop_start < loaded->loop_end ? loaded->loop_count : 0;
+        player->deadline_us = esp_timer_get_time(); // Keep playing, but time the notes from the new position
+    }
+    if (player->melody && (flags & BUZZER_PLAYER_CTRL_PAUSE)) {
+        player->paused = paused;
+        if (paused) buzzer_player_run_end(player);
+    }
+    buzzer_player_publish(player, esp_timer_get_time());
+}
+
+/**
+ * Publishes the state and position of the melody, so they can be read from other tasks.
+ * @param player Player whose task is running
+ * @param since_us Time at which the melody was at the position of the next note to play
+ */
+static void buzzer_player_publish(buzzer_player_t *player, int64_t since_us) {
+    buzzer_player_state_t state = BUZZER_PLAYER_IDLE;
+    uint32_t position_ms = 0;
+    if (player->melody) {
+        state = player->paused ? BUZZER_PLAYER_PAUSED : BUZZER_PLAYER_PLAYING;
+        position_ms = player->offsets[player->note] + player->note_skip_ms;
+    }
+
+    portENTER_CRITICAL(&player->ctrl_lock);
+    player->state = state;
+    player->position_ms = position_ms;
+    player->position_since_us = since_us;
+    player->position_tempo = player->tempo;
+    portEXIT_CRITICAL(&player->ctrl_lock);
+}
+
+/**
+ * Finds the note of a melody which is being played at the given position, with a binary search over its time index.
+ * @param offsets Time index of the melody: the start of every note, followed by the total duration
+ * @param length Amount of notes in the melody
+ * @param position_ms Position to look for, in milliseconds from the start of the melody
+ * @return Index of the last note starting at or before the position, or the length if the melody has ended by then
+ */
+static uint32_t buzzer_player_find_note(const uint32_t *offsets, uint32_t length, uint32_t position_ms) {
+    if (position_ms >= offsets[length]) return length;
+
+    uint32_t low = 0, high = length; // offsets[low] <= position_ms < offsets[high]
+    while (high - low > 1) {
+        uint32_t mid = low + (high - low) / 2;
+        if (offsets[mid] <= position_ms) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * Sets the buzzer output according to the provided event.
+ * @param player Player whose buzzer must be updated
+ * @param event Event to output
+ * @return ESP_OK if the operation was executed successfully, ESP_FAIL if something went wrong
+ */
+static esp_err_t buzzer_player_output(buzzer_player_t *player, const buzzer_event_t *event) {
+    if (event->freq_hz == 0) return buzzer_player_silence(player);
+
+    esp_err_t ret = buzzer_set_freq(player->buzzer, event->freq_hz);
+    if (ret == ESP_FAIL) return ret;
+    ret = buzzer_play(player->buzzer);
+    if (ret == ESP_OK && !player->sounding) {
+        player->sounding = true;
+        player->sound_since_us = esp_timer_get_time();
+    }
+    return ret;
+}
+
+/**
+ * Pauses the buzzer, accounting for the time it has been sounding.
+ * @param player Player whose buzzer must be paused
+ * @return ESP_OK if the operation was executed successfully, ESP_FAIL if something went wrong
+ */
+static esp_err_t buzzer_player_silence(buzzer_player_t *player) {
+    buzzer_player_account_sound(player, esp_timer_get_time());
+    return buzzer_pause(player->buzzer);
+}
+
+/**
+ * Adds the time the buzzer has been sounding to the counters, and marks it as silent.
+ * @param player Player whose buzzer stopped sounding
+ * @param until_us Time at which the buzzer stopped sounding
+ */
+static void buzzer_player_account_sound(buzzer_player_t *player, int64_t until_us) {
+    if (!player->sounding) return;
+
+    uint32_t sound_us = (uint32_t) (until_us - player->sound_since_us);
+    player->stats.sound_us += sound_us;
+    player->run_sound_us += sound_us;
+    player->sounding = false;
+}
+
+/**
+ * Outputs an event starting at the current deadline. If the event has a gate, the gate timer is armed to silence the
+ * buzzer in the middle of the event, so the task still wakes up only once, at the end.
+ * @param player Player whose buzzer must be updated
+ * @param event Event to output
+ * @return ESP_OK if the operation was executed successfully, ESP_FAIL if something went wrong
+ */
+static esp_err_t buzzer_player_start_event(buzzer_player_t *player, const buzzer_event_t *event) {
+    esp_err_t ret = buzzer_player_output(player, event);
+    if (ret != ESP_OK || event->freq_hz == 0 || event->gate_ms == 0 || event->gate_ms >= event->duration_ms) {
+        return ret;
+    }
+
+    player->gate_off_us = player->deadline_us + (int64_t) event->gate_ms * 1000;
+    int64_t wait_us = player->gate_off_us - esp_timer_get_time();
+    if (wait_us <= 0) return buzzer_player_silence(player); // We're running late, and the gate has already passed
+    player->gate_armed = true;
+    return esp_timer_start_once(player->gate_timer, wait_us);
+}
+
+/**
+ * Disarms the gate timer once the event ends or is interrupted. If the timer already silenced the buzzer, the sound
+ * time is accounted up to the gate.
+ * @param player Player whose task is running
+ */
+static void buzzer_player_end_gate(buzzer_player_t *player) {
+    if (!player->gate_armed) return;
+
+    player->gate_armed = false;
+    if (esp_timer_stop(player->gate_timer) != ESP_OK) buzzer_player_account_sound(player, player->gate_off_us);
+}
+
+/**
+ * Sleeps until the player task is notified, accounting the time it was awake before.
+ * @param player Player whose task is sleeping
+ */
+static void buzzer_player_sleep(buzzer_player_t *player) {
+    buzzer_player_account_awake(player);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    player->awake_since_us = esp_timer_get_time();
+}
+
+/**
+ * Adds the time the player task has been awake since it last woke up (or was last accounted) to the awake time
+ * counters.
+ * @param player Player whose task is running
+ */
+static void buzzer_player_account_awake(buzzer_player_t *player) {
+    int64_t now_us = esp_timer_get_time();
+    uint32_t awake_us = (uint32_t) (now_us - player->awake_since_us);
+    player->stats.awake_us += awake_us;
+    if (player->streaming) player->run_awake_us += awake_us;
+    player->awake_since_us = now_us;
+}
+
+/**
+ * Converts a time of the melody into the time it takes to play at the current tempo.
+ * @param player Player whose task is running
+ * @param melody_ms Time in the melody, in milliseconds at the speed it was loaded with
+ * @return Time it takes to play, in microseconds
+ */
+static int64_t buzzer_player_scale_us(const buzzer_player_t *player, uint32_t melody_ms) {
+    return (int64_t) melody_ms * 1000 * BUZZER_TEMPO_NORMAL / player->tempo;
+}
+
+/**
+ * Sets the buzzer back to the duty it had before the melody being unloaded set its own, if it did, so later melodies
+ * and events without a duty don't inherit it.
+ * @param player Player whose task is running
+ */
+static void buzzer_player_restore_duty(buzzer_player_t *player) {
+    if (!player->restore_duty) return;
+    buzzer_set_duty(player->buzzer, player->restore_duty);
+    player->restore_duty = 0;
+}
@@ -0,0 +1,480 @@
+/**
+ * @file buzzer_sound.c
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the definitions for the callback engine. Each sound is a small state machine advanced by
+ * its one-shot esp_timer: every time it fires, the current note ends (or is gated) and the next one is started.
+ * Beep patterns are played the same way, with each run of equal units taking a single firing, and so is Morse code,
+ * with one firing per element and space.
+ *
+ * The state is only modified from the timer callback, which runs in the esp_timer task, so it needs no locks. The
+ * control functions leave their request in an atomic word and fire the timer right away, so the callback applies it.
+ * What to play is stored along with the request under a spinlock, so the callback always copies a whole request even
+ * if another one is being left at the same time.
+ */
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <esp_log.h>
+#include "buzzer/buzzer_sound.h"
+#include "buzzer_timer_task.h"
+
+#define BUZZER_SOUND_TIMER_NAME "buzzer_sound" ///< Name of the sound timers
+
+#define BUZZER_SOUND_REQ_PLAY (1u << 0u) ///< A new melody or pattern must be started
+#define BUZZER_SOUND_REQ_STOP (1u << 1u) ///< The melody or pattern must be stopped
+#define BUZZER_SOUND_REQ_RELEASE (1u << 2u) ///< The sound is being destroyed, so the callback must let it go
+#define BUZZER_SOUND_RELEASED (1u << 3u) ///< Set by the callback once it won't touch the sound again
+
+#define BUZZER_SOUND_TEMPO_MASK 0xFFFFu ///< Bits of the variant word holding the tempo, below the transposition
+#define BUZZER_SOUND_TRANSPOSE_SHIFT 16u ///< Position of the transposition (in cents, signed) in the variant word
+
+/**
+ * Play request, copied by the callback in one piece
+ */
+typedef struct {
+    const buzzer_melody_t *melody; ///< Melody to start
+    const buzzer_pattern_t *pattern; ///< Pattern to start, if there's no melody
+    const buzzer_morse_t *morse; ///< Morse code to start, if there's no pattern
+    uint32_t bpm; ///< Speed of melody
+    buzzer_sound_done_cb_t done; ///< Callback to invoke when it ends
+    void *arg; ///< User argument for done
+} buzzer_sound_play_t;
+
+/**
+ * Struct storing the state of a sound. Kept as small as possible, as there may be dozens of them.
+ */
+struct _buzzer_sound_t {
+    buzzer_t *buzzer; ///< Buzzer the melody is played on
+    esp_timer_handle_t timer; ///< One-shot timer firing at every note boundary and gate
+    atomic_uint requests; ///< Pending requests, as BUZZER_SOUND_REQ_* flags
+    portMUX_TYPE request_lock; ///< Lock of request, taken along with the play request flag
+    buzzer_sound_play_t request; ///< What to start with the next play request
+    atomic_uint variant; ///< Transposition and tempo of the melody notes, read by the callback at every note
+
+    const buzzer_melody_t *melody; ///< Melody being played, or NULL
+    const buzzer_pattern_t *pattern; ///< Pattern being played, or NULL
+    const buzzer_morse_t *morse; ///< Morse transmission being sent, or NULL
+    uint16_t bpm; ///< Speed of the melody
+    bool gate_pending; ///< Whether the next firing silences the buzzer (the gate of a note or the end of an element)
+    uint8_t morse_code; ///< Elements of the Morse character being sent yet to start, followed by the sentinel bit
+    uint8_t restore_duty; ///< Duty the buzzer had before the melody set its own, set back when it ends. 0 if none.
+    uint32_t note; ///< Index of the next note (or pattern unit, or character of the Morse text) to start
+    uint32_t loops_left; ///< Times the looped section of the melody (or the pattern) has yet to be repeated
+    int64_t deadline_us; ///< End of the current note, accumulated so timing errors don't add up
+    int64_t fire_us; ///< Time the callback last armed the timer for, so early firings can be told apart
+    uint32_t variant_applied; ///< Variant word transpose was prepared from
+    buzzer_transpose_t transpose; ///< Transposition applied to the melody notes
+    buzzer_sound_done_cb_t done; ///< Callback invoked when the melody or pattern being played ends
+    void *arg; ///< User argument for done
+};
+
+// Private function declarations
+static void buzzer_sound_timer_cb(void *arg);
+static void buzzer_sound_request(buzzer_sound_t *sound, uint32_t request, const buzzer_sound_play_t *play);
+static void buzzer_sound_next(buzzer_sound_t *sound);
+static void buzzer_sound_next_run(buzzer_sound_t *sound);
+static void buzzer_sound_next_morse(buzzer_sound_t *sound);
+static uint8_t buzzer_sound_read_morse(buzzer_sound_t *sound, bool *word_gap);
+static void buzzer_sound_finish(buzzer_sound_t *sound);
+static void buzzer_sound_restore_duty(buzzer_sound_t *sound);
+static void buzzer_sound_arm(buzzer_sound_t *sound, int64_t at_us);
+static void buzzer_sound_set_variant(buzzer_sound_t *sound, uint32_t mask, uint32_t value);
+
+// Public functions
+
+buzzer_sound_t *buzzer_sound_create(buzzer_t *buzzer) {
+    if (!buzzer) return NULL;
+
+    buzzer_sound_t *sound = calloc(1, sizeof(buzzer_sound_t));
+    if (!sound) return NULL;
+
+    sound->buzzer = buzzer;
+    atomic_init(&sound->requests, 0);
+    portMUX_INITIALIZE(&sound->request_lock);
+    atomic_init(&sound->variant, BUZZER_TEMPO_NORMAL);
+    sound->variant_applied = BUZZER_TEMPO_NORMAL;
+    buzzer_transpose_init(&sound->transpose, 0);
+    esp_timer_create_args_t timer_args = {
+            .callback = buzzer_sound_timer_cb,
+            .arg = sound,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = BUZZER_SOUND_TIMER_NAME
+    };
+    if (esp_timer_create(&timer_args, &sound->timer) != ESP_OK) {
+        free(sound);
+        return NULL;
+    }
+    return sound;
+}
+
+void buzzer_sound_destroy(buzzer_sound_t *sound) {
+    if (!sound) return;
+    if (buzzer_in_timer_task()) {
+        // The callback can't run while this task waits for it, so waiting would never end
+        ESP_LOGE(buzzer_get_tag(), "buzzer_sound_destroy can't be called from an esp_timer callback");
+        return;
+    }
+
+    // The callback may be running right now, so let it stop the sound and wait until it confirms it's done with it
+    buzzer_sound_request(sound, BUZZER_SOUND_REQ_RELEASE, NULL);
+    while (!(atomic_load(&sound->requests) & BUZZER_SOUND_RELEASED)) vTaskDelay(1);
+
+    esp_timer_delete(sound->timer);
+    free(sound);
+}
+
+esp_err_t buzzer_sound_play_melody(buzzer_sound_t *sound, const buzzer_melody_t *melody, uint32_t bpm,
+                                   buzzer_sound_done_cb_t done, void *arg) {
+    if (!sound || buzzer_check_melody(melody) != ESP_OK || bpm == 0 || bpm > UINT16_MAX) return ESP_FAIL;
+
+    buzzer_sound_play_t play = {.melody = melody, .bpm = bpm, .done = done, .arg = arg};
+    buzzer_sound_request(sound, BUZZER_SOUND_REQ_PLAY, &play);
+    return ESP_OK;
+}
+
+esp_err_t buzzer_sound_play_pattern(buzzer_sound_t *sound, const buzzer_pattern_t *pattern,
+                                    buzzer_sound_done_cb_t done, void *arg) {
+    if (!sound || !pattern || pattern->length == 0 || pattern->length > BUZZER_PATTERN_MAX_UNITS ||
+        pattern->unit_ms == 0) {
+        return ESP_FAIL;
+    }
+
+    buzzer_sound_play_t play = {.pattern = pattern, .done = done, .arg = arg};
+    buzzer_sound_request(sound, BUZZER_SOUND_REQ_PLAY, &play);
+    return ESP_OK;
+}
+
+esp_err_t buzzer_sound_play_morse(buzzer_sound_t *sound, const buzzer_morse_t *morse, buzzer_sound_done_cb_t done,
+                                  void *arg) {
+    if (!sound || !morse || (!morse->text && !morse->source) || morse->wpm == 0) return ESP_FAIL;
+
+    buzzer_sound_play_t play = {.morse = morse, .done = done, .arg = arg};
+    buzzer_sound_request(sound, BUZZER_SOUND_REQ_PLAY, &play);
+    return ESP_OK;
+}
+
+esp_err_t buzzer_sound_set_transpose(buzzer_sound_t *sound, int32_t cents) {
+    buzzer_transpose_t transpose;
+    if (!sound || buzzer_transpose_init(&transpose, cents) != ESP_OK) return ESP_FAIL;
+
+    uint32_t value = (uint32_t) (uint16_t) (int16_t) cents << BUZZER_SOUND_TRANSPOSE_SHIFT;
+    buzzer_sound_set_variant(sound, ~BUZZER_SOUND_TEMPO_MASK, value);
+    return ESP_OK;
+}
+
+esp_err_t buzzer_sound_set_tempo(buzzer_sound_t *sound, uint16_t percent) {
+    if (!sound || percent == 0) return ESP_FAIL;
+    buzzer_sound_set_variant(sound, BUZZER_SOUND_TEMPO_MASK, percent);
+    return ESP_OK;
+}
+
+esp_err_t buzzer_sound_stop(buzzer_sound_t *sound) {
+    if (!sound) return ESP_FAIL;
+    buzzer_sound_request(sound, BUZZER_SOUND_REQ_STOP, NULL);
+    return ESP_OK;
+}
+
+bool buzzer_sound_is_playing(buzzer_sound_t *sound) {
+    if (!sound) return false;
+    uint32_t requests = atomic_load(&sound->requests);
+    if (requests & BUZZER_SOUND_REQ_PLAY) return true;
+    return !(requests & BUZZER_SOUND_REQ_STOP) && (sound->melody != NULL || sound->pattern != NULL ||
+                                                   sound->morse != NULL);
+}
+
+// Private functions
+
+/**
+ * Callback of the sound's timer. Applies the pending requests, and then advances the melody: either the gate of the
+ * current note is reached and the buzzer is silenced, or the note ends and the next one is started. Patterns advance
+ * to their next run, and Morse code to its next element or space, instead.
+ * @param arg Sound the timer belongs to
+ */
+static void buzzer_sound_timer_cb(void *arg) {
+    buzzer_sound_t *sound = arg;
+
+    // The play request is taken along with its flag, so it's never a mix of two requests
+    buzzer_sound_play_t play = {0};
+    portENTER_CRITICAL(&sound->request_lock);
+    uint32_t requests = atomic_fetch_and(&sound->requests, ~(BUZZER_SOUND_REQ_PLAY | BUZZER_SOUND_REQ_STOP));
+    if (requests & BUZZER_SOUND_REQ_PLAY) play = sound->request;
+    portEXIT_CRITICAL(&sound->request_lock);
+
+    if (requests & (BUZZER_SOUND_REQ_STOP | BUZZER_SOUND_REQ_RELEASE)) {
+        sound->melody = NULL;
+        sound->pattern = NULL;
+        sound->morse = NULL;
+        buzzer_pause(sound->buzzer);
+        buzzer_sound_restore_duty(sound);
+    }
+    if (requests & BUZZER_SOUND_REQ_RELEASE) {
+        atomic_fetch_or(&sound->requests, BUZZER_SOUND_RELEASED); // The sound may be freed from now on
+        return;
+    }
+    bool playing = sound->melody || sound->pattern || sound->morse;
+    if (!(requests & BUZZER_SOUND_REQ_PLAY) && playing && esp_timer_get_time() < sound->fire_us) {
+        // Fired by a control function whose request an earlier firing already applied (see buzzer_sound_request):
+        // there's nothing to do until the time the timer was armed for
+        buzzer_sound_arm(sound, sound->fire_us);
+        return;
+    }
+    if (requests & BUZZER_SOUND_REQ_PLAY) {
+        const buzzer_melody_t *melody = play.melody;
+        const buzzer_pattern_t *pattern = play.pattern;
+        const buzzer_morse_t *morse = play.morse;
+        sound->melody = melody;
+        sound->pattern = pattern;
+        sound->morse = morse;
+        sound->done = play.done;
+        sound->arg = play.arg;
+        sound->note = 0;
+        sound->gate_pending = false;
+        sound->morse_code = 0;
+        sound->deadline_us = esp_timer_get_time();
+        buzzer_sound_restore_duty(sound); // In case a melody with a duty was cut short by this one
+        if (melody) {
+            sound->bpm = (uint16_t) play.bpm;
+            sound->loops_left = melody->loop_start < melody->loop_end ? melody->loop_count : 0;
+            if (melody->duty) {
+                sound->restore_duty = buzzer_get_duty(sound->buzzer);
+                buzzer_set_duty(sound->buzzer, melody->duty);
+            }
+        } else if (pattern) {
+            sound->loops_left = pattern->repeat == BUZZER_PATTERN_FOREVER ? BUZZER_LOOP_FOREVER : pattern->repeat;
+            if (pattern->freq_hz) buzzer_set_freq(sound->buzzer, pattern->freq_hz);
+        } else if (morse->freq_hz) {
+            buzzer_set_freq(sound->buzzer, morse->freq_hz);
+        }
+    }
+    if (sound->pattern) {
+        buzzer_sound_next_run(sound);
+        return;
+    }
+    if (sound->morse) {
+        buzzer_sound_next_morse(sound);
+        return;
+    }
+    if (!sound->melody) return;
+
+    if (sound->gate_pending) {
+        sound->gate_pending = false;
+        buzzer_pause(sound->buzzer);
+        buzzer_sound_arm(sound, sound->deadline_us);
+        return;
+    }
+    buzzer_sound_next(sound);
+}
+
+/**
+ * Leaves a request for the callback and fires the timer right away, so the request is applied from the esp_timer task.
+ * Play requests are stored under the request lock along with their flag, replacing any play request still pending.
+ *
+ * @details The timer may fire on its own between the request being left and the timer being stopped. That firing
+ * applies the request and arms the timer for the end of the note it starts, and the firing started here comes before
+ * that time with no request left, so the callback ignores it and arms the timer again.
+ * @param sound Sound the request is for
+ * @param request Request, as a BUZZER_SOUND_REQ_* flag
+ * @param play What to start for BUZZER_SOUND_REQ_PLAY, or NULL for other requests
+ */
+static void buzzer_sound_request(buzzer_sound_t *sound, uint32_t request, const buzzer_sound_play_t *play) {
+    if (play) {
+        portENTER_CRITICAL(&sound->request_lock);
+        sound->request = *play;
+        atomic_fetch_or(&sound->requests, request);
+        portEXIT_CRITICAL(&sound->request_lock);
+    } else {
+        atomic_fetch_or(&sound->requests, request);
+    }
+    buzzer_timer_fire_now(sound->timer);
+}
+
+/**
+ * Starts the next note of the melody, or finishes the melody if there are no notes left.
+ * @param sound Sound whose melody is being played
+ */
+static void buzzer_sound_next(buzzer_sound_t *sound) {
+    const buzzer_melody_t *melody = sound->melody;
+    if (sound->note == melody->loop_end && sound->loops_left > 0) {
+        // Jumping back to the start of the loop is just another note boundary, so the deadlines keep accumulating
+        sound->note = melody->loop_start;
+        if (sound->loops_left != BUZZER_LOOP_FOREVER) sound->loops_left--;
+    }
+    if (sound->note >= melody->length) {
+        buzzer_sound_finish(sound);
+        return;
+    }
+
+    // The variant is read at every note, and the transposition is only prepared again when it changes
+    uint32_t variant = atomic_load(&sound->variant);
+    if (variant != sound->variant_applied) {
+        buzzer_transpose_init(&sound->transpose, (int16_t) (variant >> BUZZER_SOUND_TRANSPOSE_SHIFT));
+        sound->variant_applied = variant;
+    }
+    uint32_t tempo = variant & BUZZER_SOUND_TEMPO_MASK;
+
+    const buzzer_musical_note_t *note = &melody->melody[sound->note++];
+    uint32_t duration_ms = buzzer_note_type_to_ms(note->type, sound->bpm);
+    int64_t start_us = sound->deadline_us;
+    sound->deadline_us += (int64_t) duration_ms * 1000 * BUZZER_TEMPO_NORMAL / tempo;
+
+    if (note->note == BUZZER_NOTE_REST) {
+        buzzer_pause(sound->buzzer);
+        buzzer_sound_arm(sound, sound->deadline_us);
+        return;
+    }
+
+    buzzer_set_transposed_note(sound->buzzer, note->note, note->octave, &sound->transpose);
+    buzzer_play(sound->buzzer);
+    uint32_t gate_ms = buzzer_gate_to_ms(duration_ms, note->gate ? note->gate : melody->gate);
+    if (gate_ms < duration_ms) {
+        sound->gate_pending = true;
+        buzzer_sound_arm(sound, start_us + (int64_t) gate_ms * 1000 * BUZZER_TEMPO_NORMAL / tempo);
+    } else {
+        buzzer_sound_arm(sound, sound->deadline_us);
+    }
+}
+
+/**
+ * Starts the next run of equal units of the pattern, or finishes the pattern if there are no repetitions left. Runs
+ * are found with a bit scan, so the cost doesn't depend on their length.
+ * @param sound Sound whose pattern is being played
+ */
+static void buzzer_sound_next_run(buzzer_sound_t *sound) {
+    const buzzer_pattern_t *pattern = sound->pattern;
+    if (sound->note >= pattern->length) {
+        if (sound->loops_left != BUZZER_LOOP_FOREVER && --sound->loops_left == 0) {
+            buzzer_sound_finish(sound);
+            return;
+        }
+        sound->note = 0;
+    }
+
+    uint32_t left = pattern->length - sound->note;
+    uint32_t units = pattern->bits >> sound->note;
+    bool on = units & 1u;
+    uint32_t changes = on ? ~units : units; // The run ends at the first unit which differs from the current one
+    uint32_t run = changes ? (uint32_t) __builtin_ctz(changes) : left;
+    if (run > left) run = left;
+
+    sound->note += run;
+    sound->deadline_us += (int64_t) run * pattern->unit_ms * 1000;
+    if (on) {
+        buzzer_play(sound->buzzer);
+    } else {
+        buzzer_pause(sound->buzzer);
+    }
+    buzzer_sound_arm(sound, sound->deadline_us);
+}
+
+/**
+ * Advances the Morse transmission: either the current element ends and is followed by the right space, or the next
+ * element is started. The next character is only read when the current one ends, as its space depends on it.
+ * @param sound Sound whose Morse transmission is being sent
+ */
+static void buzzer_sound_next_morse(buzzer_sound_t *sound) {
+    const buzzer_morse_t *morse = sound->morse;
+    bool word_gap = false;
+
+    if (sound->gate_pending) {
+        sound->gate_pending = false;
+        buzzer_pause(sound->buzzer);
+        buzzer_morse_timing_t gap = BUZZER_MORSE_ELEMENT_GAP;
+        if (sound->morse_code <= 1) {
+            // The character is over, so the space depends on what comes next
+            sound->morse_code = buzzer_sound_read_morse(sound, &word_gap);
+            if (!sound->morse_code) {
+                buzzer_sound_finish(sound); // Nothing is left, so there's no point in waiting for the space
+                return;
+            }
+            gap = word_gap ? BUZZER_MORSE_WORD_GAP : BUZZER_MORSE_CHAR_GAP;
+        }
+        sound->deadline_us += buzzer_morse_duration_us(morse, gap);
+        buzzer_sound_arm(sound, sound->deadline_us);
+        return;
+    }
+
+    if (sound->morse_code <= 1) {
+        // First character of the transmission, which is started right away even after leading spaces
+        sound->morse_code = buzzer_sound_read_morse(sound, &word_gap);
+        if (!sound->morse_code) {
+            buzzer_sound_finish(sound);
+            return;
+        }
+    }
+    bool dah = sound->morse_code & 1u;
+    sound->morse_code >>= 1u;
+    sound->gate_pending = true;
+    sound->deadline_us += buzzer_morse_duration_us(morse, dah ? BUZZER_MORSE_DAH : BUZZER_MORSE_DIT);
+    buzzer_play(sound->buzzer);
+    buzzer_sound_arm(sound, sound->deadline_us);
+}
+
+/**
+ * Reads characters from the Morse transmission until one with a code is found.
+ * @param sound Sound whose Morse transmission is being sent
+ * @param word_gap Set to true if a space was skipped on the way
+ * @return Code of the character, or 0 if there are no characters left
+ */
+static uint8_t buzzer_sound_read_morse(buzzer_sound_t *sound, bool *word_gap) {
+    const buzzer_morse_t *morse = sound->morse;
+    for (;;) {
+        char c = morse->text ? morse->text[sound->note] : morse->source(morse->source_arg);
+        if (c == '\0') return 0;
+        if (morse->text) sound->note++;
+
+        uint8_t code = buzzer_morse_encode(c);
+        if (code) return code;
+        if (c == ' ') *word_gap = true;
+    }
+}
+
+/**
+ * Finishes the melody or pattern being played, silencing the buzzer and letting the user know.
+ * @param sound Sound which finished
+ */
+static void buzzer_sound_finish(buzzer_sound_t *sound) {
+    sound->melody = NULL;
+    sound->pattern = NULL;
+    sound->morse = NULL;
+    buzzer_pause(sound->buzzer);
+    buzzer_sound_restore_duty(sound);
+    if (sound->done) sound->done(sound, sound->arg);
+}
+
+/**
+ * Sets the buzzer back to the duty it had before the melody set its own, if it did, so later melodies and patterns
+ * without a duty don't inherit it.
+ * @param sound Sound whose melody ended or was stopped
+ */
+static void buzzer_sound_restore_duty(buzzer_sound_t *sound) {
+    if (!sound->restore_duty) return;
+    buzzer_set_duty(sound->buzzer, sound->restore_duty);
+    sound->restore_duty = 0;
+}
+
+/**
+ * Arms the timer to fire at the provided time, or right away if it has already passed.
+ * @param sound Sound whose timer must be armed
+ * @param at_us Time to fire at, in the esp_timer time base (microseconds)
+ */
+static void buzzer_sound_arm(buzzer_sound_t *sound, int64_t at_us) {
+    sound->fire_us = at_us;
+    int64_t wait_us = at_us - esp_timer_get_time();
+    esp_timer_start_once(sound->timer, wait_us > 0 ? (uint64_t) wait_us : 0);
+}
+
+/**
+ * Replaces part of the variant word, which the callback reads at the next note. Only one task controls a sound, so
+ * there are no concurrent writers, and the callback always sees either the old or the new word.
+ * @param sound Sound whose variant must be changed
+ * @param mask Bits of the variant word to replace
+ * @param value New value of those bits
+ */
+static void buzzer_sound_set_variant(buzzer_sound_t *sound, uint32_t mask, uint32_t value) {
+    uint32_t variant = atomic_load(&sound->variant);
+    atomic_store(&sound->variant, (variant & ~mask) | (value & mask));
+}
@@ -0,0 +1,42 @@
+/**
+ * @file buzzer_timer_task.h
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Private header with the pieces of the esp_timer task shared by the callback engines: telling whether the
+ * caller runs in the task, which they need to know before waiting for their own callbacks (as those can't run while
+ * the task is blocked waiting for them), and firing their timers right away so a request is applied.
+ */
+
+#ifndef GYRO_READER_BUZZER_TIMER_TASK_H
+#define GYRO_READER_BUZZER_TIMER_TASK_H
+
+#include <stdbool.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+
+#define BUZZER_TIMER_TASK_NAME "esp_timer" ///< Name of the task esp_timer dispatches its callbacks from
+
+/**
+ * Checks whether the caller runs in the esp_timer task, that is, from an esp_timer callback.
+ * @return Whether the calling task is the esp_timer task
+ */
+static inline bool buzzer_in_timer_task(void) {
+    return strcmp(pcTaskGetName(NULL), BUZZER_TIMER_TASK_NAME) == 0;
+}
+
+/**
+ * Fires a one-shot timer right away, whether it's armed or not, so its callback applies the request left for it.
+ *
+ * @details If the callback is running and arms the timer between the stop and the start, starting it fails, so both
+ * are repeated until the timer is set to fire right away.
+ * @param timer Timer to fire
+ */
+static inline void buzzer_timer_fire_now(esp_timer_handle_t timer) {
+    do {
+        esp_timer_stop(timer);
+    } while (esp_timer_start_once(timer, 0) == ESP_ERR_INVALID_STATE);
+}
+
+#endif //GYRO_READER_BUZZER_TIMER_TASK_H
@@ -0,0 +1,178 @@
+/**
+ * @file buzzer_trace.c
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the definitions for the trace recorder. Everything is compiled out unless
+ * BUZZER_TRACE_ENABLE is set.
+ */
+
+#include "buzzer/buzzer_trace.h"
+
+#if BUZZER_TRACE_ENABLE
+
+#include "freertos/FreeRTOS.h"
+#include <esp_timer.h>
+#include "buzzer_cycles.h"
+
+#define BUZZER_TRACE_MAX_CYCLE_SKEW_US 2 ///< Difference between the cycle and microsecond clocks above which the
+                                         ///< cycles are considered unusable (wrapped, other core or DFS)
+#define BUZZER_TRACE_VCD_SIGNALS 3 ///< Signals per buzzer in the VCD dump (playing, frequency and deadline)
+#define BUZZER_TRACE_VCD_FIRST_ID '!' ///< First printable character used as a VCD signal identifier
+
+static const char *trace_event_names[] = {"freq", "play", "pause", "deadline"}; ///< Names used in the CSV dump
+
+static buzzer_trace_record_t trace_records[BUZZER_TRACE_LEN]; ///< Ring buffer with the recorded events
+static uint32_t trace_next = 0; ///< Total amount of events recorded, the next one goes at trace_next % length
+static portMUX_TYPE trace_lock = portMUX_INITIALIZER_UNLOCKED; ///< Protects the ring buffer
+static buzzer_trace_record_t trace_dump_records[BUZZER_TRACE_LEN]; ///< Copy of the events being dumped, so the lock
+                                                                  ///< isn't held while writing. Dumps aren't reentrant.
+
+// Private function declarations
+static int buzzer_trace_source_index(const void **sources, uint32_t *count, const void *source);
+static uint64_t buzzer_trace_advance_ns(const buzzer_trace_record_t *prev, const buzzer_trace_record_t *cur);
+
+// Public functions
+
+void buzzer_trace_record(buzzer_trace_event_t event, const void *source, uint32_t value) {
+    uint32_t time_us = (uint32_t) esp_timer_get_time();
+    portENTER_CRITICAL_SAFE(&trace_lock);
+    buzzer_trace_record_t *record = &trace_records[trace_next % BUZZER_TRACE_LEN];
+    record->cycles = BUZZER_CYCLES();
+    record->time_us = time_us;
+    record->source = source;
+    record->value = value;
+    record->event = event;
+    record->core = xPortGetCoreID();
+    trace_next++;
+    portEXIT_CRITICAL_SAFE(&trace_lock);
+}
+
+void buzzer_trace_clear(void) {
+    portENTER_CRITICAL_SAFE(&trace_lock);
+    trace_next = 0;
+    portEXIT_CRITICAL_SAFE(&trace_lock);
+}
+
+uint32_t buzzer_trace_get(buzzer_trace_record_t *records, uint32_t max) {
+    if (!records) return 0;
+
+    portENTER_CRITICAL_SAFE(&trace_lock);
+    uint32_t count = trace_next < BUZZER_TRACE_LEN ? trace_next : BUZZER_TRACE_LEN;
+    if (count > max) count = max;
+    uint32_t first = trace_next - count; // Copy the newest events that fit
+    for (uint32_t i = 0; i < count; i++) records[i] = trace_records[(first + i) % BUZZER_TRACE_LEN];
+    portEXIT_CRITICAL_SAFE(&trace_lock);
+    return count;
+}
+
+esp_err_t buzzer_trace_dump_csv(FILE *out) {
+    if (!out) return ESP_FAIL;
+
+    buzzer_trace_record_t *records = trace_dump_records;
+    uint32_t count = buzzer_trace_get(records, BUZZER_TRACE_LEN);
+    const void *sources[BUZZER_TRACE_MAX_SOURCES];
+    uint32_t source_count = 0;
+
+    fprintf(out, "time_ns,cycles,time_us,core,buzzer,event,value\n");
+    uint64_t time_ns = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const buzzer_trace_record_t *record = &records[i];
+        if (i > 0) time_ns += buzzer_trace_advance_ns(&records[i - 1], record);
+        fprintf(out, "%llu,%u,%u,%u,%d,%s,%u\n", (unsigned long long) time_ns, (unsigned) record->cycles,
+                (unsigned) record->time_us, record->core, buzzer_trace_source_index(sources, &source_count,
+                                                                                    record->source),
+                trace_event_names[record->event], (unsigned) record->value);
+    }
+    return ferror(out) ? ESP_FAIL : ESP_OK;
+}
+
+esp_err_t buzzer_trace_dump_vcd(FILE *out) {
+    if (!out) return ESP_FAIL;
+
+    buzzer_trace_record_t *records = trace_dump_records;
+    uint32_t count = buzzer_trace_get(records, BUZZER_TRACE_LEN);
+    const void *sources[BUZZER_TRACE_MAX_SOURCES];
+    uint32_t source_count = 0;
+
+    // The signals must be declared before any value change, so find every buzzer appearing in the trace first
+    for (uint32_t i = 0; i < count; i++) buzzer_trace_source_index(sources, &source_count, records[i].source);
+
+    fprintf(out, "$timescale 1 ns $end\n$scope module buzzer $end\n");
+    for (uint32_t i = 0; i < source_count; i++) {
+        char id = (char) (BUZZER_TRACE_VCD_FIRST_ID + i * BUZZER_TRACE_VCD_SIGNALS);
+        fprintf(out, "$var wire 1 %c playing%u $end\n", id, (unsigned) i);
+        fprintf(out, "$var integer 32 %c freq%u $end\n", id + 1, (unsigned) i);
+        fprintf(out, "$var event 1 %c deadline%u $end\n", id + 2, (unsigned) i);
+    }
+    fprintf(out, "$upscope $end\n$enddefinitions $end\n");
+
+    uint64_t time_ns = 0, last_ns = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const buzzer_trace_record_t *record = &records[i];
+        if (i > 0) time_ns += buzzer_trace_advance_ns(&records[i - 1], record);
+        if (i == 0 || time_ns != last_ns) fprintf(out, "#%llu\n", (unsigned long long) time_ns);
+        last_ns = time_ns;
+
+        int index = buzzer_trace_source_index(sources, &source_count, record->source);
+        if (index < 0) continue; // Too many buzzers, this one wasn't declared
+        char id = (char) (BUZZER_TRACE_VCD_FIRST_ID + index * BUZZER_TRACE_VCD_SIGNALS);
+        switch (record->event) {
+            case BUZZER_TRACE_PLAY:
+                fprintf(out, "1%c\n", id);
+                break;
+            case BUZZER_TRACE_PAUSE:
+                fprintf(out, "0%c\n", id);
+                break;
+            case BUZZER_TRACE_FREQ:
+                fprintf(out, "b");
+                for (int bit = 31; bit >= 0; bit--) fputc((record->value >> bit) & 1u ? '1' : '0', out);
+                fprintf(out, " %c\n", id + 1);
+                break;
+            case BUZZER_TRACE_DEADLINE:
+                fprintf(out, "1%c\n", id + 2);
+                break;
+        }
+    }
+    return ferror(out) ? ESP_FAIL : ESP_OK;
+}
+
+// Private functions
+
+/**
+ * Returns the index of a buzzer among the ones seen so far in a dump, adding it if it's new.
+ * @param sources Buzzers seen so far
+ * @param count Amount of buzzers seen so far, updated if the buzzer is added
+ * @param source Buzzer to look for
+ * @return Index of the buzzer, or -1 if it's new but there's no room for more
+ */
+static int buzzer_trace_source_index(const void **sources, uint32_t *count, const void *source) {
+    for (uint32_t i = 0; i < *count; i++) {
+        if (sources[i] == source) return (int) i;
+    }
+    if (*count == BUZZER_TRACE_MAX_SOURCES) return -1;
+    sources[*count] = source;
+    return (int) (*count)++;
+}
+
+/**
+ * Calculates the time elapsed between two consecutive events. The cycle counter is used when it agrees with the
+ * microsecond clock, and the microsecond clock otherwise (when the cycle counter wrapped, the events were recorded
+ * from different cores, or the CPU frequency was scaled).
+ * @param prev Older event
+ * @param cur Newer event
+ * @return Nanoseconds between both events
+ */
+static uint64_t buzzer_trace_advance_ns(const buzzer_trace_record_t *prev, const buzzer_trace_record_t *cur) {
+    uint32_t elapsed_us = cur->time_us - prev->time_us;
+    uint32_t elapsed_cycles = cur->cycles - prev->cycles;
+    uint64_t cycles_ns = BUZZER_CYCLES_TO_NS(elapsed_cycles);
+
+    int64_t skew_us = (int64_t) (cycles_ns / 1000u) - elapsed_us;
+    if (cur->core == prev->core && skew_us <= BUZZER_TRACE_MAX_CYCLE_SKEW_US &&
+        skew_us >= -BUZZER_TRACE_MAX_CYCLE_SKEW_US) {
+        return cycles_ns;
+    }
+    return (uint64_t) elapsed_us * 1000u;
+}
+
+#endif
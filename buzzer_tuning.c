@@ -0,0 +1,184 @@
+/**
+ * @file buzzer_tuning.c
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the definitions for the tuning functions, which model the LEDC timer divider.
+ */
+
+#include <stdint.h>
+#include <math.h>
+#include "buzzer/buzzer_tuning.h"
+
+#define BUZZER_TUNING_CENTS_PER_OCTAVE 1200.0 ///< Cents in an octave
+#define BUZZER_TUNING_MAX_RES_BITS 20u ///< Highest duty resolution considered when looking for the best combination
+#define BUZZER_TUNING_SEARCH_SPAN 2 ///< Whole frequencies tried at each side of the target in best_request
+
+/**
+ * Array with the clock sources considered when looking for the best combination. The RTC8M clock isn't included, as
+ * its frequency varies between chips and with temperature.
+ */
+static const ledc_clk_cfg_t tuning_clk_sources[] = {
+        LEDC_USE_APB_CLK,
+        LEDC_USE_REF_TICK
+};
+
+/**
+ * Array with the clock sources considered when looking for the cheapest one, from the cheapest to the most expensive
+ */
+static const ledc_clk_cfg_t tuning_cost_order[] = {
+        BUZZER_TUNING_RTC8M_CLK,
+        LEDC_USE_REF_TICK,
+        LEDC_USE_APB_CLK
+};
+
+// Public functions
+
+uint32_t buzzer_tuning_clk_hz(ledc_clk_cfg_t clk_cfg) {
+    switch (clk_cfg) {
+        case LEDC_AUTO_CLK:
+        case LEDC_USE_APB_CLK:
+            return BUZZER_TUNING_APB_CLK_HZ;
+        case LEDC_USE_REF_TICK:
+            return BUZZER_TUNING_REF_TICK_HZ;
+        case BUZZER_TUNING_RTC8M_CLK:
+            return BUZZER_TUNING_RTC8M_HZ;
+        default:
+            return 0;
+    }
+}
+
+uint32_t buzzer_tuning_divider(uint32_t clk_hz, uint8_t duty_res_bits, uint32_t freq_hz) {
+    if (clk_hz == 0 || freq_hz == 0 || duty_res_bits == 0 || duty_res_bits > BUZZER_TUNING_MAX_RES_BITS) return 0;
+
+    // Same rounding the LEDC driver uses
+    uint64_t precision = (uint64_t) freq_hz << duty_res_bits;
+    uint64_t divider = (((uint64_t) clk_hz << BUZZER_TUNING_DIV_FRAC_BITS) + precision / 2) / precision;
+    if (divider < BUZZER_TUNING_DIV_MIN || divider > BUZZER_TUNING_DIV_MAX) return 0;
+    return (uint32_t) divider;
+}
+
+double buzzer_tuning_actual_freq(ledc_clk_cfg_t clk_cfg, uint8_t duty_res_bits, uint32_t freq_hz) {
+    uint32_t clk_hz = buzzer_tuning_clk_hz(clk_cfg);
+    uint32_t divider = buzzer_tuning_divider(clk_hz, duty_res_bits, freq_hz);
+    if (divider == 0) return 0;
+    return ((double) clk_hz * BUZZER_TUNING_DIV_MIN) / ((double) divider * (double) (1ull << duty_res_bits));
+}
+
+double buzzer_tuning_error_cents(double target_hz, double actual_hz) {
+    if (target_hz <= 0 || actual_hz <= 0) return 0;
+    return BUZZER_TUNING_CENTS_PER_OCTAVE * log2(actual_hz / target_hz);
+}
+
+uint32_t buzzer_tuning_best_request(ledc_clk_cfg_t clk_cfg, uint8_t duty_res_bits, double target_hz) {
+    if (target_hz < 1) return 0;
+
+    // The candidates are compared by their ratio to the target rather than their difference in Hz: in the low octaves
+    // a whole Hz is dozens of cents, and candidates at both sides of the target can be as far in Hz but not in cents
+    uint32_t best = 0;
+    double best_diff = 0;
+    int64_t center = (int64_t) (target_hz + 0.5);
+    for (int64_t freq = center - BUZZER_TUNING_SEARCH_SPAN; freq <= center + BUZZER_TUNING_SEARCH_SPAN; freq++) {
+        if (freq <= 0) continue;
+        double actual = buzzer_tuning_actual_freq(clk_cfg, duty_res_bits, (uint32_t) freq);
+        if (actual == 0) continue;
+        double diff = fabs(log(actual / target_hz));
+        if (best == 0 || diff < best_diff) {
+            best = (uint32_t) freq;
+            best_diff = diff;
+        }
+    }
+    return best;
+}
+
+esp_err_t buzzer_tuning_evaluate(ledc_clk_cfg_t clk_cfg, uint8_t duty_res_bits, uint8_t min_octave,
+                                 uint8_t max_octave, buzzer_tuning_result_t *result) {
+    if (!result || min_octave > max_octave || max_octave > 8) return ESP_FAIL;
+
+    result->clk_cfg = clk_cfg;
+    result->duty_res_bits = duty_res_bits;
+    result->max_error_cents = 0;
+    result->mean_error_cents = 0;
+
+    uint32_t notes = 0;
+    for (uint8_t octave = min_octave; octave <= max_octave; octave++) {
+        for (buzzer_note_t note = BUZZER_NOTE_C; note < BUZZER_NOTE_MAX; note++) {
+            double target = buzzer_get_note_freq(note, octave);
+            uint32_t request = buzzer_tuning_best_request(clk_cfg, duty_res_bits, target);
+            if (request == 0) return ESP_FAIL; // This note can't be played with this combination
+
+            double actual = buzzer_tuning_actual_freq(clk_cfg, duty_res_bits, request);
+            double error = fabs(buzzer_tuning_error_cents(target, actual));
+            if (error > result->max_error_cents) result->max_error_cents = error;
+            result->mean_error_cents += error;
+            notes++;
+        }
+    }
+    result->mean_error_cents /= notes;
+    return ESP_OK;
+}
+
+esp_err_t buzzer_tuning_find_best(uint8_t min_octave, uint8_t max_octave, uint8_t min_duty_res_bits,
+                                  buzzer_tuning_result_t *best) {
+    if (!best || min_duty_res_bits == 0) return ESP_FAIL;
+
+    bool found = false;
+    for (uint32_t i = 0; i < sizeof(tuning_clk_sources) / sizeof(tuning_clk_sources[0]); i++) {
+        for (uint8_t bits = min_duty_res_bits; bits <= BUZZER_TUNING_MAX_RES_BITS; bits++) {
+            buzzer_tuning_result_t result;
+            if (buzzer_tuning_evaluate(tuning_clk_sources[i], bits, min_octave, max_octave, &result) != ESP_OK) {
+                continue;
+            }
+            // Higher resolutions are visited later, so ties are resolved in their favour
+            if (!found || result.max_error_cents <= best->max_error_cents) {
+                *best = result;
+                found = true;
+            }
+        }
+    }
+    return found ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t buzzer_tuning_characterize(ledc_clk_cfg_t clk_cfg, uint8_t duty_res_bits, uint8_t min_octave,
+                                     uint8_t max_octave, buzzer_tuning_source_t *report) {
+    uint32_t clk_hz = buzzer_tuning_clk_hz(clk_cfg);
+    if (!report || clk_hz == 0 || duty_res_bits == 0 || duty_res_bits > BUZZER_TUNING_MAX_RES_BITS) return ESP_FAIL;
+
+    double precision = (double) (1ull << duty_res_bits);
+    report->clk_cfg = clk_cfg;
+    report->duty_res_bits = duty_res_bits;
+    report->min_freq_hz = ((double) clk_hz * BUZZER_TUNING_DIV_MIN) / (BUZZER_TUNING_DIV_MAX * precision);
+    report->max_freq_hz = (double) clk_hz / precision;
+    report->clk_error_cents = clk_cfg == BUZZER_TUNING_RTC8M_CLK
+                              ? BUZZER_TUNING_CENTS_PER_OCTAVE * log2(1 + BUZZER_TUNING_RTC8M_TOLERANCE) : 0;
+    // APB (and the automatic clock, which picks it) follows DFS; REF_TICK is kept at 1 MHz and RTC8M is independent
+    report->dfs_stable = clk_cfg != LEDC_AUTO_CLK && clk_cfg != LEDC_USE_APB_CLK;
+
+    buzzer_tuning_result_t result;
+    esp_err_t ret = buzzer_tuning_evaluate(clk_cfg, duty_res_bits, min_octave, max_octave, &result);
+    report->max_error_cents = ret == ESP_OK ? result.max_error_cents + report->clk_error_cents : 0;
+    report->mean_error_cents = ret == ESP_OK ? result.mean_error_cents : 0;
+    return ret;
+}
+
+esp_err_t buzzer_tuning_find_cheapest(uint8_t min_octave, uint8_t max_octave, double max_error_cents,
+                                      buzzer_tuning_source_t *cheapest) {
+    if (!cheapest) return ESP_FAIL;
+
+    for (uint32_t i = 0; i < sizeof(tuning_cost_order) / sizeof(tuning_cost_order[0]); i++) {
+        bool found = false;
+        for (uint8_t bits = 1; bits <= BUZZER_TUNING_MAX_RES_BITS; bits++) {
+            buzzer_tuning_source_t report;
+            if (buzzer_tuning_characterize(tuning_cost_order[i], bits, min_octave, max_octave, &report) != ESP_OK) {
+                continue;
+            }
+            // Higher resolutions are visited later, so ties are resolved in their favour
+            if (report.max_error_cents <= max_error_cents &&
+                (!found || report.max_error_cents <= cheapest->max_error_cents)) {
+                *cheapest = report;
+                found = true;
+            }
+        }
+        if (found) return ESP_OK;
+    }
+    return ESP_FAIL;
+}
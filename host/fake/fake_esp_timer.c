@@ -0,0 +1,188 @@
+/**
+ * @file fake_esp_timer.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief File containing the esp_timer stand-in. Like in ESP-IDF, callbacks run one after another on a task of their
+ * own, in the order of their alarms (and of their arming, for equal alarms).
+ */
+
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "fake_sim.h"
+#include "fake_sim_internal.h"
+
+#define FAKE_TIMER_MAX 64 ///< Timers that can exist at the same time
+#define FAKE_TIMER_TASK_STACK 3584 ///< Stack of the esp_timer task, the default of ESP-IDF
+
+/**
+ * Timer of the stand-in
+ */
+struct esp_timer {
+    bool used; ///< Whether the slot holds a timer
+    bool armed; ///< Whether the timer is waiting to fire
+    esp_timer_cb_t callback; ///< Function to call when it fires
+    void *arg; ///< Argument of the function
+    int64_t alarm_us; ///< Time it fires at, while armed
+    uint64_t seq; ///< Order it was armed in, to fire equal alarms in order
+};
+
+static struct esp_timer timer_pool[FAKE_TIMER_MAX]; ///< Pool of timers
+static TaskHandle_t timer_task; ///< Task running the callbacks, created with the first timer
+static uint64_t timer_seq; ///< Arming counter
+static bool timer_busy; ///< Whether a callback is running
+static int timer_list; ///< Object the timer task waits on for changes to the timers
+static int timer_flushed; ///< Object woken up whenever the timer task finishes a callback or goes idle
+static void (*timer_stop_hook)(esp_timer_handle_t timer, void *arg); ///< Function called by esp_timer_stop
+static void *timer_stop_hook_arg; ///< Argument of the stop hook
+static void (*timer_start_hook)(esp_timer_handle_t timer, void *arg); ///< Function called by esp_timer_start_once
+static void *timer_start_hook_arg; ///< Argument of the start hook
+
+// Private function declarations
+
+static struct esp_timer *fake_timer_next(void);
+
+static void fake_timer_task(void *arg);
+
+// Public functions
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle) {
+    if (!create_args || !create_args->callback || !out_handle) return ESP_ERR_INVALID_ARG;
+
+    // Created outside the simulator lock, as creating a task takes it
+    if (!timer_task && xTaskCreate(fake_timer_task, "esp_timer", FAKE_TIMER_TASK_STACK, NULL, 22,
+                                   &timer_task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    fake_sim_lock();
+    for (uint32_t i = 0; i < FAKE_TIMER_MAX; i++) {
+        struct esp_timer *timer = &timer_pool[i];
+        if (timer->used) continue;
+        timer->used = true;
+        timer->armed = false;
+        timer->callback = create_args->callback;
+        timer->arg = create_args->arg;
+        *out_handle = timer;
+        fake_sim_unlock();
+        return ESP_OK;
+    }
+    fake_sim_unlock();
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    if (timer_start_hook) timer_start_hook(timer, timer_start_hook_arg);
+    fake_sim_lock();
+    if (timer->armed) {
+        fake_sim_unlock();
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->armed = true;
+    timer->alarm_us = fake_sim_now_us() + (int64_t) timeout_us;
+    timer->seq = timer_seq++;
+    fake_sim_wake(&timer_list);
+    fake_sim_unlock();
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    if (timer_stop_hook) timer_stop_hook(timer, timer_stop_hook_arg);
+    fake_sim_lock();
+    esp_err_t ret = timer->armed ? ESP_OK : ESP_ERR_INVALID_STATE;
+    timer->armed = false;
+    fake_sim_unlock();
+    return ret;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    fake_sim_lock();
+    if (timer->armed) {
+        fake_sim_unlock();
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->used = false;
+    fake_sim_unlock();
+    return ESP_OK;
+}
+
+int64_t esp_timer_get_time(void) {
+    return fake_sim_now_us();
+}
+
+size_t fake_esp_timer_count(void) {
+    size_t count = 0;
+    fake_sim_lock();
+    for (uint32_t i = 0; i < FAKE_TIMER_MAX; i++) {
+        if (timer_pool[i].used) count++;
+    }
+    fake_sim_unlock();
+    return count;
+}
+
+void fake_esp_timer_flush(void) {
+    fake_sim_lock();
+    for (;;) {
+        struct esp_timer *next = fake_timer_next();
+        if (!timer_busy && (!next || next->alarm_us > fake_sim_now_us())) break;
+        fake_sim_block(&timer_flushed, FAKE_SIM_FOREVER);
+    }
+    fake_sim_unlock();
+}
+
+void fake_esp_timer_set_stop_hook(void (*hook)(esp_timer_handle_t timer, void *arg), void *arg) {
+    timer_stop_hook_arg = arg;
+    timer_stop_hook = hook;
+}
+
+void fake_esp_timer_set_start_hook(void (*hook)(esp_timer_handle_t timer, void *arg), void *arg) {
+    timer_start_hook_arg = arg;
+    timer_start_hook = hook;
+}
+
+// Private functions
+
+/**
+ * Finds the timer which fires next. Must be called with the simulator locked.
+ * @return The armed timer with the earliest alarm, or NULL if none is armed
+ */
+static struct esp_timer *fake_timer_next(void) {
+    struct esp_timer *next = NULL;
+    for (uint32_t i = 0; i < FAKE_TIMER_MAX; i++) {
+        struct esp_timer *timer = &timer_pool[i];
+        if (!timer->used || !timer->armed) continue;
+        if (!next || timer->alarm_us < next->alarm_us ||
+            (timer->alarm_us == next->alarm_us && timer->seq < next->seq)) {
+            next = timer;
+        }
+    }
+    return next;
+}
+
+/**
+ * Task running the callbacks of the timers as they fire, without the simulator locked.
+ * @param arg Unused
+ */
+static void fake_timer_task(void *arg) {
+    (void) arg;
+    fake_sim_lock();
+    for (;;) {
+        struct esp_timer *next = fake_timer_next();
+        if (next && next->alarm_us <= fake_sim_now_us()) {
+            next->armed = false;
+            timer_busy = true;
+            fake_sim_unlock();
+            next->callback(next->arg);
+            fake_sim_lock();
+            timer_busy = false;
+            fake_sim_wake(&timer_flushed);
+            continue;
+        }
+        fake_sim_wake(&timer_flushed);
+        fake_sim_block(&timer_list, next ? next->alarm_us : FAKE_SIM_FOREVER);
+    }
+}
@@ -0,0 +1,442 @@
+/**
+ * @file fake_freertos.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief File containing the host simulator and the FreeRTOS stand-ins built on it. Every task is a thread, and the
+ * simulated clock advances to the earliest timeout whenever the last running task blocks.
+ *
+ * @details Task and semaphore objects come from static pools instead of the heap, so the footprint test only counts
+ * what the library allocates.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "hal/cpu_hal.h"
+#include "fake_sim.h"
+#include "fake_sim_internal.h"
+
+#define FAKE_SIM_MAX_TASKS 64 ///< Tasks that can be alive at the same time
+#define FAKE_SIM_MAX_SEMAPHORES 256 ///< Semaphores that can exist at the same time
+#define FAKE_SIM_NAME_LEN 16 ///< Longest task name kept, including the terminator
+
+/**
+ * Task of the simulator
+ */
+struct fake_task {
+    bool used; ///< Whether the slot holds a task
+    bool counted; ///< Whether its stack is counted by fake_sim_task_stack_bytes
+    bool blocked; ///< Whether the task is blocked
+    bool woken; ///< Whether the last block ended because its object was woken up
+    const void *wait_object; ///< Object the task is waiting on while blocked, if any
+    int64_t wake_us; ///< Time the task wakes up at while blocked, or FAKE_SIM_FOREVER
+    uint32_t notify; ///< Notification value
+    uint32_t stack_bytes; ///< Stack the task was created with
+    UBaseType_t priority; ///< Priority the task was created with
+    BaseType_t core; ///< Core the task was pinned to, or tskNO_AFFINITY
+    char name[FAKE_SIM_NAME_LEN]; ///< Name of the task
+    TaskFunction_t function; ///< Function the task runs
+    void *arg; ///< Argument of the function
+    pthread_cond_t cond; ///< Signalled when the task is unblocked
+};
+
+/**
+ * Semaphore of the simulator
+ */
+struct fake_semaphore {
+    bool used; ///< Whether the slot holds a semaphore
+    uint32_t count; ///< Times it can be taken
+    uint32_t max; ///< Largest count
+};
+
+static pthread_mutex_t sim_mutex = PTHREAD_MUTEX_INITIALIZER; ///< Lock of the simulator
+static pthread_mutex_t sim_critical; ///< Lock shared by every critical section, recursive
+static atomic_llong sim_now_us; ///< Simulated clock
+static uint32_t sim_running; ///< Tasks which aren't blocked
+static struct fake_task sim_tasks[FAKE_SIM_MAX_TASKS]; ///< Pool of tasks
+static struct fake_semaphore sim_semaphores[FAKE_SIM_MAX_SEMAPHORES]; ///< Pool of semaphores
+static __thread struct fake_task *sim_self; ///< Task of the calling thread
+static uint32_t (*_Atomic sim_cycle_source)(void); ///< Source of the cycle counter set by the test, if any
+
+// Private function declarations
+
+static struct fake_task *fake_sim_task_alloc(const char *name, uint32_t stack_bytes);
+
+static struct fake_task *fake_sim_self(void);
+
+static void fake_sim_unblock(struct fake_task *task, bool woken);
+
+static void fake_sim_advance(void);
+
+static void *fake_sim_thread(void *arg);
+
+static SemaphoreHandle_t fake_sim_semaphore_alloc(uint32_t count, uint32_t max);
+
+// Simulator functions
+
+/**
+ * Registers the main thread as a task, before main runs.
+ */
+__attribute__((constructor)) static void fake_sim_init(void) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&sim_critical, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    sim_self = fake_sim_task_alloc("main", 0);
+    sim_self->counted = false;
+    sim_running = 1;
+}
+
+void fake_sim_lock(void) {
+    pthread_mutex_lock(&sim_mutex);
+}
+
+void fake_sim_unlock(void) {
+    pthread_mutex_unlock(&sim_mutex);
+}
+
+bool fake_sim_block(const void *object, int64_t wake_us) {
+    struct fake_task *self = fake_sim_self();
+    self->wait_object = object;
+    self->wake_us = wake_us;
+    self->woken = false;
+    self->blocked = true;
+    if (--sim_running == 0) fake_sim_advance();
+    while (self->blocked) pthread_cond_wait(&self->cond, &sim_mutex);
+    return self->woken;
+}
+
+void fake_sim_wake(const void *object) {
+    for (uint32_t i = 0; i < FAKE_SIM_MAX_TASKS; i++) {
+        struct fake_task *task = &sim_tasks[i];
+        if (task->used && task->blocked && task->wait_object == object) fake_sim_unblock(task, true);
+    }
+}
+
+int64_t fake_sim_now_us(void) {
+    return atomic_load(&sim_now_us);
+}
+
+void fake_sim_sleep_until(int64_t time_us) {
+    fake_sim_lock();
+    while (fake_sim_now_us() < time_us) fake_sim_block(NULL, time_us);
+    fake_sim_unlock();
+}
+
+size_t fake_sim_task_stack_bytes(void) {
+    size_t bytes = 0;
+    fake_sim_lock();
+    for (uint32_t i = 0; i < FAKE_SIM_MAX_TASKS; i++) {
+        if (sim_tasks[i].used && sim_tasks[i].counted) bytes += sim_tasks[i].stack_bytes;
+    }
+    fake_sim_unlock();
+    return bytes;
+}
+
+bool fake_sim_get_task_config(const char *name, fake_sim_task_config_t *config) {
+    bool found = false;
+    fake_sim_lock();
+    for (uint32_t i = 0; i < FAKE_SIM_MAX_TASKS && !found; i++) {
+        struct fake_task *task = &sim_tasks[i];
+        if (!task->used || strcmp(task->name, name) != 0) continue;
+        config->stack_bytes = task->stack_bytes;
+        config->priority = task->priority;
+        config->core = task->core;
+        found = true;
+    }
+    fake_sim_unlock();
+    return found;
+}
+
+// FreeRTOS functions
+
+void vPortEnterCritical(portMUX_TYPE *mux) {
+    (void) mux;
+    pthread_mutex_lock(&sim_critical);
+}
+
+void vPortExitCritical(portMUX_TYPE *mux) {
+    (void) mux;
+    pthread_mutex_unlock(&sim_critical);
+}
+
+BaseType_t xPortGetCoreID(void) {
+    return 0;
+}
+
+uint32_t cpu_hal_get_cycle_count(void) {
+    uint32_t (*source)(void) = atomic_load(&sim_cycle_source);
+    if (source) return source();
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t ns = (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+    return (uint32_t) (ns * FAKE_CPU_HAL_MHZ / 1000u);
+}
+
+void fake_sim_set_cycle_source(uint32_t (*source)(void)) {
+    atomic_store(&sim_cycle_source, source);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_bytes, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *task, BaseType_t core) {
+    if (core != tskNO_AFFINITY && (core < 0 || core >= portNUM_PROCESSORS)) {
+        // ESP-IDF asserts in this case
+        fprintf(stderr, "fake_sim: task %s pinned to core %d, which doesn't exist\n", name ? name : "", core);
+        abort();
+    }
+
+    fake_sim_lock();
+    struct fake_task *created = fake_sim_task_alloc(name, stack_bytes);
+    if (!created) {
+        fake_sim_unlock();
+        return pdFAIL;
+    }
+    created->counted = strcmp(created->name, "esp_timer") != 0;
+    created->priority = priority;
+    created->core = core;
+    created->function = function;
+    created->arg = arg;
+    sim_running++;
+    if (task) *task = created;
+
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, fake_sim_thread, created) != 0) {
+        created->used = false;
+        sim_running--;
+        pthread_attr_destroy(&attr);
+        fake_sim_unlock();
+        return pdFAIL;
+    }
+    pthread_attr_destroy(&attr);
+    fake_sim_unlock();
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_bytes, void *arg,
+                       UBaseType_t priority, TaskHandle_t *task) {
+    return xTaskCreatePinnedToCore(function, name, stack_bytes, arg, priority, task, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    struct fake_task *self = fake_sim_self();
+    if (task && task != self) {
+        fprintf(stderr, "fake_sim: only the calling task can be deleted\n");
+        abort();
+    }
+
+    fake_sim_lock();
+    self->used = false;
+    pthread_cond_destroy(&self->cond);
+    sim_self = NULL;
+    if (--sim_running == 0) fake_sim_advance();
+    fake_sim_unlock();
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    if (ticks == 0) {
+        sched_yield();
+        return;
+    }
+    fake_sim_sleep_until(fake_sim_now_us() + (int64_t) ticks * (1000000 / configTICK_RATE_HZ));
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    fake_sim_lock();
+    task->notify++;
+    fake_sim_wake(&task->notify);
+    fake_sim_unlock();
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+    struct fake_task *self = fake_sim_self();
+    fake_sim_lock();
+    int64_t wake_us = ticks == portMAX_DELAY ? FAKE_SIM_FOREVER :
+                      fake_sim_now_us() + (int64_t) ticks * (1000000 / configTICK_RATE_HZ);
+    while (self->notify == 0) {
+        if (ticks == 0 || !fake_sim_block(&self->notify, wake_us)) break;
+    }
+    uint32_t value = self->notify;
+    if (value) self->notify = clear ? 0 : value - 1;
+    fake_sim_unlock();
+    return value;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    struct fake_task *checked = task ? task : fake_sim_self();
+    return checked->stack_bytes;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return fake_sim_self();
+}
+
+char *pcTaskGetName(TaskHandle_t task) {
+    struct fake_task *checked = task ? task : fake_sim_self();
+    return checked->name;
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t) (fake_sim_now_us() / (1000000 / configTICK_RATE_HZ));
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return fake_sim_semaphore_alloc(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return fake_sim_semaphore_alloc(0, 1);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    fake_sim_lock();
+    int64_t wake_us = ticks == portMAX_DELAY ? FAKE_SIM_FOREVER :
+                      fake_sim_now_us() + (int64_t) ticks * (1000000 / configTICK_RATE_HZ);
+    while (semaphore->count == 0) {
+        if (ticks == 0 || !fake_sim_block(semaphore, wake_us)) break;
+    }
+    BaseType_t taken = semaphore->count ? pdTRUE : pdFALSE;
+    if (taken) semaphore->count--;
+    fake_sim_unlock();
+    return taken;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    fake_sim_lock();
+    BaseType_t given = semaphore->count < semaphore->max ? pdTRUE : pdFALSE;
+    if (given) {
+        semaphore->count++;
+        fake_sim_wake(semaphore);
+    }
+    fake_sim_unlock();
+    return given;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    fake_sim_lock();
+    semaphore->used = false;
+    fake_sim_unlock();
+}
+
+// Private functions
+
+/**
+ * Takes a task from the pool. Must be called with the simulator locked, except from the constructor.
+ * @param name Name of the task
+ * @param stack_bytes Stack the task is created with
+ * @return The task, or NULL if the pool is exhausted
+ */
+static struct fake_task *fake_sim_task_alloc(const char *name, uint32_t stack_bytes) {
+    for (uint32_t i = 0; i < FAKE_SIM_MAX_TASKS; i++) {
+        struct fake_task *task = &sim_tasks[i];
+        if (task->used) continue;
+        memset(task, 0, sizeof(*task));
+        task->used = true;
+        task->counted = true;
+        task->stack_bytes = stack_bytes;
+        task->wake_us = FAKE_SIM_FOREVER;
+        snprintf(task->name, sizeof(task->name), "%s", name ? name : "");
+        pthread_cond_init(&task->cond, NULL);
+        return task;
+    }
+    return NULL;
+}
+
+/**
+ * Returns the task of the calling thread, aborting if the thread isn't one.
+ * @return Task of the calling thread
+ */
+static struct fake_task *fake_sim_self(void) {
+    if (!sim_self) {
+        fprintf(stderr, "fake_sim: called from a thread which isn't a task\n");
+        abort();
+    }
+    return sim_self;
+}
+
+/**
+ * Lets a blocked task run again. Must be called with the simulator locked.
+ * @param task Task to unblock
+ * @param woken Whether its object was woken up, rather than its time reached
+ */
+static void fake_sim_unblock(struct fake_task *task, bool woken) {
+    task->blocked = false;
+    task->woken = woken;
+    sim_running++;
+    pthread_cond_signal(&task->cond);
+}
+
+/**
+ * Moves the clock to the earliest timeout and unblocks the tasks waiting for it. Must be called with the simulator
+ * locked, when no task is running. Aborts if no task has a timeout, as nothing could ever wake them up.
+ */
+static void fake_sim_advance(void) {
+    int64_t earliest = FAKE_SIM_FOREVER;
+    for (uint32_t i = 0; i < FAKE_SIM_MAX_TASKS; i++) {
+        struct fake_task *task = &sim_tasks[i];
+        if (!task->used || !task->blocked || task->wake_us == FAKE_SIM_FOREVER) continue;
+        if (earliest == FAKE_SIM_FOREVER || task->wake_us < earliest) earliest = task->wake_us;
+    }
+
+    if (earliest == FAKE_SIM_FOREVER) {
+        fprintf(stderr, "fake_sim: deadlock at %lld us, every task is blocked forever:\n", (long long) sim_now_us);
+        for (uint32_t i = 0; i < FAKE_SIM_MAX_TASKS; i++) {
+            if (sim_tasks[i].used) fprintf(stderr, "  %s\n", sim_tasks[i].name);
+        }
+        abort();
+    }
+
+    if (earliest > atomic_load(&sim_now_us)) atomic_store(&sim_now_us, earliest);
+    for (uint32_t i = 0; i < FAKE_SIM_MAX_TASKS; i++) {
+        struct fake_task *task = &sim_tasks[i];
+        if (task->used && task->blocked && task->wake_us != FAKE_SIM_FOREVER && task->wake_us <= earliest) {
+            fake_sim_unblock(task, false);
+        }
+    }
+}
+
+/**
+ * Thread running a task. FreeRTOS tasks mustn't return, but a return is handled as a delete.
+ * @param arg Task to run
+ * @return Nothing
+ */
+static void *fake_sim_thread(void *arg) {
+    sim_self = arg;
+    sim_self->function(sim_self->arg);
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+/**
+ * Takes a semaphore from the pool.
+ * @param count Times it can be taken initially
+ * @param max Largest count
+ * @return The semaphore, or NULL if the pool is exhausted
+ */
+static SemaphoreHandle_t fake_sim_semaphore_alloc(uint32_t count, uint32_t max) {
+    SemaphoreHandle_t semaphore = NULL;
+    fake_sim_lock();
+    for (uint32_t i = 0; i < FAKE_SIM_MAX_SEMAPHORES; i++) {
+        if (sim_semaphores[i].used) continue;
+        semaphore = &sim_semaphores[i];
+        semaphore->used = true;
+        semaphore->count = count;
+        semaphore->max = max;
+        break;
+    }
+    fake_sim_unlock();
+    return semaphore;
+}
@@ -0,0 +1,358 @@
+/**
+ * @file fake_ledc.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief File containing the LEDC stand-in, which keeps the registers of the ESP32's low and high speed timers and
+ * channels, and records every write with the time of the simulated clock.
+ *
+ * @details The event array is the only thing allocated, so the footprint test leaves recording off.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "driver/ledc.h"
+#include "esp_timer.h"
+#include "fake_ledc.h"
+
+#define FAKE_LEDC_APB_HZ 80000000u ///< Frequency of the APB clock
+#define FAKE_LEDC_REF_TICK_HZ 1000000u ///< Frequency of the REF_TICK clock
+#define FAKE_LEDC_RTC8M_HZ 8000000u ///< Nominal frequency of the RTC8M clock
+#define FAKE_LEDC_DIV_FRAC_BITS 8u ///< Fractional bits of the divider
+#define FAKE_LEDC_DIV_MIN (1u << FAKE_LEDC_DIV_FRAC_BITS) ///< Smallest divider
+#define FAKE_LEDC_DIV_MAX 0x3FFFFu ///< Largest divider
+
+/**
+ * Registers of a timer
+ */
+typedef struct {
+    bool configured; ///< Whether the timer was configured
+    bool paused; ///< Whether the timer is paused
+    uint8_t duty_res_bits; ///< Duty resolution
+    uint32_t clk_hz; ///< Frequency of the clock source
+    uint32_t divider; ///< Divider, with 8 fractional bits
+} fake_ledc_timer_t;
+
+/**
+ * Registers of a channel
+ */
+typedef struct {
+    ledc_timer_t timer; ///< Timer driving the channel
+    uint32_t duty; ///< Duty being output
+    uint32_t pending_duty; ///< Duty set, output on the next update
+} fake_ledc_channel_t;
+
+static pthread_mutex_t ledc_mutex = PTHREAD_MUTEX_INITIALIZER; ///< Lock of the registers and the recording
+static fake_ledc_timer_t ledc_timers[LEDC_SPEED_MODE_MAX][LEDC_TIMER_MAX]; ///< Timers of each speed mode
+static fake_ledc_channel_t ledc_channels[LEDC_SPEED_MODE_MAX][LEDC_CHANNEL_MAX]; ///< Channels of each speed mode
+static bool ledc_recording; ///< Whether writes are recorded
+static fake_ledc_event_t *ledc_events; ///< Writes recorded
+static size_t ledc_event_count; ///< Writes recorded
+static size_t ledc_event_capacity; ///< Writes that fit in the array
+static fake_ledc_observer_t ledc_observer; ///< Function called with every write
+static void *ledc_observer_arg; ///< Argument of the observer
+
+// Private function declarations
+
+static uint32_t fake_ledc_divider(uint32_t clk_hz, uint8_t duty_res_bits, uint32_t freq_hz);
+
+static void fake_ledc_emit(fake_ledc_op_t op, uint8_t index, uint32_t value, uint32_t freq_hz,
+                           const fake_ledc_timer_t *timer);
+
+static bool fake_ledc_valid_timer(ledc_mode_t speed_mode, ledc_timer_t timer);
+
+static bool fake_ledc_valid_channel(ledc_mode_t speed_mode, ledc_channel_t channel);
+
+// LEDC functions
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t *timer_conf) {
+    if (!timer_conf || !fake_ledc_valid_timer(timer_conf->speed_mode, timer_conf->timer_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint8_t res = (uint8_t) timer_conf->duty_resolution;
+    if (res == 0 || res >= LEDC_TIMER_BIT_MAX) return ESP_ERR_INVALID_ARG;
+
+    // Automatic selection prefers APB, and falls back to REF_TICK for frequencies too low for it
+    uint32_t clk_hz;
+    switch (timer_conf->clk_cfg) {
+        case LEDC_AUTO_CLK:
+            clk_hz = fake_ledc_divider(FAKE_LEDC_APB_HZ, res, timer_conf->freq_hz) ? FAKE_LEDC_APB_HZ :
+                     FAKE_LEDC_REF_TICK_HZ;
+            break;
+        case LEDC_USE_APB_CLK:
+            clk_hz = FAKE_LEDC_APB_HZ;
+            break;
+        case LEDC_USE_REF_TICK:
+            clk_hz = FAKE_LEDC_REF_TICK_HZ;
+            break;
+        case LEDC_USE_RTC8M_CLK:
+            if (timer_conf->speed_mode != LEDC_LOW_SPEED_MODE) return ESP_ERR_INVALID_ARG;
+            clk_hz = FAKE_LEDC_RTC8M_HZ;
+            break;
+        default:
+            return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t divider = fake_ledc_divider(clk_hz, res, timer_conf->freq_hz);
+    if (divider == 0) return ESP_FAIL;
+
+    pthread_mutex_lock(&ledc_mutex);
+    fake_ledc_timer_t *timer = &ledc_timers[timer_conf->speed_mode][timer_conf->timer_num];
+    timer->configured = true;
+    timer->paused = false;
+    timer->duty_res_bits = res;
+    timer->clk_hz = clk_hz;
+    timer->divider = divider;
+    fake_ledc_emit(FAKE_LEDC_DIVIDER, (uint8_t) timer_conf->timer_num, divider, timer_conf->freq_hz, timer);
+    fake_ledc_emit(FAKE_LEDC_RESET, (uint8_t) timer_conf->timer_num, 0, 0, timer);
+    pthread_mutex_unlock(&ledc_mutex);
+    return ESP_OK;
+}
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t *ledc_conf) {
+    if (!ledc_conf || !fake_ledc_valid_channel(ledc_conf->speed_mode, ledc_conf->channel) ||
+        !fake_ledc_valid_timer(ledc_conf->speed_mode, ledc_conf->timer_sel)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&ledc_mutex);
+    fake_ledc_channel_t *channel = &ledc_channels[ledc_conf->speed_mode][ledc_conf->channel];
+    channel->timer = ledc_conf->timer_sel;
+    channel->duty = ledc_conf->duty;
+    channel->pending_duty = ledc_conf->duty;
+    fake_ledc_emit(FAKE_LEDC_DUTY, (uint8_t) ledc_conf->channel, ledc_conf->duty, 0,
+                   &ledc_timers[ledc_conf->speed_mode][ledc_conf->timer_sel]);
+    pthread_mutex_unlock(&ledc_mutex);
+    return ESP_OK;
+}
+
+esp_err_t ledc_timer_set(ledc_mode_t speed_mode, ledc_timer_t timer_sel, uint32_t clock_divider,
+                         uint32_t duty_resolution, ledc_clk_src_t clk_src) {
+    if (!fake_ledc_valid_timer(speed_mode, timer_sel)) return ESP_ERR_INVALID_ARG;
+    if (clock_divider < FAKE_LEDC_DIV_MIN || clock_divider > FAKE_LEDC_DIV_MAX) return ESP_ERR_INVALID_ARG;
+    if (duty_resolution == 0 || duty_resolution >= LEDC_TIMER_BIT_MAX) return ESP_ERR_INVALID_ARG;
+
+    pthread_mutex_lock(&ledc_mutex);
+    fake_ledc_timer_t *timer = &ledc_timers[speed_mode][timer_sel];
+    timer->configured = true;
+    timer->duty_res_bits = (uint8_t) duty_resolution;
+    timer->clk_hz = clk_src == LEDC_APB_CLK ? FAKE_LEDC_APB_HZ : FAKE_LEDC_REF_TICK_HZ;
+    timer->divider = clock_divider;
+    fake_ledc_emit(FAKE_LEDC_DIVIDER, (uint8_t) timer_sel, clock_divider, 0, timer);
+    pthread_mutex_unlock(&ledc_mutex);
+    return ESP_OK;
+}
+
+esp_err_t ledc_timer_rst(ledc_mode_t speed_mode, ledc_timer_t timer_sel) {
+    if (!fake_ledc_valid_timer(speed_mode, timer_sel)) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&ledc_mutex);
+    fake_ledc_emit(FAKE_LEDC_RESET, (uint8_t) timer_sel, 0, 0, &ledc_timers[speed_mode][timer_sel]);
+    pthread_mutex_unlock(&ledc_mutex);
+    return ESP_OK;
+}
+
+esp_err_t ledc_timer_pause(ledc_mode_t speed_mode, ledc_timer_t timer_sel) {
+    if (!fake_ledc_valid_timer(speed_mode, timer_sel)) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&ledc_mutex);
+    ledc_timers[speed_mode][timer_sel].paused = true;
+    fake_ledc_emit(FAKE_LEDC_PAUSE, (uint8_t) timer_sel, 0, 0, &ledc_timers[speed_mode][timer_sel]);
+    pthread_mutex_unlock(&ledc_mutex);
+    return ESP_OK;
+}
+
+esp_err_t ledc_timer_resume(ledc_mode_t speed_mode, ledc_timer_t timer_sel) {
+    if (!fake_ledc_valid_timer(speed_mode, timer_sel)) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&ledc_mutex);
+    ledc_timers[speed_mode][timer_sel].paused = false;
+    fake_ledc_emit(FAKE_LEDC_RESUME, (uint8_t) timer_sel, 0, 0, &ledc_timers[speed_mode][timer_sel]);
+    pthread_mutex_unlock(&ledc_mutex);
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_freq(ledc_mode_t speed_mode, ledc_timer_t timer_num, uint32_t freq_hz) {
+    if (!fake_ledc_valid_timer(speed_mode, timer_num)) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&ledc_mutex);
+    fake_ledc_timer_t *timer = &ledc_timers[speed_mode][timer_num];
+    uint32_t divider = timer->configured ? fake_ledc_divider(timer->clk_hz, timer->duty_res_bits, freq_hz) : 0;
+    if (divider == 0) {
+        pthread_mutex_unlock(&ledc_mutex);
+        return ESP_FAIL;
+    }
+    // Like ESP-IDF 4.4, the new divider is followed by a reset of the timer
+    timer->divider = divider;
+    fake_ledc_emit(FAKE_LEDC_DIVIDER, (uint8_t) timer_num, divider, freq_hz, timer);
+    fake_ledc_emit(FAKE_LEDC_RESET, (uint8_t) timer_num, 0, 0, timer);
+    pthread_mutex_unlock(&ledc_mutex);
+    return ESP_OK;
+}
+
+uint32_t ledc_get_freq(ledc_mode_t speed_mode, ledc_timer_t timer_num) {
+    if (!fake_ledc_valid_timer(speed_mode, timer_num)) return 0;
+    pthread_mutex_lock(&ledc_mutex);
+    fake_ledc_timer_t *timer = &ledc_timers[speed_mode][timer_num];
+    uint32_t freq_hz = timer->configured ? (uint32_t) (((uint64_t) timer->clk_hz << FAKE_LEDC_DIV_FRAC_BITS) /
+                                                       ((uint64_t) timer->divider << timer->duty_res_bits)) : 0;
+    pthread_mutex_unlock(&ledc_mutex);
+    return freq_hz;
+}
+
+esp_err_t ledc_set_duty(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t duty) {
+    if (!fake_ledc_valid_channel(speed_mode, channel)) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&ledc_mutex);
+    ledc_channels[speed_mode][channel].pending_duty = duty;
+    pthread_mutex_unlock(&ledc_mutex);
+    return ESP_OK;
+}
+
+uint32_t ledc_get_duty(ledc_mode_t speed_mode, ledc_channel_t channel) {
+    if (!fake_ledc_valid_channel(speed_mode, channel)) return 0;
+    pthread_mutex_lock(&ledc_mutex);
+    uint32_t duty = ledc_channels[speed_mode][channel].duty;
+    pthread_mutex_unlock(&ledc_mutex);
+    return duty;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t speed_mode, ledc_channel_t channel) {
+    if (!fake_ledc_valid_channel(speed_mode, channel)) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&ledc_mutex);
+    fake_ledc_channel_t *updated = &ledc_channels[speed_mode][channel];
+    updated->duty = updated->pending_duty;
+    fake_ledc_emit(FAKE_LEDC_DUTY, (uint8_t) channel, updated->duty, 0, &ledc_timers[speed_mode][updated->timer]);
+    pthread_mutex_unlock(&ledc_mutex);
+    return ESP_OK;
+}
+
+esp_err_t ledc_stop(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t idle_level) {
+    (void) idle_level;
+    return ledc_set_duty(speed_mode, channel, 0) == ESP_OK ? ledc_update_duty(speed_mode, channel) :
+           ESP_ERR_INVALID_ARG;
+}
+
+// Test hooks
+
+void fake_ledc_reset(void) {
+    pthread_mutex_lock(&ledc_mutex);
+    memset(ledc_timers, 0, sizeof(ledc_timers));
+    memset(ledc_channels, 0, sizeof(ledc_channels));
+    ledc_event_count = 0;
+    pthread_mutex_unlock(&ledc_mutex);
+}
+
+void fake_ledc_set_recording(bool recording) {
+    pthread_mutex_lock(&ledc_mutex);
+    ledc_recording = recording;
+    pthread_mutex_unlock(&ledc_mutex);
+}
+
+const fake_ledc_event_t *fake_ledc_get_events(size_t *count) {
+    pthread_mutex_lock(&ledc_mutex);
+    const fake_ledc_event_t *events = ledc_events;
+    *count = ledc_event_count;
+    pthread_mutex_unlock(&ledc_mutex);
+    return events;
+}
+
+void fake_ledc_set_observer(fake_ledc_observer_t observer, void *arg) {
+    pthread_mutex_lock(&ledc_mutex);
+    ledc_observer = observer;
+    ledc_observer_arg = arg;
+    pthread_mutex_unlock(&ledc_mutex);
+}
+
+double fake_ledc_get_freq(ledc_timer_t timer) {
+    pthread_mutex_lock(&ledc_mutex);
+    const fake_ledc_timer_t *checked = &ledc_timers[LEDC_LOW_SPEED_MODE][timer];
+    double freq_hz = checked->configured ? (double) checked->clk_hz * FAKE_LEDC_DIV_MIN /
+                                           ((double) checked->divider * (double) (1u << checked->duty_res_bits)) : 0;
+    pthread_mutex_unlock(&ledc_mutex);
+    return freq_hz;
+}
+
+uint32_t fake_ledc_get_divider(ledc_timer_t timer) {
+    pthread_mutex_lock(&ledc_mutex);
+    uint32_t divider = ledc_timers[LEDC_LOW_SPEED_MODE][timer].divider;
+    pthread_mutex_unlock(&ledc_mutex);
+    return divider;
+}
+
+bool fake_ledc_is_running(ledc_timer_t timer) {
+    pthread_mutex_lock(&ledc_mutex);
+    const fake_ledc_timer_t *checked = &ledc_timers[LEDC_LOW_SPEED_MODE][timer];
+    bool running = checked->configured && !checked->paused;
+    pthread_mutex_unlock(&ledc_mutex);
+    return running;
+}
+
+uint32_t fake_ledc_get_duty(ledc_channel_t channel) {
+    return ledc_get_duty(LEDC_LOW_SPEED_MODE, channel);
+}
+
+ledc_timer_t fake_ledc_get_channel_timer(ledc_channel_t channel) {
+    pthread_mutex_lock(&ledc_mutex);
+    ledc_timer_t timer = ledc_channels[LEDC_LOW_SPEED_MODE][channel].timer;
+    pthread_mutex_unlock(&ledc_mutex);
+    return timer;
+}
+
+// Private functions
+
+/**
+ * Calculates a divider the way the LEDC driver does.
+ * @param clk_hz Frequency of the clock source
+ * @param duty_res_bits Duty resolution
+ * @param freq_hz Frequency requested
+ * @return The divider, or 0 if it's out of range
+ */
+static uint32_t fake_ledc_divider(uint32_t clk_hz, uint8_t duty_res_bits, uint32_t freq_hz) {
+    if (freq_hz == 0) return 0;
+    uint64_t precision = (uint64_t) freq_hz << duty_res_bits;
+    uint64_t divider = (((uint64_t) clk_hz << FAKE_LEDC_DIV_FRAC_BITS) + precision / 2) / precision;
+    if (divider < FAKE_LEDC_DIV_MIN || divider > FAKE_LEDC_DIV_MAX) return 0;
+    return (uint32_t) divider;
+}
+
+/**
+ * Passes a write to the observer, and records it if recording is on. Must be called with the LEDC locked.
+ * @param op Kind of write
+ * @param index Timer or channel written
+ * @param value New divider or duty
+ * @param freq_hz Frequency requested with the divider
+ * @param timer Timer affected, for its resolution and clock
+ */
+static void fake_ledc_emit(fake_ledc_op_t op, uint8_t index, uint32_t value, uint32_t freq_hz,
+                           const fake_ledc_timer_t *timer) {
+    fake_ledc_event_t event = {
+            .time_us = esp_timer_get_time(),
+            .op = op,
+            .index = index,
+            .duty_res_bits = timer->duty_res_bits,
+            .value = value,
+            .freq_hz = freq_hz,
+            .clk_hz = timer->clk_hz
+    };
+    if (ledc_observer) ledc_observer(&event, ledc_observer_arg);
+    if (!ledc_recording) return;
+
+    if (ledc_event_count == ledc_event_capacity) {
+        size_t capacity = ledc_event_capacity ? ledc_event_capacity * 2 : 1024;
+        fake_ledc_event_t *events = realloc(ledc_events, capacity * sizeof(fake_ledc_event_t));
+        if (!events) abort();
+        ledc_events = events;
+        ledc_event_capacity = capacity;
+    }
+    ledc_events[ledc_event_count++] = event;
+}
+
+/**
+ * Checks a speed mode and a timer.
+ * @return Whether they exist
+ */
+static bool fake_ledc_valid_timer(ledc_mode_t speed_mode, ledc_timer_t timer) {
+    return speed_mode >= 0 && speed_mode < LEDC_SPEED_MODE_MAX && timer >= 0 && timer < LEDC_TIMER_MAX;
+}
+
+/**
+ * Checks a speed mode and a channel.
+ * @return Whether they exist
+ */
+static bool fake_ledc_valid_channel(ledc_mode_t speed_mode, ledc_channel_t channel) {
+    return speed_mode >= 0 && speed_mode < LEDC_SPEED_MODE_MAX && channel >= 0 && channel < LEDC_CHANNEL_MAX;
+}
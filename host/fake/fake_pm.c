@@ -0,0 +1,116 @@
+/**
+ * @file fake_pm.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief File containing the power management stand-in. Locks only count their acquisitions, as there's no clock to
+ * scale nor sleep to prevent on the host.
+ *
+ * @details Locks come from a static pool instead of the heap, so the footprint test only counts what the library
+ * allocates.
+ */
+
+#include <stdbool.h>
+#include <pthread.h>
+#include "esp_pm.h"
+#include "fake_pm.h"
+
+#define FAKE_PM_MAX_LOCKS 32 ///< Locks that can exist at the same time
+
+/**
+ * Lock of the stand-in
+ */
+struct esp_pm_lock {
+    bool used; ///< Whether the slot holds a lock
+    esp_pm_lock_type_t type; ///< Type of the lock
+    uint32_t held; ///< Acquisitions not released yet
+};
+
+static pthread_mutex_t pm_mutex = PTHREAD_MUTEX_INITIALIZER; ///< Lock of the pool and the counters
+static struct esp_pm_lock pm_locks[FAKE_PM_MAX_LOCKS]; ///< Pool of locks
+static uint32_t pm_errors; ///< Calls which failed with ESP_ERR_INVALID_STATE
+
+// Public functions
+
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t lock_type, int arg, const char *name,
+                             esp_pm_lock_handle_t *out_handle) {
+    (void) arg;
+    (void) name;
+    if (!out_handle) return ESP_ERR_INVALID_ARG;
+
+    pthread_mutex_lock(&pm_mutex);
+    for (uint32_t i = 0; i < FAKE_PM_MAX_LOCKS; i++) {
+        if (pm_locks[i].used) continue;
+        pm_locks[i] = (struct esp_pm_lock) {.used = true, .type = lock_type};
+        *out_handle = &pm_locks[i];
+        pthread_mutex_unlock(&pm_mutex);
+        return ESP_OK;
+    }
+    pthread_mutex_unlock(&pm_mutex);
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t esp_pm_lock_delete(esp_pm_lock_handle_t handle) {
+    if (!handle) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t ret = ESP_OK;
+    pthread_mutex_lock(&pm_mutex);
+    if (handle->held) {
+        pm_errors++;
+        ret = ESP_ERR_INVALID_STATE;
+    } else {
+        handle->used = false;
+    }
+    pthread_mutex_unlock(&pm_mutex);
+    return ret;
+}
+
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle) {
+    if (!handle) return ESP_ERR_INVALID_ARG;
+
+    pthread_mutex_lock(&pm_mutex);
+    handle->held++;
+    pthread_mutex_unlock(&pm_mutex);
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle) {
+    if (!handle) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t ret = ESP_OK;
+    pthread_mutex_lock(&pm_mutex);
+    if (handle->held == 0) {
+        pm_errors++;
+        ret = ESP_ERR_INVALID_STATE;
+    } else {
+        handle->held--;
+    }
+    pthread_mutex_unlock(&pm_mutex);
+    return ret;
+}
+
+uint32_t fake_pm_get_held(esp_pm_lock_type_t lock_type) {
+    uint32_t held = 0;
+    pthread_mutex_lock(&pm_mutex);
+    for (uint32_t i = 0; i < FAKE_PM_MAX_LOCKS; i++) {
+        if (pm_locks[i].used && pm_locks[i].type == lock_type) held += pm_locks[i].held;
+    }
+    pthread_mutex_unlock(&pm_mutex);
+    return held;
+}
+
+size_t fake_pm_get_lock_count(void) {
+    size_t count = 0;
+    pthread_mutex_lock(&pm_mutex);
+    for (uint32_t i = 0; i < FAKE_PM_MAX_LOCKS; i++) {
+        if (pm_locks[i].used) count++;
+    }
+    pthread_mutex_unlock(&pm_mutex);
+    return count;
+}
+
+uint32_t fake_pm_get_errors(void) {
+    pthread_mutex_lock(&pm_mutex);
+    uint32_t errors = pm_errors;
+    pthread_mutex_unlock(&pm_mutex);
+    return errors;
+}
@@ -0,0 +1,47 @@
+/**
+ * @file fake_sim_internal.h
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Private header of the host simulator, shared by the FreeRTOS and esp_timer stand-ins.
+ */
+
+#ifndef GYRO_READER_FAKE_SIM_INTERNAL_H
+#define GYRO_READER_FAKE_SIM_INTERNAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FAKE_SIM_FOREVER (-1) ///< Timeout of a block that only ends when its object is woken up
+
+/**
+ * Locks the simulator. Blocking and waking up must be done with it locked.
+ */
+void fake_sim_lock(void);
+
+/**
+ * Unlocks the simulator.
+ */
+void fake_sim_unlock(void);
+
+/**
+ * Blocks the calling task until an object it waits on is woken up or the clock reaches a time. Must be called with
+ * the simulator locked, which is unlocked while blocked.
+ * @param object Object to wait on, NULL to only wait for the time
+ * @param wake_us Time to wake up at, or FAKE_SIM_FOREVER
+ * @return true if the object was woken up, false if the time was reached
+ */
+bool fake_sim_block(const void *object, int64_t wake_us);
+
+/**
+ * Wakes up every task waiting on an object. Must be called with the simulator locked.
+ * @param object Object waited on
+ */
+void fake_sim_wake(const void *object);
+
+/**
+ * Returns the time of the simulated clock.
+ * @return Microseconds elapsed since the start of the program
+ */
+int64_t fake_sim_now_us(void);
+
+#endif //GYRO_READER_FAKE_SIM_INTERNAL_H
@@ -0,0 +1,14 @@
+/**
+ * @file esp_attr.h
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Host stand-in for the ESP-IDF placement attributes, which have no meaning on the host.
+ */
+
+#ifndef GYRO_READER_FAKE_ESP_ATTR_H
+#define GYRO_READER_FAKE_ESP_ATTR_H
+
+#define IRAM_ATTR ///< Code placed in IRAM on the chip
+#define DRAM_ATTR ///< Data placed in DRAM on the chip
+
+#endif //GYRO_READER_FAKE_ESP_ATTR_H
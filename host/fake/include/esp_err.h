@@ -0,0 +1,25 @@
+/**
+ * @file esp_err.h
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Host stand-in for the ESP-IDF error codes used by the library.
+ */
+
+#ifndef GYRO_READER_FAKE_ESP_ERR_H
+#define GYRO_READER_FAKE_ESP_ERR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK 0 ///< No error
+#define ESP_FAIL (-1) ///< Generic failure
+#define ESP_ERR_NO_MEM 0x101 ///< Out of memory
+#define ESP_ERR_INVALID_ARG 0x102 ///< Invalid argument
+#define ESP_ERR_INVALID_STATE 0x103 ///< Invalid state
+#define ESP_ERR_NOT_SUPPORTED 0x106 ///< Operation or feature not supported
+#define ESP_ERR_TIMEOUT 0x107 ///< Operation timed out
+
+#endif //GYRO_READER_FAKE_ESP_ERR_H
@@ -0,0 +1,14 @@
+/**
+ * @file esp_idf_version.h
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Host stand-in for the ESP-IDF version macros. The fakes follow the ESP-IDF 4.4 APIs.
+ */
+
+#ifndef GYRO_READER_FAKE_ESP_IDF_VERSION_H
+#define GYRO_READER_FAKE_ESP_IDF_VERSION_H
+
+#define ESP_IDF_VERSION_VAL(major, minor, patch) (((major) << 16) | ((minor) << 8) | (patch)) ///< Packs a version
+#define ESP_IDF_VERSION ESP_IDF_VERSION_VAL(4, 4, 0) ///< Version emulated by the fakes
+
+#endif //GYRO_READER_FAKE_ESP_IDF_VERSION_H
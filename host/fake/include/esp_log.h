@@ -0,0 +1,19 @@
+/**
+ * @file esp_log.h
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Host stand-in for the ESP-IDF logging macros. Errors and warnings go to stderr, the rest is dropped.
+ */
+
+#ifndef GYRO_READER_FAKE_ESP_LOG_H
+#define GYRO_READER_FAKE_ESP_LOG_H
+
+#include <stdio.h>
+
+#define ESP_LOGE(tag, format, ...) fprintf(stderr, "E (%s): " format "\n", tag, ##__VA_ARGS__) ///< Logs an error
+#define ESP_LOGW(tag, format, ...) fprintf(stderr, "W (%s): " format "\n", tag, ##__VA_ARGS__) ///< Logs a warning
+#define ESP_LOGI(tag, format, ...) do {} while (0) ///< Informational messages aren't shown on the host
+#define ESP_LOGD(tag, format, ...) do {} while (0) ///< Debug messages aren't shown on the host
+#define ESP_LOGV(tag, format, ...) do {} while (0) ///< Verbose messages aren't shown on the host
+
+#endif //GYRO_READER_FAKE_ESP_LOG_H
@@ -0,0 +1,36 @@
+/**
+ * @file esp_pm.h
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Host stand-in for the power management locks of ESP-IDF 4.4. Locks are counted like on the chip, and misuse
+ * (releasing a lock which isn't held or deleting one which is) is reported with ESP_ERR_INVALID_STATE and counted, so
+ * tests can check every acquisition is balanced (see fake_pm.h).
+ */
+
+#ifndef GYRO_READER_FAKE_ESP_PM_H
+#define GYRO_READER_FAKE_ESP_PM_H
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    ESP_PM_CPU_FREQ_MAX,
+    ESP_PM_APB_FREQ_MAX,
+    ESP_PM_NO_LIGHT_SLEEP,
+} esp_pm_lock_type_t;
+
+typedef struct esp_pm_lock *esp_pm_lock_handle_t;
+
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t lock_type, int arg, const char *name, esp_pm_lock_handle_t *out_handle);
+esp_err_t esp_pm_lock_delete(esp_pm_lock_handle_t handle);
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle);
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //GYRO_READER_FAKE_ESP_PM_H
@@ -0,0 +1,117 @@
+/**
+ * @file fake_ledc.h
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Test hooks of the host LEDC. Every write to a timer or a channel can be recorded, with the simulated time it
+ * happened at, so tests can check what reached the hardware and the renderer can turn it into sound.
+ *
+ * @details ledc_set_freq is modelled like in ESP-IDF 4.4: it writes the divider and then resets the timer, which
+ * restarts the period on the pin and is heard as a click. ledc_timer_set only writes the divider.
+ */
+
+#ifndef GYRO_READER_FAKE_LEDC_HOOKS_H
+#define GYRO_READER_FAKE_LEDC_HOOKS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "driver/ledc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Kind of write recorded
+ */
+typedef enum {
+    FAKE_LEDC_DIVIDER, ///< A timer got a new divider, resolution and clock
+    FAKE_LEDC_RESET, ///< A timer was reset, restarting its period
+    FAKE_LEDC_PAUSE, ///< A timer was paused, holding its output
+    FAKE_LEDC_RESUME, ///< A timer was resumed
+    FAKE_LEDC_DUTY ///< A channel got a new duty
+} fake_ledc_op_t;
+
+/**
+ * Write recorded
+ */
+typedef struct {
+    int64_t time_us; ///< Simulated time of the write
+    fake_ledc_op_t op; ///< Kind of write
+    uint8_t index; ///< Timer written, or channel for FAKE_LEDC_DUTY
+    uint8_t duty_res_bits; ///< Duty resolution of the timer
+    uint32_t value; ///< New divider, or new duty for FAKE_LEDC_DUTY
+    uint32_t freq_hz; ///< Frequency requested with the divider, 0 if it was set directly
+    uint32_t clk_hz; ///< Frequency of the timer's clock
+} fake_ledc_event_t;
+
+/**
+ * Function called with every write, while the LEDC is locked (so it must not call the LEDC)
+ */
+typedef void (*fake_ledc_observer_t)(const fake_ledc_event_t *event, void *arg);
+
+/**
+ * Unconfigures every timer and channel, and drops the writes recorded.
+ */
+void fake_ledc_reset(void);
+
+/**
+ * Starts or stops recording the writes. Recording is off by default.
+ * @param recording Whether to record
+ */
+void fake_ledc_set_recording(bool recording);
+
+/**
+ * Returns the writes recorded since the last reset. The array is only valid until the next write.
+ * @param count Where to store the number of writes
+ * @return Array of writes, in the order they happened
+ */
+const fake_ledc_event_t *fake_ledc_get_events(size_t *count);
+
+/**
+ * Sets a function called with every write, whether it's recorded or not. Pass NULL to remove it.
+ * @param observer Function to call
+ * @param arg Argument passed to the function
+ */
+void fake_ledc_set_observer(fake_ledc_observer_t observer, void *arg);
+
+/**
+ * Returns the frequency a timer produces, from its divider.
+ * @param timer Timer to check
+ * @return Frequency in Hz, 0 if the timer isn't configured
+ */
+double fake_ledc_get_freq(ledc_timer_t timer);
+
+/**
+ * Returns the divider of a timer.
+ * @param timer Timer to check
+ * @return Divider with 8 fractional bits, 0 if the timer isn't configured
+ */
+uint32_t fake_ledc_get_divider(ledc_timer_t timer);
+
+/**
+ * Returns whether a timer is configured and not paused.
+ * @param timer Timer to check
+ * @return Whether its channels are producing a signal
+ */
+bool fake_ledc_is_running(ledc_timer_t timer);
+
+/**
+ * Returns the duty a channel is outputting (the last one updated).
+ * @param channel Channel to check
+ * @return Duty of the channel
+ */
+uint32_t fake_ledc_get_duty(ledc_channel_t channel);
+
+/**
+ * Returns the timer a channel is attached to.
+ * @param channel Channel to check
+ * @return Timer of the channel
+ */
+ledc_timer_t fake_ledc_get_channel_timer(ledc_channel_t channel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //GYRO_READER_FAKE_LEDC_HOOKS_H
@@ -0,0 +1,43 @@
+/**
+ * @file fake_pm.h
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Test hooks of the host power management locks, which tell how many acquisitions are held and whether any
+ * lock was misused.
+ */
+
+#ifndef GYRO_READER_FAKE_PM_H
+#define GYRO_READER_FAKE_PM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_pm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Returns the acquisitions held, added up over every lock of a type.
+ * @param lock_type Type of the locks
+ * @return Acquisitions not released yet
+ */
+uint32_t fake_pm_get_held(esp_pm_lock_type_t lock_type);
+
+/**
+ * Returns the locks which exist right now.
+ * @return Locks created and not deleted yet
+ */
+size_t fake_pm_get_lock_count(void);
+
+/**
+ * Returns the times a lock was misused: released while not held, or deleted while held.
+ * @return Calls which failed with ESP_ERR_INVALID_STATE
+ */
+uint32_t fake_pm_get_errors(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //GYRO_READER_FAKE_PM_H
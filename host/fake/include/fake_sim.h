@@ -0,0 +1,94 @@
+/**
+ * @file fake_sim.h
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Test hooks of the host simulator. FreeRTOS tasks run as threads, and the simulated clock only moves forward
+ * when every task is blocked: it then jumps to the earliest timeout, so timing is exact and doesn't depend on the
+ * load of the host. Code running between two blocking calls takes no simulated time at all.
+ *
+ * @details If every task is blocked without a timeout, the simulator prints the tasks and aborts, which turns
+ * deadlocks into test failures instead of hangs.
+ */
+
+#ifndef GYRO_READER_FAKE_SIM_H
+#define GYRO_READER_FAKE_SIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Configuration a task was created with
+ */
+typedef struct {
+    uint32_t stack_bytes; ///< Stack reserved for the task
+    UBaseType_t priority; ///< FreeRTOS priority of the task
+    BaseType_t core; ///< Core the task is pinned to, or tskNO_AFFINITY
+} fake_sim_task_config_t;
+
+/**
+ * Blocks the calling task until the simulated clock reaches the given time.
+ * @param time_us Time to wait for in microseconds, as returned by esp_timer_get_time
+ */
+void fake_sim_sleep_until(int64_t time_us);
+
+/**
+ * Returns the stack reserved by the tasks alive right now, not counting the main task and the esp_timer task.
+ * @return Bytes of stack reserved
+ */
+size_t fake_sim_task_stack_bytes(void);
+
+/**
+ * Looks up the configuration a task alive right now was created with.
+ * @param name Name of the task. If several tasks share it, the first one found is used.
+ * @param config Where to store the configuration
+ * @return Whether a task with that name exists
+ */
+bool fake_sim_get_task_config(const char *name, fake_sim_task_config_t *config);
+
+/**
+ * Replaces the source of the CPU cycle counter, so tests can make it follow the simulated clock or wrap around when
+ * they need to. Pass NULL to go back to the host's monotonic clock.
+ * @param source Function returning the cycle counter
+ */
+void fake_sim_set_cycle_source(uint32_t (*source)(void));
+
+/**
+ * Returns the esp_timers which exist right now.
+ * @return Timers created and not deleted yet
+ */
+size_t fake_esp_timer_count(void);
+
+/**
+ * Blocks the calling task until every esp_timer callback due by now has run, including the ones they arm to run
+ * right away.
+ */
+void fake_esp_timer_flush(void);
+
+/**
+ * Sets a function called at the start of every esp_timer_stop, before the timer is looked at. Tests use it to let
+ * the callback run right before a stop, which is the window races hide in. Pass NULL to remove it.
+ * @param hook Function to call with the timer being stopped
+ * @param arg Argument passed to the function
+ */
+void fake_esp_timer_set_stop_hook(void (*hook)(esp_timer_handle_t timer, void *arg), void *arg);
+
+/**
+ * Sets a function called at the start of every esp_timer_start_once, before the timer is looked at. Tests use it to
+ * let a running callback arm the timer between a stop and a start. Pass NULL to remove it.
+ * @param hook Function to call with the timer being started
+ * @param arg Argument passed to the function
+ */
+void fake_esp_timer_set_start_hook(void (*hook)(esp_timer_handle_t timer, void *arg), void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //GYRO_READER_FAKE_SIM_H
@@ -0,0 +1,81 @@
+/**
+ * @file FreeRTOS.h
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Host stand-in for the FreeRTOS types, port macros and critical sections used by the library. Tasks run as
+ * threads over a simulated clock (see fake_sim.h), with a tick of 1 ms.
+ *
+ * @details Critical sections take a single recursive lock shared by every portMUX_TYPE, which keeps their mutual
+ * exclusion (and their nesting) without modelling the spinlocks of each core.
+ */
+
+#ifndef GYRO_READER_FAKE_FREERTOS_H
+#define GYRO_READER_FAKE_FREERTOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+/**
+ * Spinlock of a critical section. Only its size matters on the host, which is the same as on the chip.
+ */
+typedef struct {
+    uint32_t owner; ///< Core holding the lock
+    uint32_t count; ///< Nesting depth
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {0, 0} ///< Static initializer of an unlocked spinlock
+#define portMUX_INITIALIZE(mux) ((mux)->owner = 0, (mux)->count = 0) ///< Initializes an unlocked spinlock
+
+#define configTICK_RATE_HZ 1000 ///< Tick rate of the simulated scheduler
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ) ///< Length of a tick in milliseconds
+#define pdMS_TO_TICKS(ms) ((TickType_t) (((uint64_t) (ms) * configTICK_RATE_HZ) / 1000u)) ///< Milliseconds to ticks
+#define portMAX_DELAY ((TickType_t) 0xFFFFFFFFu) ///< Blocks without a timeout
+
+#define pdFALSE 0 ///< False
+#define pdTRUE 1 ///< True
+#define pdFAIL pdFALSE ///< Failure
+#define pdPASS pdTRUE ///< Success
+#define tskNO_AFFINITY 0x7FFFFFFF ///< Lets a task run on any core
+#define portNUM_PROCESSORS 2 ///< Cores tasks can be pinned to, as on the ESP32, even if they all share one on the host
+
+/**
+ * Enters a critical section.
+ * @param mux Spinlock of the critical section
+ */
+void vPortEnterCritical(portMUX_TYPE *mux);
+
+/**
+ * Leaves a critical section.
+ * @param mux Spinlock of the critical section
+ */
+void vPortExitCritical(portMUX_TYPE *mux);
+
+#define portENTER_CRITICAL(mux) vPortEnterCritical(mux) ///< Enters a critical section from a task
+#define portEXIT_CRITICAL(mux) vPortExitCritical(mux) ///< Leaves a critical section from a task
+#define portENTER_CRITICAL_ISR(mux) vPortEnterCritical(mux) ///< Enters a critical section from an ISR
+#define portEXIT_CRITICAL_ISR(mux) vPortExitCritical(mux) ///< Leaves a critical section from an ISR
+#define portENTER_CRITICAL_SAFE(mux) vPortEnterCritical(mux) ///< Enters a critical section from anywhere
+#define portEXIT_CRITICAL_SAFE(mux) vPortExitCritical(mux) ///< Leaves a critical section from anywhere
+
+/**
+ * Returns the core running the caller. The host is modelled as a single core.
+ * @return Always 0
+ */
+BaseType_t xPortGetCoreID(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //GYRO_READER_FAKE_FREERTOS_H
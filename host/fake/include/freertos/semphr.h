@@ -0,0 +1,57 @@
+/**
+ * @file semphr.h
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Host stand-in for the FreeRTOS semaphores used by the library. Mutexes are binary semaphores given at
+ * creation, without priority inheritance.
+ */
+
+#ifndef GYRO_READER_FAKE_SEMPHR_H
+#define GYRO_READER_FAKE_SEMPHR_H
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct fake_semaphore *SemaphoreHandle_t;
+
+/**
+ * Creates a mutex, which can be taken right away.
+ * @return Handle of the mutex, or NULL if it couldn't be created
+ */
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+
+/**
+ * Creates a binary semaphore, which must be given before it can be taken.
+ * @return Handle of the semaphore, or NULL if it couldn't be created
+ */
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+
+/**
+ * Takes a semaphore, waiting for it on the simulated clock.
+ * @param semaphore Semaphore to take
+ * @param ticks Ticks to wait at most, or portMAX_DELAY
+ * @return pdTRUE if the semaphore was taken, pdFALSE on timeout
+ */
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
+
+/**
+ * Gives a semaphore, waking up the tasks waiting for it.
+ * @param semaphore Semaphore to give
+ * @return pdTRUE if the semaphore was given, pdFALSE if it was already available
+ */
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+
+/**
+ * Deletes a semaphore.
+ * @param semaphore Semaphore to delete
+ */
+void vSemaphoreDelete(SemaphoreHandle_t semaphore);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //GYRO_READER_FAKE_SEMPHR_H
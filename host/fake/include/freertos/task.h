@@ -0,0 +1,92 @@
+/**
+ * @file task.h
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Host stand-in for the FreeRTOS task functions used by the library. Each task is a thread, and blocking
+ * calls wait on the simulated clock.
+ */
+
+#ifndef GYRO_READER_FAKE_TASK_H
+#define GYRO_READER_FAKE_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct fake_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *arg);
+
+/**
+ * Creates a task, which starts running right away. The core is ignored.
+ * @return pdPASS if the task was created, pdFAIL otherwise
+ */
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_bytes, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *task, BaseType_t core);
+
+/**
+ * Creates a task which can run on any core.
+ * @return pdPASS if the task was created, pdFAIL otherwise
+ */
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_bytes, void *arg,
+                       UBaseType_t priority, TaskHandle_t *task);
+
+/**
+ * Deletes a task. Only the calling task (NULL) can be deleted on the host.
+ * @param task Task to delete, NULL for the caller
+ */
+void vTaskDelete(TaskHandle_t task);
+
+/**
+ * Blocks the calling task for the given amount of ticks of the simulated clock. 0 just yields.
+ * @param ticks Ticks to wait
+ */
+void vTaskDelay(TickType_t ticks);
+
+/**
+ * Increments the notification value of a task, waking it up if it's waiting for it.
+ * @param task Task to notify
+ * @return Always pdPASS
+ */
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+
+/**
+ * Waits until the notification value of the calling task is not zero, and then clears or decrements it.
+ * @param clear pdTRUE to clear the value, pdFALSE to decrement it
+ * @param ticks Ticks to wait at most, or portMAX_DELAY
+ * @return Notification value before it was cleared or decremented, 0 on timeout
+ */
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+
+/**
+ * Returns the least stack a task has had left. Stacks aren't measured on the host, so it's the whole stack.
+ * @param task Task to check, NULL for the caller
+ * @return Stack size of the task in bytes
+ */
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+/**
+ * Returns the calling task.
+ * @return Handle of the calling task
+ */
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+/**
+ * Returns the name of a task.
+ * @param task Task to check, NULL for the caller
+ * @return Name the task was created with
+ */
+char *pcTaskGetName(TaskHandle_t task);
+
+/**
+ * Returns the time of the simulated clock in ticks.
+ * @return Ticks elapsed since the start of the program
+ */
+TickType_t xTaskGetTickCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //GYRO_READER_FAKE_TASK_H
@@ -0,0 +1,31 @@
+/**
+ * @file cpu_hal.h
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Host stand-in for the CPU cycle counter. Cycles are derived from the host's monotonic clock at 240 MHz, so
+ * short code paths (like a group start) are measured in real time, unlike everything timed with esp_timer. Tests can
+ * replace the source of the cycles with fake_sim_set_cycle_source.
+ */
+
+#ifndef GYRO_READER_FAKE_CPU_HAL_H
+#define GYRO_READER_FAKE_CPU_HAL_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FAKE_CPU_HAL_MHZ 240u ///< Frequency the cycle counter runs at
+
+/**
+ * Reads the cycle counter.
+ * @return Cycles elapsed, wrapping around every 32 bits like on the chip
+ */
+uint32_t cpu_hal_get_cycle_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //GYRO_READER_FAKE_CPU_HAL_H
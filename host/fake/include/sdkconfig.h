@@ -0,0 +1,14 @@
+/**
+ * @file sdkconfig.h
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Host stand-in for the project configuration. Power management is disabled, as in the default configuration,
+ * except in the variant built with CONFIG_PM_ENABLE, which gets counting locks from esp_pm.h.
+ */
+
+#ifndef GYRO_READER_FAKE_SDKCONFIG_H
+#define GYRO_READER_FAKE_SDKCONFIG_H
+
+#define CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ 240 ///< CPU frequency the cycle counter is emulated at
+
+#endif //GYRO_READER_FAKE_SDKCONFIG_H
@@ -0,0 +1,274 @@
+/**
+ * @file buzzer_render.c
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the definitions for the offline renderer.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_timer.h>
+#include "buzzer/buzzer_player.h"
+#include "buzzer/buzzer_sound.h"
+#include "fake_ledc.h"
+#include "buzzer_render.h"
+
+#define BUZZER_RENDER_CHUNK 256 ///< Samples rendered at once before handing them to the write callback
+#define BUZZER_RENDER_HEADER_SIZE 44u ///< Size of the WAV header
+#define BUZZER_RENDER_BYTES_PER_SAMPLE 2u ///< 16 bit samples
+#define BUZZER_RENDER_PHASE_ONE (1ull << 32u) ///< One full period in the 32.32 fixed point phase accumulator
+#define BUZZER_RENDER_GPIO GPIO_NUM_4 ///< Pin of the buzzer melodies are rendered with
+#define BUZZER_RENDER_DIV_FRAC_BITS 8u ///< Fractional bits of the LEDC timer divider
+
+/**
+ * Struct storing the state of the rendered timer and channel, as rebuilt from the LEDC writes
+ */
+typedef struct _buzzer_render_state_t {
+    const buzzer_render_config_t *config; ///< Render configuration
+    uint32_t sample_rate; ///< Sample rate in Hz
+    uint32_t clk_hz; ///< Clock of the timer
+    uint32_t divider; ///< Divider of the timer, with BUZZER_RENDER_DIV_FRAC_BITS fractional bits (0 if unconfigured)
+    uint8_t duty_res_bits; ///< Duty resolution of the timer
+    bool running; ///< Whether the timer is counting
+    uint32_t duty; ///< Duty of the channel, in steps of its timer's resolution
+    uint64_t phase; ///< Position within the current period, in 32.32 fixed point periods
+    uint64_t step; ///< Phase advanced per sample
+    uint64_t high; ///< Part of each period the output is high for, in 32.32 fixed point periods
+} buzzer_render_state_t;
+
+// Private function declarations
+static void buzzer_render_done(buzzer_sound_t *sound, void *arg);
+static esp_err_t buzzer_render_play(buzzer_t *buzzer, const buzzer_melody_t *melody, uint32_t bpm,
+                                    const buzzer_render_config_t *config, int64_t *end_us);
+static void buzzer_render_apply(buzzer_render_state_t *state, const fake_ledc_event_t *event,
+                                ledc_channel_t channel, ledc_timer_t timer);
+static void buzzer_render_put_u16(uint8_t *dst, uint16_t value);
+static void buzzer_render_put_u32(uint8_t *dst, uint32_t value);
+static esp_err_t buzzer_render_header(buzzer_render_state_t *state, uint32_t samples);
+
+// Public functions
+
+esp_err_t buzzer_render_melody_wav(const buzzer_melody_t *melody, uint32_t bpm, const buzzer_render_config_t *config) {
+    if (!melody || !config || !config->write || bpm == 0) return ESP_FAIL;
+    bool endless = melody->loop_start < melody->loop_end && melody->loop_count == BUZZER_LOOP_FOREVER;
+    if (endless) return ESP_FAIL; // The file would never end
+    bool tempo_changed = config->tempo && config->tempo != 100;
+    if (config->engine == BUZZER_RENDER_BLOCKING && (config->transpose_cents || tempo_changed)) {
+        return ESP_FAIL; // The blocking functions can't transpose nor change the tempo
+    }
+
+    // Recording from before the buzzer is created, so the initial state of its timer and channel is known
+    fake_ledc_reset();
+    fake_ledc_set_recording(true);
+    buzzer_t *buzzer = buzzer_init(BUZZER_RENDER_CHANNEL, BUZZER_RENDER_TIMER, BUZZER_RENDER_GPIO);
+    if (!buzzer) {
+        fake_ledc_set_recording(false);
+        return ESP_FAIL;
+    }
+
+    int64_t start_us = esp_timer_get_time(), end_us = start_us;
+    esp_err_t ret = buzzer_render_play(buzzer, melody, bpm, config, &end_us);
+
+    if (ret == ESP_OK) {
+        ret = buzzer_render_timeline_wav(BUZZER_RENDER_CHANNEL, BUZZER_RENDER_TIMER, start_us, end_us, config);
+    }
+    buzzer_destroy(buzzer);
+    fake_ledc_set_recording(false);
+    return ret;
+}
+
+esp_err_t buzzer_render_timeline_wav(ledc_channel_t channel, ledc_timer_t timer, int64_t start_us, int64_t end_us,
+                                     const buzzer_render_config_t *config) {
+    if (!config || !config->write || end_us < start_us) return ESP_FAIL;
+
+    buzzer_render_state_t state = {
+            .config = config,
+            .sample_rate = config->sample_rate ? config->sample_rate : BUZZER_RENDER_DEFAULT_SAMPLE_RATE,
+            .running = true // A timer counts from the moment it's configured
+    };
+    uint32_t total_samples = (uint32_t) (((end_us - start_us) * state.sample_rate) / 1000000);
+    esp_err_t ret = buzzer_render_header(&state, total_samples);
+    if (ret != ESP_OK) return ret;
+
+    size_t count;
+    const fake_ledc_event_t *events = fake_ledc_get_events(&count);
+    size_t next = 0;
+    uint8_t chunk[BUZZER_RENDER_CHUNK * BUZZER_RENDER_BYTES_PER_SAMPLE];
+    uint32_t filled = 0;
+    for (uint32_t i = 0; i < total_samples; i++) {
+        // Every write made up to this sample's time takes effect before it
+        int64_t time_us = start_us + (int64_t) (((uint64_t) i * 1000000u) / state.sample_rate);
+        while (next < count && events[next].time_us <= time_us) {
+            buzzer_render_apply(&state, &events[next++], channel, timer);
+        }
+
+        // A paused timer holds the pin, and a constant level (like a duty of 0 or 100 %) makes no sound
+        int16_t sample = 0;
+        if (state.running && state.step && state.high > 0 && state.high < BUZZER_RENDER_PHASE_ONE) {
+            sample = (state.phase & (BUZZER_RENDER_PHASE_ONE - 1)) < state.high
+                     ? BUZZER_RENDER_AMPLITUDE : -BUZZER_RENDER_AMPLITUDE;
+        }
+        if (state.running) state.phase += state.step;
+
+        buzzer_render_put_u16(&chunk[filled * BUZZER_RENDER_BYTES_PER_SAMPLE], (uint16_t) sample);
+        if (++filled == BUZZER_RENDER_CHUNK || i + 1 == total_samples) {
+            ret = config->write(chunk, filled * BUZZER_RENDER_BYTES_PER_SAMPLE, config->arg);
+            if (ret != ESP_OK) return ret;
+            filled = 0;
+        }
+    }
+    return ESP_OK;
+}
+
+// Private functions
+
+/**
+ * Callback of the callback engine, signalling the end of the melody to the renderer.
+ * @param sound Sound which finished
+ * @param arg Semaphore to give
+ */
+static void buzzer_render_done(buzzer_sound_t *sound, void *arg) {
+    (void) sound;
+    xSemaphoreGive((SemaphoreHandle_t) arg);
+}
+
+/**
+ * Plays a melody with the configured engine, returning once it has ended on the simulated clock. The end is taken
+ * before the engine is destroyed, as waiting for its task or callback to let it go can take a tick.
+ * @param buzzer Buzzer to play the melody on
+ * @param melody Melody to play
+ * @param bpm Speed to play the melody at (in beats per minute)
+ * @param config Render configuration
+ * @param end_us Where the simulated time the melody ended at is stored
+ * @return ESP_OK if the melody was played, ESP_FAIL otherwise
+ */
+static esp_err_t buzzer_render_play(buzzer_t *buzzer, const buzzer_melody_t *melody, uint32_t bpm,
+                                    const buzzer_render_config_t *config, int64_t *end_us) {
+    uint16_t tempo = config->tempo ? config->tempo : 100;
+    esp_err_t ret = ESP_FAIL;
+
+    switch (config->engine) {
+        case BUZZER_RENDER_BLOCKING:
+            ret = buzzer_play_melody(buzzer, melody, bpm);
+            *end_us = esp_timer_get_time();
+            return ret;
+        case BUZZER_RENDER_PLAYER: {
+            buzzer_player_t *player = buzzer_player_create(buzzer, NULL);
+            if (!player) return ESP_FAIL;
+            ret = buzzer_player_set_transpose(player, config->transpose_cents);
+            if (ret == ESP_OK) ret = buzzer_player_set_tempo(player, tempo);
+            if (ret == ESP_OK) ret = buzzer_player_play_melody(player, melody, bpm);
+            // The player task loads the melody before the clock moves, so it's playing after the first tick
+            if (ret == ESP_OK) {
+                do {
+                    vTaskDelay(1);
+                } while (buzzer_player_get_state(player) != BUZZER_PLAYER_IDLE);
+                *end_us = esp_timer_get_time();
+            }
+            buzzer_player_destroy(player);
+            return ret;
+        }
+        case BUZZER_RENDER_SOUND: {
+            buzzer_sound_t *sound = buzzer_sound_create(buzzer);
+            SemaphoreHandle_t done = xSemaphoreCreateBinary();
+            if (sound && done) {
+                ret = buzzer_sound_set_transpose(sound, config->transpose_cents);
+                if (ret == ESP_OK) ret = buzzer_sound_set_tempo(sound, tempo);
+                if (ret == ESP_OK) ret = buzzer_sound_play_melody(sound, melody, bpm, buzzer_render_done, done);
+                if (ret == ESP_OK) xSemaphoreTake(done, portMAX_DELAY);
+                *end_us = esp_timer_get_time();
+            }
+            if (sound) buzzer_sound_destroy(sound);
+            if (done) vSemaphoreDelete(done);
+            return ret;
+        }
+        default:
+            return ESP_FAIL;
+    }
+}
+
+/**
+ * Applies a write to the LEDC to the rendered timer and channel, ignoring writes to other ones.
+ * @param state Rendered state
+ * @param event Write to apply
+ * @param channel Rendered channel
+ * @param timer Rendered timer
+ */
+static void buzzer_render_apply(buzzer_render_state_t *state, const fake_ledc_event_t *event,
+                                ledc_channel_t channel, ledc_timer_t timer) {
+    if (event->op == FAKE_LEDC_DUTY) {
+        if (event->index != channel) return;
+        state->duty = event->value;
+    } else {
+        if (event->index != timer) return;
+        switch (event->op) {
+            case FAKE_LEDC_DIVIDER:
+                state->divider = event->value;
+                state->clk_hz = event->clk_hz;
+                state->duty_res_bits = event->duty_res_bits;
+                break;
+            case FAKE_LEDC_RESET:
+                state->phase = 0; // The counter restarts, so the period does too
+                break;
+            case FAKE_LEDC_PAUSE:
+                state->running = false;
+                break;
+            case FAKE_LEDC_RESUME:
+                state->running = true;
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Same frequency the timer outputs: the clock divided by the divider and by the counter's range
+    double freq_hz = 0;
+    if (state->divider) {
+        freq_hz = ((double) state->clk_hz * (1u << BUZZER_RENDER_DIV_FRAC_BITS)) /
+                  ((double) state->divider * (double) (1ull << state->duty_res_bits));
+    }
+    state->step = (uint64_t) ((freq_hz * (double) BUZZER_RENDER_PHASE_ONE) / state->sample_rate);
+    state->high = state->divider ? (BUZZER_RENDER_PHASE_ONE * state->duty) >> state->duty_res_bits : 0;
+}
+
+/**
+ * Stores a 16 bit value in little endian order, as WAV files require.
+ */
+static void buzzer_render_put_u16(uint8_t *dst, uint16_t value) {
+    dst[0] = value & 0xFFu;
+    dst[1] = value >> 8u;
+}
+
+/**
+ * Stores a 32 bit value in little endian order, as WAV files require.
+ */
+static void buzzer_render_put_u32(uint8_t *dst, uint32_t value) {
+    buzzer_render_put_u16(dst, value & 0xFFFFu);
+    buzzer_render_put_u16(dst + 2, value >> 16u);
+}
+
+/**
+ * Writes the header of a 16 bit mono PCM WAV file.
+ * @param state Render in progress
+ * @param samples Amount of samples the file will contain
+ * @return Result of the write callback
+ */
+static esp_err_t buzzer_render_header(buzzer_render_state_t *state, uint32_t samples) {
+    uint8_t header[BUZZER_RENDER_HEADER_SIZE] = {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+                                                 'f', 'm', 't', ' ', 16, 0, 0, 0, 1, 0, 1, 0};
+    uint32_t data_size = samples * BUZZER_RENDER_BYTES_PER_SAMPLE;
+    buzzer_render_put_u32(&header[4], BUZZER_RENDER_HEADER_SIZE - 8 + data_size);
+    buzzer_render_put_u32(&header[24], state->sample_rate);
+    buzzer_render_put_u32(&header[28], state->sample_rate * BUZZER_RENDER_BYTES_PER_SAMPLE);
+    buzzer_render_put_u16(&header[32], BUZZER_RENDER_BYTES_PER_SAMPLE);
+    buzzer_render_put_u16(&header[34], BUZZER_RENDER_BYTES_PER_SAMPLE * 8);
+    header[36] = 'd';
+    header[37] = 'a';
+    header[38] = 't';
+    header[39] = 'a';
+    buzzer_render_put_u32(&header[40], data_size);
+    return state->config->write(header, sizeof(header), state->config->arg);
+}
@@ -0,0 +1,94 @@
+/**
+ * @file buzzer_render.h
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the declarations for the offline renderer, which plays a melody on the host build and turns
+ * the writes the library made to the simulated LEDC into the pulse wave the buzzer would output, as a WAV file, so
+ * melodies can be regression tested without a device.
+ *
+ * @details Nothing about the melody is modelled by the renderer: the notes are played by the library itself (the
+ * blocking functions, the player or the callback engine) over the simulated clock, and the wave is rebuilt from the
+ * dividers, duties, resets and pauses the LEDC received, so the render includes the engine's timing, transposition,
+ * tempo and duty as well as the LEDC quantization. Renders can be compared against golden files with
+ * tools/buzzer_wavdiff.py.
+ */
+
+#ifndef GYRO_READER_BUZZER_RENDER_H
+#define GYRO_READER_BUZZER_RENDER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <driver/ledc.h>
+#include "buzzer/buzzer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BUZZER_RENDER_DEFAULT_SAMPLE_RATE 44100u ///< Sample rate used when the configuration doesn't set one
+#define BUZZER_RENDER_AMPLITUDE 16384 ///< Amplitude of the rendered square wave (half of the 16 bit range)
+#define BUZZER_RENDER_CHANNEL LEDC_CHANNEL_0 ///< LEDC channel of the buzzer melodies are rendered with
+#define BUZZER_RENDER_TIMER LEDC_TIMER_0 ///< LEDC timer of the buzzer melodies are rendered with
+
+/**
+ * Callback used by the renderer to output the WAV file.
+ * @param data Bytes to write
+ * @param size Amount of bytes to write
+ * @param arg User argument provided in the render configuration
+ * @return ESP_OK if the bytes were written, anything else to abort the render
+ */
+typedef esp_err_t (*buzzer_render_write_t)(const void *data, size_t size, void *arg);
+
+/**
+ * Enumeration containing the engines a melody can be rendered with
+ */
+typedef enum _buzzer_render_engine_t {
+    BUZZER_RENDER_BLOCKING, ///< buzzer_play_melody, which doesn't support transposition nor tempo changes
+    BUZZER_RENDER_PLAYER,   ///< buzzer_player_play_melody
+    BUZZER_RENDER_SOUND,    ///< buzzer_sound_play_melody
+} buzzer_render_engine_t;
+
+/**
+ * Structure with the configuration used when rendering
+ */
+typedef struct _buzzer_render_config_t {
+    uint32_t sample_rate; ///< Sample rate of the WAV file in Hz, 0 means default
+    buzzer_render_engine_t engine; ///< Engine the melody is played with by buzzer_render_melody_wav
+    int32_t transpose_cents; ///< Transposition set on the engine before playing, in cents
+    uint16_t tempo; ///< Tempo set on the engine before playing, in percent. 0 means 100.
+    buzzer_render_write_t write; ///< Callback receiving the WAV file
+    void *arg; ///< User argument passed to write
+} buzzer_render_config_t;
+
+/**
+ * Renders the provided melody, played at the given speed in beats per minute by the configured engine, as a 16 bit
+ * mono WAV file. The melody is played on a new buzzer (BUZZER_RENDER_CHANNEL and BUZZER_RENDER_TIMER) after resetting
+ * the simulated LEDC, and takes as long on the simulated clock as it would on a device.
+ * @param melody Melody to render. Its loops are played, but it can't loop forever, as the file must end.
+ * @param bpm Speed to render the melody at (in beats per minute)
+ * @param config Render configuration
+ * @return ESP_OK if the melody was rendered, ESP_FAIL if the engine couldn't play it, the configuration is invalid (a
+ * transposition or tempo for the blocking engine) or the write callback failed
+ */
+esp_err_t buzzer_render_melody_wav(const buzzer_melody_t *melody, uint32_t bpm, const buzzer_render_config_t *config);
+
+/**
+ * Renders the writes recorded by the simulated LEDC for a channel and its timer within a span of simulated time, as a
+ * 16 bit mono WAV file. Recording must have been enabled (with fake_ledc_set_recording) before the timer and the
+ * channel were configured, so their whole state is known. This renders anything the library plays, not only melodies.
+ * @param channel LEDC channel of the buzzer
+ * @param timer LEDC timer of the buzzer
+ * @param start_us Simulated time of the first sample
+ * @param end_us Simulated time the render ends at
+ * @param config Render configuration. The engine, transposition and tempo are ignored.
+ * @return ESP_OK if the writes were rendered, ESP_FAIL if the arguments are invalid or the write callback failed
+ */
+esp_err_t buzzer_render_timeline_wav(ledc_channel_t channel, ledc_timer_t timer, int64_t start_us, int64_t end_us,
+                                     const buzzer_render_config_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //GYRO_READER_BUZZER_RENDER_H
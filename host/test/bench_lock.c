@@ -0,0 +1,134 @@
+/**
+ * @file bench_lock.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Benchmark of the buzzer locks, built against both the thread-safe and the BUZZER_THREAD_SAFE=0 variants of
+ * the library. The thread-safe build also checks that two tasks hammering the same buzzer leave its state matching
+ * the LEDC.
+ *
+ * @details On the host, critical sections are a pthread mutex and the frequency lock is a simulated semaphore, so the
+ * absolute numbers aren't those of the ESP32's spinlocks. The difference between both builds shows what the locks add
+ * to each call relative to the LEDC work around them.
+ */
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include "buzzer/buzzer.h"
+#include "test_util.h"
+
+#define BENCH_ITERATIONS 200000u ///< Frequency changes and play/pause pairs timed
+#define CONTENTION_ITERATIONS 20000u ///< Operations done by each task of the contention test
+
+#if BUZZER_THREAD_SAFE
+/**
+ * Task of the contention test
+ */
+typedef struct {
+    buzzer_t *buzzer; ///< Buzzer shared by both tasks
+    uint32_t base_hz; ///< First frequency the task sets
+    SemaphoreHandle_t done; ///< Given when the task finishes
+} contention_task_t;
+
+static uint32_t last_requested_hz; ///< Last frequency written to the LEDC timer
+
+// Private function declarations
+
+static void last_freq_observer(const fake_ledc_event_t *event, void *arg);
+
+static void contention_task(void *arg);
+#endif
+
+// Tests
+
+/**
+ * Times frequency changes and play/pause pairs on a single task.
+ */
+static void bench_single_task(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    TEST_CHECK(buzzer != NULL);
+
+    uint64_t start_ns = test_real_ns();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) buzzer_set_freq(buzzer, 440 + i % 100);
+    uint64_t freq_ns = test_real_ns() - start_ns;
+
+    start_ns = test_real_ns();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        buzzer_play(buzzer);
+        buzzer_pause(buzzer);
+    }
+    uint64_t play_ns = test_real_ns() - start_ns;
+
+    printf("lock (%s): buzzer_set_freq %.1f ns, buzzer_play + buzzer_pause %.1f ns\n",
+           BUZZER_THREAD_SAFE ? "thread-safe" : "BUZZER_THREAD_SAFE=0", (double) freq_ns / BENCH_ITERATIONS,
+           (double) play_ns / BENCH_ITERATIONS);
+    TEST_CHECK_EQ(buzzer_get_freq(buzzer), 440 + (BENCH_ITERATIONS - 1) % 100);
+    TEST_CHECK(!buzzer_is_playing(buzzer));
+    buzzer_destroy(buzzer);
+}
+
+#if BUZZER_THREAD_SAFE
+/**
+ * Changes the frequency and the playing state of a buzzer from two tasks at the same time, and checks that the state
+ * kept by the buzzer matches the LEDC afterwards.
+ */
+static void test_contention(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    fake_ledc_set_observer(last_freq_observer, NULL);
+
+    contention_task_t tasks[2] = {
+            {.buzzer = buzzer, .base_hz = 500, .done = xSemaphoreCreateBinary()},
+            {.buzzer = buzzer, .base_hz = 1500, .done = xSemaphoreCreateBinary()}
+    };
+    for (uint32_t i = 0; i < 2; i++) xTaskCreate(contention_task, "contention", 2048, &tasks[i], 5, NULL);
+    for (uint32_t i = 0; i < 2; i++) {
+        xSemaphoreTake(tasks[i].done, portMAX_DELAY);
+        vSemaphoreDelete(tasks[i].done);
+    }
+    fake_ledc_set_observer(NULL, NULL);
+
+    TEST_CHECK_EQ(buzzer_get_freq(buzzer), last_requested_hz);
+    TEST_CHECK_EQ(buzzer_is_playing(buzzer), fake_ledc_is_running(LEDC_TIMER_0));
+    buzzer_destroy(buzzer);
+}
+#endif
+
+int main(void) {
+    TEST_RUN(bench_single_task);
+#if BUZZER_THREAD_SAFE
+    TEST_RUN(test_contention);
+#endif
+    return TEST_RESULT();
+}
+
+// Private functions
+
+#if BUZZER_THREAD_SAFE
+/**
+ * Remembers the last frequency requested from the LEDC.
+ * @param event Write to the LEDC
+ * @param arg Unused
+ */
+static void last_freq_observer(const fake_ledc_event_t *event, void *arg) {
+    (void) arg;
+    if (event->op == FAKE_LEDC_DIVIDER && event->index == LEDC_TIMER_0) last_requested_hz = event->freq_hz;
+}
+
+/**
+ * Body of the tasks of the contention test.
+ * @param arg Task description
+ */
+static void contention_task(void *arg) {
+    contention_task_t *task = arg;
+    for (uint32_t i = 0; i < CONTENTION_ITERATIONS; i++) {
+        buzzer_set_freq(task->buzzer, task->base_hz + i % 500);
+        if (i % 2) {
+            buzzer_play(task->buzzer);
+        } else {
+            buzzer_pause(task->buzzer);
+        }
+    }
+    xSemaphoreGive(task->done);
+    vTaskDelete(NULL);
+}
+#endif
@@ -0,0 +1,205 @@
+/**
+ * @file footprint.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Measures the memory taken by the library on the host and prints it as the Markdown tables of the README:
+ * the size of the structures kept in RAM (and the RAM a melody library declared static const keeps free), and what
+ * creating each engine and playing a melody on it costs.
+ *
+ * @details Heap is counted by wrapping malloc and calloc at link time, so only the library's own allocations are seen.
+ * Task stacks and esp_timers are counted by the host stand-ins. Sizes depend on the pointer width, so the numbers are
+ * those of the host (x86-64, 8 byte pointers); the kernel objects behind tasks, timers and semaphores aren't included,
+ * as their size is ESP-IDF's.
+ */
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_timer.h>
+#include "buzzer/buzzer.h"
+#include "buzzer/buzzer_player.h"
+#include "buzzer/buzzer_sound.h"
+#include "buzzer/buzzer_dual.h"
+#include "buzzer/buzzer_lfo.h"
+#include "fake_sim.h"
+#include "test_util.h"
+
+#define FOOTPRINT_NOTES 50u ///< Notes of the melody played on each engine
+#define FOOTPRINT_BPM 6000u ///< Speed the melody is played at, so it ends quickly
+#define FOOTPRINT_LIBRARY_MELODIES 20u ///< Melodies of FOOTPRINT_NOTES notes in the library kept in flash
+
+#if BUZZER_COMPACT
+#define FOOTPRINT_VARIANT "compact" ///< Name of the library variant being measured
+#else
+#define FOOTPRINT_VARIANT "default" ///< Name of the library variant being measured
+#endif
+
+/**
+ * Resources taken by a step, as differences between two snapshots
+ */
+typedef struct {
+    size_t heap; ///< Bytes allocated by the library
+    size_t stack; ///< Bytes of task stack reserved
+    size_t timers; ///< esp_timers created
+} footprint_t;
+
+static atomic_size_t footprint_heap; ///< Bytes allocated so far through malloc and calloc
+
+void *__real_malloc(size_t size);
+
+void *__real_calloc(size_t count, size_t size);
+
+// Private function declarations
+
+static footprint_t footprint_take(void);
+
+static footprint_t footprint_since(footprint_t before);
+
+static void footprint_print_engine(const char *name, footprint_t created, footprint_t played);
+
+static void footprint_wait(void);
+
+// Tests
+
+/**
+ * Prints the size of the structures which can be kept in RAM in large numbers.
+ */
+static void print_structures(void) {
+    footprint_t before = footprint_take();
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    footprint_t created = footprint_since(before);
+    TEST_CHECK(buzzer != NULL);
+
+    printf("| Structure (x86-64 host) | %s |\n|---|---|\n", FOOTPRINT_VARIANT);
+    printf("| `buzzer_musical_note_t` | %zu B |\n", sizeof(buzzer_musical_note_t));
+    printf("| `buzzer_t` | %zu B |\n", created.heap);
+    printf("| `buzzer_melody_t` | %zu B |\n", sizeof(buzzer_melody_t));
+    printf("| `buzzer_pattern_t` | %zu B |\n", sizeof(buzzer_pattern_t));
+    // Melodies played in place from flash take none of their notes or descriptors from RAM
+    printf("| %u melodies of %u notes, kept in flash | %zu B |\n\n", (unsigned) FOOTPRINT_LIBRARY_MELODIES,
+           (unsigned) FOOTPRINT_NOTES,
+           FOOTPRINT_LIBRARY_MELODIES * (FOOTPRINT_NOTES * sizeof(buzzer_musical_note_t) + sizeof(buzzer_melody_t)));
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Creates each engine, plays a melody on it when it can, and prints what both steps cost.
+ */
+static void print_engines(void) {
+    static buzzer_musical_note_t notes[FOOTPRINT_NOTES];
+    for (uint32_t i = 0; i < FOOTPRINT_NOTES; i++) {
+        notes[i] = (buzzer_musical_note_t) {.note = BUZZER_NOTE_A, .octave = 4, .type = BUZZER_NTYPE_CROTCHET};
+    }
+    buzzer_melody_t melody = BUZZER_MELODY_INIT(notes, FOOTPRINT_NOTES);
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_t *high = buzzer_init(LEDC_CHANNEL_1, LEDC_TIMER_1, GPIO_NUM_5);
+    footprint_t before, created, played;
+
+    printf("| Engine (x86-64 host, %s) | Create: heap | Create: task stacks | Create: esp_timers | "
+           "Melody of %u notes: heap |\n|---|---|---|---|---|\n", FOOTPRINT_VARIANT, (unsigned) FOOTPRINT_NOTES);
+
+    before = footprint_take();
+    buzzer_player_t *player = buzzer_player_create(buzzer, NULL);
+    created = footprint_since(before);
+    TEST_CHECK(player != NULL);
+    before = footprint_take();
+    TEST_CHECK_EQ(buzzer_player_play_melody(player, &melody, FOOTPRINT_BPM), ESP_OK);
+    footprint_wait();
+    played = footprint_since(before);
+    footprint_print_engine("Player (`buzzer_player.h`)", created, played);
+    buzzer_player_destroy(player);
+
+    before = footprint_take();
+    buzzer_sound_t *sound = buzzer_sound_create(buzzer);
+    created = footprint_since(before);
+    TEST_CHECK(sound != NULL);
+    before = footprint_take();
+    TEST_CHECK_EQ(buzzer_sound_play_melody(sound, &melody, FOOTPRINT_BPM, NULL, NULL), ESP_OK);
+    footprint_wait();
+    played = footprint_since(before);
+    footprint_print_engine("Callback (`buzzer_sound.h`)", created, played);
+    buzzer_sound_destroy(sound);
+
+    before = footprint_take();
+    buzzer_dual_t *dual = buzzer_dual_create(buzzer, high);
+    created = footprint_since(before);
+    TEST_CHECK(dual != NULL);
+    footprint_print_engine("Dual tone (`buzzer_dual.h`)", created, (footprint_t) {SIZE_MAX, 0, 0});
+    buzzer_dual_destroy(dual);
+
+    before = footprint_take();
+    buzzer_lfo_t *lfo = buzzer_lfo_create(buzzer);
+    created = footprint_since(before);
+    TEST_CHECK(lfo != NULL);
+    footprint_print_engine("LFO (`buzzer_lfo.h`)", created, (footprint_t) {SIZE_MAX, 0, 0});
+    buzzer_lfo_destroy(lfo);
+
+    buzzer_destroy(high);
+    buzzer_destroy(buzzer);
+}
+
+int main(void) {
+    print_structures();
+    print_engines();
+    return TEST_RESULT();
+}
+
+// Private functions
+
+/**
+ * Counts the bytes allocated by the library before allocating them.
+ * @param size Bytes to allocate
+ * @return The allocated memory
+ */
+void *__wrap_malloc(size_t size) {
+    atomic_fetch_add(&footprint_heap, size);
+    return __real_malloc(size);
+}
+
+/**
+ * Counts the bytes allocated by the library before allocating them.
+ * @param count Amount of elements
+ * @param size Bytes per element
+ * @return The allocated memory
+ */
+void *__wrap_calloc(size_t count, size_t size) {
+    atomic_fetch_add(&footprint_heap, count * size);
+    return __real_calloc(count, size);
+}
+
+/**
+ * Takes a snapshot of the resources in use.
+ * @return Heap allocated so far, task stacks reserved and timers alive
+ */
+static footprint_t footprint_take(void) {
+    return (footprint_t) {atomic_load(&footprint_heap), fake_sim_task_stack_bytes(), fake_esp_timer_count()};
+}
+
+/**
+ * Returns the resources taken since a snapshot.
+ * @param before Snapshot to compare with
+ * @return Resources taken since then
+ */
+static footprint_t footprint_since(footprint_t before) {
+    footprint_t now = footprint_take();
+    return (footprint_t) {now.heap - before.heap, now.stack - before.stack, now.timers - before.timers};
+}
+
+/**
+ * Prints the row of an engine.
+ * @param name Name of the engine
+ * @param created Resources taken by creating it
+ * @param played Resources taken by playing the melody, with SIZE_MAX heap if it can't play melodies
+ */
+static void footprint_print_engine(const char *name, footprint_t created, footprint_t played) {
+    printf("| %s | %zu B | %zu B | %zu |", name, created.heap, created.stack, created.timers);
+    if (played.heap == SIZE_MAX) printf(" n/a |\n");
+    else printf(" %zu B |\n", played.heap);
+}
+
+/**
+ * Lets the melody being played end, which takes FOOTPRINT_NOTES crotchets.
+ */
+static void footprint_wait(void) {
+    fake_sim_sleep_until(esp_timer_get_time() + (int64_t) (FOOTPRINT_NOTES + 2) * 60000000 / FOOTPRINT_BPM);
+}
@@ -0,0 +1,254 @@
+/**
+ * @file test_dual.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Tests of dual-tone output: the DTMF keypad frequencies, the tones played for a string of digits, that a
+ * request applied by the timer firing on its own right before the control function fires it doesn't cut the new tones
+ * short, and that of several requests left while the callback runs only the last one is played and finishes.
+ */
+
+#include <stdlib.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_timer.h>
+#include "buzzer/buzzer.h"
+#include "buzzer/buzzer_dual.h"
+#include "fake_sim.h"
+#include "test_util.h"
+
+#define DUAL_TONE_US 100000 ///< Length of the tones played
+#define DUAL_FREQ_TOLERANCE 2 ///< Hz a frequency may differ from the requested one by, due to the LEDC quantization
+
+/**
+ * Ends of the tones seen by the done callback
+ */
+typedef struct {
+    uint32_t calls; ///< Times the callback was called
+    int64_t time_us; ///< Simulated time of the last call
+    bool destroy; ///< Whether the callback must try to destroy the output
+} done_t;
+
+/**
+ * LEDC observer keeping the callback busy in its first frequency write
+ */
+typedef struct {
+    int64_t until_us; ///< Simulated time the write returns at
+    bool called; ///< Whether the write was seen
+} slow_write_t;
+
+// Private function declarations
+
+static void dual_done(buzzer_dual_t *dual, void *arg);
+
+static void race_hook(esp_timer_handle_t timer, void *arg);
+
+static void slow_observer(const fake_ledc_event_t *event, void *arg);
+
+static bool freq_near(ledc_timer_t timer, uint32_t freq_hz);
+
+// Tests
+
+/**
+ * Checks the row and column frequencies of every key of the keypad, in both cases, and that other characters are
+ * rejected.
+ */
+static void test_dtmf_table(void) {
+    static const char keys[] = "123A456B789C*0#D";
+    static const uint16_t rows_hz[] = {697, 770, 852, 941};
+    static const uint16_t columns_hz[] = {1209, 1336, 1477, 1633};
+
+    for (uint32_t i = 0; i < sizeof(keys) - 1; i++) {
+        uint16_t low_hz = 0, high_hz = 0;
+        TEST_CHECK_EQ(buzzer_dtmf_get_freqs(keys[i], &low_hz, &high_hz), ESP_OK);
+        TEST_CHECK_EQ(low_hz, rows_hz[i / 4]);
+        TEST_CHECK_EQ(high_hz, columns_hz[i % 4]);
+    }
+    uint16_t low_hz = 0, high_hz = 0;
+    TEST_CHECK_EQ(buzzer_dtmf_get_freqs('d', &low_hz, &high_hz), ESP_OK);
+    TEST_CHECK_EQ(low_hz, 941);
+    TEST_CHECK_EQ(high_hz, 1633);
+    TEST_CHECK_EQ(buzzer_dtmf_get_freqs('5', NULL, NULL), ESP_OK);
+
+    static const char invalid[] = {'E', 'e', 'x', ' ', '+', '\0'};
+    for (uint32_t i = 0; i < sizeof(invalid); i++) {
+        TEST_CHECK_EQ(buzzer_dtmf_get_freqs(invalid[i], NULL, NULL), ESP_FAIL);
+    }
+}
+
+/**
+ * Plays a string of digits, and checks the tones of each one, the gaps between them and the end.
+ */
+static void test_dtmf_digits(void) {
+    buzzer_t *low = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_t *high = buzzer_init(LEDC_CHANNEL_1, LEDC_TIMER_1, GPIO_NUM_5);
+    buzzer_dual_t *dual = buzzer_dual_create(low, high);
+    done_t done = {0};
+
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_dual_play_dtmf(dual, "1#", BUZZER_DTMF_TONE_MS, BUZZER_DTMF_GAP_MS, dual_done, &done), ESP_OK);
+    fake_sim_sleep_until(start_us + BUZZER_DTMF_TONE_MS * 1000 / 2);
+    TEST_CHECK(freq_near(LEDC_TIMER_0, 697) && freq_near(LEDC_TIMER_1, 1209));
+    TEST_CHECK(fake_ledc_is_running(LEDC_TIMER_0) && fake_ledc_is_running(LEDC_TIMER_1));
+    fake_sim_sleep_until(start_us + BUZZER_DTMF_TONE_MS * 1000 * 3 / 2);
+    TEST_CHECK(!fake_ledc_is_running(LEDC_TIMER_0) && !fake_ledc_is_running(LEDC_TIMER_1));
+    fake_sim_sleep_until(start_us + (BUZZER_DTMF_TONE_MS + BUZZER_DTMF_GAP_MS) * 1000 + BUZZER_DTMF_TONE_MS * 1000 / 2);
+    TEST_CHECK(freq_near(LEDC_TIMER_0, 941) && freq_near(LEDC_TIMER_1, 1477));
+    TEST_CHECK(buzzer_dual_is_playing(dual));
+    fake_sim_sleep_until(start_us + (3 * BUZZER_DTMF_TONE_MS + BUZZER_DTMF_GAP_MS) * 1000);
+
+    TEST_CHECK_EQ(done.calls, 1);
+    TEST_CHECK_EQ(done.time_us - start_us, (2 * BUZZER_DTMF_TONE_MS + BUZZER_DTMF_GAP_MS) * 1000);
+    TEST_CHECK(!buzzer_dual_is_playing(dual));
+    TEST_CHECK_EQ(buzzer_dual_play_dtmf(dual, "12E", BUZZER_DTMF_TONE_MS, BUZZER_DTMF_GAP_MS, NULL, NULL), ESP_FAIL);
+
+    buzzer_dual_destroy(dual);
+    buzzer_destroy(high);
+    buzzer_destroy(low);
+}
+
+/**
+ * Starts new tones while others play, letting the timer reach the end of the current ones (and apply the request)
+ * between the request being left and the timer being fired, and checks the new tones still last their whole length.
+ */
+static void test_request_race(void) {
+    buzzer_t *low = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_t *high = buzzer_init(LEDC_CHANNEL_1, LEDC_TIMER_1, GPIO_NUM_5);
+    buzzer_dual_t *dual = buzzer_dual_create(low, high);
+    done_t first = {0}, second = {0};
+
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_dual_play_ms(dual, 400, 1000, DUAL_TONE_US / 1000, dual_done, &first), ESP_OK);
+    fake_sim_sleep_until(start_us + DUAL_TONE_US / 2);
+    int64_t until_us = start_us + DUAL_TONE_US + 1;
+    fake_esp_timer_set_stop_hook(race_hook, &until_us);
+    TEST_CHECK_EQ(buzzer_dual_play_ms(dual, 500, 1200, DUAL_TONE_US / 1000, dual_done, &second), ESP_OK);
+    fake_esp_timer_set_stop_hook(NULL, NULL);
+    TEST_CHECK_EQ(until_us, 0);
+
+    fake_sim_sleep_until(start_us + DUAL_TONE_US * 3 / 2);
+    TEST_CHECK(freq_near(LEDC_TIMER_0, 500) && freq_near(LEDC_TIMER_1, 1200));
+    TEST_CHECK(fake_ledc_is_running(LEDC_TIMER_0) && fake_ledc_is_running(LEDC_TIMER_1));
+    fake_sim_sleep_until(start_us + DUAL_TONE_US * 3);
+    TEST_CHECK_EQ(first.calls, 0);
+    TEST_CHECK_EQ(second.calls, 1);
+    TEST_CHECK_EQ(second.time_us - start_us, 2 * DUAL_TONE_US);
+
+    buzzer_dual_destroy(dual);
+    buzzer_destroy(high);
+    buzzer_destroy(low);
+}
+
+/**
+ * Leaves two play requests back to back while the callback is starting the tones of a third one, and checks only the
+ * last one is played, and that it finishes with its own done callback argument.
+ */
+static void test_request_while_running(void) {
+    buzzer_t *low = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_t *high = buzzer_init(LEDC_CHANNEL_1, LEDC_TIMER_1, GPIO_NUM_5);
+    buzzer_dual_t *dual = buzzer_dual_create(low, high);
+    done_t first = {0}, second = {0}, third = {0};
+
+    int64_t start_us = esp_timer_get_time();
+    slow_write_t slow = {.until_us = start_us + DUAL_TONE_US / 2};
+    fake_ledc_set_observer(slow_observer, &slow);
+    TEST_CHECK_EQ(buzzer_dual_play_ms(dual, 400, 1000, DUAL_TONE_US / 1000, dual_done, &first), ESP_OK);
+    fake_sim_sleep_until(start_us + DUAL_TONE_US / 4);
+    TEST_CHECK(slow.called);
+    TEST_CHECK_EQ(buzzer_dual_play_ms(dual, 500, 1200, DUAL_TONE_US / 1000, dual_done, &second), ESP_OK);
+    TEST_CHECK_EQ(buzzer_dual_play_dtmf(dual, "1", BUZZER_DTMF_TONE_MS, 0, dual_done, &third), ESP_OK);
+    fake_sim_sleep_until(start_us + DUAL_TONE_US / 2 + BUZZER_DTMF_TONE_MS * 1000 / 2);
+    fake_ledc_set_observer(NULL, NULL);
+    TEST_CHECK(freq_near(LEDC_TIMER_0, 697) && freq_near(LEDC_TIMER_1, 1209));
+
+    fake_sim_sleep_until(start_us + 3 * DUAL_TONE_US);
+    TEST_CHECK_EQ(first.calls, 0);
+    TEST_CHECK_EQ(second.calls, 0);
+    TEST_CHECK_EQ(third.calls, 1);
+    TEST_CHECK_EQ(third.time_us - start_us, DUAL_TONE_US / 2 + BUZZER_DTMF_TONE_MS * 1000);
+    TEST_CHECK(!buzzer_dual_is_playing(dual));
+
+    buzzer_dual_destroy(dual);
+    buzzer_destroy(high);
+    buzzer_destroy(low);
+}
+
+/**
+ * Destroys the output from its done callback, and checks the call is refused instead of waiting forever.
+ */
+static void test_destroy_from_callback(void) {
+    buzzer_t *low = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_t *high = buzzer_init(LEDC_CHANNEL_1, LEDC_TIMER_1, GPIO_NUM_5);
+    buzzer_dual_t *dual = buzzer_dual_create(low, high);
+    done_t done = {.destroy = true};
+
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_dual_play_ms(dual, 400, 1000, DUAL_TONE_US / 1000, dual_done, &done), ESP_OK);
+    fake_sim_sleep_until(start_us + 2 * DUAL_TONE_US);
+    TEST_CHECK_EQ(done.calls, 1);
+    TEST_CHECK_EQ(buzzer_dual_play_ms(dual, 400, 1000, DUAL_TONE_US / 1000, NULL, NULL), ESP_OK);
+    fake_esp_timer_flush();
+    TEST_CHECK(buzzer_dual_is_playing(dual));
+
+    buzzer_dual_destroy(dual);
+    buzzer_destroy(high);
+    buzzer_destroy(low);
+}
+
+int main(void) {
+    TEST_RUN(test_dtmf_table);
+    TEST_RUN(test_dtmf_digits);
+    TEST_RUN(test_request_race);
+    TEST_RUN(test_request_while_running);
+    TEST_RUN(test_destroy_from_callback);
+    return TEST_RESULT();
+}
+
+// Private functions
+
+/**
+ * Records the end of the tones, and tries to destroy the output if asked to.
+ * @param dual Dual-tone output which finished
+ * @param arg Ends seen so far
+ */
+static void dual_done(buzzer_dual_t *dual, void *arg) {
+    done_t *done = arg;
+    done->calls++;
+    done->time_us = esp_timer_get_time();
+    if (done->destroy) buzzer_dual_destroy(dual);
+}
+
+/**
+ * Lets the timer fire on its own before the first stop it sees goes ahead, by waiting past the time it's armed for.
+ * @param timer Timer being stopped
+ * @param arg Simulated time to wait for, cleared once waited for
+ */
+static void race_hook(esp_timer_handle_t timer, void *arg) {
+    (void) timer;
+    int64_t *until_us = arg;
+    if (*until_us == 0) return;
+    int64_t wait_us = *until_us;
+    *until_us = 0;
+    fake_sim_sleep_until(wait_us);
+}
+
+/**
+ * Holds the first frequency write until the simulated clock reaches the time it waits for, keeping the callback
+ * running until then.
+ * @param event Write to the LEDC
+ * @param arg Observer state
+ */
+static void slow_observer(const fake_ledc_event_t *event, void *arg) {
+    slow_write_t *slow = arg;
+    if (event->op != FAKE_LEDC_DIVIDER || slow->called) return;
+    slow->called = true;
+    fake_sim_sleep_until(slow->until_us);
+}
+
+/**
+ * Checks the frequency a timer is set to, within the LEDC quantization.
+ * @param timer Timer to check
+ * @param freq_hz Expected frequency
+ * @return Whether the timer is close enough to the frequency
+ */
+static bool freq_near(ledc_timer_t timer, uint32_t freq_hz) {
+    return abs((int) fake_ledc_get_freq(timer) - (int) freq_hz) <= DUAL_FREQ_TOLERANCE;
+}
@@ -0,0 +1,204 @@
+/**
+ * @file test_duty.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Tests of the duty of melodies: every engine outputs a melody with the duty it carries, and sets the previous
+ * duty back once the melody ends or is stopped, so later melodies without a duty don't inherit it.
+ */
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include "buzzer/buzzer.h"
+#include "buzzer/buzzer_player.h"
+#include "buzzer/buzzer_sound.h"
+#include "fake_sim.h"
+#include "test_util.h"
+
+#define DUTY_BPM 600u ///< Speed the melodies are played at, so crotchets last 100 ms
+#define DUTY_PREVIOUS 30u ///< Duty the buzzer is set to before playing the melodies
+
+/**
+ * Duties written to the buzzer's channel, followed through the writes to the LEDC
+ */
+typedef struct {
+    bool melody_seen; ///< Whether the duty of the melody was written
+    uint32_t last; ///< Last duty register value written
+} duties_t;
+
+/**
+ * Duty of the buzzer seen by the done callback
+ */
+typedef struct {
+    buzzer_t *buzzer; ///< Buzzer the sound plays on
+    uint8_t duty; ///< Duty it had when the callback was called
+} done_t;
+
+static const buzzer_musical_note_t duty_notes[] = {
+        {.note = BUZZER_NOTE_A, .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+        {.note = BUZZER_NOTE_C, .octave = 5, .type = BUZZER_NTYPE_CROTCHET},
+};
+static const buzzer_melody_t duty_melody = {
+        .melody = duty_notes,
+        .length = sizeof(duty_notes) / sizeof(duty_notes[0]),
+        .duty = BUZZER_DUTY_NARROW
+};
+static const buzzer_compiled_note_t duty_compiled_notes[] = {{440, BUZZER_NTYPE_CROTCHET}, {0, BUZZER_NTYPE_QUAVER}};
+static const buzzer_compiled_melody_t duty_compiled = {
+        .notes = duty_compiled_notes,
+        .length = sizeof(duty_compiled_notes) / sizeof(duty_compiled_notes[0]),
+        .duty = BUZZER_DUTY_NARROW
+};
+
+// Private function declarations
+
+static buzzer_t *duty_buzzer_init(duties_t *duties);
+
+static void duties_observer(const fake_ledc_event_t *event, void *arg);
+
+static uint32_t duty_reg(uint8_t duty);
+
+static void sound_done(buzzer_sound_t *sound, void *arg);
+
+// Tests
+
+/**
+ * Plays a melody and a compiled melody with the blocking functions, and checks both output their duty and set the
+ * previous one back.
+ */
+static void test_duty_blocking(void) {
+    duties_t duties;
+    buzzer_t *buzzer = duty_buzzer_init(&duties);
+
+    TEST_CHECK_EQ(buzzer_play_melody(buzzer, &duty_melody, DUTY_BPM), ESP_OK);
+    TEST_CHECK(duties.melody_seen);
+    TEST_CHECK_EQ(buzzer_get_duty(buzzer), DUTY_PREVIOUS);
+    TEST_CHECK_EQ(duties.last, duty_reg(DUTY_PREVIOUS));
+
+    duties.melody_seen = false;
+    TEST_CHECK_EQ(buzzer_play_compiled_melody(buzzer, &duty_compiled, DUTY_BPM), ESP_OK);
+    TEST_CHECK(duties.melody_seen);
+    TEST_CHECK_EQ(buzzer_get_duty(buzzer), DUTY_PREVIOUS);
+
+    fake_ledc_set_observer(NULL, NULL);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Plays a melody on the player until it ends, and another one which is stopped halfway, and checks the duty of the
+ * melody is only kept while they play.
+ */
+static void test_duty_player(void) {
+    duties_t duties;
+    buzzer_t *buzzer = duty_buzzer_init(&duties);
+    buzzer_player_t *player = buzzer_player_create(buzzer, NULL);
+
+    TEST_CHECK_EQ(buzzer_player_play_melody(player, &duty_melody, DUTY_BPM), ESP_OK);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_CHECK_EQ(buzzer_get_duty(buzzer), BUZZER_DUTY_NARROW);
+    while (buzzer_player_get_state(player) != BUZZER_PLAYER_IDLE) vTaskDelay(1);
+    TEST_CHECK_EQ(buzzer_get_duty(buzzer), DUTY_PREVIOUS);
+
+    TEST_CHECK_EQ(buzzer_player_play_melody(player, &duty_melody, DUTY_BPM), ESP_OK);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_CHECK_EQ(buzzer_player_stop(player), ESP_OK);
+    while (buzzer_player_get_state(player) != BUZZER_PLAYER_IDLE) vTaskDelay(1);
+    TEST_CHECK_EQ(buzzer_get_duty(buzzer), DUTY_PREVIOUS);
+    TEST_CHECK_EQ(duties.last, duty_reg(DUTY_PREVIOUS));
+
+    fake_ledc_set_observer(NULL, NULL);
+    buzzer_player_destroy(player);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Plays a melody on the callback engine until it ends, another one which is stopped halfway and another one which is
+ * replaced by a melody without a duty, and checks the duty of the melody is only kept while they play.
+ */
+static void test_duty_sound(void) {
+    duties_t duties;
+    buzzer_t *buzzer = duty_buzzer_init(&duties);
+    buzzer_sound_t *sound = buzzer_sound_create(buzzer);
+    done_t done = {.buzzer = buzzer};
+
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_sound_play_melody(sound, &duty_melody, DUTY_BPM, sound_done, &done), ESP_OK);
+    fake_sim_sleep_until(start_us + 50000);
+    TEST_CHECK_EQ(buzzer_get_duty(buzzer), BUZZER_DUTY_NARROW);
+    fake_sim_sleep_until(start_us + 300000);
+    TEST_CHECK_EQ(done.duty, DUTY_PREVIOUS); // Already set back when the done callback runs
+
+    start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_sound_play_melody(sound, &duty_melody, DUTY_BPM, NULL, NULL), ESP_OK);
+    fake_sim_sleep_until(start_us + 50000);
+    TEST_CHECK_EQ(buzzer_sound_stop(sound), ESP_OK);
+    fake_esp_timer_flush();
+    TEST_CHECK_EQ(buzzer_get_duty(buzzer), DUTY_PREVIOUS);
+
+    static const buzzer_melody_t plain = BUZZER_MELODY_INIT(duty_notes, 1);
+    start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_sound_play_melody(sound, &duty_melody, DUTY_BPM, NULL, NULL), ESP_OK);
+    fake_sim_sleep_until(start_us + 50000);
+    TEST_CHECK_EQ(buzzer_sound_play_melody(sound, &plain, DUTY_BPM, NULL, NULL), ESP_OK);
+    fake_sim_sleep_until(start_us + 100000);
+    TEST_CHECK_EQ(buzzer_get_duty(buzzer), DUTY_PREVIOUS);
+    TEST_CHECK_EQ(duties.last, duty_reg(DUTY_PREVIOUS));
+
+    fake_ledc_set_observer(NULL, NULL);
+    buzzer_sound_destroy(sound);
+    buzzer_destroy(buzzer);
+}
+
+int main(void) {
+    TEST_RUN(test_duty_blocking);
+    TEST_RUN(test_duty_player);
+    TEST_RUN(test_duty_sound);
+    return TEST_RESULT();
+}
+
+// Private functions
+
+/**
+ * Creates the buzzer, sets it to the previous duty and starts following the duties written to it.
+ * @param duties Duties seen, cleared
+ * @return The created buzzer
+ */
+static buzzer_t *duty_buzzer_init(duties_t *duties) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    TEST_CHECK_EQ(buzzer_set_duty(buzzer, DUTY_PREVIOUS), ESP_OK);
+    *duties = (duties_t) {0};
+    fake_ledc_set_observer(duties_observer, duties);
+    return buzzer;
+}
+
+/**
+ * Keeps the duties written to the buzzer's channel.
+ * @param event Write to the LEDC
+ * @param arg Duties seen so far
+ */
+static void duties_observer(const fake_ledc_event_t *event, void *arg) {
+    duties_t *duties = arg;
+    if (event->op != FAKE_LEDC_DUTY || event->index != LEDC_CHANNEL_0) return;
+    duties->last = event->value;
+    if (event->value == duty_reg(BUZZER_DUTY_NARROW)) duties->melody_seen = true;
+}
+
+/**
+ * Returns the duty register value the buzzer writes for a duty, with the default resolution.
+ * @param duty Duty in percent
+ * @return Value of the duty register
+ */
+static uint32_t duty_reg(uint8_t duty) {
+    return (uint32_t) (((uint64_t) 1u << BUZZER_DUTY_RES_BITS) * duty / 100u);
+}
+
+/**
+ * Records the duty of the buzzer when the melody ends.
+ * @param sound Sound which finished
+ * @param arg Buzzer to read and where its duty is stored
+ */
+static void sound_done(buzzer_sound_t *sound, void *arg) {
+    (void) sound;
+    done_t *done = arg;
+    done->duty = buzzer_get_duty(done->buzzer);
+}
@@ -0,0 +1,149 @@
+/**
+ * @file test_flash.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Tests of the flash-resident melody pipeline: melodies declared static const are placed by the linker out of
+ * the writable data sections (in .rodata, which the ESP32 maps from flash), and every engine plays them in place
+ * instead of copying their notes to the heap.
+ *
+ * @details The writable data of the program lies between the __data_start and _end symbols of the GNU linker, which
+ * cover .data and .bss. Heap is counted by wrapping malloc and calloc at link time.
+ */
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include "buzzer/buzzer.h"
+#include "buzzer/buzzer_player.h"
+#include "buzzer/buzzer_sound.h"
+#include "fake_sim.h"
+#include "test_util.h"
+
+#define FLASH_BPM 6000u ///< Speed the melody is played at, so crotchets last 10 ms
+
+extern char __data_start[]; ///< Start of the writable data, set by the linker
+extern char _end[]; ///< End of the writable data (and of .bss), set by the linker
+
+static atomic_size_t flash_heap; ///< Bytes allocated so far through malloc and calloc
+
+void *__real_malloc(size_t size);
+
+void *__real_calloc(size_t count, size_t size);
+
+static const buzzer_musical_note_t flash_notes[] = {
+        {.note = BUZZER_NOTE_C, .octave = 5, .type = BUZZER_NTYPE_CROTCHET},
+        {.note = BUZZER_NOTE_E, .octave = 5, .type = BUZZER_NTYPE_CROTCHET, .gate = BUZZER_GATE_STACCATO},
+        {.note = BUZZER_NOTE_G, .octave = 5, .type = BUZZER_NTYPE_MINIM},
+        {.note = BUZZER_NOTE_REST, .octave = 0, .type = BUZZER_NTYPE_CROTCHET},
+};
+static const buzzer_melody_t flash_melody =
+        BUZZER_MELODY_INIT(flash_notes, sizeof(flash_notes) / sizeof(flash_notes[0]));
+
+static buzzer_musical_note_t ram_notes[] = {
+        {.note = BUZZER_NOTE_C, .octave = 5, .type = BUZZER_NTYPE_CROTCHET},
+};
+
+// Private function declarations
+
+static bool is_writable_data(const void *address);
+
+static void flash_done(buzzer_sound_t *sound, void *arg);
+
+// Tests
+
+/**
+ * Checks the const melody and its notes are out of the writable data, and that the check tells writable data apart.
+ */
+static void test_const_placement(void) {
+    TEST_CHECK(!is_writable_data(flash_notes));
+    TEST_CHECK(!is_writable_data(&flash_notes[sizeof(flash_notes) / sizeof(flash_notes[0]) - 1]));
+    TEST_CHECK(!is_writable_data(&flash_melody));
+    TEST_CHECK(is_writable_data(ram_notes));
+    TEST_CHECK(is_writable_data(&flash_heap));
+}
+
+/**
+ * Plays the const melody with the blocking functions, the player and the callback engine, and checks none of them
+ * allocates a copy of its notes. The player only allocates the time index it seeks with, one offset per note.
+ */
+static void test_played_in_place(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    size_t length = flash_melody.length;
+
+    size_t before = atomic_load(&flash_heap);
+    TEST_CHECK_EQ(buzzer_play_melody(buzzer, &flash_melody, FLASH_BPM), ESP_OK);
+    TEST_CHECK_EQ(atomic_load(&flash_heap) - before, 0);
+
+    buzzer_player_t *player = buzzer_player_create(buzzer, NULL);
+    before = atomic_load(&flash_heap);
+    TEST_CHECK_EQ(buzzer_player_play_melody(player, &flash_melody, FLASH_BPM), ESP_OK);
+    do {
+        vTaskDelay(1);
+    } while (buzzer_player_get_state(player) != BUZZER_PLAYER_IDLE);
+    size_t player_heap = atomic_load(&flash_heap) - before;
+    TEST_CHECK(player_heap <= (length + 1) * sizeof(uint32_t));
+    TEST_CHECK(player_heap < length * sizeof(buzzer_musical_note_t));
+    buzzer_player_destroy(player);
+
+    buzzer_sound_t *sound = buzzer_sound_create(buzzer);
+    bool done = false;
+    before = atomic_load(&flash_heap);
+    TEST_CHECK_EQ(buzzer_sound_play_melody(sound, &flash_melody, FLASH_BPM, flash_done, &done), ESP_OK);
+    fake_sim_sleep_until(esp_timer_get_time() + 100000);
+    TEST_CHECK(done);
+    TEST_CHECK_EQ(atomic_load(&flash_heap) - before, 0);
+    buzzer_sound_destroy(sound);
+
+    buzzer_destroy(buzzer);
+}
+
+int main(void) {
+    TEST_RUN(test_const_placement);
+    TEST_RUN(test_played_in_place);
+    return TEST_RESULT();
+}
+
+// Private functions
+
+/**
+ * Counts the bytes allocated by the library before allocating them.
+ * @param size Bytes to allocate
+ * @return The allocated memory
+ */
+void *__wrap_malloc(size_t size) {
+    atomic_fetch_add(&flash_heap, size);
+    return __real_malloc(size);
+}
+
+/**
+ * Counts the bytes allocated by the library before allocating them.
+ * @param count Amount of elements
+ * @param size Bytes per element
+ * @return The allocated memory
+ */
+void *__wrap_calloc(size_t count, size_t size) {
+    atomic_fetch_add(&flash_heap, count * size);
+    return __real_calloc(count, size);
+}
+
+/**
+ * Checks whether an address lies in the writable data of the program.
+ * @param address Address to check
+ * @return Whether it's within .data or .bss
+ */
+static bool is_writable_data(const void *address) {
+    uintptr_t at = (uintptr_t) address;
+    return at >= (uintptr_t) __data_start && at < (uintptr_t) _end;
+}
+
+/**
+ * Records the end of the melody.
+ * @param sound Sound which finished
+ * @param arg Flag to set
+ */
+static void flash_done(buzzer_sound_t *sound, void *arg) {
+    (void) sound;
+    *(bool *) arg = true;
+}
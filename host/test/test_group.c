@@ -0,0 +1,212 @@
+/**
+ * @file test_group.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Tests of the synchronized start of several buzzers: buzzer_play_group resets every timer before resuming any
+ * of them, so the outputs start in phase, and the skew between the first and the last resume is measured and reported
+ * next to the one of starting the same buzzers one by one with buzzer_play.
+ *
+ * @details The skew is taken with the host's real clock when each resume reaches the LEDC. Host locks and clocks
+ * aren't the ESP32's, so only the comparison between both ways of starting the buzzers is meaningful here.
+ */
+
+#include "buzzer/buzzer.h"
+#include "test_util.h"
+
+#define GROUP_SIZE 4u ///< Buzzers started together, one per LEDC timer
+#define GROUP_ROUNDS 10000u ///< Starts measured for each way of starting the buzzers
+#define GROUP_EVENTS_MAX 16u ///< Writes kept by the observer per start
+
+/**
+ * Writes to the LEDC made while starting the buzzers
+ */
+typedef struct {
+    uint32_t count; ///< Writes made
+    fake_ledc_op_t op[GROUP_EVENTS_MAX]; ///< Kind of each write
+    uint8_t index[GROUP_EVENTS_MAX]; ///< Timer or channel of each write
+    uint64_t first_resume_ns; ///< Real time of the first timer resume
+    uint64_t last_resume_ns; ///< Real time of the last timer resume
+} group_writes_t;
+
+/**
+ * Skew of a way of starting the buzzers over several rounds
+ */
+typedef struct {
+    uint64_t min_ns; ///< Smallest skew
+    uint64_t max_ns; ///< Largest skew
+    uint64_t total_ns; ///< Sum of the skews, for the mean
+} group_skew_t;
+
+// Private function declarations
+
+static void group_observer(const fake_ledc_event_t *event, void *arg);
+
+static void group_init(buzzer_t **buzzers);
+
+static void group_destroy(buzzer_t **buzzers);
+
+static void group_skew_add(group_skew_t *skew, uint64_t skew_ns);
+
+static void group_skew_print(const char *name, const group_skew_t *skew);
+
+// Tests
+
+/**
+ * Starts a group and checks every timer is reset before any is resumed, with nothing else reaching the LEDC in between,
+ * so all the outputs start a new period together.
+ */
+static void test_group_in_phase(void) {
+    buzzer_t *buzzers[GROUP_SIZE];
+    group_init(buzzers);
+    group_writes_t writes = {0};
+    fake_ledc_set_observer(group_observer, &writes);
+
+    uint32_t skew_ns = UINT32_MAX;
+    TEST_CHECK_EQ(buzzer_play_group(buzzers, GROUP_SIZE, &skew_ns), ESP_OK);
+    fake_ledc_set_observer(NULL, NULL);
+
+    TEST_CHECK(skew_ns != UINT32_MAX);
+    TEST_CHECK_EQ(writes.count, 2 * GROUP_SIZE);
+    for (uint32_t i = 0; i < GROUP_SIZE && i + GROUP_SIZE < GROUP_EVENTS_MAX; i++) {
+        TEST_CHECK_EQ(writes.op[i], FAKE_LEDC_RESET);
+        TEST_CHECK_EQ(writes.index[i], i);
+        TEST_CHECK_EQ(writes.op[GROUP_SIZE + i], FAKE_LEDC_RESUME);
+        TEST_CHECK_EQ(writes.index[GROUP_SIZE + i], i);
+    }
+    for (uint32_t i = 0; i < GROUP_SIZE; i++) {
+        TEST_CHECK(buzzer_is_playing(buzzers[i]));
+        TEST_CHECK(fake_ledc_is_running((ledc_timer_t) i));
+    }
+
+    TEST_CHECK_EQ(buzzer_pause_group(buzzers, GROUP_SIZE), ESP_OK);
+    for (uint32_t i = 0; i < GROUP_SIZE; i++) TEST_CHECK(!fake_ledc_is_running((ledc_timer_t) i));
+    group_destroy(buzzers);
+}
+
+/**
+ * Checks buzzers which are already playing keep their phase, and that invalid groups are rejected.
+ */
+static void test_group_playing_and_invalid(void) {
+    buzzer_t *buzzers[GROUP_SIZE];
+    group_init(buzzers);
+    TEST_CHECK_EQ(buzzer_play(buzzers[1]), ESP_OK);
+
+    group_writes_t writes = {0};
+    fake_ledc_set_observer(group_observer, &writes);
+    TEST_CHECK_EQ(buzzer_play_group(buzzers, GROUP_SIZE, NULL), ESP_OK);
+    fake_ledc_set_observer(NULL, NULL);
+    TEST_CHECK_EQ(writes.count, 2 * (GROUP_SIZE - 1));
+    for (uint32_t i = 0; i < writes.count && i < GROUP_EVENTS_MAX; i++) TEST_CHECK(writes.index[i] != 1);
+    TEST_CHECK_EQ(buzzer_pause_group(buzzers, GROUP_SIZE), ESP_OK);
+
+    buzzer_t *with_null[] = {buzzers[0], NULL};
+    TEST_CHECK_EQ(buzzer_play_group(with_null, 2, NULL), ESP_FAIL);
+    TEST_CHECK_EQ(buzzer_play_group(buzzers, 0, NULL), ESP_FAIL);
+    TEST_CHECK_EQ(buzzer_play_group(buzzers, BUZZER_GROUP_MAX + 1, NULL), ESP_FAIL);
+    TEST_CHECK_EQ(buzzer_play_group(NULL, 1, NULL), ESP_FAIL);
+    group_destroy(buzzers);
+}
+
+/**
+ * Measures the skew between the first and the last output of a group started with buzzer_play_group and with one
+ * buzzer_play per buzzer, and reports both along with the skew reported by buzzer_play_group.
+ */
+static void bench_group_skew(void) {
+    buzzer_t *buzzers[GROUP_SIZE];
+    group_init(buzzers);
+    group_skew_t grouped = {.min_ns = UINT64_MAX}, sequential = {.min_ns = UINT64_MAX};
+    group_skew_t reported = {.min_ns = UINT64_MAX};
+
+    for (uint32_t round = 0; round < GROUP_ROUNDS; round++) {
+        group_writes_t writes = {0};
+        uint32_t skew_ns;
+        fake_ledc_set_observer(group_observer, &writes);
+        buzzer_play_group(buzzers, GROUP_SIZE, &skew_ns);
+        fake_ledc_set_observer(NULL, NULL);
+        group_skew_add(&grouped, writes.last_resume_ns - writes.first_resume_ns);
+        group_skew_add(&reported, skew_ns);
+        buzzer_pause_group(buzzers, GROUP_SIZE);
+
+        writes = (group_writes_t) {0};
+        fake_ledc_set_observer(group_observer, &writes);
+        for (uint32_t i = 0; i < GROUP_SIZE; i++) buzzer_play(buzzers[i]);
+        fake_ledc_set_observer(NULL, NULL);
+        group_skew_add(&sequential, writes.last_resume_ns - writes.first_resume_ns);
+        buzzer_pause_group(buzzers, GROUP_SIZE);
+    }
+
+    printf("group skew over %u buzzers, %u rounds (host):\n", (unsigned) GROUP_SIZE, (unsigned) GROUP_ROUNDS);
+    group_skew_print("buzzer_play_group", &grouped);
+    group_skew_print("buzzer_play_group (reported)", &reported);
+    group_skew_print("buzzer_play one by one", &sequential);
+    group_destroy(buzzers);
+}
+
+int main(void) {
+    TEST_RUN(test_group_in_phase);
+    TEST_RUN(test_group_playing_and_invalid);
+    TEST_RUN(bench_group_skew);
+    return TEST_RESULT();
+}
+
+// Private functions
+
+/**
+ * Keeps the writes made to the LEDC, and the real time of the first and the last timer resume.
+ * @param event Write to the LEDC
+ * @param arg Writes seen so far
+ */
+static void group_observer(const fake_ledc_event_t *event, void *arg) {
+    group_writes_t *writes = arg;
+    if (event->op == FAKE_LEDC_RESUME) {
+        uint64_t now_ns = test_real_ns();
+        if (writes->first_resume_ns == 0) writes->first_resume_ns = now_ns;
+        writes->last_resume_ns = now_ns;
+    }
+    if (writes->count < GROUP_EVENTS_MAX) {
+        writes->op[writes->count] = event->op;
+        writes->index[writes->count] = event->index;
+    }
+    writes->count++;
+}
+
+/**
+ * Creates the buzzers of the group, one per channel and timer, each one with a different note.
+ * @param buzzers Where the buzzers are stored
+ */
+static void group_init(buzzer_t **buzzers) {
+    for (uint32_t i = 0; i < GROUP_SIZE; i++) {
+        buzzers[i] = buzzer_init((ledc_channel_t) i, (ledc_timer_t) i, (gpio_num_t) (GPIO_NUM_4 + i));
+        TEST_CHECK(buzzers[i] != NULL);
+        buzzer_set_note(buzzers[i], (buzzer_note_t) (BUZZER_NOTE_C + 4 * i), 4);
+    }
+}
+
+/**
+ * Destroys the buzzers of the group.
+ * @param buzzers Buzzers to destroy
+ */
+static void group_destroy(buzzer_t **buzzers) {
+    for (uint32_t i = 0; i < GROUP_SIZE; i++) buzzer_destroy(buzzers[i]);
+}
+
+/**
+ * Adds the skew of a round to the statistics.
+ * @param skew Statistics to update
+ * @param skew_ns Skew of the round
+ */
+static void group_skew_add(group_skew_t *skew, uint64_t skew_ns) {
+    if (skew_ns < skew->min_ns) skew->min_ns = skew_ns;
+    if (skew_ns > skew->max_ns) skew->max_ns = skew_ns;
+    skew->total_ns += skew_ns;
+}
+
+/**
+ * Prints the statistics of a way of starting the buzzers.
+ * @param name Way of starting the buzzers
+ * @param skew Its statistics
+ */
+static void group_skew_print(const char *name, const group_skew_t *skew) {
+    printf("  %-30s min %6llu ns, mean %8.1f ns, max %8llu ns\n", name, (unsigned long long) skew->min_ns,
+           (double) skew->total_ns / GROUP_ROUNDS, (unsigned long long) skew->max_ns);
+}
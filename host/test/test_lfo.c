@@ -0,0 +1,287 @@
+/**
+ * @file test_lfo.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Tests of the low-frequency oscillator: tremolo alone never touches the timer, vibrato sets its divider without
+ * resetting it (except on the RTC8M clock), the frequency is restored once stopped, a request is applied right away
+ * even if the callback arms the timer while it's being left, and destroying the oscillator from an esp_timer callback
+ * is refused instead of waiting forever.
+ */
+
+#include <stdlib.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_timer.h>
+#include "buzzer/buzzer.h"
+#include "buzzer/buzzer_lfo.h"
+#include "buzzer/buzzer_sound.h"
+#include "buzzer/buzzer_tuning.h"
+#include "fake_sim.h"
+#include "test_util.h"
+
+#define LFO_FREQ_HZ 1000u ///< Frequency the buzzer is modulated around
+#define LFO_RUN_US 500000 ///< Time each modulation runs for
+#define LFO_FREQ_TOLERANCE 2 ///< Hz a frequency may differ from the requested one by, due to the LEDC quantization
+#define LFO_PERIOD_US (1000000 / BUZZER_LFO_DEFAULT_UPDATE_HZ) ///< Time between updates
+
+/**
+ * Writes to the buzzer's timer and channel, counted by the observer
+ */
+typedef struct {
+    uint32_t dividers; ///< New dividers
+    uint32_t resets; ///< Timer resets
+    uint32_t duties; ///< Duty writes
+} writes_t;
+
+/**
+ * Oscillator the done callback of a sound tries to destroy
+ */
+typedef struct {
+    buzzer_lfo_t *lfo; ///< Oscillator to destroy
+    bool called; ///< Whether the callback was called
+} destroy_t;
+
+/**
+ * LEDC observer holding an update of the oscillator, and then recording when the duty is written again
+ */
+typedef struct {
+    int64_t until_us; ///< Simulated time the held duty write returns at
+    bool held; ///< Whether a duty write was held
+    int64_t next_us; ///< Simulated time of the first duty written after the held one, or 0
+} slow_update_t;
+
+/**
+ * State of the start hook letting the callback arm the timer right before a start
+ */
+typedef struct {
+    bool armed; ///< Whether the next start must wait for the callback
+    int64_t until_us; ///< Simulated time waited for
+} start_hook_t;
+
+// Private function declarations
+
+static writes_t run_lfo(buzzer_t *buzzer, const buzzer_lfo_config_t *config);
+
+static void writes_observer(const fake_ledc_event_t *event, void *arg);
+
+static void destroy_done(buzzer_sound_t *sound, void *arg);
+
+static void slow_observer(const fake_ledc_event_t *event, void *arg);
+
+static void start_hook(esp_timer_handle_t timer, void *arg);
+
+static bool freq_near(ledc_timer_t timer, uint32_t freq_hz);
+
+// Tests
+
+/**
+ * Runs tremolo alone, and checks only the duty is written, as the frequency never changes.
+ */
+static void test_lfo_tremolo(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    static const buzzer_lfo_config_t config = {.rate_centihz = 550, .tremolo_percent = 50};
+
+    writes_t writes = run_lfo(buzzer, &config);
+    TEST_CHECK_EQ(writes.dividers, 0);
+    TEST_CHECK_EQ(writes.resets, 0);
+    TEST_CHECK(writes.duties > 0);
+    TEST_CHECK(freq_near(LEDC_TIMER_0, LFO_FREQ_HZ));
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Runs vibrato, and checks the divider is set at most once per update and never followed by a reset of the timer,
+ * and that the frequency goes back to the note's once stopped.
+ */
+static void test_lfo_vibrato(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    static const buzzer_lfo_config_t config = {.rate_centihz = 550, .vibrato_cents = 50};
+
+    writes_t writes = run_lfo(buzzer, &config);
+    TEST_CHECK(writes.dividers > 0);
+    TEST_CHECK(writes.dividers <= BUZZER_LFO_DEFAULT_UPDATE_HZ * (LFO_RUN_US / 1000) / 1000 + 1);
+    TEST_CHECK_EQ(writes.resets, 0);
+    TEST_CHECK(freq_near(LEDC_TIMER_0, LFO_FREQ_HZ));
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Runs vibrato on a timer fed by the RTC8M clock, and checks it falls back to ledc_set_freq, which resets the timer.
+ */
+static void test_lfo_rtc8m(void) {
+    // The default resolution is too fine for the slow clock to output the note
+    buzzer_config_t buzzer_config = {.clk_cfg = BUZZER_TUNING_RTC8M_CLK, .duty_res_bits = 10};
+    buzzer_t *buzzer = buzzer_init_ex(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4, &buzzer_config);
+    TEST_CHECK(buzzer != NULL);
+    static const buzzer_lfo_config_t config = {.rate_centihz = 550, .vibrato_cents = 50};
+
+    writes_t writes = run_lfo(buzzer, &config);
+    TEST_CHECK(writes.dividers > 0);
+    TEST_CHECK_EQ(writes.resets, writes.dividers);
+    TEST_CHECK(freq_near(LEDC_TIMER_0, LFO_FREQ_HZ));
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Stops the oscillator while one of its updates is held in a duty write, letting the update arm the timer between the
+ * stop and the start of the request, and checks the duty is still restored right away instead of at the next update.
+ */
+static void test_request_retry(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    TEST_CHECK_EQ(buzzer_set_freq(buzzer, LFO_FREQ_HZ), ESP_OK);
+    TEST_CHECK_EQ(buzzer_play(buzzer), ESP_OK);
+    buzzer_lfo_t *lfo = buzzer_lfo_create(buzzer);
+    static const buzzer_lfo_config_t tremolo = {.rate_centihz = 550, .tremolo_percent = 50};
+
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_lfo_start(lfo, &tremolo), ESP_OK);
+    fake_sim_sleep_until(start_us + 4 * LFO_PERIOD_US + 1);
+    slow_update_t slow = {.until_us = start_us + 5 * LFO_PERIOD_US + 2};
+    fake_ledc_set_observer(slow_observer, &slow);
+    fake_sim_sleep_until(start_us + 5 * LFO_PERIOD_US + 1);
+    TEST_CHECK(slow.held);
+
+    start_hook_t hook = {.armed = true, .until_us = start_us + 5 * LFO_PERIOD_US + 3};
+    fake_esp_timer_set_start_hook(start_hook, &hook);
+    TEST_CHECK_EQ(buzzer_lfo_stop(lfo), ESP_OK);
+    fake_esp_timer_set_start_hook(NULL, NULL);
+    TEST_CHECK(!hook.armed);
+    fake_sim_sleep_until(start_us + 7 * LFO_PERIOD_US);
+    fake_ledc_set_observer(NULL, NULL);
+    TEST_CHECK_EQ(slow.next_us, hook.until_us);
+
+    buzzer_lfo_destroy(lfo);
+    buzzer_pause(buzzer);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Destroys the oscillator from the done callback of a sound, and checks the call is refused and the oscillator keeps
+ * modulating.
+ */
+static void test_destroy_from_callback(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_sound_t *sound = buzzer_sound_create(buzzer);
+    buzzer_lfo_t *lfo = buzzer_lfo_create(buzzer);
+    static const buzzer_lfo_config_t config = {.rate_centihz = 550, .tremolo_percent = 50};
+    TEST_CHECK_EQ(buzzer_lfo_start(lfo, &config), ESP_OK);
+
+    static const buzzer_musical_note_t notes[] = {{.note = BUZZER_NOTE_A, .octave = 4, .type = BUZZER_NTYPE_QUAVER}};
+    static const buzzer_melody_t melody = BUZZER_MELODY_INIT(notes, 1);
+    destroy_t destroy = {.lfo = lfo};
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_sound_play_melody(sound, &melody, 600, destroy_done, &destroy), ESP_OK);
+    fake_sim_sleep_until(start_us + LFO_RUN_US);
+    TEST_CHECK(destroy.called);
+
+    writes_t writes = {0};
+    fake_ledc_set_observer(writes_observer, &writes);
+    fake_sim_sleep_until(start_us + 2 * LFO_RUN_US);
+    fake_ledc_set_observer(NULL, NULL);
+    TEST_CHECK(writes.duties > 0);
+
+    buzzer_lfo_destroy(lfo);
+    buzzer_sound_destroy(sound);
+    buzzer_destroy(buzzer);
+}
+
+int main(void) {
+    TEST_RUN(test_lfo_tremolo);
+    TEST_RUN(test_lfo_vibrato);
+    TEST_RUN(test_lfo_rtc8m);
+    TEST_RUN(test_request_retry);
+    TEST_RUN(test_destroy_from_callback);
+    return TEST_RESULT();
+}
+
+// Private functions
+
+/**
+ * Sounds the buzzer, runs an oscillator on it for LFO_RUN_US and stops it, counting the writes in between.
+ * @param buzzer Buzzer to modulate
+ * @param config Modulation to run
+ * @return Writes made while the oscillator ran
+ */
+static writes_t run_lfo(buzzer_t *buzzer, const buzzer_lfo_config_t *config) {
+    TEST_CHECK_EQ(buzzer_set_freq(buzzer, LFO_FREQ_HZ), ESP_OK);
+    TEST_CHECK_EQ(buzzer_play(buzzer), ESP_OK);
+    buzzer_lfo_t *lfo = buzzer_lfo_create(buzzer);
+    writes_t writes = {0};
+    fake_ledc_set_observer(writes_observer, &writes);
+
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_lfo_start(lfo, config), ESP_OK);
+    fake_sim_sleep_until(start_us + LFO_RUN_US);
+    TEST_CHECK_EQ(buzzer_lfo_stop(lfo), ESP_OK);
+    fake_esp_timer_flush();
+
+    fake_ledc_set_observer(NULL, NULL);
+    buzzer_lfo_destroy(lfo);
+    buzzer_pause(buzzer);
+    return writes;
+}
+
+/**
+ * Counts the dividers, resets and duties written to the buzzer's timer and channel.
+ * @param event Write to the LEDC
+ * @param arg Writes seen so far
+ */
+static void writes_observer(const fake_ledc_event_t *event, void *arg) {
+    writes_t *writes = arg;
+    if (event->index != 0) return; // Timer 0 and channel 0 alike
+    if (event->op == FAKE_LEDC_DIVIDER) writes->dividers++;
+    else if (event->op == FAKE_LEDC_RESET) writes->resets++;
+    else if (event->op == FAKE_LEDC_DUTY) writes->duties++;
+}
+
+/**
+ * Tries to destroy the oscillator from the esp_timer task.
+ * @param sound Sound which finished
+ * @param arg Oscillator to destroy
+ */
+static void destroy_done(buzzer_sound_t *sound, void *arg) {
+    (void) sound;
+    destroy_t *destroy = arg;
+    buzzer_lfo_destroy(destroy->lfo);
+    destroy->called = true;
+}
+
+/**
+ * Holds the first duty write until the simulated clock reaches the time it waits for, keeping the callback running
+ * until then, and records the time of the next duty write.
+ * @param event Write to the LEDC
+ * @param arg Observer state
+ */
+static void slow_observer(const fake_ledc_event_t *event, void *arg) {
+    slow_update_t *slow = arg;
+    if (event->op != FAKE_LEDC_DUTY) return;
+    if (slow->held) {
+        if (!slow->next_us) slow->next_us = event->time_us;
+        return;
+    }
+    slow->held = true;
+    fake_sim_sleep_until(slow->until_us);
+}
+
+/**
+ * Lets the callback go on and arm the timer before the first start it sees goes ahead, by waiting past the time the
+ * callback is held for.
+ * @param timer Timer being started
+ * @param arg Hook state
+ */
+static void start_hook(esp_timer_handle_t timer, void *arg) {
+    (void) timer;
+    start_hook_t *hook = arg;
+    if (!hook->armed) return;
+    hook->armed = false;
+    fake_sim_sleep_until(hook->until_us);
+}
+
+/**
+ * Checks the frequency a timer is set to, within the LEDC quantization.
+ * @param timer Timer to check
+ * @param freq_hz Expected frequency
+ * @return Whether the timer is close enough to the frequency
+ */
+static bool freq_near(ledc_timer_t timer, uint32_t freq_hz) {
+    return abs((int) fake_ledc_get_freq(timer) - (int) freq_hz) <= LFO_FREQ_TOLERANCE;
+}
@@ -0,0 +1,281 @@
+/**
+ * @file test_loop.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Tests of looped melodies, on the simulated clock: the player and the callback engine repeat the looped
+ * section exactly the times asked, with no gap nor extra frequency change at the wrap, treat an empty section as no
+ * loop, don't merge rests across the end of the section, and every engine rejects sections out of order or bounds.
+ *
+ * @details The output of the buzzer is rebuilt from the writes to the LEDC as a timeline of changes, each one with
+ * the time it happened at and the frequency sounding from then on (0 for silence).
+ */
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include "buzzer/buzzer.h"
+#include "buzzer/buzzer_player.h"
+#include "buzzer/buzzer_sound.h"
+#include "buzzer/buzzer_tuning.h"
+#include "fake_sim.h"
+#include "test_util.h"
+
+#define LOOP_BPM 600u ///< Speed the melodies are played at, so crotchets last 100 ms
+#define LOOP_NOTE_US 100000 ///< Length of a crotchet at LOOP_BPM
+#define LOOP_CHANGES_MAX 32u ///< Changes of the output kept in a timeline
+
+/**
+ * Engine a melody is played with
+ */
+typedef enum {
+    LOOP_PLAYER, ///< buzzer_player_play_melody
+    LOOP_SOUND, ///< buzzer_sound_play_melody
+    LOOP_ENGINES ///< Amount of engines
+} loop_engine_t;
+
+/**
+ * Change of the output of the buzzer
+ */
+typedef struct {
+    int64_t time_us; ///< Time of the change, from the start of the melody
+    uint32_t freq_hz; ///< Frequency sounding from then on, 0 for silence
+} loop_change_t;
+
+/**
+ * Output of the buzzer while a melody played
+ */
+typedef struct {
+    loop_change_t changes[LOOP_CHANGES_MAX]; ///< Changes of the output, in order
+    uint32_t count; ///< Changes of the output
+    uint32_t freq_writes; ///< Frequencies written to the timer, whether they changed the output or not
+} loop_timeline_t;
+
+// A B, repeated twice more, and C: A B A B A B C
+static const buzzer_musical_note_t repeat_notes[] = {
+        {.note = BUZZER_NOTE_A, .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+        {.note = BUZZER_NOTE_B, .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+        {.note = BUZZER_NOTE_C, .octave = 5, .type = BUZZER_NTYPE_CROTCHET},
+};
+static const buzzer_melody_t repeat_melody = {
+        .melody = repeat_notes,
+        .length = sizeof(repeat_notes) / sizeof(repeat_notes[0]),
+        .loop_start = 0,
+        .loop_end = 2,
+        .loop_count = 2
+};
+
+// A and a rest, repeated once, followed by another rest and C: A R A R R C
+static const buzzer_musical_note_t rest_notes[] = {
+        {.note = BUZZER_NOTE_A, .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+        {.note = BUZZER_NOTE_REST, .octave = 0, .type = BUZZER_NTYPE_CROTCHET},
+        {.note = BUZZER_NOTE_REST, .octave = 0, .type = BUZZER_NTYPE_CROTCHET},
+        {.note = BUZZER_NOTE_C, .octave = 5, .type = BUZZER_NTYPE_CROTCHET},
+};
+static const buzzer_melody_t rest_melody = {
+        .melody = rest_notes,
+        .length = sizeof(rest_notes) / sizeof(rest_notes[0]),
+        .loop_start = 0,
+        .loop_end = 2,
+        .loop_count = 1
+};
+
+// Private function declarations
+
+static void loop_play(loop_engine_t engine, const buzzer_melody_t *melody, int64_t length_us,
+                      loop_timeline_t *timeline);
+
+static void loop_check(const loop_timeline_t *timeline, const loop_change_t *expected, uint32_t count);
+
+static uint32_t note_hz(buzzer_note_t note, uint8_t octave);
+
+// Tests
+
+/**
+ * Plays a melody whose first two notes are repeated twice, and checks every note starts exactly when the previous one
+ * ends, with a single frequency write each, and that the melody ends after the last repetition.
+ */
+static void test_loop_repeats(void) {
+    uint32_t a4 = note_hz(BUZZER_NOTE_A, 4), b4 = note_hz(BUZZER_NOTE_B, 4), c5 = note_hz(BUZZER_NOTE_C, 5);
+    const loop_change_t expected[] = {
+            {0, a4}, {100000, b4}, {200000, a4}, {300000, b4}, {400000, a4}, {500000, b4}, {600000, c5}, {700000, 0}
+    };
+    for (loop_engine_t engine = 0; engine < LOOP_ENGINES; engine++) {
+        loop_timeline_t timeline;
+        loop_play(engine, &repeat_melody, 7 * LOOP_NOTE_US, &timeline);
+        loop_check(&timeline, expected, sizeof(expected) / sizeof(expected[0]));
+        TEST_CHECK_EQ(timeline.freq_writes, 7);
+    }
+}
+
+/**
+ * Plays a melody whose looped section starts and ends at the same note, asking it to repeat forever, and checks the
+ * melody is played once and ends.
+ */
+static void test_loop_empty(void) {
+    buzzer_melody_t melody = repeat_melody;
+    melody.loop_start = melody.loop_end = 1;
+    melody.loop_count = BUZZER_LOOP_FOREVER;
+    uint32_t a4 = note_hz(BUZZER_NOTE_A, 4), b4 = note_hz(BUZZER_NOTE_B, 4), c5 = note_hz(BUZZER_NOTE_C, 5);
+    const loop_change_t expected[] = {{0, a4}, {100000, b4}, {200000, c5}, {300000, 0}};
+    for (loop_engine_t engine = 0; engine < LOOP_ENGINES; engine++) {
+        loop_timeline_t timeline;
+        loop_play(engine, &melody, 3 * LOOP_NOTE_US, &timeline);
+        loop_check(&timeline, expected, sizeof(expected) / sizeof(expected[0]));
+    }
+
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_play_melody(buzzer, &melody, LOOP_BPM), ESP_OK);
+    TEST_CHECK_EQ(esp_timer_get_time() - start_us, 3 * LOOP_NOTE_US);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Plays a melody whose looped section ends with a rest followed by another rest, and checks the rests are only merged
+ * once the section isn't repeated anymore, so the repetition starts on time.
+ */
+static void test_loop_rests(void) {
+    uint32_t a4 = note_hz(BUZZER_NOTE_A, 4), c5 = note_hz(BUZZER_NOTE_C, 5);
+    const loop_change_t expected[] = {{0, a4}, {100000, 0}, {200000, a4}, {300000, 0}, {500000, c5}, {600000, 0}};
+    for (loop_engine_t engine = 0; engine < LOOP_ENGINES; engine++) {
+        loop_timeline_t timeline;
+        loop_play(engine, &rest_melody, 6 * LOOP_NOTE_US, &timeline);
+        loop_check(&timeline, expected, sizeof(expected) / sizeof(expected[0]));
+    }
+
+    // The player wakes up once for both rests after the last repetition: A R A RR C
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_player_t *player = buzzer_player_create(buzzer, NULL);
+    TEST_CHECK_EQ(buzzer_player_play_melody(player, &rest_melody, LOOP_BPM), ESP_OK);
+    fake_sim_sleep_until(esp_timer_get_time() + 7 * LOOP_NOTE_US);
+    buzzer_player_stats_t stats;
+    TEST_CHECK_EQ(buzzer_player_get_stats(player, &stats), ESP_OK);
+    TEST_CHECK_EQ(stats.run_wakeups, 5);
+    buzzer_player_destroy(player);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Checks every engine rejects looped sections which start after their end or end past the melody, and accepts an
+ * empty section at the end of the melody.
+ */
+static void test_loop_invalid(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_player_t *player = buzzer_player_create(buzzer, NULL);
+    buzzer_sound_t *sound = buzzer_sound_create(buzzer);
+
+    buzzer_melody_t reversed = repeat_melody;
+    reversed.loop_start = 2;
+    reversed.loop_end = 1;
+    buzzer_melody_t unset_end = repeat_melody; // Garbage in loop_start, with loop_end left at 0
+    unset_end.loop_start = 1;
+    unset_end.loop_end = 0;
+    buzzer_melody_t past_end = repeat_melody;
+    past_end.loop_end = repeat_melody.length + 1;
+    const buzzer_melody_t *invalid[] = {&reversed, &unset_end, &past_end};
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        TEST_CHECK_EQ(buzzer_check_melody(invalid[i]), ESP_FAIL);
+        TEST_CHECK_EQ(buzzer_play_melody(buzzer, invalid[i], LOOP_BPM), ESP_FAIL);
+        TEST_CHECK_EQ(buzzer_player_play_melody(player, invalid[i], LOOP_BPM), ESP_FAIL);
+        TEST_CHECK_EQ(buzzer_sound_play_melody(sound, invalid[i], LOOP_BPM, NULL, NULL), ESP_FAIL);
+    }
+    TEST_CHECK_EQ(buzzer_player_get_state(player), BUZZER_PLAYER_IDLE);
+
+    buzzer_melody_t at_end = repeat_melody;
+    at_end.loop_start = at_end.loop_end = repeat_melody.length;
+    TEST_CHECK_EQ(buzzer_check_melody(&at_end), ESP_OK);
+    TEST_CHECK_EQ(buzzer_check_melody(&repeat_melody), ESP_OK);
+    TEST_CHECK_EQ(buzzer_check_melody(NULL), ESP_FAIL);
+
+    buzzer_sound_destroy(sound);
+    buzzer_player_destroy(player);
+    buzzer_destroy(buzzer);
+}
+
+int main(void) {
+    TEST_RUN(test_loop_repeats);
+    TEST_RUN(test_loop_empty);
+    TEST_RUN(test_loop_rests);
+    TEST_RUN(test_loop_invalid);
+    return TEST_RESULT();
+}
+
+// Private functions
+
+/**
+ * Plays a melody with an engine until it ends, and rebuilds the output of the buzzer from the writes to the LEDC.
+ * @param engine Engine to play the melody with
+ * @param melody Melody to play
+ * @param length_us Time the melody lasts
+ * @param timeline Where to store the output of the buzzer
+ */
+static void loop_play(loop_engine_t engine, const buzzer_melody_t *melody, int64_t length_us,
+                      loop_timeline_t *timeline) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_player_t *player = NULL;
+    buzzer_sound_t *sound = NULL;
+    fake_ledc_set_recording(true);
+    size_t first;
+    fake_ledc_get_events(&first);
+
+    int64_t start_us = esp_timer_get_time();
+    if (engine == LOOP_PLAYER) {
+        player = buzzer_player_create(buzzer, NULL);
+        TEST_CHECK_EQ(buzzer_player_play_melody(player, melody, LOOP_BPM), ESP_OK);
+    } else {
+        sound = buzzer_sound_create(buzzer);
+        TEST_CHECK_EQ(buzzer_sound_play_melody(sound, melody, LOOP_BPM, NULL, NULL), ESP_OK);
+    }
+    fake_sim_sleep_until(start_us + length_us + LOOP_NOTE_US);
+    if (player) TEST_CHECK_EQ(buzzer_player_get_state(player), BUZZER_PLAYER_IDLE);
+
+    *timeline = (loop_timeline_t) {0};
+    size_t count;
+    const fake_ledc_event_t *events = fake_ledc_get_events(&count);
+    bool running = false;
+    uint32_t freq_hz = 0;
+    for (size_t i = first; i < count && timeline->count < LOOP_CHANGES_MAX; i++) {
+        const fake_ledc_event_t *event = &events[i];
+        if (event->op == FAKE_LEDC_DUTY || event->index != LEDC_TIMER_0) continue;
+        uint32_t sounding = running ? freq_hz : 0;
+        if (event->op == FAKE_LEDC_DIVIDER) {
+            freq_hz = event->freq_hz;
+            timeline->freq_writes++;
+        } else if (event->op == FAKE_LEDC_PAUSE || event->op == FAKE_LEDC_RESUME) {
+            running = event->op == FAKE_LEDC_RESUME;
+        }
+        uint32_t now = running ? freq_hz : 0;
+        if (now != sounding) {
+            timeline->changes[timeline->count++] = (loop_change_t) {event->time_us - start_us, now};
+        }
+    }
+    fake_ledc_set_recording(false);
+
+    if (player) buzzer_player_destroy(player);
+    if (sound) buzzer_sound_destroy(sound);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Checks the output of the buzzer matches the expected one, change by change.
+ * @param timeline Output of the buzzer
+ * @param expected Changes expected, in order
+ * @param count Changes expected
+ */
+static void loop_check(const loop_timeline_t *timeline, const loop_change_t *expected, uint32_t count) {
+    TEST_CHECK_EQ(timeline->count, count);
+    for (uint32_t i = 0; i < count && i < timeline->count; i++) {
+        TEST_CHECK_EQ(timeline->changes[i].time_us, expected[i].time_us);
+        TEST_CHECK_EQ(timeline->changes[i].freq_hz, expected[i].freq_hz);
+    }
+}
+
+/**
+ * Returns the frequency the engines request for a note, tuned for the buzzer's timer.
+ * @param note Note to play
+ * @param octave Octave of the note
+ * @return Frequency requested, in Hz
+ */
+static uint32_t note_hz(buzzer_note_t note, uint8_t octave) {
+    return buzzer_tuning_best_request(LEDC_USE_APB_CLK, BUZZER_DUTY_RES_BITS, buzzer_get_note_freq(note, octave));
+}
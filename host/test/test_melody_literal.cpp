@@ -0,0 +1,139 @@
+/**
+ * @file test_melody_literal.cpp
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Tests of the C++ melody literals: the text compiles (at compile time) to the frequencies of the C note table
+ * and to the right durations, rests, accidentals and bar lines included, and playing the compiled melody sets those
+ * frequencies on the LEDC for as long as the durations last, with its own duty only while it plays.
+ */
+
+#include <esp_timer.h>
+#include "buzzer/buzzer.h"
+#include "buzzer/buzzer_melody.hpp"
+#include "fake_ledc.h"
+#include "test_util.h"
+
+using namespace buzzer::literals;
+
+#define LITERAL_BPM 120 ///< Speed the melodies are played at
+
+static constexpr auto tune = "C4e. C4s D4q C4q F4q E4h"_melody; ///< Melody from the header's documentation
+static constexpr auto marks = "Cb4q B#4q | A#3e Bb3e Rh. | A4w"_melody; ///< Accidentals, rests and bar lines
+static constexpr auto scale = "C4e D4e E4e Re F4s G4s A4q B4q C5h"_melody; ///< No note repeats the previous one
+
+// The melodies are compiled by the compiler itself, not when the program starts
+static_assert(tune.size() == 6, "every note is counted");
+static_assert(tune.notes[0].type == BUZZER_NTYPE_QUAVER_DOTTED, "a dot adds half of the duration");
+static_assert(marks.size() == 6, "bar lines aren't notes");
+static_assert(marks.notes[4].freq_hz == 0, "rests have no frequency");
+
+// Private function declarations
+
+static void check_note(const buzzer_compiled_note_t &compiled, buzzer_note_t note, uint8_t octave,
+                       buzzer_note_type_t type);
+
+// Tests
+
+/**
+ * Checks the notes of the melodies against the C note table, with their durations.
+ */
+static void test_compile(void) {
+    check_note(tune.notes[0], BUZZER_NOTE_C, 4, BUZZER_NTYPE_QUAVER_DOTTED);
+    check_note(tune.notes[1], BUZZER_NOTE_C, 4, BUZZER_NTYPE_SEMIQUAVER);
+    check_note(tune.notes[2], BUZZER_NOTE_D, 4, BUZZER_NTYPE_CROTCHET);
+    check_note(tune.notes[3], BUZZER_NOTE_C, 4, BUZZER_NTYPE_CROTCHET);
+    check_note(tune.notes[4], BUZZER_NOTE_F, 4, BUZZER_NTYPE_CROTCHET);
+    check_note(tune.notes[5], BUZZER_NOTE_E, 4, BUZZER_NTYPE_MINIM);
+    TEST_CHECK_EQ(tune.notes[5].freq_hz, 329); // E4 is 329.6 Hz, truncated like the table's shifts
+
+    // Accidentals move to the neighbouring octave when they cross its edge
+    check_note(marks.notes[0], BUZZER_NOTE_B, 3, BUZZER_NTYPE_CROTCHET);
+    check_note(marks.notes[1], BUZZER_NOTE_C, 5, BUZZER_NTYPE_CROTCHET);
+    check_note(marks.notes[2], BUZZER_NOTE_As, 3, BUZZER_NTYPE_QUAVER);
+    check_note(marks.notes[3], BUZZER_NOTE_As, 3, BUZZER_NTYPE_QUAVER);
+    TEST_CHECK_EQ(marks.notes[4].freq_hz, 0);
+    TEST_CHECK_EQ(marks.notes[4].type, BUZZER_NTYPE_MINIM_DOTTED);
+    check_note(marks.notes[5], BUZZER_NOTE_A, 4, BUZZER_NTYPE_SEMIBREVE);
+    TEST_CHECK_EQ(marks.notes[5].freq_hz, 440);
+
+    buzzer_compiled_melody_t view = marks.melody(BUZZER_DUTY_NARROW);
+    TEST_CHECK(view.notes == marks.notes);
+    TEST_CHECK_EQ(view.length, marks.size());
+    TEST_CHECK_EQ(view.duty, BUZZER_DUTY_NARROW);
+}
+
+/**
+ * Plays a melody with a rest through the fake LEDC, and checks the frequencies requested, in order, and that the
+ * melody lasts as long as its durations add up to.
+ */
+static void test_play(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    uint32_t expected_ms = 0;
+    for (const buzzer_compiled_note_t &note : scale.notes) {
+        expected_ms += buzzer_note_type_to_ms((buzzer_note_type_t) note.type, LITERAL_BPM);
+    }
+
+    fake_ledc_set_recording(true);
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer::play(buzzer, scale, LITERAL_BPM), ESP_OK);
+    TEST_CHECK_EQ(esp_timer_get_time() - start_us, (int64_t) expected_ms * 1000);
+    fake_ledc_set_recording(false);
+
+    size_t count;
+    const fake_ledc_event_t *events = fake_ledc_get_events(&count);
+    size_t next = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (events[i].op != FAKE_LEDC_DIVIDER) continue;
+        while (next < scale.size() && scale.notes[next].freq_hz == 0) next++; // Rests don't touch the divider
+        TEST_CHECK(next < scale.size());
+        if (next < scale.size()) TEST_CHECK_EQ(events[i].freq_hz, scale.notes[next++].freq_hz);
+    }
+    TEST_CHECK_EQ(next, scale.size());
+    TEST_CHECK(!fake_ledc_is_running(LEDC_TIMER_0));
+
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Plays a melody with its own duty, and checks the duty is set while it plays and the buzzer's is set back after.
+ */
+static void test_play_duty(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    uint32_t square = fake_ledc_get_duty(LEDC_CHANNEL_0);
+
+    fake_ledc_set_recording(true);
+    TEST_CHECK_EQ(buzzer::play(buzzer, "A5e C6e E6q"_melody, LITERAL_BPM, BUZZER_DUTY_NARROW), ESP_OK);
+    fake_ledc_set_recording(false);
+    size_t count, duties = 0;
+    const fake_ledc_event_t *events = fake_ledc_get_events(&count);
+    for (size_t i = 0; i < count; i++) {
+        if (events[i].op == FAKE_LEDC_DUTY) duties++;
+    }
+    TEST_CHECK_EQ(duties, 2); // Once before the first note, and once more to set it back
+    TEST_CHECK_EQ(buzzer_get_duty(buzzer), BUZZER_DUTY_SQUARE);
+    TEST_CHECK_EQ(fake_ledc_get_duty(LEDC_CHANNEL_0), square);
+
+    buzzer_destroy(buzzer);
+}
+
+int main(void) {
+    TEST_RUN(test_compile);
+    TEST_RUN(test_play);
+    TEST_RUN(test_play_duty);
+    return TEST_RESULT();
+}
+
+// Private functions
+
+/**
+ * Checks a compiled note against the frequency the C module gives the same note, and its duration.
+ * @param compiled Note compiled by the literal
+ * @param note Note expected
+ * @param octave Octave expected
+ * @param type Duration expected
+ */
+static void check_note(const buzzer_compiled_note_t &compiled, buzzer_note_t note, uint8_t octave,
+                       buzzer_note_type_t type) {
+    TEST_CHECK_EQ(compiled.freq_hz, (uint16_t) buzzer_get_note_freq(note, octave));
+    TEST_CHECK_EQ(compiled.type, type);
+}
@@ -0,0 +1,221 @@
+/**
+ * @file test_morse.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Tests of the Morse code encoder and of its transmission by the callback engine: the codes of the table, the
+ * standard and Farnsworth timings, and the elements and spaces sent for text and for characters produced on the fly.
+ */
+
+#include <stdlib.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_timer.h>
+#include "buzzer/buzzer.h"
+#include "buzzer/buzzer_morse.h"
+#include "buzzer/buzzer_sound.h"
+#include "fake_sim.h"
+#include "test_util.h"
+
+#define MORSE_WPM 20u ///< Speed of the transmissions, so dits last 60 ms
+#define MORSE_DIT_US 60000 ///< Length of a dit at MORSE_WPM
+#define MORSE_EDGES_MAX 32u ///< Output changes kept by the observer
+
+/**
+ * Times the output was turned on and off
+ */
+typedef struct {
+    uint32_t count; ///< Changes seen
+    int64_t time_us[MORSE_EDGES_MAX]; ///< Simulated time of each change, alternating between on and off
+} edges_t;
+
+/**
+ * Characters produced on the fly by the source callback
+ */
+typedef struct {
+    const char *text; ///< Characters left to produce
+    uint32_t calls; ///< Times the callback was called
+} source_t;
+
+// Private function declarations
+
+static void edges_observer(const fake_ledc_event_t *event, void *arg);
+
+static char morse_source(void *arg);
+
+static void morse_done(buzzer_sound_t *sound, void *arg);
+
+static void check_edges(const edges_t *edges, const int64_t *expected_units, uint32_t count, int64_t start_us);
+
+// Tests
+
+/**
+ * Checks the codes of letters (in both cases), digits and punctuation, and that characters without a code give 0.
+ */
+static void test_morse_encode(void) {
+    TEST_CHECK_EQ(buzzer_morse_encode('A'), 0x6);   // .-
+    TEST_CHECK_EQ(buzzer_morse_encode('a'), 0x6);
+    TEST_CHECK_EQ(buzzer_morse_encode('S'), 0x8);   // ...
+    TEST_CHECK_EQ(buzzer_morse_encode('O'), 0xF);   // ---
+    TEST_CHECK_EQ(buzzer_morse_encode('z'), 0x13);  // --..
+    TEST_CHECK_EQ(buzzer_morse_encode('0'), 0x3F);  // -----
+    TEST_CHECK_EQ(buzzer_morse_encode('5'), 0x20);  // .....
+    TEST_CHECK_EQ(buzzer_morse_encode('?'), 0x4C);  // ..--..
+    TEST_CHECK_EQ(buzzer_morse_encode('$'), 0xC8);  // ...-..-
+    TEST_CHECK_EQ(buzzer_morse_encode(' '), 0);
+    TEST_CHECK_EQ(buzzer_morse_encode('#'), 0);
+    TEST_CHECK_EQ(buzzer_morse_encode('{'), 0);
+    TEST_CHECK_EQ(buzzer_morse_encode('\n'), 0);
+
+    // Every letter has a code of one to four elements
+    for (char c = 'A'; c <= 'Z'; c++) {
+        uint8_t code = buzzer_morse_encode(c);
+        TEST_CHECK(code >= 0x2 && code < 0x20);
+    }
+}
+
+/**
+ * Checks the standard timing, and that Farnsworth spacing keeps the elements and stretches the spaces so PARIS takes
+ * a minute divided by the overall speed.
+ */
+static void test_morse_durations(void) {
+    buzzer_morse_t standard = {.text = "", .wpm = MORSE_WPM};
+    TEST_CHECK_EQ(buzzer_morse_duration_us(&standard, BUZZER_MORSE_DIT), MORSE_DIT_US);
+    TEST_CHECK_EQ(buzzer_morse_duration_us(&standard, BUZZER_MORSE_DAH), 3 * MORSE_DIT_US);
+    TEST_CHECK_EQ(buzzer_morse_duration_us(&standard, BUZZER_MORSE_ELEMENT_GAP), MORSE_DIT_US);
+    TEST_CHECK_EQ(buzzer_morse_duration_us(&standard, BUZZER_MORSE_CHAR_GAP), 3 * MORSE_DIT_US);
+    TEST_CHECK_EQ(buzzer_morse_duration_us(&standard, BUZZER_MORSE_WORD_GAP), 7 * MORSE_DIT_US);
+
+    buzzer_morse_t farnsworth = {.text = "", .wpm = MORSE_WPM, .farnsworth_wpm = 10};
+    TEST_CHECK_EQ(buzzer_morse_duration_us(&farnsworth, BUZZER_MORSE_DIT), MORSE_DIT_US);
+    TEST_CHECK_EQ(buzzer_morse_duration_us(&farnsworth, BUZZER_MORSE_DAH), 3 * MORSE_DIT_US);
+    TEST_CHECK_EQ(buzzer_morse_duration_us(&farnsworth, BUZZER_MORSE_ELEMENT_GAP), MORSE_DIT_US);
+    uint32_t char_gap_us = buzzer_morse_duration_us(&farnsworth, BUZZER_MORSE_CHAR_GAP);
+    uint32_t word_gap_us = buzzer_morse_duration_us(&farnsworth, BUZZER_MORSE_WORD_GAP);
+    TEST_CHECK(char_gap_us > 3 * MORSE_DIT_US && word_gap_us > 7 * MORSE_DIT_US);
+    // PARIS has 31 units of elements and gaps within characters, four character gaps and a word gap
+    int64_t paris_us = 31 * MORSE_DIT_US + 4 * (int64_t) char_gap_us + word_gap_us;
+    TEST_CHECK(paris_us > 6000000 - 10 && paris_us <= 6000000);
+
+    // Overall speeds which aren't lower than the character speed mean standard spacing
+    farnsworth.farnsworth_wpm = MORSE_WPM;
+    TEST_CHECK_EQ(buzzer_morse_duration_us(&farnsworth, BUZZER_MORSE_WORD_GAP), 7 * MORSE_DIT_US);
+    TEST_CHECK_EQ(buzzer_morse_duration_us(NULL, BUZZER_MORSE_DIT), 0);
+}
+
+/**
+ * Sends text with a word gap and characters without a code, and checks when the output is turned on and off.
+ */
+static void test_morse_text(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_sound_t *sound = buzzer_sound_create(buzzer);
+    // Leading spaces are skipped, the run of spaces and the character without a code make a single word gap
+    static const buzzer_morse_t morse = {.text = " an # e", .wpm = MORSE_WPM, .freq_hz = 700};
+    edges_t edges = {0};
+    bool done = false;
+    fake_ledc_set_observer(edges_observer, &edges);
+
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_sound_play_morse(sound, &morse, morse_done, &done), ESP_OK);
+    fake_sim_sleep_until(start_us + 40 * MORSE_DIT_US);
+    fake_ledc_set_observer(NULL, NULL);
+
+    // A (.-), a character gap, N (-.), a word gap and E (.), in units from the start
+    static const int64_t expected[] = {0, 1, 2, 5, 8, 11, 12, 13, 20, 21};
+    check_edges(&edges, expected, sizeof(expected) / sizeof(expected[0]), start_us);
+    TEST_CHECK(abs((int) fake_ledc_get_freq(LEDC_TIMER_0) - 700) <= 2); // Within the LEDC quantization
+    TEST_CHECK(done);
+    TEST_CHECK(!buzzer_sound_is_playing(sound));
+
+    buzzer_sound_destroy(sound);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Sends characters produced by a callback, and checks each one is read when it's about to be sent.
+ */
+static void test_morse_source(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_sound_t *sound = buzzer_sound_create(buzzer);
+    source_t source = {.text = "TE"};
+    buzzer_morse_t morse = {.source = morse_source, .source_arg = &source, .wpm = MORSE_WPM};
+    edges_t edges = {0};
+    bool done = false;
+    fake_ledc_set_observer(edges_observer, &edges);
+
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_sound_play_morse(sound, &morse, morse_done, &done), ESP_OK);
+    fake_esp_timer_flush();
+    TEST_CHECK_EQ(source.calls, 1);
+    fake_sim_sleep_until(start_us + 20 * MORSE_DIT_US);
+    fake_ledc_set_observer(NULL, NULL);
+
+    // T (-), a character gap and E (.)
+    static const int64_t expected[] = {0, 3, 6, 7};
+    check_edges(&edges, expected, sizeof(expected) / sizeof(expected[0]), start_us);
+    TEST_CHECK_EQ(source.calls, 3); // The last call returned the end of the text
+    TEST_CHECK(done);
+
+    buzzer_morse_t invalid = {.wpm = MORSE_WPM};
+    TEST_CHECK_EQ(buzzer_sound_play_morse(sound, &invalid, NULL, NULL), ESP_FAIL);
+    invalid = (buzzer_morse_t) {.text = "E"};
+    TEST_CHECK_EQ(buzzer_sound_play_morse(sound, &invalid, NULL, NULL), ESP_FAIL);
+
+    buzzer_sound_destroy(sound);
+    buzzer_destroy(buzzer);
+}
+
+int main(void) {
+    TEST_RUN(test_morse_encode);
+    TEST_RUN(test_morse_durations);
+    TEST_RUN(test_morse_text);
+    TEST_RUN(test_morse_source);
+    return TEST_RESULT();
+}
+
+// Private functions
+
+/**
+ * Keeps the times the timer of the buzzer is resumed and paused, which turn its output on and off.
+ * @param event Write to the LEDC
+ * @param arg Changes seen so far
+ */
+static void edges_observer(const fake_ledc_event_t *event, void *arg) {
+    edges_t *edges = arg;
+    if (event->op != FAKE_LEDC_RESUME && event->op != FAKE_LEDC_PAUSE) return;
+    if (edges->count < MORSE_EDGES_MAX) edges->time_us[edges->count] = event->time_us;
+    edges->count++;
+}
+
+/**
+ * Produces the next character of the text.
+ * @param arg Characters left
+ * @return The next character, or '\0' at the end of the text
+ */
+static char morse_source(void *arg) {
+    source_t *source = arg;
+    source->calls++;
+    return *source->text ? *source->text++ : '\0';
+}
+
+/**
+ * Records the end of the transmission.
+ * @param sound Sound which finished
+ * @param arg Flag to set
+ */
+static void morse_done(buzzer_sound_t *sound, void *arg) {
+    (void) sound;
+    *(bool *) arg = true;
+}
+
+/**
+ * Checks the output was turned on and off at the expected times.
+ * @param edges Changes seen
+ * @param expected_units Expected times of the changes, in dits from the start
+ * @param count Amount of expected changes
+ * @param start_us Time the transmission started at
+ */
+static void check_edges(const edges_t *edges, const int64_t *expected_units, uint32_t count, int64_t start_us) {
+    TEST_CHECK_EQ(edges->count, count);
+    for (uint32_t i = 0; i < count && i < edges->count && i < MORSE_EDGES_MAX; i++) {
+        TEST_CHECK_EQ(edges->time_us[i] - start_us, expected_units[i] * MORSE_DIT_US);
+    }
+}
@@ -0,0 +1,245 @@
+/**
+ * @file test_notation.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Tests of the text notation parser: the pitches, octaves and durations of the notes it queues, that each note
+ * is queued as soon as a character completes it when fed one byte at a time, that invalid notes are skipped, and that
+ * streams are read to the end.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include "buzzer/buzzer.h"
+#include "buzzer/buzzer_player.h"
+#include "buzzer/buzzer_notation.h"
+#include "fake_sim.h"
+#include "test_util.h"
+
+#define NOTATION_BPM 600u ///< Speed the notes are played at, so crotchets last 100 ms
+#define NOTATION_CHANGES_MAX 32u ///< Output changes kept by the observer
+#define NOTATION_FREQ_TOLERANCE 2 ///< Hz a frequency may differ from the note by, due to tuning and quantization
+
+/**
+ * Changes of the output of the buzzer, followed through the writes to the LEDC
+ */
+typedef struct {
+    uint32_t freq_hz; ///< Frequency the timer is set to
+    bool running; ///< Whether the timer is counting
+    uint32_t dividers; ///< Frequencies written to the timer, one per note started
+    uint32_t count; ///< Changes seen
+    int64_t time_us[NOTATION_CHANGES_MAX]; ///< Simulated time of each change
+    uint32_t sounding_hz[NOTATION_CHANGES_MAX]; ///< Frequency sounding after each change, 0 for silence
+} changes_t;
+
+/**
+ * Buzzer, player and parser a test feeds notes to
+ */
+typedef struct {
+    buzzer_t *buzzer; ///< Buzzer the notes are played on
+    buzzer_player_t *player; ///< Player the notes are queued in
+    buzzer_notation_t *parser; ///< Parser under test
+    changes_t changes; ///< Output changes seen since the parser was created
+    int64_t start_us; ///< Simulated time the parser was created at
+} fixture_t;
+
+// Private function declarations
+
+static void fixture_init(fixture_t *fixture);
+
+static void fixture_destroy(fixture_t *fixture);
+
+static void changes_observer(const fake_ledc_event_t *event, void *arg);
+
+static void check_changes(const fixture_t *fixture, const int64_t *times_ms, const uint32_t *freqs_hz, uint32_t count);
+
+// Tests
+
+/**
+ * Feeds a melody with an octave, durations, a rest and a note which takes the octave and duration of the previous
+ * ones, and checks when each note starts and what it sounds.
+ */
+static void test_notation_notes(void) {
+    fixture_t fixture;
+    fixture_init(&fixture);
+    static const char text[] = "C4q D4e R q E";
+    TEST_CHECK_EQ(buzzer_notation_feed(fixture.parser, text, strlen(text)), ESP_OK);
+    TEST_CHECK_EQ(buzzer_notation_flush(fixture.parser), ESP_OK);
+    fake_sim_sleep_until(fixture.start_us + 500000);
+
+    static const int64_t times_ms[] = {0, 100, 150, 250, 350};
+    static const uint32_t freqs_hz[] = {262, 294, 0, 330, 0};
+    check_changes(&fixture, times_ms, freqs_hz, sizeof(times_ms) / sizeof(times_ms[0]));
+    fixture_destroy(&fixture);
+}
+
+/**
+ * Feeds a melody one byte at a time, and checks each note is queued once the character completing it arrives, and not
+ * before: a duration may still follow the octave, and a dot may still follow the duration.
+ */
+static void test_notation_incremental(void) {
+    fixture_t fixture;
+    fixture_init(&fixture);
+
+    static const char *const steps[] = {"C", "4", "q", " ", "D", "5", " ", "e", ".", "|", "R"};
+    static const uint32_t queued[] = {0, 0, 0, 1, 1, 1, 1, 1, 2, 2, 2};
+    for (uint32_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        TEST_CHECK_EQ(buzzer_notation_feed(fixture.parser, steps[i], 1), ESP_OK);
+        vTaskDelay(1); // Lets the player take whatever was queued
+        buzzer_player_stats_t stats;
+        buzzer_player_get_stats(fixture.player, &stats);
+        TEST_CHECK_EQ(stats.played + buzzer_player_get_level(fixture.player), queued[i]);
+    }
+    TEST_CHECK_EQ(buzzer_notation_flush(fixture.parser), ESP_OK);
+    fake_sim_sleep_until(fixture.start_us + 500000);
+    fixture.start_us = fixture.changes.time_us[0]; // Each step took a tick
+
+    // The dotted quaver lasts 75 ms, and is followed by a rest of the same length
+    static const int64_t times_ms[] = {0, 100, 175};
+    static const uint32_t freqs_hz[] = {262, 587, 0};
+    check_changes(&fixture, times_ms, freqs_hz, sizeof(times_ms) / sizeof(times_ms[0]));
+    fixture_destroy(&fixture);
+}
+
+/**
+ * Feeds accidentals, including ones which move the note to the neighbouring octave, and checks their pitches.
+ */
+static void test_notation_accidentals(void) {
+    fixture_t fixture;
+    fixture_init(&fixture);
+    // B#3 is C4 and Cb4 is B3, and the following notes keep octave 4
+    static const char text[] = "B#3s Cb4 A# Bb\n";
+    TEST_CHECK_EQ(buzzer_notation_feed(fixture.parser, text, strlen(text)), ESP_OK);
+    fake_sim_sleep_until(fixture.start_us + 300000);
+
+    static const int64_t times_ms[] = {0, 25, 50, 100};
+    static const uint32_t freqs_hz[] = {262, 247, 466, 0};
+    check_changes(&fixture, times_ms, freqs_hz, sizeof(times_ms) / sizeof(times_ms[0]));
+    TEST_CHECK_EQ(fixture.changes.dividers, 4); // A#4 and Bb4 are two notes, even if they sound the same
+    fixture_destroy(&fixture);
+}
+
+/**
+ * Feeds invalid notes, and checks they're reported and skipped up to the next separator while the valid ones are
+ * still queued.
+ */
+static void test_notation_invalid(void) {
+    fixture_t fixture;
+    fixture_init(&fixture);
+    static const char text[] = "C4q X9 Dx4q, H Eq";
+    TEST_CHECK_EQ(buzzer_notation_feed(fixture.parser, text, strlen(text)), ESP_FAIL);
+    TEST_CHECK_EQ(buzzer_notation_flush(fixture.parser), ESP_OK);
+    fake_sim_sleep_until(fixture.start_us + 500000);
+
+    static const int64_t times_ms[] = {0, 100, 200};
+    static const uint32_t freqs_hz[] = {262, 330, 0};
+    check_changes(&fixture, times_ms, freqs_hz, sizeof(times_ms) / sizeof(times_ms[0]));
+
+    TEST_CHECK_EQ(buzzer_notation_feed(NULL, text, 1), ESP_FAIL);
+    TEST_CHECK_EQ(buzzer_notation_feed(fixture.parser, NULL, 1), ESP_FAIL);
+    TEST_CHECK_EQ(buzzer_notation_feed(fixture.parser, NULL, 0), ESP_OK);
+    TEST_CHECK(buzzer_notation_create(fixture.player, 0) == NULL);
+    fixture_destroy(&fixture);
+}
+
+/**
+ * Reads a melody from a stream, and checks the note left pending at the end of the stream is queued too.
+ */
+static void test_notation_stream(void) {
+    fixture_t fixture;
+    fixture_init(&fixture);
+    char text[] = "G4e A";
+    FILE *stream = fmemopen(text, strlen(text), "r");
+    TEST_CHECK(stream != NULL);
+    TEST_CHECK_EQ(buzzer_notation_feed_stream(fixture.parser, stream), ESP_OK);
+    fclose(stream);
+    fake_sim_sleep_until(fixture.start_us + 300000);
+
+    static const int64_t times_ms[] = {0, 50, 100};
+    static const uint32_t freqs_hz[] = {392, 440, 0};
+    check_changes(&fixture, times_ms, freqs_hz, sizeof(times_ms) / sizeof(times_ms[0]));
+    TEST_CHECK_EQ(buzzer_notation_feed_stream(fixture.parser, NULL), ESP_FAIL);
+    fixture_destroy(&fixture);
+}
+
+int main(void) {
+    TEST_RUN(test_notation_notes);
+    TEST_RUN(test_notation_incremental);
+    TEST_RUN(test_notation_accidentals);
+    TEST_RUN(test_notation_invalid);
+    TEST_RUN(test_notation_stream);
+    return TEST_RESULT();
+}
+
+// Private functions
+
+/**
+ * Creates the buzzer, the player and the parser, and starts following the output.
+ * @param fixture Where they're stored
+ */
+static void fixture_init(fixture_t *fixture) {
+    memset(fixture, 0, sizeof(*fixture));
+    fixture->buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    fixture->player = buzzer_player_create(fixture->buzzer, NULL);
+    fixture->parser = buzzer_notation_create(fixture->player, NOTATION_BPM);
+    TEST_CHECK(fixture->parser != NULL);
+    fixture->start_us = esp_timer_get_time();
+    fake_ledc_set_observer(changes_observer, &fixture->changes);
+}
+
+/**
+ * Stops following the output, and destroys the parser, the player and the buzzer.
+ * @param fixture What to destroy
+ */
+static void fixture_destroy(fixture_t *fixture) {
+    fake_ledc_set_observer(NULL, NULL);
+    buzzer_notation_destroy(fixture->parser);
+    buzzer_player_destroy(fixture->player);
+    buzzer_destroy(fixture->buzzer);
+}
+
+/**
+ * Follows the frequency and the state of the timer, and keeps the output whenever it changes.
+ * @param event Write to the LEDC
+ * @param arg Changes seen so far
+ */
+static void changes_observer(const fake_ledc_event_t *event, void *arg) {
+    changes_t *changes = arg;
+    if (event->op == FAKE_LEDC_DUTY || event->index != LEDC_TIMER_0) return;
+    if (event->op == FAKE_LEDC_DIVIDER) {
+        changes->freq_hz = event->freq_hz;
+        changes->dividers++;
+    } else if (event->op == FAKE_LEDC_RESUME) {
+        changes->running = true;
+    } else if (event->op == FAKE_LEDC_PAUSE) {
+        changes->running = false;
+    }
+
+    uint32_t sounding_hz = changes->running ? changes->freq_hz : 0;
+    uint32_t last_hz = changes->count ? changes->sounding_hz[(changes->count - 1) % NOTATION_CHANGES_MAX] : 0;
+    if (sounding_hz == last_hz) return;
+    if (changes->count < NOTATION_CHANGES_MAX) {
+        changes->time_us[changes->count] = event->time_us;
+        changes->sounding_hz[changes->count] = sounding_hz;
+    }
+    changes->count++;
+}
+
+/**
+ * Checks the output changed at the expected times to the expected frequencies.
+ * @param fixture Fixture whose output is checked
+ * @param times_ms Expected times of the changes, in milliseconds since the parser was created
+ * @param freqs_hz Expected frequency after each change, 0 for silence
+ * @param count Amount of expected changes
+ */
+static void check_changes(const fixture_t *fixture, const int64_t *times_ms, const uint32_t *freqs_hz, uint32_t count) {
+    const changes_t *changes = &fixture->changes;
+    TEST_CHECK_EQ(changes->count, count);
+    for (uint32_t i = 0; i < count && i < changes->count && i < NOTATION_CHANGES_MAX; i++) {
+        TEST_CHECK_EQ((changes->time_us[i] - fixture->start_us) / 1000, times_ms[i]);
+        TEST_CHECK(abs((int) changes->sounding_hz[i] - (int) freqs_hz[i]) <= NOTATION_FREQ_TOLERANCE);
+    }
+}
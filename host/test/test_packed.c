@@ -0,0 +1,196 @@
+/**
+ * @file test_packed.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Tests of the packed melody decoder against a melody packed with tools/buzzer_pack.py, which uses every
+ * operation of the format, and a benchmark of the decoder reporting its cost per note and the compression ratio.
+ */
+
+#include <esp_timer.h>
+#include "buzzer/buzzer.h"
+#include "buzzer/buzzer_packed.h"
+#include "test_util.h"
+
+#define BENCH_PASSES 100000u ///< Times the fixture is decoded by the benchmark
+
+/**
+ * Melody the fixture was packed from: the test melody, a rest, and a jump too wide for a delta
+ */
+static const buzzer_musical_note_t fixture_notes[] = {
+        {BUZZER_NOTE_C,    4, BUZZER_NTYPE_QUAVER_DOTTED,     0},
+        {BUZZER_NOTE_C,    4, BUZZER_NTYPE_SEMIQUAVER,        0},
+        {BUZZER_NOTE_D,    4, BUZZER_NTYPE_CROTCHET,          0},
+        {BUZZER_NOTE_C,    4, BUZZER_NTYPE_CROTCHET,          0},
+        {BUZZER_NOTE_F,    4, BUZZER_NTYPE_CROTCHET,          0},
+        {BUZZER_NOTE_E,    4, BUZZER_NTYPE_MINIM,             0},
+        {BUZZER_NOTE_C,    4, BUZZER_NTYPE_QUAVER_DOTTED,     0},
+        {BUZZER_NOTE_C,    4, BUZZER_NTYPE_SEMIQUAVER,        0},
+        {BUZZER_NOTE_D,    4, BUZZER_NTYPE_CROTCHET,          0},
+        {BUZZER_NOTE_C,    4, BUZZER_NTYPE_CROTCHET,          0},
+        {BUZZER_NOTE_G,    4, BUZZER_NTYPE_CROTCHET,          0},
+        {BUZZER_NOTE_F,    4, BUZZER_NTYPE_MINIM,             0},
+        {BUZZER_NOTE_C,    4, BUZZER_NTYPE_QUAVER_DOTTED,     0},
+        {BUZZER_NOTE_C,    4, BUZZER_NTYPE_SEMIQUAVER,        0},
+        {BUZZER_NOTE_C,    5, BUZZER_NTYPE_CROTCHET,          0},
+        {BUZZER_NOTE_A,    4, BUZZER_NTYPE_CROTCHET,          0},
+        {BUZZER_NOTE_F,    4, BUZZER_NTYPE_CROTCHET,          0},
+        {BUZZER_NOTE_E,    4, BUZZER_NTYPE_CROTCHET,          0},
+        {BUZZER_NOTE_D,    4, BUZZER_NTYPE_CROTCHET,          0},
+        {BUZZER_NOTE_As,   4, BUZZER_NTYPE_QUAVER_DOTTED,     0},
+        {BUZZER_NOTE_As,   4, BUZZER_NTYPE_SEMIQUAVER,        0},
+        {BUZZER_NOTE_A,    4, BUZZER_NTYPE_CROTCHET,          0},
+        {BUZZER_NOTE_F,    4, BUZZER_NTYPE_CROTCHET,          0},
+        {BUZZER_NOTE_G,    4, BUZZER_NTYPE_CROTCHET,          0},
+        {BUZZER_NOTE_F,    4, BUZZER_NTYPE_MINIM,             0},
+        {BUZZER_NOTE_REST, 0, BUZZER_NTYPE_MINIM,             0},
+        {BUZZER_NOTE_C,    1, BUZZER_NTYPE_SEMIBREVE,         0},
+        {BUZZER_NOTE_C,    5, BUZZER_NTYPE_SEMIBREVE,         0}
+};
+
+#define FIXTURE_LENGTH (sizeof(fixture_notes) / sizeof(fixture_notes[0])) ///< Notes in the fixture
+
+/**
+ * Output of tools/buzzer_pack.py for fixture_notes
+ */
+static const uint8_t fixture_data[] = {
+        0x46, 0x20, 0x49, 0x20, 0x45, 0x22, 0x1E, 0x25, 0x43, 0x1F, 0x46, 0x1C,
+        0x84, 0x0A, 0x00, 0x27, 0x43, 0x1E, 0x46, 0x1B, 0x49, 0x20, 0x45, 0x2C,
+        0x1D, 0x1C, 0x1F, 0x1E, 0x46, 0x28, 0x49, 0x20, 0x45, 0x1F, 0x1C, 0x22,
+        0x43, 0x1E, 0x53, 0x41, 0x60, 0x0C, 0x60, 0x3C,
+};
+static const buzzer_packed_melody_t fixture = {fixture_data, sizeof(fixture_data)};
+
+/**
+ * Malformed stream, with the notes that can be unpacked before the error
+ */
+typedef struct {
+    const char *name; ///< What's wrong with it
+    uint8_t data[8]; ///< Packed operations
+    uint32_t size; ///< Size of the packed operations
+    uint32_t notes; ///< Notes unpacked before the error
+} malformed_case_t;
+
+/**
+ * Malformed streams, one per error the decoder detects
+ */
+static const malformed_case_t malformed_cases[] = {
+        {"reserved operation",        {0x20, 0x70},                   2, 1},
+        {"truncated absolute pitch",  {0x20, 0x60},                   2, 1},
+        {"truncated back-reference",  {0x20, 0x80, 0x01},             3, 1},
+        {"back-reference to itself",  {0x20, 0x80, 0x00, 0x00},       4, 1},
+        {"back-reference too far",    {0x20, 0x80, 0x05, 0x00},       4, 1},
+        {"nested back-reference",     {0x20, 0x21, 0x81, 0x01, 0x00}, 5, 3},
+        {"pitch below the range",     {0x00, 0x00},                   2, 1},
+        {"pitch above the range",     {0x60, 0x6B, 0x21},             3, 1},
+};
+
+// Tests
+
+/**
+ * Unpacks the fixture and compares it with the melody it was packed from.
+ */
+static void test_unpack_fixture(void) {
+    buzzer_unpacker_t unpacker;
+    buzzer_musical_note_t note;
+    buzzer_unpacker_init(&unpacker, &fixture);
+
+    uint32_t count = 0;
+    while (buzzer_unpacker_next(&unpacker, &note)) {
+        if (count < FIXTURE_LENGTH) {
+            TEST_CHECK_EQ(note.note, fixture_notes[count].note);
+            TEST_CHECK_EQ(note.octave, fixture_notes[count].octave);
+            TEST_CHECK_EQ(note.type, fixture_notes[count].type);
+            TEST_CHECK_EQ(note.gate, 0);
+        }
+        count++;
+    }
+    TEST_CHECK_EQ(count, FIXTURE_LENGTH);
+    TEST_CHECK(!buzzer_unpacker_next(&unpacker, &note)); // Stays at the end
+}
+
+/**
+ * Unpacks and plays malformed streams, which must stop at the error and be reported, unlike the end of a melody.
+ */
+static void test_malformed(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    for (uint32_t i = 0; i < sizeof(malformed_cases) / sizeof(malformed_cases[0]); i++) {
+        const malformed_case_t *test = &malformed_cases[i];
+        buzzer_packed_melody_t melody = {test->data, test->size};
+        buzzer_unpacker_t unpacker;
+        buzzer_musical_note_t note;
+        buzzer_unpacker_init(&unpacker, &melody);
+
+        uint32_t notes = 0;
+        while (buzzer_unpacker_next(&unpacker, &note)) notes++;
+        if (notes != test->notes || !unpacker.malformed) fprintf(stderr, "malformed case: %s\n", test->name);
+        TEST_CHECK_EQ(notes, test->notes);
+        TEST_CHECK(unpacker.malformed);
+        TEST_CHECK(!buzzer_unpacker_next(&unpacker, &note));
+        TEST_CHECK_EQ(buzzer_play_packed_melody(buzzer, &melody, 6000), ESP_FAIL);
+    }
+
+    // Reaching the end of the main stream is how melodies end, even an empty one
+    buzzer_packed_melody_t empty = {NULL, 0};
+    TEST_CHECK_EQ(buzzer_play_packed_melody(buzzer, &empty, 6000), ESP_OK);
+    TEST_CHECK_EQ(buzzer_play_packed_melody(buzzer, &fixture, 6000), ESP_OK);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Plays the fixture with the blocking functions, and checks the notes reach the LEDC with their full duration.
+ */
+static void test_play_fixture(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    fake_ledc_set_recording(true);
+
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_play_packed_melody(buzzer, &fixture, 240), ESP_OK);
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+
+    uint32_t expected_ms = 0, sounding = 0;
+    for (uint32_t i = 0; i < FIXTURE_LENGTH; i++) {
+        expected_ms += buzzer_note_type_to_ms(fixture_notes[i].type, 240);
+        if (fixture_notes[i].note != BUZZER_NOTE_REST) sounding++;
+    }
+    TEST_CHECK_EQ(elapsed_us, (int64_t) expected_ms * 1000);
+
+    size_t count;
+    const fake_ledc_event_t *events = fake_ledc_get_events(&count);
+    uint32_t frequencies = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (events[i].op == FAKE_LEDC_DIVIDER && events[i].index == LEDC_TIMER_0) frequencies++;
+    }
+    TEST_CHECK_EQ(frequencies, sounding);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Decodes the fixture many times, reporting the time per note on the host and the compression ratio.
+ */
+static void bench_decode(void) {
+    buzzer_unpacker_t unpacker;
+    buzzer_musical_note_t note;
+    volatile uint32_t checksum = 0; // Keeps the decoding from being optimized away
+
+    uint64_t start_ns = test_real_ns();
+    for (uint32_t pass = 0; pass < BENCH_PASSES; pass++) {
+        buzzer_unpacker_init(&unpacker, &fixture);
+        while (buzzer_unpacker_next(&unpacker, &note)) checksum += note.note + note.type;
+    }
+    uint64_t elapsed_ns = test_real_ns() - start_ns;
+    (void) checksum;
+
+    size_t unpacked = FIXTURE_LENGTH * sizeof(buzzer_musical_note_t);
+    printf("packed (%s): %u notes in %u B instead of %u B (%.1fx), decoded in %.1f ns/note\n",
+           BUZZER_COMPACT ? "BUZZER_COMPACT=1" : "default", (unsigned) FIXTURE_LENGTH, (unsigned) fixture.size,
+           (unsigned) unpacked, (double) unpacked / fixture.size,
+           (double) elapsed_ns / ((double) BENCH_PASSES * FIXTURE_LENGTH));
+}
+
+int main(void) {
+    TEST_RUN(test_unpack_fixture);
+    TEST_RUN(test_malformed);
+    TEST_RUN(test_play_fixture);
+    TEST_RUN(bench_decode);
+    return TEST_RESULT();
+}
@@ -0,0 +1,179 @@
+/**
+ * @file test_player_config.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Tests of the player task configuration and resource usage: the task is created with the configured stack,
+ * priority and core (and refused on cores which don't exist), the stats report its stack, awake time and lateness,
+ * and destroying the player from its own low watermark callback is refused instead of waiting forever.
+ */
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include "buzzer/buzzer.h"
+#include "buzzer/buzzer_player.h"
+#include "fake_sim.h"
+#include "test_util.h"
+
+#define CONFIG_TASK_NAME "buzzer_player" ///< Name of the player task
+#define CONFIG_EVENT_US 100000 ///< Length of the events played
+#define CONFIG_LATE_US 3000 ///< Time the esp_timer task is kept busy past the end of an event
+
+/**
+ * State of the low watermark callback trying to destroy its player
+ */
+typedef struct {
+    buzzer_player_t *player; ///< Player to destroy
+    uint32_t calls; ///< Times the callback was called
+} destroy_t;
+
+// Private function declarations
+
+static void wait_task_gone(void);
+
+static void hog_cb(void *arg);
+
+static void destroy_on_watermark(buzzer_player_t *player, void *arg);
+
+// Tests
+
+/**
+ * Creates players with the default task configuration, with a custom one and pinned to a core which doesn't exist,
+ * and checks the tasks created and the stack reported by the stats.
+ */
+static void test_task_config(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    fake_sim_task_config_t task;
+
+    buzzer_player_t *player = buzzer_player_create(buzzer, NULL);
+    TEST_CHECK(fake_sim_get_task_config(CONFIG_TASK_NAME, &task));
+    TEST_CHECK_EQ(task.stack_bytes, BUZZER_PLAYER_TASK_STACK);
+    TEST_CHECK_EQ(task.priority, BUZZER_PLAYER_TASK_PRIORITY);
+    TEST_CHECK_EQ(task.core, tskNO_AFFINITY);
+    buzzer_player_destroy(player);
+    wait_task_gone();
+
+    buzzer_player_config_t config = {.task_stack = 3072, .task_priority = 7, .task_pinned = true, .task_core = 1};
+    player = buzzer_player_create(buzzer, &config);
+    TEST_CHECK(fake_sim_get_task_config(CONFIG_TASK_NAME, &task));
+    TEST_CHECK_EQ(task.stack_bytes, 3072);
+    TEST_CHECK_EQ(task.priority, 7);
+    TEST_CHECK_EQ(task.core, 1);
+    buzzer_player_stats_t stats;
+    TEST_CHECK_EQ(buzzer_player_get_stats(player, &stats), ESP_OK);
+    TEST_CHECK_EQ(stats.stack_free_min, 3072); // The host doesn't measure stacks, so nothing is ever used
+    buzzer_player_destroy(player);
+    wait_task_gone();
+
+    size_t timers = fake_esp_timer_count();
+    config.task_core = portNUM_PROCESSORS;
+    TEST_CHECK(buzzer_player_create(buzzer, &config) == NULL);
+    TEST_CHECK(!fake_sim_get_task_config(CONFIG_TASK_NAME, &task));
+    TEST_CHECK_EQ(fake_esp_timer_count(), timers);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Plays two runs of two events, keeping the esp_timer task busy past the end of the first event of the first run, and
+ * checks the lateness of both runs, and that the time the task spends sleeping isn't counted as awake.
+ */
+static void test_stats_timing(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_player_t *player = buzzer_player_create(buzzer, NULL);
+    buzzer_event_t event = {.freq_hz = 440, .duration_ms = CONFIG_EVENT_US / 1000};
+
+    int64_t start_us = esp_timer_get_time();
+    int64_t hog_until_us = start_us + CONFIG_EVENT_US + CONFIG_LATE_US;
+    esp_timer_handle_t hog;
+    esp_timer_create_args_t hog_args = {.callback = hog_cb, .arg = &hog_until_us, .name = "hog"};
+    TEST_CHECK_EQ(esp_timer_create(&hog_args, &hog), ESP_OK);
+    TEST_CHECK_EQ(esp_timer_start_once(hog, CONFIG_EVENT_US - 1), ESP_OK);
+    TEST_CHECK_EQ(buzzer_player_push(player, &event), ESP_OK);
+    TEST_CHECK_EQ(buzzer_player_push(player, &event), ESP_OK);
+    fake_sim_sleep_until(start_us + 3 * CONFIG_EVENT_US);
+
+    buzzer_player_stats_t stats;
+    TEST_CHECK_EQ(buzzer_player_get_stats(player, &stats), ESP_OK);
+    TEST_CHECK_EQ(stats.max_late_us, CONFIG_LATE_US);
+    TEST_CHECK_EQ(stats.run_max_late_us, CONFIG_LATE_US);
+    TEST_CHECK_EQ(stats.run_us, 2 * CONFIG_EVENT_US); // The deadlines are accumulated, so the delay is made up for
+    TEST_CHECK_EQ(stats.awake_us, 0); // Code takes no simulated time, so only sleeping could have been counted
+    TEST_CHECK_EQ(stats.run_awake_us, 0);
+
+    start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_player_push(player, &event), ESP_OK);
+    TEST_CHECK_EQ(buzzer_player_push(player, &event), ESP_OK);
+    fake_sim_sleep_until(start_us + 3 * CONFIG_EVENT_US);
+    TEST_CHECK_EQ(buzzer_player_get_stats(player, &stats), ESP_OK);
+    TEST_CHECK_EQ(stats.max_late_us, CONFIG_LATE_US);
+    TEST_CHECK_EQ(stats.run_max_late_us, 0);
+    TEST_CHECK_EQ(stats.run_us, 2 * CONFIG_EVENT_US);
+    TEST_CHECK_EQ(stats.awake_us, 0);
+
+    esp_timer_delete(hog);
+    buzzer_player_destroy(player);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Destroys the player from its low watermark callback, and checks the call is refused, leaving the player usable.
+ */
+static void test_destroy_from_watermark(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    destroy_t destroy = {0};
+    buzzer_player_config_t config = {.on_low_watermark = destroy_on_watermark, .arg = &destroy};
+    destroy.player = buzzer_player_create(buzzer, &config);
+    buzzer_event_t event = {.freq_hz = 440, .duration_ms = CONFIG_EVENT_US / 1000};
+
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_player_push(destroy.player, &event), ESP_OK);
+    fake_sim_sleep_until(start_us + 2 * CONFIG_EVENT_US);
+    TEST_CHECK_EQ(destroy.calls, 1);
+
+    // The player is still alive and plays
+    TEST_CHECK_EQ(buzzer_player_push(destroy.player, &event), ESP_OK);
+    fake_sim_sleep_until(start_us + 2 * CONFIG_EVENT_US + CONFIG_EVENT_US / 2);
+    TEST_CHECK(fake_ledc_is_running(LEDC_TIMER_0));
+    buzzer_player_stats_t stats;
+    TEST_CHECK_EQ(buzzer_player_get_stats(destroy.player, &stats), ESP_OK);
+    TEST_CHECK_EQ(stats.played, 2);
+
+    buzzer_player_destroy(destroy.player);
+    buzzer_destroy(buzzer);
+}
+
+int main(void) {
+    TEST_RUN(test_task_config);
+    TEST_RUN(test_stats_timing);
+    TEST_RUN(test_destroy_from_watermark);
+    return TEST_RESULT();
+}
+
+// Private functions
+
+/**
+ * Waits for the player task to finish deleting itself, which it does right after the player is destroyed.
+ */
+static void wait_task_gone(void) {
+    fake_sim_task_config_t task;
+    while (fake_sim_get_task_config(CONFIG_TASK_NAME, &task)) vTaskDelay(1);
+}
+
+/**
+ * Keeps the esp_timer task busy until the simulated clock reaches the time it waits for, delaying the other timers.
+ * @param arg Simulated time to wait for
+ */
+static void hog_cb(void *arg) {
+    fake_sim_sleep_until(*(int64_t *) arg);
+}
+
+/**
+ * Tries to destroy the player from its own task.
+ * @param player Player whose ring buffer reached the low watermark
+ * @param arg Callback state
+ */
+static void destroy_on_watermark(buzzer_player_t *player, void *arg) {
+    destroy_t *destroy = arg;
+    destroy->calls++;
+    buzzer_player_destroy(player);
+}
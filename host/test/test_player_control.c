@@ -0,0 +1,357 @@
+/**
+ * @file test_player_control.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Tests of the melody controls of the player, on the simulated clock: seeking into the middle of a note or of
+ * merged rests, pausing and resuming in the middle of a note or after its gate, seeking past the end, and the position
+ * and repetitions of the looped section when it wraps around or is seeked into.
+ */
+
+#include <math.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_timer.h>
+#include "buzzer/buzzer.h"
+#include "buzzer/buzzer_player.h"
+#include "fake_sim.h"
+#include "test_util.h"
+
+#define CONTROL_BPM 600u ///< Speed the melodies are played at, so crotchets last 100 ms
+#define CONTROL_NOTE_US 100000 ///< Length of a crotchet at CONTROL_BPM
+#define CONTROL_MARGIN_US 1000 ///< Time the output is checked before and after a boundary
+
+/**
+ * Frequency requested to the buzzer's timer, followed through the writes to the LEDC
+ */
+typedef struct {
+    uint32_t freq_hz; ///< Last frequency requested
+} output_t;
+
+// A crotchet, a staccato crotchet (sounding for its first half), two rests which are merged, and a minim
+static const buzzer_musical_note_t control_notes[] = {
+        {.note = BUZZER_NOTE_A, .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+        {.note = BUZZER_NOTE_C, .octave = 5, .type = BUZZER_NTYPE_CROTCHET, .gate = BUZZER_GATE_STACCATO},
+        {.note = BUZZER_NOTE_REST, .octave = 0, .type = BUZZER_NTYPE_CROTCHET},
+        {.note = BUZZER_NOTE_REST, .octave = 0, .type = BUZZER_NTYPE_CROTCHET},
+        {.note = BUZZER_NOTE_E, .octave = 5, .type = BUZZER_NTYPE_MINIM},
+};
+static const buzzer_melody_t control_melody =
+        BUZZER_MELODY_INIT(control_notes, sizeof(control_notes) / sizeof(control_notes[0]));
+
+// Four crotchets, whose second and third ones are repeated once: A B C B C D, 600 ms
+static const buzzer_musical_note_t loop_notes[] = {
+        {.note = BUZZER_NOTE_A, .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+        {.note = BUZZER_NOTE_B, .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+        {.note = BUZZER_NOTE_C, .octave = 5, .type = BUZZER_NTYPE_CROTCHET},
+        {.note = BUZZER_NOTE_D, .octave = 5, .type = BUZZER_NTYPE_CROTCHET},
+};
+static const buzzer_melody_t loop_melody = {
+        .melody = loop_notes,
+        .length = sizeof(loop_notes) / sizeof(loop_notes[0]),
+        .loop_start = 1,
+        .loop_end = 3,
+        .loop_count = 1
+};
+
+// Private function declarations
+
+static void output_observer(const fake_ledc_event_t *event, void *arg);
+
+static bool sounds(const output_t *output, buzzer_note_t note, uint8_t octave);
+
+// Tests
+
+/**
+ * Seeks into the middle of a staccato note, before its gate ends, and checks the note sounds for the rest of its gate,
+ * and the following notes keep their timing from the new position.
+ */
+static void test_seek_mid_note(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_player_t *player = buzzer_player_create(buzzer, NULL);
+    output_t output = {0};
+    fake_ledc_set_observer(output_observer, &output);
+
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_player_play_melody(player, &control_melody, CONTROL_BPM), ESP_OK);
+    fake_sim_sleep_until(start_us + 30000);
+    TEST_CHECK(sounds(&output, BUZZER_NOTE_A, 4));
+
+    int64_t seek_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_player_seek(player, 120), ESP_OK);
+    fake_sim_sleep_until(seek_us + 10000);
+    TEST_CHECK(sounds(&output, BUZZER_NOTE_C, 5));
+    TEST_CHECK_EQ(buzzer_player_get_position_ms(player), 130);
+    TEST_CHECK_EQ(buzzer_player_get_state(player), BUZZER_PLAYER_PLAYING);
+
+    // The gate is measured from the start of the note, so it ends 30 ms after the seek
+    fake_sim_sleep_until(seek_us + 30000 - CONTROL_MARGIN_US);
+    TEST_CHECK(sounds(&output, BUZZER_NOTE_C, 5));
+    fake_sim_sleep_until(seek_us + 30000 + CONTROL_MARGIN_US);
+    TEST_CHECK(!fake_ledc_is_running(LEDC_TIMER_0));
+
+    // The rests end at 400 ms, 280 ms after the seek
+    fake_sim_sleep_until(seek_us + 280000 - CONTROL_MARGIN_US);
+    TEST_CHECK(!fake_ledc_is_running(LEDC_TIMER_0));
+    fake_sim_sleep_until(seek_us + 280000 + CONTROL_MARGIN_US);
+    TEST_CHECK(sounds(&output, BUZZER_NOTE_E, 5));
+
+    fake_sim_sleep_until(seek_us + 480000 + CONTROL_MARGIN_US);
+    TEST_CHECK_EQ(buzzer_player_get_state(player), BUZZER_PLAYER_IDLE);
+    TEST_CHECK(!fake_ledc_is_running(LEDC_TIMER_0));
+
+    fake_ledc_set_observer(NULL, NULL);
+    buzzer_player_destroy(player);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Seeks into the middle of the first of the merged rests and to the start of the second one, and checks the silence
+ * lasts until the note after them, with the position advancing through it.
+ */
+static void test_seek_merged_rests(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_player_t *player = buzzer_player_create(buzzer, NULL);
+    output_t output = {0};
+    fake_ledc_set_observer(output_observer, &output);
+
+    TEST_CHECK_EQ(buzzer_player_play_melody(player, &control_melody, CONTROL_BPM), ESP_OK);
+    fake_sim_sleep_until(esp_timer_get_time() + 30000);
+
+    const uint32_t seeks_ms[] = {250, 300};
+    for (size_t i = 0; i < sizeof(seeks_ms) / sizeof(seeks_ms[0]); i++) {
+        int64_t seek_us = esp_timer_get_time();
+        int64_t left_us = (400 - (int64_t) seeks_ms[i]) * 1000;
+        TEST_CHECK_EQ(buzzer_player_seek(player, seeks_ms[i]), ESP_OK);
+        fake_sim_sleep_until(seek_us + left_us / 2);
+        TEST_CHECK(!fake_ledc_is_running(LEDC_TIMER_0));
+        TEST_CHECK_EQ(buzzer_player_get_position_ms(player), seeks_ms[i] + (uint32_t) (left_us / 2000));
+        fake_sim_sleep_until(seek_us + left_us - CONTROL_MARGIN_US);
+        TEST_CHECK(!fake_ledc_is_running(LEDC_TIMER_0));
+        fake_sim_sleep_until(seek_us + left_us + CONTROL_MARGIN_US);
+        TEST_CHECK(sounds(&output, BUZZER_NOTE_E, 5));
+    }
+
+    fake_ledc_set_observer(NULL, NULL);
+    buzzer_player_destroy(player);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Pauses in the middle of a note, and checks the position holds while paused, and that resuming sounds the note for
+ * the part of it which was left, keeping the timing of the following notes.
+ */
+static void test_pause_mid_note(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_player_t *player = buzzer_player_create(buzzer, NULL);
+    output_t output = {0};
+    fake_ledc_set_observer(output_observer, &output);
+
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_player_play_melody(player, &control_melody, CONTROL_BPM), ESP_OK);
+    fake_sim_sleep_until(start_us + 40000);
+    TEST_CHECK_EQ(buzzer_player_pause(player), ESP_OK);
+    fake_sim_sleep_until(start_us + 50000);
+    TEST_CHECK_EQ(buzzer_player_get_state(player), BUZZER_PLAYER_PAUSED);
+    TEST_CHECK(!fake_ledc_is_running(LEDC_TIMER_0));
+    TEST_CHECK_EQ(buzzer_player_get_position_ms(player), 40);
+    fake_sim_sleep_until(start_us + 500000);
+    TEST_CHECK_EQ(buzzer_player_get_position_ms(player), 40);
+    TEST_CHECK(!fake_ledc_is_running(LEDC_TIMER_0));
+
+    int64_t resume_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_player_resume(player), ESP_OK);
+    fake_sim_sleep_until(resume_us + 60000 - CONTROL_MARGIN_US);
+    TEST_CHECK(sounds(&output, BUZZER_NOTE_A, 4));
+    TEST_CHECK_EQ(buzzer_player_get_state(player), BUZZER_PLAYER_PLAYING);
+    fake_sim_sleep_until(resume_us + 60000 + CONTROL_MARGIN_US);
+    TEST_CHECK(sounds(&output, BUZZER_NOTE_C, 5));
+    TEST_CHECK_EQ(buzzer_player_get_position_ms(player), 101);
+
+    fake_ledc_set_observer(NULL, NULL);
+    buzzer_player_destroy(player);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Pauses a staccato note after its gate has ended, and checks resuming keeps the buzzer silent for the rest of the
+ * note instead of sounding it again.
+ */
+static void test_pause_in_gate(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_player_t *player = buzzer_player_create(buzzer, NULL);
+    output_t output = {0};
+    fake_ledc_set_observer(output_observer, &output);
+
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_player_play_melody(player, &control_melody, CONTROL_BPM), ESP_OK);
+    fake_sim_sleep_until(start_us + 170000);
+    TEST_CHECK(!fake_ledc_is_running(LEDC_TIMER_0));
+    TEST_CHECK_EQ(buzzer_player_pause(player), ESP_OK);
+    fake_sim_sleep_until(start_us + 300000);
+    TEST_CHECK_EQ(buzzer_player_get_position_ms(player), 170);
+
+    // 30 ms of the note are left, followed by 200 ms of rests
+    int64_t resume_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_player_resume(player), ESP_OK);
+    fake_sim_sleep_until(resume_us + 10000);
+    TEST_CHECK(!fake_ledc_is_running(LEDC_TIMER_0));
+    fake_sim_sleep_until(resume_us + 230000 - CONTROL_MARGIN_US);
+    TEST_CHECK(!fake_ledc_is_running(LEDC_TIMER_0));
+    fake_sim_sleep_until(resume_us + 230000 + CONTROL_MARGIN_US);
+    TEST_CHECK(sounds(&output, BUZZER_NOTE_E, 5));
+
+    // Pausing while the gate is still open silences the note, and resuming sounds it again until the gate ends
+    buzzer_player_stop(player);
+    start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_player_play_melody(player, &control_melody, CONTROL_BPM), ESP_OK);
+    fake_sim_sleep_until(start_us + 120000);
+    TEST_CHECK_EQ(buzzer_player_pause(player), ESP_OK);
+    fake_sim_sleep_until(start_us + 200000);
+    TEST_CHECK(!fake_ledc_is_running(LEDC_TIMER_0));
+    resume_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_player_resume(player), ESP_OK);
+    fake_sim_sleep_until(resume_us + 30000 - CONTROL_MARGIN_US);
+    TEST_CHECK(sounds(&output, BUZZER_NOTE_C, 5));
+    fake_sim_sleep_until(resume_us + 30000 + CONTROL_MARGIN_US);
+    TEST_CHECK(!fake_ledc_is_running(LEDC_TIMER_0));
+
+    fake_ledc_set_observer(NULL, NULL);
+    buzzer_player_destroy(player);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Seeks past the end of the melody, while playing and while paused, and checks it finishes right away, silencing the
+ * buzzer and leaving nothing to control.
+ */
+static void test_seek_past_end(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_player_t *player = buzzer_player_create(buzzer, NULL);
+
+    for (int paused = 0; paused <= 1; paused++) {
+        int64_t start_us = esp_timer_get_time();
+        TEST_CHECK_EQ(buzzer_player_play_melody(player, &control_melody, CONTROL_BPM), ESP_OK);
+        fake_sim_sleep_until(start_us + 30000);
+        if (paused) TEST_CHECK_EQ(buzzer_player_pause(player), ESP_OK);
+        TEST_CHECK_EQ(buzzer_player_seek(player, 600), ESP_OK);
+        fake_sim_sleep_until(start_us + 31000);
+        TEST_CHECK_EQ(buzzer_player_get_state(player), BUZZER_PLAYER_IDLE);
+        TEST_CHECK_EQ(buzzer_player_get_position_ms(player), 0);
+        TEST_CHECK(!fake_ledc_is_running(LEDC_TIMER_0));
+        TEST_CHECK_EQ(buzzer_player_seek(player, 0), ESP_FAIL);
+        TEST_CHECK_EQ(buzzer_player_resume(player), ESP_FAIL);
+    }
+
+    buzzer_player_destroy(player);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Plays a melody with a looped section, and checks the position goes back when the loop wraps around, and that the
+ * melody ends after a single repetition.
+ */
+static void test_position_loop_wrap(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_player_t *player = buzzer_player_create(buzzer, NULL);
+    output_t output = {0};
+    fake_ledc_set_observer(output_observer, &output);
+
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_player_play_melody(player, &loop_melody, CONTROL_BPM), ESP_OK);
+    // Played: A B C B C D, while the position follows A B C, then B C again and D
+    const uint32_t positions_ms[] = {50, 150, 250, 150, 250, 350};
+    const buzzer_note_t notes[] = {BUZZER_NOTE_A, BUZZER_NOTE_B, BUZZER_NOTE_C, BUZZER_NOTE_B, BUZZER_NOTE_C,
+                                   BUZZER_NOTE_D};
+    const uint8_t octaves[] = {4, 4, 5, 4, 5, 5};
+    for (size_t i = 0; i < sizeof(positions_ms) / sizeof(positions_ms[0]); i++) {
+        fake_sim_sleep_until(start_us + (int64_t) i * CONTROL_NOTE_US + CONTROL_NOTE_US / 2);
+        TEST_CHECK_EQ(buzzer_player_get_position_ms(player), positions_ms[i]);
+        TEST_CHECK(sounds(&output, notes[i], octaves[i]));
+    }
+    fake_sim_sleep_until(start_us + 6 * CONTROL_NOTE_US + CONTROL_MARGIN_US);
+    TEST_CHECK_EQ(buzzer_player_get_state(player), BUZZER_PLAYER_IDLE);
+    TEST_CHECK(!fake_ledc_is_running(LEDC_TIMER_0));
+
+    fake_ledc_set_observer(NULL, NULL);
+    buzzer_player_destroy(player);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Seeks into the looped section while it's being repeated, and past it while it's played for the first time, and
+ * checks the repetitions are counted again from the position seeked to.
+ */
+static void test_seek_loop(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_player_t *player = buzzer_player_create(buzzer, NULL);
+    output_t output = {0};
+    fake_ledc_set_observer(output_observer, &output);
+
+    // Seeking back into the loop during its repetition plays it again: B (50 ms left) C B C D
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_player_play_melody(player, &loop_melody, CONTROL_BPM), ESP_OK);
+    fake_sim_sleep_until(start_us + 350000);
+    TEST_CHECK_EQ(buzzer_player_get_position_ms(player), 150);
+    int64_t seek_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_player_seek(player, 150), ESP_OK);
+    fake_sim_sleep_until(seek_us + 200000);
+    TEST_CHECK(sounds(&output, BUZZER_NOTE_B, 4));
+    TEST_CHECK_EQ(buzzer_player_get_position_ms(player), 150);
+    fake_sim_sleep_until(seek_us + 400000);
+    TEST_CHECK(sounds(&output, BUZZER_NOTE_D, 5));
+    fake_sim_sleep_until(seek_us + 450000 - CONTROL_MARGIN_US);
+    TEST_CHECK_EQ(buzzer_player_get_state(player), BUZZER_PLAYER_PLAYING);
+    fake_sim_sleep_until(seek_us + 450000 + CONTROL_MARGIN_US);
+    TEST_CHECK_EQ(buzzer_player_get_state(player), BUZZER_PLAYER_IDLE);
+
+    // Seeking past the loop during its first pass skips its repetition: D (50 ms left)
+    start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_player_play_melody(player, &loop_melody, CONTROL_BPM), ESP_OK);
+    fake_sim_sleep_until(start_us + 150000);
+    seek_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_player_seek(player, 350), ESP_OK);
+    fake_sim_sleep_until(seek_us + 50000 - CONTROL_MARGIN_US);
+    TEST_CHECK(sounds(&output, BUZZER_NOTE_D, 5));
+    fake_sim_sleep_until(seek_us + 50000 + CONTROL_MARGIN_US);
+    TEST_CHECK_EQ(buzzer_player_get_state(player), BUZZER_PLAYER_IDLE);
+
+    fake_ledc_set_observer(NULL, NULL);
+    buzzer_player_destroy(player);
+    buzzer_destroy(buzzer);
+}
+
+int main(void) {
+    TEST_RUN(test_seek_mid_note);
+    TEST_RUN(test_seek_merged_rests);
+    TEST_RUN(test_pause_mid_note);
+    TEST_RUN(test_pause_in_gate);
+    TEST_RUN(test_seek_past_end);
+    TEST_RUN(test_position_loop_wrap);
+    TEST_RUN(test_seek_loop);
+    return TEST_RESULT();
+}
+
+// Private functions
+
+/**
+ * Keeps the last frequency requested to the buzzer's timer.
+ * @param event Write to the LEDC
+ * @param arg Output seen so far
+ */
+static void output_observer(const fake_ledc_event_t *event, void *arg) {
+    output_t *output = arg;
+    if (event->op == FAKE_LEDC_DIVIDER && event->index == LEDC_TIMER_0 && event->freq_hz) {
+        output->freq_hz = event->freq_hz;
+    }
+}
+
+/**
+ * Checks the buzzer is sounding the given note, tuned for its timer.
+ * @param output Output seen so far
+ * @param note Note expected
+ * @param octave Octave of the note
+ * @return Whether the buzzer sounds and the last frequency requested is within a quarter tone of the note
+ */
+static bool sounds(const output_t *output, buzzer_note_t note, uint8_t octave) {
+    double expected_hz = buzzer_get_note_freq(note, octave);
+    return fake_ledc_is_running(LEDC_TIMER_0) && fabs(output->freq_hz / expected_hz - 1.0) < 0.03;
+}
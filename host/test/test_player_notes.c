@@ -0,0 +1,177 @@
+/**
+ * @file test_player_notes.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Tests of the notes played by the player: the frequencies requested for pushed notes and melody notes are
+ * tuned for the buzzer's timer and transposed, rather than truncated, and transposed notes stay within the octaves
+ * of the table.
+ */
+
+#include <freertos/FreeRTOS.h>
+#include <esp_timer.h>
+#include "buzzer/buzzer.h"
+#include "buzzer/buzzer_player.h"
+#include "buzzer/buzzer_tuning.h"
+#include "fake_sim.h"
+#include "test_util.h"
+
+#define NOTES_MAX 64u ///< Frequencies kept by the observer
+#define NOTES_BPM 600u ///< Speed the notes are played at, so crotchets last 100 ms
+
+/**
+ * Frequencies requested to the LEDC
+ */
+typedef struct {
+    uint32_t count; ///< Frequencies requested
+    uint32_t freq_hz[NOTES_MAX]; ///< Frequencies in the order they were requested
+} requests_t;
+
+// Private function declarations
+
+static void requests_observer(const fake_ledc_event_t *event, void *arg);
+
+static uint32_t expected_request(int32_t cents, buzzer_note_t note, uint8_t octave);
+
+// Tests
+
+/**
+ * Pushes the notes of three low octaves transposed by a quarter tone, and checks the frequency requested for each one
+ * is the best one for the timer.
+ */
+static void test_push_note_tuning(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_player_config_t config = {.queue_len = NOTES_MAX};
+    buzzer_player_t *player = buzzer_player_create(buzzer, &config);
+    requests_t requests = {0};
+    fake_ledc_set_observer(requests_observer, &requests);
+
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_player_set_transpose(player, 50), ESP_OK);
+    uint32_t pushed = 0, truncation_differs = 0;
+    buzzer_transpose_t transpose;
+    buzzer_transpose_init(&transpose, 50);
+    for (uint8_t octave = 1; octave <= 3; octave++) {
+        for (int note = BUZZER_NOTE_C; note < BUZZER_NOTE_MAX; note++) {
+            buzzer_musical_note_t pushed_note = {.note = note, .octave = octave, .type = BUZZER_NTYPE_CROTCHET};
+            TEST_CHECK_EQ(buzzer_player_push_note(player, &pushed_note, NOTES_BPM), ESP_OK);
+            double target_hz = buzzer_get_transposed_freq(&transpose, note, octave);
+            if (expected_request(50, note, octave) != (uint32_t) target_hz) truncation_differs++;
+            pushed++;
+        }
+    }
+    // The new transposition applies to the notes pushed afterwards
+    TEST_CHECK_EQ(buzzer_player_set_transpose(player, 0), ESP_OK);
+    buzzer_musical_note_t a4 = {.note = BUZZER_NOTE_A, .octave = 4, .type = BUZZER_NTYPE_CROTCHET};
+    TEST_CHECK_EQ(buzzer_player_push_note(player, &a4, NOTES_BPM), ESP_OK);
+    pushed++;
+
+    fake_sim_sleep_until(start_us + (int64_t) (pushed + 1) * 100000);
+    fake_ledc_set_observer(NULL, NULL);
+
+    TEST_CHECK_EQ(requests.count, pushed);
+    uint32_t index = 0;
+    for (uint8_t octave = 1; octave <= 3; octave++) {
+        for (int note = BUZZER_NOTE_C; note < BUZZER_NOTE_MAX; note++, index++) {
+            TEST_CHECK_EQ(requests.freq_hz[index], expected_request(50, note, octave));
+        }
+    }
+    TEST_CHECK_EQ(requests.freq_hz[index], 440);
+    TEST_CHECK(truncation_differs > 0); // Otherwise the test couldn't tell tuning from truncation
+
+    buzzer_player_destroy(player);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Plays a melody with the notes of a low octave transposed by a quarter tone, and checks the frequency requested for
+ * each one is the best one for the timer, like for pushed notes.
+ */
+static void test_melody_note_tuning(void) {
+    buzzer_musical_note_t notes[BUZZER_NOTE_MAX];
+    uint32_t truncation_differs = 0;
+    buzzer_transpose_t transpose;
+    buzzer_transpose_init(&transpose, 50);
+    for (int note = BUZZER_NOTE_C; note < BUZZER_NOTE_MAX; note++) {
+        notes[note] = (buzzer_musical_note_t) {.note = note, .octave = 2, .type = BUZZER_NTYPE_CROTCHET};
+        if (expected_request(50, note, 2) != (uint32_t) buzzer_get_transposed_freq(&transpose, note, 2)) {
+            truncation_differs++;
+        }
+    }
+    buzzer_melody_t melody = BUZZER_MELODY_INIT(notes, BUZZER_NOTE_MAX);
+
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_player_t *player = buzzer_player_create(buzzer, NULL);
+    requests_t requests = {0};
+    fake_ledc_set_observer(requests_observer, &requests);
+
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_player_set_transpose(player, 50), ESP_OK);
+    TEST_CHECK_EQ(buzzer_player_play_melody(player, &melody, NOTES_BPM), ESP_OK);
+    fake_sim_sleep_until(start_us + (int64_t) (BUZZER_NOTE_MAX + 1) * 100000);
+    fake_ledc_set_observer(NULL, NULL);
+
+    TEST_CHECK_EQ(buzzer_player_get_state(player), BUZZER_PLAYER_IDLE);
+    TEST_CHECK_EQ(requests.count, BUZZER_NOTE_MAX);
+    for (int note = BUZZER_NOTE_C; note < BUZZER_NOTE_MAX; note++) {
+        TEST_CHECK_EQ(requests.freq_hz[note], expected_request(50, note, 2));
+    }
+    TEST_CHECK(truncation_differs > 0); // Otherwise the test couldn't tell tuning from truncation
+
+    buzzer_player_destroy(player);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Transposes the lowest and highest notes, and out of range octaves, by the largest intervals, and checks the notes
+ * are clamped to octaves 0 to 8 instead of wrapping around.
+ */
+static void test_transpose_limits(void) {
+    buzzer_transpose_t up, down;
+    TEST_CHECK_EQ(buzzer_transpose_init(&up, BUZZER_TRANSPOSE_MAX_CENTS), ESP_OK);
+    TEST_CHECK_EQ(buzzer_transpose_init(&down, -BUZZER_TRANSPOSE_MAX_CENTS), ESP_OK);
+    TEST_CHECK(buzzer_transpose_init(&up, BUZZER_TRANSPOSE_MAX_CENTS + 1) == ESP_FAIL);
+
+    double a0 = buzzer_get_note_freq(BUZZER_NOTE_A, 0), a8 = buzzer_get_note_freq(BUZZER_NOTE_A, 8);
+    TEST_CHECK(buzzer_get_transposed_freq(&up, BUZZER_NOTE_A, 0) == a8);
+    TEST_CHECK(buzzer_get_transposed_freq(&up, BUZZER_NOTE_A, 8) == a8);
+    TEST_CHECK(buzzer_get_transposed_freq(&up, BUZZER_NOTE_A, UINT8_MAX) == a8);
+    TEST_CHECK(buzzer_get_transposed_freq(&down, BUZZER_NOTE_A, 8) == a0);
+    TEST_CHECK(buzzer_get_transposed_freq(&down, BUZZER_NOTE_A, 0) == a0);
+    TEST_CHECK(buzzer_get_transposed_freq(&down, BUZZER_NOTE_A, UINT8_MAX) == buzzer_get_note_freq(BUZZER_NOTE_A, 8));
+    TEST_CHECK(buzzer_get_transposed_freq(&up, BUZZER_NOTE_B, UINT8_MAX) == buzzer_get_note_freq(BUZZER_NOTE_B, 8));
+}
+
+int main(void) {
+    TEST_RUN(test_push_note_tuning);
+    TEST_RUN(test_melody_note_tuning);
+    TEST_RUN(test_transpose_limits);
+    return TEST_RESULT();
+}
+
+// Private functions
+
+/**
+ * Stores the frequencies requested to the buzzer's timer.
+ * @param event Write to the LEDC
+ * @param arg Requests seen so far
+ */
+static void requests_observer(const fake_ledc_event_t *event, void *arg) {
+    requests_t *requests = arg;
+    if (event->op != FAKE_LEDC_DIVIDER || event->index != LEDC_TIMER_0 || event->freq_hz == 0) return;
+    if (requests->count < NOTES_MAX) requests->freq_hz[requests->count] = event->freq_hz;
+    requests->count++;
+}
+
+/**
+ * Calculates the frequency that should be requested for a note on the default buzzer, which runs from the APB clock.
+ * @param cents Transposition in cents
+ * @param note Note to play
+ * @param octave Octave of the note
+ * @return Frequency to request in Hz
+ */
+static uint32_t expected_request(int32_t cents, buzzer_note_t note, uint8_t octave) {
+    buzzer_transpose_t transpose;
+    buzzer_transpose_init(&transpose, cents);
+    return buzzer_tuning_best_request(LEDC_USE_APB_CLK, BUZZER_DUTY_RES_BITS,
+                                      buzzer_get_transposed_freq(&transpose, note, octave));
+}
@@ -0,0 +1,171 @@
+/**
+ * @file test_player_ring.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Tests of the player's ring buffer: capacity (and its limit), counters, low watermark and timing on the
+ * simulated clock, and a stress test pushing events as fast as the player takes them, checking they reach the LEDC in
+ * order.
+ */
+
+#include <stdlib.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include "buzzer/buzzer.h"
+#include "buzzer/buzzer_player.h"
+#include "fake_sim.h"
+#include "test_util.h"
+
+#define STRESS_EVENTS 200000u ///< Events pushed by the stress test
+#define STRESS_QUEUE_LEN 64u ///< Capacity of the ring buffer in the stress test
+#define STRESS_FREQ(i) (100u + (i) % 2000u) ///< Frequency of each event in the stress test, never repeated in a row
+
+/**
+ * Frequencies seen by the LEDC during the stress test
+ */
+typedef struct {
+    uint32_t next; ///< Index of the event expected next
+    uint32_t mismatches; ///< Frequencies seen out of order
+} stress_check_t;
+
+static uint32_t watermark_calls; ///< Times the low watermark callback was called
+
+// Private function declarations
+
+static void stress_observer(const fake_ledc_event_t *event, void *arg);
+
+static void on_low_watermark(buzzer_player_t *player, void *arg);
+
+// Tests
+
+/**
+ * Fills a ring buffer while the player is busy with a long event, then lets everything play.
+ */
+static void test_capacity_and_counters(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_player_config_t config = {
+            .queue_len = 5, // Rounded up to 8
+            .low_watermark = 2,
+            .on_low_watermark = on_low_watermark
+    };
+    watermark_calls = 0;
+    buzzer_player_t *player = buzzer_player_create(buzzer, &config);
+    TEST_CHECK(player != NULL);
+
+    buzzer_event_t event = {.freq_hz = 440, .duration_ms = 100};
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_player_push(player, &event), ESP_OK);
+    fake_sim_sleep_until(start_us + 1000); // The player takes the first event and waits for its end
+
+    uint32_t accepted = 0;
+    while (buzzer_player_push(player, &event) == ESP_OK) accepted++;
+    TEST_CHECK_EQ(accepted, 8);
+    TEST_CHECK_EQ(buzzer_player_get_level(player), 8);
+
+    fake_sim_sleep_until(start_us + 2000000);
+    buzzer_player_stats_t stats;
+    TEST_CHECK_EQ(buzzer_player_get_stats(player, &stats), ESP_OK);
+    TEST_CHECK_EQ(stats.pushed, 9);
+    TEST_CHECK_EQ(stats.played, 9);
+    TEST_CHECK_EQ(stats.overruns, 1);
+    TEST_CHECK_EQ(stats.underruns, 1);
+    TEST_CHECK_EQ(stats.high_watermark, 8);
+    TEST_CHECK_EQ(stats.run_us, 900000); // Back to back, on the simulated clock
+    TEST_CHECK_EQ(stats.sound_us, 900000);
+    TEST_CHECK_EQ(stats.max_late_us, 0);
+    TEST_CHECK_EQ(watermark_calls, 1);
+    TEST_CHECK_EQ(buzzer_player_get_level(player), 0);
+    TEST_CHECK(!fake_ledc_is_running(LEDC_TIMER_0));
+
+    buzzer_player_destroy(player);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Creates players with the largest capacity and above it, and checks only the former are created, instead of the
+ * rounding never ending or the size of the ring overflowing.
+ */
+static void test_capacity_limit(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_player_config_t config = {.queue_len = BUZZER_PLAYER_MAX_QUEUE_LEN};
+    buzzer_player_t *player = buzzer_player_create(buzzer, &config);
+    TEST_CHECK(player != NULL);
+    buzzer_player_destroy(player);
+
+    static const uint32_t too_long[] = {BUZZER_PLAYER_MAX_QUEUE_LEN + 1, 0x80000001u, UINT32_MAX};
+    for (uint32_t i = 0; i < sizeof(too_long) / sizeof(too_long[0]); i++) {
+        config.queue_len = too_long[i];
+        TEST_CHECK(buzzer_player_create(buzzer, &config) == NULL);
+    }
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Pushes zero-length events as fast as the player takes them, through many wraparounds of a small ring buffer, and
+ * checks every one reaches the LEDC exactly once and in order.
+ */
+static void test_stress_order(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_player_config_t config = {.queue_len = STRESS_QUEUE_LEN};
+    buzzer_player_t *player = buzzer_player_create(buzzer, &config);
+    TEST_CHECK(player != NULL);
+
+    stress_check_t check = {0};
+    fake_ledc_set_observer(stress_observer, &check);
+
+    uint64_t start_ns = test_real_ns();
+    for (uint32_t i = 0; i < STRESS_EVENTS; i++) {
+        buzzer_event_t event = {.freq_hz = STRESS_FREQ(i), .duration_ms = 0};
+        while (buzzer_player_push(player, &event) != ESP_OK) vTaskDelay(0); // Full, let the player catch up
+    }
+    buzzer_player_stats_t stats;
+    do {
+        vTaskDelay(0);
+        buzzer_player_get_stats(player, &stats);
+    } while (stats.played < STRESS_EVENTS);
+    uint64_t elapsed_ns = test_real_ns() - start_ns;
+    fake_ledc_set_observer(NULL, NULL);
+
+    TEST_CHECK_EQ(check.next, STRESS_EVENTS);
+    TEST_CHECK_EQ(check.mismatches, 0);
+    TEST_CHECK_EQ(stats.pushed, STRESS_EVENTS);
+    TEST_CHECK_EQ(stats.played, STRESS_EVENTS);
+    TEST_CHECK(stats.high_watermark <= STRESS_QUEUE_LEN);
+    printf("spsc: %u events through a %u event ring in %.3f s, %.0f events/s (%u overruns)\n", STRESS_EVENTS,
+           STRESS_QUEUE_LEN, (double) elapsed_ns / 1e9, STRESS_EVENTS / ((double) elapsed_ns / 1e9), stats.overruns);
+
+    buzzer_player_destroy(player);
+    buzzer_destroy(buzzer);
+}
+
+int main(void) {
+    TEST_RUN(test_capacity_and_counters);
+    TEST_RUN(test_capacity_limit);
+    TEST_RUN(test_stress_order);
+    return TEST_RESULT();
+}
+
+// Private functions
+
+/**
+ * Checks every frequency the player writes against the sequence pushed.
+ * @param event Write to the LEDC
+ * @param arg Check state
+ */
+static void stress_observer(const fake_ledc_event_t *event, void *arg) {
+    stress_check_t *check = arg;
+    if (event->op != FAKE_LEDC_DIVIDER || event->freq_hz == 0) return;
+    if (event->freq_hz != STRESS_FREQ(check->next)) check->mismatches++;
+    check->next++;
+}
+
+/**
+ * Counts the calls of the low watermark callback.
+ * @param player Player which reached the low watermark
+ * @param arg Unused
+ */
+static void on_low_watermark(buzzer_player_t *player, void *arg) {
+    (void) player;
+    (void) arg;
+    watermark_calls++;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file test_pm.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Tests of the power management lock of the buzzer, built with CONFIG_PM_ENABLE: the lock is held exactly once
+ * while the buzzer sounds, whichever function starts or stops it (single, group or through the player), and it's
+ * released and deleted when the buzzer is destroyed.
+ *
+ * @details The buzzer's timer runs from the APB clock when power management is enabled, so its lock keeps the APB
+ * frequency at its maximum.
+ */
+
+#include <freertos/FreeRTOS.h>
+#include <esp_timer.h>
+#include "buzzer/buzzer.h"
+#include "buzzer/buzzer_player.h"
+#include "fake_pm.h"
+#include "fake_sim.h"
+#include "test_util.h"
+
+#define PM_LOCK ESP_PM_APB_FREQ_MAX ///< Type of lock taken by buzzers on the APB clock
+
+// Tests
+
+/**
+ * Creates and destroys buzzers, silent and sounding, and checks each one creates a lock and deletes it without
+ * leaving it held.
+ */
+static void test_lock_lifecycle(void) {
+    size_t locks = fake_pm_get_lock_count();
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    TEST_CHECK_EQ(fake_pm_get_lock_count(), locks + 1);
+    TEST_CHECK_EQ(fake_pm_get_held(PM_LOCK), 0);
+    buzzer_destroy(buzzer);
+    TEST_CHECK_EQ(fake_pm_get_lock_count(), locks);
+
+    buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    TEST_CHECK_EQ(buzzer_play(buzzer), ESP_OK);
+    TEST_CHECK_EQ(fake_pm_get_held(PM_LOCK), 1);
+    buzzer_destroy(buzzer);
+    TEST_CHECK_EQ(fake_pm_get_held(PM_LOCK), 0);
+    TEST_CHECK_EQ(fake_pm_get_lock_count(), locks);
+    TEST_CHECK_EQ(fake_pm_get_errors(), 0);
+}
+
+/**
+ * Plays and pauses a buzzer, twice in a row each, and checks the lock is held once while it sounds and released once
+ * it's silent.
+ */
+static void test_play_pause(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+
+    TEST_CHECK_EQ(buzzer_play(buzzer), ESP_OK);
+    TEST_CHECK_EQ(fake_pm_get_held(PM_LOCK), 1);
+    TEST_CHECK_EQ(buzzer_play(buzzer), ESP_OK); // Already playing, so the lock isn't taken twice
+    TEST_CHECK_EQ(fake_pm_get_held(PM_LOCK), 1);
+    TEST_CHECK_EQ(buzzer_pause(buzzer), ESP_OK);
+    TEST_CHECK_EQ(fake_pm_get_held(PM_LOCK), 0);
+    TEST_CHECK_EQ(buzzer_pause(buzzer), ESP_OK);
+    TEST_CHECK_EQ(fake_pm_get_held(PM_LOCK), 0);
+
+    TEST_CHECK_EQ(buzzer_play_ms(buzzer, 10), ESP_OK);
+    TEST_CHECK_EQ(fake_pm_get_held(PM_LOCK), 0);
+
+    buzzer_destroy(buzzer);
+    TEST_CHECK_EQ(fake_pm_get_errors(), 0);
+}
+
+/**
+ * Starts and stops a group whose buzzers are partly sounding already, and mixes group and single calls, checking
+ * every buzzer holds the lock once while it sounds.
+ */
+static void test_group(void) {
+    buzzer_t *buzzers[2] = {buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4),
+                            buzzer_init(LEDC_CHANNEL_1, LEDC_TIMER_1, GPIO_NUM_5)};
+
+    TEST_CHECK_EQ(buzzer_play(buzzers[0]), ESP_OK);
+    TEST_CHECK_EQ(buzzer_play_group(buzzers, 2, NULL), ESP_OK);
+    TEST_CHECK_EQ(fake_pm_get_held(PM_LOCK), 2);
+    TEST_CHECK_EQ(buzzer_play_group(buzzers, 2, NULL), ESP_OK);
+    TEST_CHECK_EQ(fake_pm_get_held(PM_LOCK), 2);
+
+    TEST_CHECK_EQ(buzzer_pause(buzzers[1]), ESP_OK);
+    TEST_CHECK_EQ(fake_pm_get_held(PM_LOCK), 1);
+    TEST_CHECK_EQ(buzzer_pause_group(buzzers, 2), ESP_OK);
+    TEST_CHECK_EQ(fake_pm_get_held(PM_LOCK), 0);
+    TEST_CHECK_EQ(buzzer_pause_group(buzzers, 2), ESP_OK);
+    TEST_CHECK_EQ(fake_pm_get_held(PM_LOCK), 0);
+
+    TEST_CHECK_EQ(buzzer_play_group(buzzers, 2, NULL), ESP_OK);
+    buzzer_destroy(buzzers[0]);
+    buzzer_destroy(buzzers[1]);
+    TEST_CHECK_EQ(fake_pm_get_held(PM_LOCK), 0);
+    TEST_CHECK_EQ(fake_pm_get_errors(), 0);
+}
+
+/**
+ * Plays a note and a rest on the player, and destroys it in the middle of another note, checking the lock is only
+ * held while a note sounds.
+ */
+static void test_player(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_player_t *player = buzzer_player_create(buzzer, NULL);
+    buzzer_event_t note = {.freq_hz = 440, .duration_ms = 100};
+    buzzer_event_t rest = {.freq_hz = 0, .duration_ms = 100};
+
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_player_push(player, &note), ESP_OK);
+    TEST_CHECK_EQ(buzzer_player_push(player, &rest), ESP_OK);
+    TEST_CHECK_EQ(buzzer_player_push(player, &note), ESP_OK);
+    fake_sim_sleep_until(start_us + 50000);
+    TEST_CHECK_EQ(fake_pm_get_held(PM_LOCK), 1);
+    fake_sim_sleep_until(start_us + 150000);
+    TEST_CHECK_EQ(fake_pm_get_held(PM_LOCK), 0);
+    fake_sim_sleep_until(start_us + 250000);
+    TEST_CHECK_EQ(fake_pm_get_held(PM_LOCK), 1);
+
+    buzzer_player_destroy(player);
+    TEST_CHECK_EQ(fake_pm_get_held(PM_LOCK), 0);
+    buzzer_destroy(buzzer);
+    TEST_CHECK_EQ(fake_pm_get_errors(), 0);
+}
+
+int main(void) {
+    TEST_RUN(test_lock_lifecycle);
+    TEST_RUN(test_play_pause);
+    TEST_RUN(test_group);
+    TEST_RUN(test_player);
+    return TEST_RESULT();
+}
@@ -0,0 +1,228 @@
+/**
+ * @file test_render.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Tests of the offline renderer: a melody rendered with each engine sounds the same, with the pitch, gate and
+ * duty of its notes, and the transposition and tempo of the engines reach the render. The renders are also written
+ * to the working directory, so tools/buzzer_wavdiff.py can compare them.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "buzzer/buzzer.h"
+#include "buzzer_render.h"
+#include "test_util.h"
+
+#define RENDER_BPM 120u ///< Speed the melody is rendered at, so crotchets last 500 ms
+#define RENDER_RATE 44100u ///< Sample rate of the renders
+#define RENDER_EDGE_TOLERANCE 2 ///< Rising edges a section may differ by, as it can start or end mid-period
+
+/**
+ * WAV file rendered to memory
+ */
+typedef struct {
+    uint8_t *data; ///< Bytes written so far
+    size_t size; ///< Amount of bytes written
+} render_buffer_t;
+
+/**
+ * A4, a rest and a staccato A5, with a thin duty
+ */
+static const buzzer_musical_note_t render_notes[] = {
+        {.note = BUZZER_NOTE_A, .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+        {.note = BUZZER_NOTE_REST, .octave = 0, .type = BUZZER_NTYPE_CROTCHET},
+        {.note = BUZZER_NOTE_A, .octave = 5, .type = BUZZER_NTYPE_CROTCHET, .gate = BUZZER_GATE_STACCATO},
+};
+static const buzzer_melody_t render_melody = {
+        .melody = render_notes,
+        .length = sizeof(render_notes) / sizeof(render_notes[0]),
+        .duty = BUZZER_DUTY_THIN
+};
+
+// Private function declarations
+
+static esp_err_t render_write(const void *data, size_t size, void *arg);
+
+static bool render(render_buffer_t *buffer, buzzer_render_engine_t engine, int32_t cents, uint16_t tempo,
+                   const char *path);
+
+static uint32_t render_samples(const render_buffer_t *buffer);
+
+static int16_t render_sample(const render_buffer_t *buffer, uint32_t index);
+
+static int32_t render_edges(const render_buffer_t *buffer, uint32_t from_ms, uint32_t to_ms);
+
+// Tests
+
+/**
+ * Renders the melody with the blocking functions, and checks its length, pitches, gate and duty.
+ */
+static void test_render_blocking(void) {
+    render_buffer_t buffer = {0};
+    TEST_CHECK(render(&buffer, BUZZER_RENDER_BLOCKING, 0, 0, "render_blocking.wav"));
+    TEST_CHECK_EQ(render_samples(&buffer), RENDER_RATE * 3 / 2);
+
+    TEST_CHECK(abs(render_edges(&buffer, 0, 500) - 220) <= RENDER_EDGE_TOLERANCE);
+    TEST_CHECK_EQ(render_edges(&buffer, 500, 1000), 0);
+    uint32_t gate_ms = buzzer_gate_to_ms(500, BUZZER_GATE_STACCATO);
+    TEST_CHECK(abs(render_edges(&buffer, 1000, 1000 + gate_ms) - (int32_t) (880 * gate_ms / 1000)) <=
+               RENDER_EDGE_TOLERANCE);
+    TEST_CHECK_EQ(render_edges(&buffer, 1000 + gate_ms + 1, 1500), 0);
+
+    // A quarter of the samples of the first note are high, as the duty is 25 %
+    uint32_t high = 0;
+    for (uint32_t i = 0; i < RENDER_RATE / 2; i++) {
+        if (render_sample(&buffer, i) > 0) high++;
+    }
+    TEST_CHECK(high > RENDER_RATE / 2 / 5 && high < RENDER_RATE / 2 * 3 / 10);
+    free(buffer.data);
+}
+
+/**
+ * Renders the melody with the player and the callback engine, and checks they sound like the blocking functions.
+ */
+static void test_render_engines(void) {
+    render_buffer_t blocking = {0}, player = {0}, sound = {0};
+    TEST_CHECK(render(&blocking, BUZZER_RENDER_BLOCKING, 0, 0, NULL));
+    TEST_CHECK(render(&player, BUZZER_RENDER_PLAYER, 0, 0, "render_player.wav"));
+    TEST_CHECK(render(&sound, BUZZER_RENDER_SOUND, 0, 0, "render_sound.wav"));
+
+    // The player is polled every tick, so its render can end a tick later
+    TEST_CHECK(render_samples(&player) >= render_samples(&blocking));
+    TEST_CHECK(render_samples(&player) <= render_samples(&blocking) + RENDER_RATE / 1000);
+    TEST_CHECK_EQ(render_samples(&sound), render_samples(&blocking));
+    for (uint32_t from_ms = 0; from_ms < 1500; from_ms += 250) {
+        int32_t expected = render_edges(&blocking, from_ms, from_ms + 250);
+        TEST_CHECK(abs(render_edges(&player, from_ms, from_ms + 250) - expected) <= RENDER_EDGE_TOLERANCE);
+        TEST_CHECK(abs(render_edges(&sound, from_ms, from_ms + 250) - expected) <= RENDER_EDGE_TOLERANCE);
+    }
+    free(blocking.data);
+    free(player.data);
+    free(sound.data);
+}
+
+/**
+ * Renders the melody an octave up at double speed with the player and the callback engine, and checks the first note
+ * doubles its pitch and halves its length. The blocking functions can't do either.
+ */
+static void test_render_transpose_tempo(void) {
+    buzzer_render_engine_t engines[] = {BUZZER_RENDER_PLAYER, BUZZER_RENDER_SOUND};
+    for (uint32_t i = 0; i < sizeof(engines) / sizeof(engines[0]); i++) {
+        render_buffer_t buffer = {0};
+        TEST_CHECK(render(&buffer, engines[i], 1200, 200, NULL));
+        TEST_CHECK(abs(render_edges(&buffer, 0, 250) - 220) <= RENDER_EDGE_TOLERANCE);
+        TEST_CHECK_EQ(render_edges(&buffer, 251, 500), 0);
+        free(buffer.data);
+    }
+
+    render_buffer_t buffer = {0};
+    TEST_CHECK(!render(&buffer, BUZZER_RENDER_BLOCKING, 1200, 0, NULL));
+    TEST_CHECK(!render(&buffer, BUZZER_RENDER_BLOCKING, 0, 200, NULL));
+    free(buffer.data);
+}
+
+/**
+ * Checks melodies which loop forever are rejected, as the render would never end.
+ */
+static void test_render_loop_forever(void) {
+    buzzer_melody_t forever = render_melody;
+    forever.loop_end = forever.length;
+    forever.loop_count = BUZZER_LOOP_FOREVER;
+    render_buffer_t buffer = {0};
+    buzzer_render_config_t config = {.engine = BUZZER_RENDER_SOUND, .write = render_write, .arg = &buffer};
+    TEST_CHECK_EQ(buzzer_render_melody_wav(&forever, RENDER_BPM, &config), ESP_FAIL);
+    free(buffer.data);
+}
+
+int main(void) {
+    TEST_RUN(test_render_blocking);
+    TEST_RUN(test_render_engines);
+    TEST_RUN(test_render_transpose_tempo);
+    TEST_RUN(test_render_loop_forever);
+    return TEST_RESULT();
+}
+
+// Private functions
+
+/**
+ * Appends bytes of the WAV file to a buffer.
+ * @param data Bytes to write
+ * @param size Amount of bytes to write
+ * @param arg Buffer to append them to
+ * @return ESP_OK if they were appended, ESP_FAIL if out of memory
+ */
+static esp_err_t render_write(const void *data, size_t size, void *arg) {
+    render_buffer_t *buffer = arg;
+    uint8_t *grown = realloc(buffer->data, buffer->size + size);
+    if (!grown) return ESP_FAIL;
+    memcpy(grown + buffer->size, data, size);
+    buffer->data = grown;
+    buffer->size += size;
+    return ESP_OK;
+}
+
+/**
+ * Renders the melody to a buffer, and optionally to a file.
+ * @param buffer Buffer to render to, which must be empty
+ * @param engine Engine to play the melody with
+ * @param cents Transposition of the engine
+ * @param tempo Tempo of the engine, in percent
+ * @param path File to write the render to, or NULL
+ * @return Whether the melody was rendered
+ */
+static bool render(render_buffer_t *buffer, buzzer_render_engine_t engine, int32_t cents, uint16_t tempo,
+                   const char *path) {
+    buzzer_render_config_t config = {
+            .sample_rate = RENDER_RATE,
+            .engine = engine,
+            .transpose_cents = cents,
+            .tempo = tempo,
+            .write = render_write,
+            .arg = buffer
+    };
+    if (buzzer_render_melody_wav(&render_melody, RENDER_BPM, &config) != ESP_OK) return false;
+    if (path) {
+        FILE *file = fopen(path, "wb");
+        if (!file) return false;
+        fwrite(buffer->data, 1, buffer->size, file);
+        fclose(file);
+    }
+    return true;
+}
+
+/**
+ * Returns the amount of samples of a render.
+ * @param buffer Rendered WAV file
+ * @return Amount of samples after the header
+ */
+static uint32_t render_samples(const render_buffer_t *buffer) {
+    return buffer->size < 44 ? 0 : (uint32_t) ((buffer->size - 44) / 2);
+}
+
+/**
+ * Returns a sample of a render.
+ * @param buffer Rendered WAV file
+ * @param index Index of the sample
+ * @return Value of the sample, 0 past the end
+ */
+static int16_t render_sample(const render_buffer_t *buffer, uint32_t index) {
+    if (index >= render_samples(buffer)) return 0;
+    const uint8_t *sample = buffer->data + 44 + index * 2;
+    return (int16_t) (sample[0] | (sample[1] << 8));
+}
+
+/**
+ * Counts the rising edges of a render within a span of time.
+ * @param buffer Rendered WAV file
+ * @param from_ms Start of the span
+ * @param to_ms End of the span
+ * @return Amount of samples going high after a sample which wasn't
+ */
+static int32_t render_edges(const render_buffer_t *buffer, uint32_t from_ms, uint32_t to_ms) {
+    int32_t edges = 0;
+    uint32_t from = from_ms * RENDER_RATE / 1000, to = to_ms * RENDER_RATE / 1000;
+    for (uint32_t i = from ? from : 1; i < to; i++) {
+        if (render_sample(buffer, i) > 0 && render_sample(buffer, i - 1) <= 0) edges++;
+    }
+    return edges;
+}
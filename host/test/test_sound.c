@@ -0,0 +1,226 @@
+/**
+ * @file test_sound.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Tests of the callback engine: a request applied by the timer firing on its own right before the control
+ * function fires it doesn't skip a note, a play request left while the callback runs doesn't change what the running
+ * callback finishes with, and destroying a sound from a done callback is refused instead of waiting forever for the
+ * callback.
+ */
+
+#include <stdlib.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_timer.h>
+#include "buzzer/buzzer.h"
+#include "buzzer/buzzer_sound.h"
+#include "fake_sim.h"
+#include "test_util.h"
+
+#define SOUND_BPM 600u ///< Speed the melodies are played at, so crotchets last 100 ms
+#define SOUND_NOTE_US 100000 ///< Length of a crotchet at SOUND_BPM
+#define SOUND_EVENTS_MAX 16u ///< Frequencies kept by the observer
+#define SOUND_FREQ_TOLERANCE 3 ///< Hz a tuned request may differ from the note by
+
+/**
+ * Frequencies requested to the LEDC, and when
+ */
+typedef struct {
+    uint32_t count; ///< Frequencies requested
+    uint32_t freq_hz[SOUND_EVENTS_MAX]; ///< Frequencies in the order they were requested
+    int64_t time_us[SOUND_EVENTS_MAX]; ///< Simulated time of each request
+} requests_t;
+
+/**
+ * State of the stop hook letting the timer fire on its own right before a stop
+ */
+typedef struct {
+    bool armed; ///< Whether the next stop must wait for the timer
+    int64_t until_us; ///< Simulated time waited for
+} race_hook_t;
+
+/**
+ * Morse source blocking the callback until a new play request has been left
+ */
+typedef struct {
+    int64_t until_us; ///< Simulated time the source returns at
+    bool called; ///< Whether the source was called
+} slow_source_t;
+
+static const buzzer_musical_note_t first_notes[] = {
+        {.note = BUZZER_NOTE_A, .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+        {.note = BUZZER_NOTE_A, .octave = 4, .type = BUZZER_NTYPE_CROTCHET},
+};
+static const buzzer_musical_note_t second_notes[] = {
+        {.note = BUZZER_NOTE_C, .octave = 5, .type = BUZZER_NTYPE_CROTCHET},
+        {.note = BUZZER_NOTE_E, .octave = 5, .type = BUZZER_NTYPE_CROTCHET},
+};
+
+// Private function declarations
+
+static void requests_observer(const fake_ledc_event_t *event, void *arg);
+
+static void race_hook(esp_timer_handle_t timer, void *arg);
+
+static char slow_source(void *arg);
+
+static void count_done(buzzer_sound_t *sound, void *arg);
+
+static void destroy_done(buzzer_sound_t *sound, void *arg);
+
+// Tests
+
+/**
+ * Starts a melody while another one plays, letting the timer reach the end of the current note (and apply the request)
+ * between the request being left and the timer being fired, and checks the first note of the new melody still lasts
+ * its whole length.
+ */
+static void test_request_race(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_sound_t *sound = buzzer_sound_create(buzzer);
+    buzzer_melody_t first = BUZZER_MELODY_INIT(first_notes, 2), second = BUZZER_MELODY_INIT(second_notes, 2);
+    requests_t requests = {0};
+    fake_ledc_set_observer(requests_observer, &requests);
+
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_sound_play_melody(sound, &first, SOUND_BPM, NULL, NULL), ESP_OK);
+    fake_sim_sleep_until(start_us + SOUND_NOTE_US / 2);
+    race_hook_t hook = {.armed = true, .until_us = start_us + SOUND_NOTE_US + 1};
+    fake_esp_timer_set_stop_hook(race_hook, &hook);
+    TEST_CHECK_EQ(buzzer_sound_play_melody(sound, &second, SOUND_BPM, NULL, NULL), ESP_OK);
+    fake_esp_timer_set_stop_hook(NULL, NULL);
+    TEST_CHECK(!hook.armed);
+    fake_sim_sleep_until(start_us + 4 * SOUND_NOTE_US);
+    fake_ledc_set_observer(NULL, NULL);
+
+    // A4, then C5 started by the timer itself, then E5 a whole note later
+    TEST_CHECK_EQ(requests.count, 3);
+    TEST_CHECK(abs((int) requests.freq_hz[0] - 440) <= SOUND_FREQ_TOLERANCE);
+    TEST_CHECK(abs((int) requests.freq_hz[1] - 523) <= SOUND_FREQ_TOLERANCE);
+    TEST_CHECK(abs((int) requests.freq_hz[2] - 659) <= SOUND_FREQ_TOLERANCE);
+    TEST_CHECK(requests.time_us[2] - requests.time_us[1] >= SOUND_NOTE_US - 1000);
+    TEST_CHECK(!buzzer_sound_is_playing(sound));
+
+    buzzer_sound_destroy(sound);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Leaves a play request while the callback is in the middle of a Morse transmission, which it then finishes, and
+ * checks the transmission ends with its own done callback and argument, and the new melody with its own.
+ */
+static void test_request_while_running(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_sound_t *sound = buzzer_sound_create(buzzer);
+    static const buzzer_melody_t empty = BUZZER_MELODY_INIT(NULL, 0);
+    uint32_t morse_done = 0, melody_done = 0;
+
+    int64_t start_us = esp_timer_get_time();
+    slow_source_t source = {.until_us = start_us + SOUND_NOTE_US};
+    buzzer_morse_t morse = {.source = slow_source, .source_arg = &source, .wpm = 20};
+    TEST_CHECK_EQ(buzzer_sound_play_morse(sound, &morse, count_done, &morse_done), ESP_OK);
+    fake_sim_sleep_until(start_us + SOUND_NOTE_US / 2);
+    TEST_CHECK(source.called);
+    TEST_CHECK_EQ(buzzer_sound_play_melody(sound, &empty, SOUND_BPM, count_done, &melody_done), ESP_OK);
+    fake_sim_sleep_until(start_us + 2 * SOUND_NOTE_US);
+
+    TEST_CHECK_EQ(morse_done, 1);
+    TEST_CHECK_EQ(melody_done, 1);
+    TEST_CHECK(!buzzer_sound_is_playing(sound));
+
+    buzzer_sound_destroy(sound);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Destroys a sound from its own done callback, and checks the call returns leaving the sound usable, so it can be
+ * destroyed from a task afterwards.
+ */
+static void test_destroy_from_callback(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_sound_t *sound = buzzer_sound_create(buzzer);
+    buzzer_melody_t melody = BUZZER_MELODY_INIT(first_notes, 1);
+    bool returned = false;
+
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_sound_play_melody(sound, &melody, SOUND_BPM, destroy_done, &returned), ESP_OK);
+    fake_sim_sleep_until(start_us + 2 * SOUND_NOTE_US);
+    TEST_CHECK(returned);
+    TEST_CHECK(!buzzer_sound_is_playing(sound));
+
+    // The sound is still alive and plays
+    TEST_CHECK_EQ(buzzer_sound_play_melody(sound, &melody, SOUND_BPM, NULL, NULL), ESP_OK);
+    fake_esp_timer_flush();
+    TEST_CHECK(buzzer_sound_is_playing(sound));
+    buzzer_sound_destroy(sound);
+    buzzer_destroy(buzzer);
+}
+
+int main(void) {
+    TEST_RUN(test_request_race);
+    TEST_RUN(test_request_while_running);
+    TEST_RUN(test_destroy_from_callback);
+    return TEST_RESULT();
+}
+
+// Private functions
+
+/**
+ * Keeps the frequencies requested to the LEDC, along with the simulated time of each request.
+ * @param event Write to the LEDC
+ * @param arg Requests seen so far
+ */
+static void requests_observer(const fake_ledc_event_t *event, void *arg) {
+    requests_t *requests = arg;
+    if (event->op != FAKE_LEDC_DIVIDER) return;
+    if (requests->count < SOUND_EVENTS_MAX) {
+        requests->freq_hz[requests->count] = event->freq_hz;
+        requests->time_us[requests->count] = event->time_us;
+    }
+    requests->count++;
+}
+
+/**
+ * Lets the timer fire on its own before the first stop it sees goes ahead, by waiting past the time it's armed for.
+ * @param timer Timer being stopped
+ * @param arg Hook state
+ */
+static void race_hook(esp_timer_handle_t timer, void *arg) {
+    (void) timer;
+    race_hook_t *hook = arg;
+    if (!hook->armed) return;
+    hook->armed = false;
+    fake_sim_sleep_until(hook->until_us);
+}
+
+/**
+ * Ends the Morse transmission right away, but only returns once the simulated clock reaches the time it waits for,
+ * keeping the callback running until then.
+ * @param arg Source state
+ * @return The end of the text
+ */
+static char slow_source(void *arg) {
+    slow_source_t *source = arg;
+    source->called = true;
+    fake_sim_sleep_until(source->until_us);
+    return '\0';
+}
+
+/**
+ * Counts the times a done callback is called with an argument.
+ * @param sound Sound which finished
+ * @param arg Counter of the argument
+ */
+static void count_done(buzzer_sound_t *sound, void *arg) {
+    (void) sound;
+    (*(uint32_t *) arg)++;
+}
+
+/**
+ * Done callback destroying the sound which finished, which must be refused.
+ * @param sound Sound whose melody finished
+ * @param arg Flag set once the destroy call returns
+ */
+static void destroy_done(buzzer_sound_t *sound, void *arg) {
+    buzzer_sound_destroy(sound);
+    *(bool *) arg = true;
+}
@@ -0,0 +1,287 @@
+/**
+ * @file test_trace.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Tests of the trace recorder, built with BUZZER_TRACE_ENABLE=1 and a short ring buffer: the ring keeps the
+ * newest events in order once it wraps around, the CSV dump unwraps the cycle counter (falling back to the microsecond
+ * clock when both disagree), the VCD dump gives every buzzer its own identifiers and timestamps its changes, and the
+ * library records its plays, pauses, frequencies and deadlines.
+ *
+ * @details The cycle counter is driven from the simulated clock, with an offset which makes it wrap around where the
+ * tests need it, and an extra half microsecond per read, which only the cycles can resolve.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_timer.h>
+#include "buzzer/buzzer.h"
+#include "buzzer/buzzer_player.h"
+#include "buzzer/buzzer_trace.h"
+#include "fake_sim.h"
+#include "test_util.h"
+
+#define TRACE_CYCLES_PER_US 240u ///< Cycles per microsecond of the emulated CPU
+#define TRACE_READ_CYCLES 120u ///< Cycles added by every read when reads are spread, half a microsecond
+#define TRACE_LINES_MAX (BUZZER_TRACE_LEN + 1) ///< Lines of a CSV dump, including the header
+
+/**
+ * Line of a CSV dump
+ */
+typedef struct {
+    unsigned long long time_ns; ///< Time since the first event
+    unsigned cycles; ///< Cycle counter
+    unsigned time_us; ///< Low bits of the microsecond clock
+    int buzzer; ///< Index of the buzzer
+    char event[16]; ///< Name of the event
+    unsigned value; ///< Value of the event
+} trace_line_t;
+
+static uint32_t trace_cycle_offset; ///< Cycles added to the simulated clock
+static uint32_t trace_read_cycles; ///< Cycles added by every read
+static uint32_t trace_reads; ///< Reads of the cycle counter so far
+
+static const int trace_sources[BUZZER_TRACE_MAX_SOURCES + 1]; ///< Buzzers the events are recorded for
+
+// Private function declarations
+
+static void trace_set_cycles(uint32_t wrap_in_us, uint32_t read_cycles);
+
+static uint32_t trace_cycles(void);
+
+static char *trace_dump(esp_err_t (*dump)(FILE *out));
+
+static uint32_t trace_parse_csv(char *csv, trace_line_t *lines, uint32_t max);
+
+// Tests
+
+/**
+ * Records more events than the ring buffer holds, and checks the newest ones are kept in order, whether they're
+ * copied or dumped, and that clearing drops them.
+ */
+static void test_ring_wrap(void) {
+    trace_set_cycles(UINT32_MAX, 0);
+    buzzer_trace_clear();
+    for (uint32_t i = 0; i < BUZZER_TRACE_LEN + 5; i++) buzzer_trace_record(BUZZER_TRACE_FREQ, &trace_sources[0], i);
+
+    buzzer_trace_record_t records[BUZZER_TRACE_LEN * 2];
+    TEST_CHECK_EQ(buzzer_trace_get(records, BUZZER_TRACE_LEN * 2), BUZZER_TRACE_LEN);
+    for (uint32_t i = 0; i < BUZZER_TRACE_LEN; i++) TEST_CHECK_EQ(records[i].value, i + 5);
+    TEST_CHECK_EQ(buzzer_trace_get(records, 4), 4);
+    for (uint32_t i = 0; i < 4; i++) TEST_CHECK_EQ(records[i].value, BUZZER_TRACE_LEN + 1 + i);
+
+    char *csv = trace_dump(buzzer_trace_dump_csv);
+    trace_line_t lines[TRACE_LINES_MAX];
+    TEST_CHECK_EQ(trace_parse_csv(csv, lines, TRACE_LINES_MAX), BUZZER_TRACE_LEN);
+    for (uint32_t i = 0; i < BUZZER_TRACE_LEN; i++) TEST_CHECK_EQ(lines[i].value, i + 5);
+    free(csv);
+
+    buzzer_trace_clear();
+    TEST_CHECK_EQ(buzzer_trace_get(records, BUZZER_TRACE_LEN), 0);
+    fake_sim_set_cycle_source(NULL);
+}
+
+/**
+ * Records events across a wraparound of the cycle counter, and after a gap longer than the counter can measure, and
+ * checks the CSV dump times them from the cycles when the clocks agree and from the microseconds otherwise.
+ */
+static void test_csv_unwrap(void) {
+    trace_set_cycles(5000, TRACE_READ_CYCLES);
+    buzzer_trace_clear();
+    int64_t start_us = esp_timer_get_time();
+    buzzer_trace_record(BUZZER_TRACE_FREQ, &trace_sources[0], 440);
+    fake_sim_sleep_until(start_us + 10000);
+    buzzer_trace_record(BUZZER_TRACE_PLAY, &trace_sources[0], 0);
+    fake_sim_sleep_until(start_us + 20000);
+    buzzer_trace_record(BUZZER_TRACE_PAUSE, &trace_sources[0], 0);
+    // 30 s are 7.2e9 cycles, which the 32 bits of the counter can't hold
+    fake_sim_sleep_until(start_us + 20000 + 30000000);
+    buzzer_trace_record(BUZZER_TRACE_DEADLINE, &trace_sources[1], 1234);
+
+    char *csv = trace_dump(buzzer_trace_dump_csv);
+    trace_line_t lines[TRACE_LINES_MAX];
+    TEST_CHECK_EQ(trace_parse_csv(csv, lines, TRACE_LINES_MAX), 4);
+    free(csv);
+    TEST_CHECK(lines[1].cycles < lines[0].cycles); // The counter wrapped around in between
+    TEST_CHECK_EQ(lines[0].time_ns, 0);
+    TEST_CHECK_EQ(lines[1].time_ns, 10000000 + 500); // Cycles resolve the half microsecond added by the read
+    TEST_CHECK_EQ(lines[2].time_ns, 20000000 + 1000);
+    TEST_CHECK_EQ(lines[3].time_ns, 20000000 + 1000 + 30000000000ull); // The cycles are off, so microseconds are used
+    TEST_CHECK_EQ(lines[3].buzzer, 1);
+    TEST_CHECK(strcmp(lines[3].event, "deadline") == 0);
+    TEST_CHECK_EQ(lines[3].value, 1234);
+
+    buzzer_trace_clear();
+    fake_sim_set_cycle_source(NULL);
+}
+
+/**
+ * Records events of two buzzers, and checks the VCD dump declares three signals per buzzer with consecutive
+ * identifiers, writes a timestamp per instant, and changes the right signal for each event. Buzzers past the limit
+ * are left out.
+ */
+static void test_vcd(void) {
+    trace_set_cycles(UINT32_MAX, 0);
+    buzzer_trace_clear();
+    int64_t start_us = esp_timer_get_time();
+    buzzer_trace_record(BUZZER_TRACE_FREQ, &trace_sources[0], 440);
+    buzzer_trace_record(BUZZER_TRACE_PLAY, &trace_sources[0], 0);
+    fake_sim_sleep_until(start_us + 1000);
+    buzzer_trace_record(BUZZER_TRACE_FREQ, &trace_sources[1], 880);
+    buzzer_trace_record(BUZZER_TRACE_PLAY, &trace_sources[1], 0);
+    fake_sim_sleep_until(start_us + 2000);
+    buzzer_trace_record(BUZZER_TRACE_PAUSE, &trace_sources[0], 0);
+    buzzer_trace_record(BUZZER_TRACE_DEADLINE, &trace_sources[1], 0);
+
+    char *vcd = trace_dump(buzzer_trace_dump_vcd);
+    const char *expected = "$timescale 1 ns $end\n"
+                           "$scope module buzzer $end\n"
+                           "$var wire 1 ! playing0 $end\n"
+                           "$var integer 32 \" freq0 $end\n"
+                           "$var event 1 # deadline0 $end\n"
+                           "$var wire 1 $ playing1 $end\n"
+                           "$var integer 32 % freq1 $end\n"
+                           "$var event 1 & deadline1 $end\n"
+                           "$upscope $end\n"
+                           "$enddefinitions $end\n"
+                           "#0\n"
+                           "b00000000000000000000000110111000 \"\n"
+                           "1!\n"
+                           "#1000000\n"
+                           "b00000000000000000000001101110000 %\n"
+                           "1$\n"
+                           "#2000000\n"
+                           "0!\n"
+                           "1&\n";
+    TEST_CHECK(strcmp(vcd, expected) == 0);
+    if (strcmp(vcd, expected) != 0) printf("%s", vcd);
+    free(vcd);
+
+    buzzer_trace_clear();
+    for (uint32_t i = 0; i <= BUZZER_TRACE_MAX_SOURCES; i++) {
+        buzzer_trace_record(BUZZER_TRACE_PLAY, &trace_sources[i], 0);
+    }
+    vcd = trace_dump(buzzer_trace_dump_vcd);
+    uint32_t vars = 0, changes = 0;
+    for (char *line = strtok(vcd, "\n"); line; line = strtok(NULL, "\n")) {
+        if (strncmp(line, "$var", 4) == 0) vars++;
+        if (line[0] == '1') changes++;
+    }
+    TEST_CHECK_EQ(vars, BUZZER_TRACE_MAX_SOURCES * 3);
+    TEST_CHECK_EQ(changes, BUZZER_TRACE_MAX_SOURCES);
+    free(vcd);
+
+    buzzer_trace_clear();
+    fake_sim_set_cycle_source(NULL);
+}
+
+/**
+ * Plays a note with the blocking functions and pushes an event to the player, and checks the library records the
+ * frequency, the play and the pause at their times, and the deadline of the event.
+ */
+static void test_library_events(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    buzzer_trace_clear();
+    int64_t start_us = esp_timer_get_time();
+    TEST_CHECK_EQ(buzzer_set_freq(buzzer, 1000), ESP_OK);
+    TEST_CHECK_EQ(buzzer_play_ms(buzzer, 100), ESP_OK);
+
+    buzzer_trace_record_t records[BUZZER_TRACE_LEN];
+    TEST_CHECK_EQ(buzzer_trace_get(records, BUZZER_TRACE_LEN), 3);
+    TEST_CHECK_EQ(records[0].event, BUZZER_TRACE_FREQ);
+    TEST_CHECK_EQ(records[0].value, 1000);
+    TEST_CHECK_EQ(records[1].event, BUZZER_TRACE_PLAY);
+    TEST_CHECK_EQ(records[1].time_us, (uint32_t) start_us);
+    TEST_CHECK_EQ(records[2].event, BUZZER_TRACE_PAUSE);
+    TEST_CHECK_EQ(records[2].time_us, (uint32_t) start_us + 100000);
+    for (uint32_t i = 0; i < 3; i++) TEST_CHECK(records[i].source == buzzer);
+
+    buzzer_player_t *player = buzzer_player_create(buzzer, NULL);
+    buzzer_trace_clear();
+    start_us = esp_timer_get_time();
+    buzzer_event_t event = {.freq_hz = 440, .duration_ms = 100};
+    TEST_CHECK_EQ(buzzer_player_push(player, &event), ESP_OK);
+    fake_sim_sleep_until(start_us + 200000);
+    uint32_t count = buzzer_trace_get(records, BUZZER_TRACE_LEN);
+    uint32_t deadlines = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (records[i].event != BUZZER_TRACE_DEADLINE) continue;
+        TEST_CHECK_EQ(records[i].value, (uint32_t) (start_us + 100000));
+        deadlines++;
+    }
+    TEST_CHECK_EQ(deadlines, 1);
+
+    buzzer_trace_clear();
+    buzzer_player_destroy(player);
+    buzzer_destroy(buzzer);
+}
+
+int main(void) {
+    TEST_RUN(test_ring_wrap);
+    TEST_RUN(test_csv_unwrap);
+    TEST_RUN(test_vcd);
+    TEST_RUN(test_library_events);
+    return TEST_RESULT();
+}
+
+// Private functions
+
+/**
+ * Drives the cycle counter from the simulated clock.
+ * @param wrap_in_us Time from now at which the counter wraps around
+ * @param read_cycles Cycles added by every read, on top of the simulated clock
+ */
+static void trace_set_cycles(uint32_t wrap_in_us, uint32_t read_cycles) {
+    uint32_t now_cycles = (uint32_t) ((uint64_t) esp_timer_get_time() * TRACE_CYCLES_PER_US);
+    trace_cycle_offset = 0u - now_cycles - wrap_in_us * TRACE_CYCLES_PER_US;
+    trace_read_cycles = read_cycles;
+    trace_reads = 0;
+    fake_sim_set_cycle_source(trace_cycles);
+}
+
+/**
+ * Reads the cycle counter driven from the simulated clock.
+ * @return Cycles elapsed, wrapping around every 32 bits
+ */
+static uint32_t trace_cycles(void) {
+    uint64_t cycles = (uint64_t) esp_timer_get_time() * TRACE_CYCLES_PER_US;
+    return (uint32_t) cycles + trace_cycle_offset + trace_reads++ * trace_read_cycles;
+}
+
+/**
+ * Dumps the trace into memory.
+ * @param dump Function writing the dump
+ * @return The dump as a string, to be freed
+ */
+static char *trace_dump(esp_err_t (*dump)(FILE *out)) {
+    char *text = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&text, &size);
+    TEST_CHECK_EQ(dump(out), ESP_OK);
+    fclose(out);
+    return text;
+}
+
+/**
+ * Parses a CSV dump, checking its header.
+ * @param csv Dump to parse, modified while parsing
+ * @param lines Where to store the lines after the header
+ * @param max Lines that fit
+ * @return Lines parsed, not counting the header
+ */
+static uint32_t trace_parse_csv(char *csv, trace_line_t *lines, uint32_t max) {
+    char *line = strtok(csv, "\n");
+    TEST_CHECK(line && strcmp(line, "time_ns,cycles,time_us,core,buzzer,event,value") == 0);
+
+    uint32_t count = 0;
+    unsigned core;
+    while ((line = strtok(NULL, "\n")) && count < max) {
+        trace_line_t *parsed = &lines[count];
+        int fields = sscanf(line, "%llu,%u,%u,%u,%d,%15[^,],%u", &parsed->time_ns, &parsed->cycles,
+                            &parsed->time_us, &core, &parsed->buzzer, parsed->event, &parsed->value);
+        TEST_CHECK_EQ(fields, 7);
+        count++;
+    }
+    return count;
+}
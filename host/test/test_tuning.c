@@ -0,0 +1,194 @@
+/**
+ * @file test_tuning.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Tests of the tuning model: the dividers and frequencies it predicts match the ones the LEDC ends up with,
+ * the requests it picks are never worse than truncating the note frequency, and the clock source searches honour
+ * their limits.
+ */
+
+#include <math.h>
+#include "buzzer/buzzer.h"
+#include "buzzer/buzzer_tuning.h"
+#include "test_util.h"
+
+#define TUNING_RES_BITS BUZZER_DUTY_RES_BITS ///< Duty resolution of the buzzers, which the tests are run with
+#define TUNING_EPSILON 1e-9 ///< Largest difference between two frequencies considered equal, in Hz
+
+// Private function declarations
+
+static double abs_error_cents(double target_hz, uint32_t request_hz);
+
+// Tests
+
+/**
+ * Checks the frequency of every clock source, and that unknown sources are rejected.
+ */
+static void test_clk_hz(void) {
+    TEST_CHECK_EQ(buzzer_tuning_clk_hz(LEDC_AUTO_CLK), BUZZER_TUNING_APB_CLK_HZ);
+    TEST_CHECK_EQ(buzzer_tuning_clk_hz(LEDC_USE_APB_CLK), BUZZER_TUNING_APB_CLK_HZ);
+    TEST_CHECK_EQ(buzzer_tuning_clk_hz(LEDC_USE_REF_TICK), BUZZER_TUNING_REF_TICK_HZ);
+    TEST_CHECK_EQ(buzzer_tuning_clk_hz(BUZZER_TUNING_RTC8M_CLK), BUZZER_TUNING_RTC8M_HZ);
+    TEST_CHECK_EQ(buzzer_tuning_clk_hz((ledc_clk_cfg_t) 42), 0);
+}
+
+/**
+ * Checks the divider rounding and the limits of the frequencies a timer can output.
+ */
+static void test_divider(void) {
+    // 80 MHz / (440 Hz << 15) = 5.549, or 1420.45 in steps of 1/256, which the driver rounds to the nearest step
+    TEST_CHECK_EQ(buzzer_tuning_divider(BUZZER_TUNING_APB_CLK_HZ, TUNING_RES_BITS, 440), 1420);
+
+    // The highest frequency needs a divider of 1, and the lowest one the 18 bit maximum
+    uint32_t max_hz = BUZZER_TUNING_APB_CLK_HZ >> TUNING_RES_BITS;
+    TEST_CHECK(buzzer_tuning_divider(BUZZER_TUNING_APB_CLK_HZ, TUNING_RES_BITS, max_hz) >= BUZZER_TUNING_DIV_MIN);
+    TEST_CHECK_EQ(buzzer_tuning_divider(BUZZER_TUNING_APB_CLK_HZ, TUNING_RES_BITS, max_hz + 100), 0);
+    TEST_CHECK(buzzer_tuning_divider(BUZZER_TUNING_APB_CLK_HZ, TUNING_RES_BITS, 3) <= BUZZER_TUNING_DIV_MAX);
+    TEST_CHECK_EQ(buzzer_tuning_divider(BUZZER_TUNING_APB_CLK_HZ, TUNING_RES_BITS, 2), 0);
+
+    // Invalid arguments
+    TEST_CHECK_EQ(buzzer_tuning_divider(0, TUNING_RES_BITS, 440), 0);
+    TEST_CHECK_EQ(buzzer_tuning_divider(BUZZER_TUNING_APB_CLK_HZ, 0, 440), 0);
+    TEST_CHECK_EQ(buzzer_tuning_divider(BUZZER_TUNING_APB_CLK_HZ, TUNING_RES_BITS, 0), 0);
+    TEST_CHECK_EQ(buzzer_tuning_divider(BUZZER_TUNING_APB_CLK_HZ, 21, 440), 0);
+}
+
+/**
+ * Sets a sweep of frequencies on a buzzer, and checks the divider and frequency predicted by the model are the ones the
+ * LEDC ends up with.
+ */
+static void test_model_matches_ledc(void) {
+    buzzer_t *buzzer = buzzer_init(LEDC_CHANNEL_0, LEDC_TIMER_0, GPIO_NUM_4);
+    uint32_t mismatches = 0;
+    for (uint32_t freq_hz = 3; freq_hz <= (BUZZER_TUNING_APB_CLK_HZ >> TUNING_RES_BITS); freq_hz += 7) {
+        TEST_CHECK_EQ(buzzer_set_freq(buzzer, freq_hz), ESP_OK);
+        uint32_t divider = buzzer_tuning_divider(BUZZER_TUNING_APB_CLK_HZ, TUNING_RES_BITS, freq_hz);
+        double actual_hz = buzzer_tuning_actual_freq(LEDC_AUTO_CLK, TUNING_RES_BITS, freq_hz);
+        if (divider != fake_ledc_get_divider(LEDC_TIMER_0) ||
+            fabs(actual_hz - fake_ledc_get_freq(LEDC_TIMER_0)) > TUNING_EPSILON) {
+            if (mismatches++ == 0) fprintf(stderr, "model differs from the LEDC at %u Hz\n", (unsigned) freq_hz);
+        }
+    }
+    TEST_CHECK_EQ(mismatches, 0);
+    buzzer_destroy(buzzer);
+}
+
+/**
+ * Checks the request picked for every playable note is at least as accurate as truncating or rounding its frequency,
+ * and strictly better for some of them.
+ */
+static void test_best_request(void) {
+    uint32_t playable = 0, better = 0;
+    for (uint8_t octave = 0; octave <= 8; octave++) {
+        for (int note = BUZZER_NOTE_C; note < BUZZER_NOTE_MAX; note++) {
+            double target_hz = buzzer_get_note_freq(note, octave);
+            uint32_t best = buzzer_tuning_best_request(LEDC_USE_APB_CLK, TUNING_RES_BITS, target_hz);
+            if (best == 0) {
+                // Only the notes above what the timer can output are rejected
+                TEST_CHECK(target_hz > (BUZZER_TUNING_APB_CLK_HZ >> TUNING_RES_BITS));
+                continue;
+            }
+            playable++;
+
+            double best_error = abs_error_cents(target_hz, best);
+            double truncated_error = abs_error_cents(target_hz, (uint32_t) target_hz);
+            TEST_CHECK(best_error <= truncated_error);
+            TEST_CHECK(best_error <= abs_error_cents(target_hz, (uint32_t) (target_hz + 0.5)));
+            if (best_error < truncated_error) better++;
+        }
+    }
+    printf("tuning: %u playable notes, %u tuned better than truncated\n", (unsigned) playable, (unsigned) better);
+    TEST_CHECK(playable > 0);
+    TEST_CHECK(better > 0);
+
+    TEST_CHECK_EQ(buzzer_tuning_best_request(LEDC_USE_APB_CLK, TUNING_RES_BITS, 0.5), 0);
+    TEST_CHECK_EQ(buzzer_tuning_best_request(LEDC_USE_APB_CLK, TUNING_RES_BITS, 1e6), 0);
+}
+
+/**
+ * Evaluates and characterizes clock sources, checking the results against the notes they're made of and the limits of
+ * each source.
+ */
+static void test_evaluate(void) {
+    buzzer_tuning_result_t result;
+    TEST_CHECK_EQ(buzzer_tuning_evaluate(LEDC_USE_APB_CLK, TUNING_RES_BITS, 1, 6, &result), ESP_OK);
+    TEST_CHECK(result.mean_error_cents >= 0);
+    TEST_CHECK(result.max_error_cents >= result.mean_error_cents);
+
+    double max_error = 0;
+    for (uint8_t octave = 1; octave <= 6; octave++) {
+        for (int note = BUZZER_NOTE_C; note < BUZZER_NOTE_MAX; note++) {
+            double target_hz = buzzer_get_note_freq(note, octave);
+            double error = abs_error_cents(target_hz,
+                                           buzzer_tuning_best_request(LEDC_USE_APB_CLK, TUNING_RES_BITS, target_hz));
+            if (error > max_error) max_error = error;
+        }
+    }
+    TEST_CHECK(fabs(result.max_error_cents - max_error) < TUNING_EPSILON);
+
+    // Octave 7 goes beyond what the timer outputs at this resolution
+    TEST_CHECK_EQ(buzzer_tuning_evaluate(LEDC_USE_APB_CLK, TUNING_RES_BITS, 1, 7, &result), ESP_FAIL);
+    TEST_CHECK_EQ(buzzer_tuning_evaluate(LEDC_USE_APB_CLK, TUNING_RES_BITS, 5, 4, &result), ESP_FAIL);
+    TEST_CHECK_EQ(buzzer_tuning_evaluate(LEDC_USE_APB_CLK, TUNING_RES_BITS, 1, 9, &result), ESP_FAIL);
+    TEST_CHECK_EQ(buzzer_tuning_evaluate(LEDC_USE_APB_CLK, TUNING_RES_BITS, 1, 6, NULL), ESP_FAIL);
+
+    // The best combination is at least as accurate as the one the buzzers use
+    buzzer_tuning_result_t best;
+    TEST_CHECK_EQ(buzzer_tuning_evaluate(LEDC_USE_APB_CLK, TUNING_RES_BITS, 1, 6, &result), ESP_OK);
+    TEST_CHECK_EQ(buzzer_tuning_find_best(1, 6, TUNING_RES_BITS, &best), ESP_OK);
+    TEST_CHECK(best.duty_res_bits >= TUNING_RES_BITS);
+    TEST_CHECK(best.max_error_cents <= result.max_error_cents);
+
+    buzzer_tuning_source_t report;
+    TEST_CHECK_EQ(buzzer_tuning_characterize(BUZZER_TUNING_RTC8M_CLK, 10, 3, 6, &report), ESP_OK);
+    TEST_CHECK(report.dfs_stable);
+    TEST_CHECK(fabs(report.clk_error_cents - 1200.0 * log2(1 + BUZZER_TUNING_RTC8M_TOLERANCE)) < TUNING_EPSILON);
+    TEST_CHECK(report.max_error_cents >= report.clk_error_cents);
+    TEST_CHECK(fabs(report.max_freq_hz - BUZZER_TUNING_RTC8M_HZ / 1024.0) < TUNING_EPSILON);
+    TEST_CHECK_EQ(buzzer_tuning_characterize(LEDC_USE_APB_CLK, TUNING_RES_BITS, 3, 6, &report), ESP_OK);
+    TEST_CHECK(!report.dfs_stable);
+    TEST_CHECK_EQ(report.clk_error_cents, 0);
+    TEST_CHECK_EQ(buzzer_tuning_characterize((ledc_clk_cfg_t) 42, TUNING_RES_BITS, 3, 6, &report), ESP_FAIL);
+}
+
+/**
+ * Checks the cheapest source search prefers the sources unaffected by DFS, and falls back to the accurate ones when
+ * the tolerance is tighter than the RTC8M clock.
+ */
+static void test_find_cheapest(void) {
+    buzzer_tuning_source_t cheapest;
+    TEST_CHECK_EQ(buzzer_tuning_find_cheapest(3, 6, 50, &cheapest), ESP_OK);
+    TEST_CHECK_EQ(cheapest.clk_cfg, BUZZER_TUNING_RTC8M_CLK);
+    TEST_CHECK(cheapest.max_error_cents <= 50);
+
+    // Whole Hz requests keep the error of octave 3 around 5 cents, below the tolerance of the RTC8M clock
+    TEST_CHECK_EQ(buzzer_tuning_find_cheapest(3, 6, 10, &cheapest), ESP_OK);
+    TEST_CHECK(cheapest.clk_cfg != BUZZER_TUNING_RTC8M_CLK);
+    TEST_CHECK(cheapest.max_error_cents <= 10);
+
+    TEST_CHECK_EQ(buzzer_tuning_find_cheapest(3, 6, 0, &cheapest), ESP_FAIL);
+    TEST_CHECK_EQ(buzzer_tuning_find_cheapest(3, 6, 50, NULL), ESP_FAIL);
+}
+
+int main(void) {
+    TEST_RUN(test_clk_hz);
+    TEST_RUN(test_divider);
+    TEST_RUN(test_model_matches_ledc);
+    TEST_RUN(test_best_request);
+    TEST_RUN(test_evaluate);
+    TEST_RUN(test_find_cheapest);
+    return TEST_RESULT();
+}
+
+// Private functions
+
+/**
+ * Calculates how far the frequency output for a request is from the target.
+ * @param target_hz Intended frequency
+ * @param request_hz Frequency requested to an APB timer at the buzzers' resolution
+ * @return Absolute error in cents
+ */
+static double abs_error_cents(double target_hz, uint32_t request_hz) {
+    double actual_hz = buzzer_tuning_actual_freq(LEDC_USE_APB_CLK, TUNING_RES_BITS, request_hz);
+    return fabs(buzzer_tuning_error_cents(target_hz, actual_hz));
+}
@@ -0,0 +1,68 @@
+/**
+ * @file test_util.h
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Minimal helpers shared by the host tests: checks which report failures without stopping the test, and a
+ * real-time clock for benchmarks (everything timed by the library runs on the simulated clock instead).
+ */
+
+#ifndef GYRO_READER_TEST_UTIL_H
+#define GYRO_READER_TEST_UTIL_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "fake_ledc.h"
+
+static int test_failures; ///< Checks failed so far
+
+/**
+ * Checks a condition, reporting it if it doesn't hold.
+ */
+#define TEST_CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        test_failures++; \
+    } \
+} while (0)
+
+/**
+ * Checks that two integers are equal, reporting both if they aren't.
+ */
+#define TEST_CHECK_EQ(actual, expected) do { \
+    long long test_actual_ = (long long) (actual), test_expected_ = (long long) (expected); \
+    if (test_actual_ != test_expected_) { \
+        fprintf(stderr, "%s:%d: check failed: %s == %s (%lld != %lld)\n", __FILE__, __LINE__, #actual, #expected, \
+                test_actual_, test_expected_); \
+        test_failures++; \
+    } \
+} while (0)
+
+/**
+ * Runs a test function, starting from a clean LEDC.
+ */
+#define TEST_RUN(test) do { \
+    fake_ledc_reset(); \
+    fake_ledc_set_observer(NULL, NULL); \
+    fake_ledc_set_recording(false); \
+    int test_before_ = test_failures; \
+    test(); \
+    printf("%s %s\n", test_failures == test_before_ ? "PASS" : "FAIL", #test); \
+} while (0)
+
+/**
+ * Returns the exit code of the test program.
+ */
+#define TEST_RESULT() (test_failures ? 1 : 0)
+
+/**
+ * Reads the real monotonic clock, to measure how fast the host runs something.
+ * @return Nanoseconds elapsed since an arbitrary point
+ */
+static inline uint64_t test_real_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+#endif //GYRO_READER_TEST_UTIL_H
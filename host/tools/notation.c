@@ -0,0 +1,144 @@
+/**
+ * @file notation.c
+ * @author Diego Ortín Fernández
+ * @date 17-10-2026
+ * @brief Host program playing a melody written in text notation (see buzzer_notation.h) read from stdin, through a
+ * player on the simulated clock. Every time the output of the buzzer changes, a line with the simulated time in
+ * milliseconds and the frequency sounding in Hz (0 when silent) is printed, and the output can also be rendered to a
+ * WAV file:
+ *
+ *     echo "C4q D4e R q" | ./notation --bpm 120 --wav melody.wav
+ *
+ * @details The whole input is parsed as soon as it's read, so it must fit in the player's ring buffer
+ * (NOTATION_QUEUE_LEN notes).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include "buzzer/buzzer.h"
+#include "buzzer/buzzer_player.h"
+#include "buzzer/buzzer_notation.h"
+#include "buzzer_render.h"
+#include "fake_ledc.h"
+
+#define NOTATION_DEFAULT_BPM 120u ///< Speed the notes are played at unless --bpm is given
+#define NOTATION_QUEUE_LEN 1024u ///< Capacity of the player's ring buffer, which holds the whole input
+#define NOTATION_GPIO GPIO_NUM_4 ///< Pin of the buzzer
+
+/**
+ * Output of the buzzer, followed through the writes to the LEDC
+ */
+typedef struct {
+    uint32_t freq_hz; ///< Frequency the timer is set to
+    bool running; ///< Whether the timer is counting
+    uint32_t printed_hz; ///< Frequency last printed, 0 for silence
+    int64_t start_us; ///< Simulated time the input started playing at
+} notation_output_t;
+
+// Private function declarations
+
+static void notation_observer(const fake_ledc_event_t *event, void *arg);
+
+static esp_err_t notation_write(const void *data, size_t size, void *arg);
+
+static int notation_usage(const char *program);
+
+int main(int argc, char **argv) {
+    uint32_t bpm = NOTATION_DEFAULT_BPM;
+    const char *wav_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bpm") == 0 && i + 1 < argc) bpm = (uint32_t) strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--wav") == 0 && i + 1 < argc) wav_path = argv[++i];
+        else return notation_usage(argv[0]);
+    }
+    if (bpm == 0) return notation_usage(argv[0]);
+
+    // Recording from before the buzzer is created, so the initial state of its timer and channel is known
+    fake_ledc_set_recording(wav_path != NULL);
+    buzzer_t *buzzer = buzzer_init(BUZZER_RENDER_CHANNEL, BUZZER_RENDER_TIMER, NOTATION_GPIO);
+    buzzer_player_config_t config = {.queue_len = NOTATION_QUEUE_LEN};
+    buzzer_player_t *player = buzzer ? buzzer_player_create(buzzer, &config) : NULL;
+    buzzer_notation_t *parser = player ? buzzer_notation_create(player, bpm) : NULL;
+    if (!parser) {
+        fprintf(stderr, "couldn't create the player\n");
+        return 1;
+    }
+
+    notation_output_t output = {.start_us = esp_timer_get_time()};
+    buzzer_player_stats_t stats;
+    buzzer_player_get_stats(player, &stats);
+    uint32_t underruns = stats.underruns;
+    fake_ledc_set_observer(notation_observer, &output);
+    esp_err_t ret = buzzer_notation_feed_stream(parser, stdin);
+    if (ret != ESP_OK) fprintf(stderr, "some notes were invalid or didn't fit, and were skipped\n");
+
+    // The player silences the buzzer and counts an underrun once it runs out of notes, if it got any
+    do {
+        vTaskDelay(1);
+        buzzer_player_get_stats(player, &stats);
+    } while (stats.underruns == underruns && (stats.played > 0 || buzzer_player_get_level(player) > 0));
+    int64_t end_us = esp_timer_get_time();
+    fake_ledc_set_observer(NULL, NULL);
+
+    int status = ret == ESP_OK ? 0 : 1;
+    if (wav_path) {
+        FILE *file = fopen(wav_path, "wb");
+        buzzer_render_config_t render = {.write = notation_write, .arg = file};
+        if (!file || buzzer_render_timeline_wav(BUZZER_RENDER_CHANNEL, BUZZER_RENDER_TIMER, output.start_us, end_us,
+                                                &render) != ESP_OK) {
+            fprintf(stderr, "couldn't write %s\n", wav_path);
+            status = 1;
+        }
+        if (file) fclose(file);
+    }
+
+    buzzer_notation_destroy(parser);
+    buzzer_player_destroy(player);
+    buzzer_destroy(buzzer);
+    return status;
+}
+
+// Private functions
+
+/**
+ * Follows the frequency and the state of the buzzer's timer, and prints the output whenever it changes.
+ * @param event Write to the LEDC
+ * @param arg Output of the buzzer
+ */
+static void notation_observer(const fake_ledc_event_t *event, void *arg) {
+    notation_output_t *output = arg;
+    if (event->op == FAKE_LEDC_DUTY || event->index != BUZZER_RENDER_TIMER) return;
+    if (event->op == FAKE_LEDC_DIVIDER) output->freq_hz = event->freq_hz;
+    else if (event->op == FAKE_LEDC_RESUME) output->running = true;
+    else if (event->op == FAKE_LEDC_PAUSE) output->running = false;
+
+    uint32_t sounding_hz = output->running ? output->freq_hz : 0;
+    if (sounding_hz == output->printed_hz) return;
+    output->printed_hz = sounding_hz;
+    printf("%lld %u\n", (long long) ((event->time_us - output->start_us) / 1000), (unsigned) sounding_hz);
+}
+
+/**
+ * Writes bytes of the WAV file.
+ * @param data Bytes to write
+ * @param size Amount of bytes to write
+ * @param arg File to write to
+ * @return ESP_OK if the bytes were written, ESP_FAIL otherwise
+ */
+static esp_err_t notation_write(const void *data, size_t size, void *arg) {
+    return fwrite(data, 1, size, arg) == size ? ESP_OK : ESP_FAIL;
+}
+
+/**
+ * Prints how to run the program.
+ * @param program Name the program was run with
+ * @return Exit status for invalid arguments
+ */
+static int notation_usage(const char *program) {
+    fprintf(stderr, "usage: %s [--bpm N] [--wav FILE] < melody.txt\n", program);
+    return 2;
+}
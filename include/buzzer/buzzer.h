@@ -9,18 +9,91 @@
 #ifndef GYRO_READER_BUZZER_H
 #define GYRO_READER_BUZZER_H
 
+#include <stdint.h>
 #include <esp_err.h>
 #include <driver/ledc.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define BUZZER_BASE_PULSE_DIVISIONS 8 ///< How many parts a pulse is divided by before multiplying by the note type
 
 #define BUZZER_INTIIAL_FREQ 440 ///< Frequency the buzzer will be set to at initialization time
 
+#define BUZZER_DUTY_RES_BITS 15u ///< Bits of resolution set in the buzzer's timer
+
+#define BUZZER_GROUP_MAX 8 ///< Maximum amount of buzzers that can be started or paused together
+
+#define BUZZER_LOOP_FOREVER UINT32_MAX ///< Loop count which repeats the looped section of a melody until stopped
+
+#define BUZZER_GATE_LEGATO 100 ///< Notes sound for their whole duration, with no gap between them
+#define BUZZER_GATE_DETACHED 90 ///< Notes are shortened just enough to separate repeated pitches
+#define BUZZER_GATE_STACCATO 50 ///< Notes sound for half of their duration
+
+#define BUZZER_DUTY_SQUARE 50 ///< Duty (in percent) of a square wave, the loudest and the one set at initialization
+#define BUZZER_DUTY_THIN 25 ///< Quieter and more nasal than a square wave
+#define BUZZER_DUTY_NARROW 12 ///< Quiet and reedy, for echoes and background voices
+#define BUZZER_DUTY_MAX 99 ///< Highest duty a buzzer can be set to, in percent
+
+/**
+ * Initializer of a buzzer_melody_t which plays the given notes once, legato and with the buzzer's duty: every field
+ * after the length is zeroed. Melodies declared without an initializer and then filled field by field (usually on the
+ * stack) must start from it, as fields added to the structure would otherwise hold garbage.
+ * @param notes Pointer to the array of musical notes
+ * @param count Length of the array of musical notes
+ */
+#define BUZZER_MELODY_INIT(notes, count) {.melody = (notes), .length = (count), .loop_start = 0, .loop_end = 0, \
+                                          .loop_count = 0, .gate = 0, .duty = 0}
+
+#define BUZZER_TEMPO_NORMAL 100 ///< Tempo (in percent of the bpm) which plays melodies at their own speed
+#define BUZZER_TRANSPOSE_MAX_CENTS 9600 ///< Largest transposition, up or down, in cents (8 octaves)
+
+#define BUZZER_MODULATION_UNITY 65536u ///< Modulation scale (in Q16 fixed point) which leaves the output unchanged
+
+/**
+ * Base frequencies for each musical note from C to B, in Hz, in the 8th octave. Final frequencies can then be
+ * calculated from these by dividing depending on the octave. Kept as a macro so the C++ melody compiler can use them
+ * in constant expressions.
+ */
+#define BUZZER_NOTE_BASE_FREQS \
+        4186, /* C  */ \
+        4435, /* C# */ \
+        4699, /* D  */ \
+        4978, /* D# */ \
+        5274, /* E  */ \
+        5588, /* F  */ \
+        5920, /* F# */ \
+        6272, /* G  */ \
+        6645, /* G# */ \
+        7040, /* A  */ \
+        7459, /* A# */ \
+        7902  /* B  */
+
+#ifndef BUZZER_THREAD_SAFE
+#define BUZZER_THREAD_SAFE 1 ///< When set to 1, a buzzer can be safely shared between tasks. Can be set to 0 at compile
+                             ///< time to remove the locking overhead when each buzzer is only used from one task.
+#endif
+
+#ifndef BUZZER_COMPACT
+#define BUZZER_COMPACT 0 ///< When set to 1 at compile time, enumerations take a single byte (so musical notes take 4
+                         ///< bytes instead of 16) and buzzers pack their fields, for builds with many buzzers or note
+                         ///< buffers in RAM. Must be the same for every file using the library.
+#endif
+
+#if BUZZER_COMPACT
+#define BUZZER_ENUM_ATTR __attribute__((packed)) ///< Makes enumerations take the smallest integer type that fits them
+#define BUZZER_FREQ_MAX UINT16_MAX ///< Highest frequency a buzzer can be set to, as it's stored in 16 bits
+#else
+#define BUZZER_ENUM_ATTR
+#define BUZZER_FREQ_MAX UINT32_MAX ///< Highest frequency a buzzer can be set to
+#endif
+
 /**
  * Enumeration containing the different musical notes. It also contains the "rest note", which isn't a real musical
  * note but can be used to "play" a silence.
  */
-typedef enum _buzzer_note_t {
+typedef enum BUZZER_ENUM_ATTR _buzzer_note_t {
     BUZZER_NOTE_C,   ///< C
     BUZZER_NOTE_Cs,  ///< C#
     BUZZER_NOTE_D,   ///< D
@@ -41,7 +114,7 @@ typedef enum _buzzer_note_t {
  * Enumeration containing the different note types, according to their duration.
  * The corresponding number for each note type corresponds with the number of eights of a pulse the type takes.
  */
-typedef enum _buzzer_note_type_t {
+typedef enum BUZZER_ENUM_ATTR _buzzer_note_type_t {
     BUZZER_NTYPE_SEMIBREVE_DOTTED   = 48,   ///< 𝅝𝅭 or 𝄻𝅭 (6 pulses sound) (48/8)
     BUZZER_NTYPE_SEMIBREVE          = 32,   ///< 𝅝 or 𝄻 (4 pulses sound) (32/8)
     BUZZER_NTYPE_MINIM_DOTTED       = 24,   ///< 𝅗𝅥𝅭 or 𝄼𝅭 (3 pulses sound) (24/8)
@@ -57,22 +130,70 @@ typedef enum _buzzer_note_type_t {
 typedef struct _buzzer_t buzzer_t;
 
 /**
- * Structure with the required attributes to fully define a musical note (pitch and duration)
+ * Structure with the required attributes to fully define a musical note (pitch and duration), and optionally its
+ * articulation
  */
 typedef struct _buzzer_melody_note_t {
     buzzer_note_t note; ///< Musical note
     uint8_t octave; ///< Octave of the musical note (from 0 to 8)
     buzzer_note_type_t type; ///< Duration type of the musical note
+    uint8_t gate; ///< Part of the duration that sounds, in percent (see BUZZER_GATE_*). 0 uses the melody's gate.
 } buzzer_musical_note_t;
 
 /**
- * Structure with a sequence of musical notes, and its length for iteration purposes
+ * Structure with a sequence of musical notes, and its length for iteration purposes. A section of the melody can be
+ * looped: after its last note, playback jumps back to its first note as if it was any other note boundary. The loop
+ * fields must be zero for melodies without a loop, so melodies must be declared with an initializer (designated, or
+ * BUZZER_MELODY_INIT) which zeroes the fields it doesn't set.
  */
 typedef struct _buzzer_melody_t {
-    buzzer_musical_note_t *melody; ///< Pointer to an array of musical notes, to be played in order
+    const buzzer_musical_note_t *melody; ///< Pointer to an array of musical notes, to be played in order. It's never
+                                         ///< written, so it can be placed in flash.
     uint32_t length; ///< Length of the array of musical notes
+    uint32_t loop_start; ///< Index of the first note of the looped section
+    uint32_t loop_end; ///< Index right after the last note of the looped section, 0 for no loop
+    uint32_t loop_count; ///< Times the looped section is repeated after being played once, or BUZZER_LOOP_FOREVER
+    uint8_t gate; ///< Gate of the notes which don't set their own, in percent. 0 means legato.
+    uint8_t duty; ///< Duty (timbre) of the melody, in percent (see BUZZER_DUTY_*), kept only while it plays. 0 keeps
+                  ///< the buzzer's duty.
 } buzzer_melody_t;
 
+/**
+ * Structure with a note whose frequency has already been resolved, as generated at compile time by the C++ melody
+ * literals in buzzer_melody.hpp. Packed, so each note only takes 3 bytes of flash.
+ */
+typedef struct __attribute__((packed)) _buzzer_compiled_note_t {
+    uint16_t freq_hz; ///< Frequency of the note in Hz, or 0 for rests
+    uint8_t type; ///< Duration of the note, as a buzzer_note_type_t value
+} buzzer_compiled_note_t;
+
+/**
+ * Structure with a sequence of compiled notes, and its length for iteration purposes
+ */
+typedef struct _buzzer_compiled_melody_t {
+    const buzzer_compiled_note_t *notes; ///< Pointer to an array of compiled notes, to be played in order
+    uint32_t length; ///< Length of the array of compiled notes
+    uint8_t duty; ///< Duty (timbre) of the melody, in percent (see BUZZER_DUTY_*). 0 keeps the buzzer's duty.
+} buzzer_compiled_melody_t;
+
+/**
+ * Structure with a transposition prepared to be applied while playing, as set up by buzzer_transpose_init. Whole
+ * semitones are applied by moving through the note frequency table, so only the cents left need a multiplication.
+ */
+typedef struct _buzzer_transpose_t {
+    int16_t semitones; ///< Whole semitones the notes are moved by
+    float ratio; ///< Frequency ratio of the cents left over, from 1 up to (but not including) a semitone
+} buzzer_transpose_t;
+
+/**
+ * Structure with the optional configuration of a buzzer's timer
+ */
+typedef struct _buzzer_config_t {
+    ledc_clk_cfg_t clk_cfg; ///< Clock source of the timer, or LEDC_AUTO_CLK for the default
+    uint8_t duty_res_bits; ///< Duty resolution of the timer in bits, 0 for BUZZER_DUTY_RES_BITS. Slow clocks need lower
+                           ///< resolutions to reach high frequencies.
+} buzzer_config_t;
+
 /**
  * Creates and initializes the buzzer, using the provided LEDC channel and timer, on the specified GPIO pin.
  *
@@ -80,10 +201,26 @@ typedef struct _buzzer_melody_t {
  * @param channel LEDC channel to use
  * @param timer LEDC timer to use
  * @param gpio_num GPIO pìn to use
- * @return Pointer to an initialized buzzer
+ * @return Pointer to an initialized buzzer, or NULL if it couldn't be allocated
  */
 buzzer_t *buzzer_init(ledc_channel_t channel, ledc_timer_t timer, gpio_num_t gpio_num);
 
+/**
+ * Creates and initializes the buzzer like buzzer_init, with a custom clock source and duty resolution for its timer.
+ * Frequencies are then quantized (and notes tuned) for that clock and resolution.
+ *
+ * @details Under power management, buzzers using the APB clock hold it at its maximum while they play, while the
+ * ones using REF_TICK or RTC8M only keep the chip out of light sleep, so DFS can still lower the APB clock.
+ * @param channel LEDC channel to use
+ * @param timer LEDC timer to use
+ * @param gpio_num GPIO pin to use
+ * @param config Configuration of the timer, or NULL for the defaults
+ * @return Pointer to an initialized buzzer, or NULL if it couldn't be allocated or the timer can't output
+ * BUZZER_INTIIAL_FREQ with the provided configuration
+ */
+buzzer_t *buzzer_init_ex(ledc_channel_t channel, ledc_timer_t timer, gpio_num_t gpio_num,
+                         const buzzer_config_t *config);
+
 /**
  * Plays a melody on the buzzer to test if it's working correctly.
  *
@@ -121,6 +258,26 @@ esp_err_t buzzer_play(buzzer_t *buzzer);
  */
 esp_err_t buzzer_pause(buzzer_t *buzzer);
 
+/**
+ * Starts several buzzers at the same time and in phase. Their timer counters are reset and then resumed back to back
+ * inside a single critical section, so the outputs start within a few CPU cycles of each other. Frequencies should be
+ * set beforehand with buzzer_set_freq or buzzer_set_note, which don't start the sound. Buzzers which are already
+ * playing are left untouched.
+ * @param buzzers Buzzers to start
+ * @param count Amount of buzzers, up to BUZZER_GROUP_MAX
+ * @param skew_ns Where the time between the first and the last timer resume is stored, in nanoseconds, or NULL
+ * @return ESP_OK if the operation was executed successfully, ESP_FAIL if something went wrong
+ */
+esp_err_t buzzer_play_group(buzzer_t *const *buzzers, uint32_t count, uint32_t *skew_ns);
+
+/**
+ * Pauses several buzzers at the same time, inside a single critical section.
+ * @param buzzers Buzzers to stop
+ * @param count Amount of buzzers, up to BUZZER_GROUP_MAX
+ * @return ESP_OK if the operation was executed successfully, ESP_FAIL if something went wrong
+ */
+esp_err_t buzzer_pause_group(buzzer_t *const *buzzers, uint32_t count);
+
 /**
  * Checks if the buzzer is currently playing
  * @param buzzer Buzzer to check
@@ -145,22 +302,86 @@ esp_err_t buzzer_play_ms(buzzer_t *buzzer, uint32_t time_ms);
 esp_err_t buzzer_rest_ms(buzzer_t *buzzer, uint32_t time_ms);
 
 /**
- * Plays the provided melody in the buzzer, at the given speed in beats per minute.
+ * Plays the provided melody in the buzzer, at the given speed in beats per minute. Melodies looping forever never
+ * return, so they should be played with buzzer_player_play_melody instead. Melodies with a duty set it before their
+ * first note, and set the previous one back once they end.
  * @param buzzer Buzzer to play the melody on
  * @param melody Melody to play
  * @param bpm Speed to play the melody at (in beats per minute)
+ * @return ESP_OK if the operation was executed successfully, ESP_FAIL if something went wrong (or the melody is
+ * invalid, see buzzer_check_melody)
+ */
+esp_err_t buzzer_play_melody(buzzer_t *buzzer, const buzzer_melody_t *melody, uint32_t bpm);
+
+/**
+ * Checks a melody can be played: its notes must be set unless it's empty, and its looped section must lie within it,
+ * starting at or before its end. A looped section starting at its end is empty, so the melody is played once.
+ * @param melody Melody to check
+ * @return ESP_OK if the melody is valid, ESP_FAIL otherwise
+ */
+esp_err_t buzzer_check_melody(const buzzer_melody_t *melody);
+
+/**
+ * Plays the provided musical note at the given speed in beats per minute. Rests silence the buzzer for their duration,
+ * and notes with a gate are silenced for the rest of their duration after sounding.
+ * @param buzzer Buzzer to play the note on
+ * @param note Musical note to play
+ * @param bpm Speed to play the note at (in beats per minute)
+ * @return ESP_OK if the operation was executed successfully, ESP_FAIL if something went wrong
+ */
+esp_err_t buzzer_play_note(buzzer_t *buzzer, const buzzer_musical_note_t *note, uint32_t bpm);
+
+/**
+ * Plays the provided compiled melody in the buzzer, at the given speed in beats per minute. As frequencies are already
+ * resolved, no note table lookups are needed while playing. Melodies with a duty set it before their first note, and
+ * set the previous one back once they end.
+ * @param buzzer Buzzer to play the melody on
+ * @param melody Compiled melody to play
+ * @param bpm Speed to play the melody at (in beats per minute)
  * @return ESP_OK if the operation was executed successfully, ESP_FAIL if something went wrong
  */
-esp_err_t buzzer_play_melody(buzzer_t *buzzer, buzzer_melody_t *melody, uint32_t bpm);
+esp_err_t buzzer_play_compiled_melody(buzzer_t *buzzer, const buzzer_compiled_melody_t *melody, uint32_t bpm);
 
 /**
  * Sets the frequency the buzzer plays in Hertzs
  * @param buzzer Buzzer whose frequency must be set
- * @param freq_hz Frequency to set in Hz
+ * @param freq_hz Frequency to set in Hz, up to BUZZER_FREQ_MAX
  * @return ESP_OK if the operation was executed successfully, ESP_FAIL if something went wrong
  */
 esp_err_t buzzer_set_freq(buzzer_t *buzzer, uint32_t freq_hz);
 
+/**
+ * Sets the duty of the buzzer's output, which changes its timbre and loudness: on piezos, square waves are the loudest,
+ * and narrower pulses sound thinner and quieter. Takes a single duty register update, which the LEDC applies at the
+ * start of the next period, so it can be changed between notes without clicks. Kept until it's set again.
+ * @param buzzer Buzzer whose duty must be set
+ * @param duty Duty in percent, from 1 to BUZZER_DUTY_MAX (see BUZZER_DUTY_*)
+ * @return ESP_OK if the operation was executed successfully, ESP_FAIL if something went wrong
+ */
+esp_err_t buzzer_set_duty(buzzer_t *buzzer, uint8_t duty);
+
+/**
+ * Checks and returns the duty the buzzer is currently set to, without any modulation
+ * @param buzzer Buzzer whose duty must be checked
+ * @return Duty currently set in the buzzer, in percent, or 0 if the buzzer is invalid
+ */
+uint8_t buzzer_get_duty(buzzer_t *buzzer);
+
+/**
+ * Modulates the output of the buzzer around its frequency and its duty, without changing them. Meant to be called
+ * periodically, for effects like vibrato and tremolo (see buzzer_lfo.h).
+ *
+ * @details buzzer_set_freq sets the frequency back without modulation, while the duty keeps its modulation until this
+ * function is called again, with a duty_scale of BUZZER_MODULATION_UNITY to remove it (or buzzer_set_duty is called).
+ * The timer is only written when the modulated frequency differs from the one it outputs, and then its divider is set
+ * without resetting it, so the modulation doesn't click (except on the RTC8M clock, which goes through ledc_set_freq).
+ * @param buzzer Buzzer whose output must be modulated
+ * @param freq_scale Factor the frequency is multiplied by, in Q16 fixed point (BUZZER_MODULATION_UNITY for none)
+ * @param duty_scale Factor the duty is multiplied by, in Q16 fixed point, up to BUZZER_MODULATION_UNITY
+ * @return ESP_OK if the operation was executed successfully, ESP_FAIL if something went wrong
+ */
+esp_err_t buzzer_modulate(buzzer_t *buzzer, uint32_t freq_scale, uint32_t duty_scale);
+
 /**
  * Checks and returns the frequency the buzzer is currently set to, in Hertzs
  * @param buzzer Buzzer whose frequency must be checked
@@ -168,8 +389,19 @@ esp_err_t buzzer_set_freq(buzzer_t *buzzer, uint32_t freq_hz);
  */
 uint32_t buzzer_get_freq(buzzer_t *buzzer);
 
+/**
+ * Returns the frequency the buzzer actually outputs, which differs slightly from the one it's set to because the
+ * LEDC timer can only divide its clock in discrete steps.
+ * @param buzzer Buzzer whose frequency must be checked
+ * @return Frequency currently output by the buzzer, in Hz
+ */
+double buzzer_get_actual_freq(buzzer_t *buzzer);
+
 /**
  * Sets the frequency the buzzer plays to that of the provided note (in the given octave)
+ *
+ * @details The whole frequency requested to the timer is the one whose output gets closest to the note, as
+ * calculated by buzzer_tuning_best_request.
  * @param buzzer Buzzer to set the frequency for
  * @param note Note to set
  * @param octave Octave of the note (from 0 to 8)
@@ -177,6 +409,30 @@ uint32_t buzzer_get_freq(buzzer_t *buzzer);
  */
 esp_err_t buzzer_set_note(buzzer_t *buzzer, buzzer_note_t note, uint8_t octave);
 
+/**
+ * Sets the frequency the buzzer plays to that of the provided note (in the given octave), transposed. Like
+ * buzzer_set_note, the whole frequency requested to the timer is the one whose output gets closest to the result.
+ * @param buzzer Buzzer to set the frequency for
+ * @param note Note to set
+ * @param octave Octave of the note (from 0 to 8)
+ * @param transpose Transposition to apply, or NULL for none
+ * @return ESP_OK if the operation was executed successfully, ESP_FAIL if something went wrong
+ */
+esp_err_t buzzer_set_transposed_note(buzzer_t *buzzer, buzzer_note_t note, uint8_t octave,
+                                     const buzzer_transpose_t *transpose);
+
+/**
+ * Returns the whole frequency buzzer_set_transposed_note would request to the buzzer's timer for the provided note,
+ * so notes can be turned into frequencies ahead of time (like the player does) and still be tuned for the buzzer.
+ * @param buzzer Buzzer the note will be played on
+ * @param note Note to convert
+ * @param octave Octave of the note (from 0 to 8)
+ * @param transpose Transposition to apply, or NULL for none
+ * @return Frequency to request in Hz, or 0 for rests (and if the arguments are invalid)
+ */
+uint32_t buzzer_get_note_request(buzzer_t *buzzer, buzzer_note_t note, uint8_t octave,
+                                 const buzzer_transpose_t *transpose);
+
 //esp_err_t buzzer_set_volume(buzzer_t *buzzer, uint8_t volume);
 
 /**
@@ -197,4 +453,44 @@ esp_err_t buzzer_play_note_ms(buzzer_t *buzzer, buzzer_note_t note, uint8_t octa
  */
 uint32_t buzzer_note_type_to_ms(buzzer_note_type_t type, uint32_t bpm);
 
+/**
+ * Returns the part of a note's duration that sounds with the given gate. The result is never longer than the duration.
+ * @param duration_ms Duration of the note in milliseconds
+ * @param gate Gate in percent, where 0 (or anything from BUZZER_GATE_LEGATO up) means the whole duration
+ * @return Milliseconds the note sounds for
+ */
+uint32_t buzzer_gate_to_ms(uint32_t duration_ms, uint8_t gate);
+
+/**
+ * Returns the frequency of the given note in the provided octave.
+ * @param note Note whose frequency must be calculated
+ * @param octave Octave of the note (from 0 to 8)
+ * @return Frequency of the note in Hz, or 0 for rests
+ */
+double buzzer_get_note_freq(buzzer_note_t note, uint8_t octave);
+
+/**
+ * Prepares a transposition, splitting it into whole semitones and the ratio of the cents left over, so applying it to
+ * a note doesn't need any power calculation.
+ * @param transpose Transposition to prepare
+ * @param cents Interval to transpose by, in cents (100 per semitone). Negative values lower the pitch.
+ * @return ESP_OK if the transposition was prepared, ESP_FAIL if the arguments are invalid or the interval is larger
+ * than BUZZER_TRANSPOSE_MAX_CENTS
+ */
+esp_err_t buzzer_transpose_init(buzzer_transpose_t *transpose, int32_t cents);
+
+/**
+ * Returns the frequency of the given note in the provided octave, transposed. Notes moved out of the table keep their
+ * pitch class but are clamped to octaves 0 to 8, like with buzzer_get_note_freq.
+ * @param transpose Transposition to apply, or NULL for none
+ * @param note Note whose frequency must be calculated
+ * @param octave Octave of the note (from 0 to 8)
+ * @return Frequency of the transposed note in Hz, or 0 for rests
+ */
+double buzzer_get_transposed_freq(const buzzer_transpose_t *transpose, buzzer_note_t note, uint8_t octave);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif //GYRO_READER_BUZZER_H
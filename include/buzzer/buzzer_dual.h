@@ -0,0 +1,111 @@
+/**
+ * @file buzzer_dual.h
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the declarations for dual-tone output, which plays two frequencies at once on a pair of
+ * buzzers, and can stream DTMF digits.
+ *
+ * @details Both tones are started in phase with buzzer_play_group and share their scheduling: a single one-shot
+ * esp_timer ends them (and starts the next digit), so none of the functions block. Each buzzer must use its own LEDC
+ * timer, as a timer sets the frequency of all its channels. The GPIO matrix routes a single output signal to each pin,
+ * so the buzzers must be on different GPIOs: tie them to the transducer through a resistor each to mix the tones. If
+ * both buzzers share a GPIO, only the channel configured last reaches the pin.
+ */
+
+#ifndef GYRO_READER_BUZZER_DUAL_H
+#define GYRO_READER_BUZZER_DUAL_H
+
+#include <esp_err.h>
+#include "buzzer/buzzer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BUZZER_DTMF_TONE_MS 70 ///< Suggested duration of each DTMF digit
+#define BUZZER_DTMF_GAP_MS 70 ///< Suggested silence between DTMF digits
+
+typedef struct _buzzer_dual_t buzzer_dual_t;
+
+/**
+ * Callback invoked from the esp_timer task when the tones or digits finish by themselves (not when they're stopped).
+ * @param dual Dual-tone output which finished
+ * @param arg User argument provided when the tones were started
+ */
+typedef void (*buzzer_dual_done_cb_t)(buzzer_dual_t *dual, void *arg);
+
+/**
+ * Creates a dual-tone output from two initialized buzzers, which it takes over while playing.
+ * @param low Buzzer playing the lower tone
+ * @param high Buzzer playing the higher tone
+ * @return Pointer to the created dual-tone output, or NULL if it couldn't be created
+ */
+buzzer_dual_t *buzzer_dual_create(buzzer_t *low, buzzer_t *high);
+
+/**
+ * Stops the dual-tone output, waits until its callback has finished using it, and frees the associated memory. The
+ * buzzers are left initialized.
+ *
+ * @details Like buzzer_sound_destroy, this must not be called from an esp_timer callback (including the done callback
+ * of the output), as the callback it waits for couldn't run. Such calls are detected, logged and ignored.
+ * @param dual Dual-tone output to destroy
+ */
+void buzzer_dual_destroy(buzzer_dual_t *dual);
+
+/**
+ * Plays two tones for the provided time, starting them in phase. Returns right away.
+ * @param dual Dual-tone output to play on
+ * @param low_hz Frequency of the lower tone in Hz
+ * @param high_hz Frequency of the higher tone in Hz
+ * @param time_ms Time to play the tones for, in milliseconds
+ * @param done Optional callback invoked when the time is over
+ * @param arg User argument passed to done
+ * @return ESP_OK if the tones were started, ESP_FAIL if the arguments are invalid
+ */
+esp_err_t buzzer_dual_play_ms(buzzer_dual_t *dual, uint32_t low_hz, uint32_t high_hz, uint32_t time_ms,
+                              buzzer_dual_done_cb_t done, void *arg);
+
+/**
+ * Streams a string of DTMF digits at a fixed rate. Returns right away.
+ *
+ * @details The string must stay valid until the digits end or are stopped. Only one task may control a given
+ * dual-tone output.
+ * @param dual Dual-tone output to play on
+ * @param digits Digits to play, from "0123456789ABCD*#" (letters are case insensitive)
+ * @param tone_ms Duration of each digit in milliseconds (see BUZZER_DTMF_TONE_MS)
+ * @param gap_ms Silence between digits in milliseconds (see BUZZER_DTMF_GAP_MS)
+ * @param done Optional callback invoked when the last digit ends
+ * @param arg User argument passed to done
+ * @return ESP_OK if the digits were started, ESP_FAIL if the arguments are invalid or a digit isn't a DTMF digit
+ */
+esp_err_t buzzer_dual_play_dtmf(buzzer_dual_t *dual, const char *digits, uint16_t tone_ms, uint16_t gap_ms,
+                                buzzer_dual_done_cb_t done, void *arg);
+
+/**
+ * Stops the tones or digits being played, if any. Returns right away.
+ * @param dual Dual-tone output to stop
+ * @return ESP_OK if the request was sent, ESP_FAIL if the arguments are invalid
+ */
+esp_err_t buzzer_dual_stop(buzzer_dual_t *dual);
+
+/**
+ * Returns whether the dual-tone output is playing tones or digits.
+ * @param dual Dual-tone output to check
+ * @return true if tones or digits are being played (or are about to start), false otherwise
+ */
+bool buzzer_dual_is_playing(buzzer_dual_t *dual);
+
+/**
+ * Looks up the frequencies of a DTMF digit.
+ * @param digit Digit, from "0123456789ABCD*#" (letters are case insensitive)
+ * @param low_hz Where the frequency of the row (lower) tone is stored, in Hz
+ * @param high_hz Where the frequency of the column (higher) tone is stored, in Hz
+ * @return ESP_OK if the digit was found, ESP_FAIL otherwise
+ */
+esp_err_t buzzer_dtmf_get_freqs(char digit, uint16_t *low_hz, uint16_t *high_hz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //GYRO_READER_BUZZER_DUAL_H
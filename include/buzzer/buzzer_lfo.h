@@ -0,0 +1,79 @@
+/**
+ * @file buzzer_lfo.h
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the declarations for the low-frequency oscillator, which adds vibrato (frequency modulation)
+ * and tremolo (duty modulation) to whatever a buzzer plays, making long tones less fatiguing.
+ *
+ * @details The oscillator is advanced by its own one-shot esp_timer, a few hundred times per second, and each update
+ * only takes a sine table lookup, a couple of fixed-point multiplications and a buzzer_modulate call. It modulates the
+ * buzzer around the frequency it's set to, so it keeps working while a player or a sound changes the notes. As the
+ * LEDC timer is set in whole Hertzs, vibrato is smoother at higher pitches.
+ */
+
+#ifndef GYRO_READER_BUZZER_LFO_H
+#define GYRO_READER_BUZZER_LFO_H
+
+#include <esp_err.h>
+#include "buzzer/buzzer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BUZZER_LFO_DEFAULT_UPDATE_HZ 200 ///< Default amount of updates per second
+#define BUZZER_LFO_MAX_UPDATE_HZ 1000 ///< Largest amount of updates per second
+#define BUZZER_LFO_MAX_VIBRATO_CENTS 1200 ///< Largest vibrato depth, in cents (an octave)
+
+typedef struct _buzzer_lfo_t buzzer_lfo_t;
+
+/**
+ * Structure describing the modulation applied by an oscillator
+ */
+typedef struct _buzzer_lfo_config_t {
+    uint16_t rate_centihz; ///< Frequency of the oscillator in hundredths of Hz (550 is 5.5 Hz), below update_hz / 2
+    uint16_t vibrato_cents; ///< Largest frequency deviation, up and down, in cents. 0 for no vibrato.
+    uint8_t tremolo_percent; ///< Largest duty reduction, in percent of the duty. 0 for no tremolo.
+    uint16_t update_hz; ///< Updates per second, up to BUZZER_LFO_MAX_UPDATE_HZ. 0 for BUZZER_LFO_DEFAULT_UPDATE_HZ.
+} buzzer_lfo_config_t;
+
+/**
+ * Creates an oscillator for the provided buzzer. It doesn't modulate anything until it's started.
+ * @param buzzer Buzzer to modulate
+ * @return Pointer to the created oscillator, or NULL if it couldn't be created
+ */
+buzzer_lfo_t *buzzer_lfo_create(buzzer_t *buzzer);
+
+/**
+ * Stops the oscillator, waits until its callback has finished using it, and frees the associated memory.
+ *
+ * @details Waiting for the callback blocks the calling task, so this must not be called from an esp_timer callback
+ * (like the done callbacks of sounds): the callback would never get to run. Such calls are detected, logged and
+ * ignored, leaving the oscillator alive.
+ * @param lfo Oscillator to destroy
+ */
+void buzzer_lfo_destroy(buzzer_lfo_t *lfo);
+
+/**
+ * Starts modulating the buzzer, or changes the modulation if the oscillator is already running. The phase carries on,
+ * so changes don't click. Returns right away.
+ *
+ * @details Only one task may control a given oscillator.
+ * @param lfo Oscillator to start
+ * @param config Modulation to apply, which is copied
+ * @return ESP_OK if the oscillator was started, ESP_FAIL if the arguments are invalid
+ */
+esp_err_t buzzer_lfo_start(buzzer_lfo_t *lfo, const buzzer_lfo_config_t *config);
+
+/**
+ * Stops modulating the buzzer, restoring its frequency and duty. Returns right away.
+ * @param lfo Oscillator to stop
+ * @return ESP_OK if the request was sent, ESP_FAIL if the arguments are invalid
+ */
+esp_err_t buzzer_lfo_stop(buzzer_lfo_t *lfo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //GYRO_READER_BUZZER_LFO_H
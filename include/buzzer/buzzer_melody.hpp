@@ -0,0 +1,208 @@
+/**
+ * @file buzzer_melody.hpp
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the C++ melody literals, which compile a text notation into buzzer_compiled_note_t arrays
+ * at compile time, so no parsing nor note table lookups happen at runtime.
+ *
+ * @details Melodies are written as whitespace separated notes. Each note is a letter from A to G, an optional
+ * accidental (# for sharp, b for flat), the octave (0 to 8) and its duration: w (semibreve), h (minim), q (crotchet),
+ * e (quaver) or s (semiquaver), optionally followed by a dot. Rests are written as R followed by their duration, and
+ * | can be used as a bar line to make long melodies easier to read.
+ *
+ * @code
+ * using namespace buzzer::literals;
+ * static constexpr auto tune = "C4e. C4s D4q C4q F4q E4h"_melody; // Lives in .rodata
+ * buzzer::play(buzzer, tune, 120);
+ * buzzer::play(buzzer, tune, 120, BUZZER_DUTY_NARROW); // Thinner timbre, only for this time
+ * @endcode
+ *
+ * A malformed melody doesn't compile (the call to melody_syntax_error isn't a constant expression). Requires C++17.
+ */
+
+#ifndef GYRO_READER_BUZZER_MELODY_HPP
+#define GYRO_READER_BUZZER_MELODY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "buzzer/buzzer.h"
+
+namespace buzzer {
+
+    namespace detail {
+        constexpr uint16_t note_base_freq[] = {BUZZER_NOTE_BASE_FREQS}; ///< Same table the C module uses
+        constexpr int notes_per_octave = 12; ///< Semitones in an octave
+        constexpr int max_octave = 8; ///< Highest octave, whose frequencies are the ones in note_base_freq
+
+        /**
+         * Deliberately not constexpr: reaching it while compiling a melody makes the compilation fail, pointing at
+         * the malformed melody.
+         */
+        void melody_syntax_error();
+
+        constexpr bool is_space(char c) {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '|';
+        }
+
+        /**
+         * Returns the semitone (0 for C, 11 for B) of a note letter, or -1 if it isn't one.
+         */
+        constexpr int note_semitone(char c) {
+            switch (c) {
+                case 'C': return 0;
+                case 'D': return 2;
+                case 'E': return 4;
+                case 'F': return 5;
+                case 'G': return 7;
+                case 'A': return 9;
+                case 'B': return 11;
+                default: return -1;
+            }
+        }
+
+        /**
+         * Returns the duration, in eighths of a pulse (same as buzzer_note_type_t), of a duration letter.
+         */
+        constexpr int note_length(char c) {
+            switch (c) {
+                case 'w': return BUZZER_NTYPE_SEMIBREVE;
+                case 'h': return BUZZER_NTYPE_MINIM;
+                case 'q': return BUZZER_NTYPE_CROTCHET;
+                case 'e': return BUZZER_NTYPE_QUAVER;
+                case 's': return BUZZER_NTYPE_SEMIQUAVER;
+                default: melody_syntax_error(); return 0;
+            }
+        }
+
+        /**
+         * Counts the notes in a melody, so the size of the compiled array is known before compiling it.
+         */
+        constexpr std::size_t count_notes(const char *text, std::size_t len) {
+            std::size_t count = 0;
+            bool in_note = false;
+            for (std::size_t i = 0; i < len; i++) {
+                bool space = is_space(text[i]);
+                if (!space && !in_note) count++;
+                in_note = !space;
+            }
+            return count;
+        }
+
+        /**
+         * Compiles a single note starting at text[pos], leaving pos after it.
+         */
+        constexpr buzzer_compiled_note_t compile_note(const char *text, std::size_t len, std::size_t &pos) {
+            while (pos < len && is_space(text[pos])) pos++;
+
+            uint16_t freq_hz = 0;
+            if (text[pos] == 'R') {
+                pos++;
+            } else {
+                int semitone = note_semitone(text[pos++]);
+                if (semitone < 0 || pos >= len) melody_syntax_error();
+                if (text[pos] == '#' || text[pos] == 'b') {
+                    semitone += text[pos] == '#' ? 1 : -1;
+                    pos++;
+                }
+                if (pos >= len || text[pos] < '0' || text[pos] > '0' + max_octave) melody_syntax_error();
+                int octave = text[pos++] - '0';
+
+                // Accidentals can move the note into the neighbouring octave (Cb4 is B3, B#4 is C5)
+                int pitch = octave * notes_per_octave + semitone;
+                if (pitch < 0 || pitch >= (max_octave + 1) * notes_per_octave) melody_syntax_error();
+                octave = pitch / notes_per_octave;
+                freq_hz = note_base_freq[pitch % notes_per_octave] >> (max_octave - octave);
+            }
+
+            if (pos >= len) melody_syntax_error();
+            int type = note_length(text[pos++]);
+            if (pos < len && text[pos] == '.') { // Dotted notes last half as long again
+                type += type / 2;
+                pos++;
+            }
+            if (pos < len && !is_space(text[pos])) melody_syntax_error();
+            return buzzer_compiled_note_t{freq_hz, static_cast<uint8_t>(type)};
+        }
+    }
+
+    /**
+     * A melody compiled from text, holding its notes in an array sized exactly for them.
+     * @tparam N Amount of notes in the melody
+     */
+    template<std::size_t N>
+    struct compiled_melody {
+        buzzer_compiled_note_t notes[N]; ///< Compiled notes, in playing order
+
+        /**
+         * Returns the C view of this melody, to be used with buzzer_play_compiled_melody.
+         * @param duty Duty (timbre) to play the melody with, in percent (see BUZZER_DUTY_*). 0 keeps the buzzer's duty.
+         */
+        constexpr buzzer_compiled_melody_t melody(uint8_t duty = 0) const {
+            return buzzer_compiled_melody_t{notes, N, duty};
+        }
+
+        static constexpr std::size_t size() {
+            return N;
+        }
+    };
+
+    /**
+     * Compiles a melody written in text notation. Meant to be called from the _melody literal.
+     * @tparam N Amount of notes in the melody, as counted by detail::count_notes
+     */
+    template<std::size_t N>
+    constexpr compiled_melody<N> compile(const char *text, std::size_t len) {
+        compiled_melody<N> result{};
+        std::size_t pos = 0;
+        for (std::size_t i = 0; i < N; i++) result.notes[i] = detail::compile_note(text, len, pos);
+        return result;
+    }
+
+    /**
+     * Plays a compiled melody on the buzzer at the given speed in beats per minute, optionally with its own duty, which
+     * is only kept while it plays.
+     * @return ESP_OK if the operation was executed successfully, ESP_FAIL if something went wrong
+     */
+    template<std::size_t N>
+    esp_err_t play(buzzer_t *buzzer, const compiled_melody<N> &melody, uint32_t bpm, uint8_t duty = 0) {
+        const buzzer_compiled_melody_t view = melody.melody(duty);
+        return buzzer_play_compiled_melody(buzzer, &view, bpm);
+    }
+
+    namespace literals {
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+        /**
+         * String usable as a template argument, so the melody text is known at compile time (C++20)
+         */
+        template<std::size_t L>
+        struct melody_text {
+            char text[L];
+
+            constexpr melody_text(const char (&str)[L]) : text{} {
+                for (std::size_t i = 0; i < L; i++) text[i] = str[i];
+            }
+        };
+
+        template<melody_text Text>
+        constexpr auto operator ""_melody() {
+            constexpr std::size_t len = sizeof(Text.text) - 1; // Without the null terminator
+            return compile<detail::count_notes(Text.text, len)>(Text.text, len);
+        }
+#else
+        /**
+         * Before C++20, the melody text is received as a character pack using the GNU string literal operator
+         * template extension, supported by GCC and Clang.
+         */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+        template<typename CharT, CharT... Chars>
+        constexpr auto operator ""_melody() {
+            constexpr char text[] = {Chars..., '\0'};
+            return compile<detail::count_notes(text, sizeof...(Chars))>(text, sizeof...(Chars));
+        }
+#pragma GCC diagnostic pop
+#endif
+    }
+}
+
+#endif //GYRO_READER_BUZZER_MELODY_HPP
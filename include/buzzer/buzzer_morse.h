@@ -0,0 +1,73 @@
+/**
+ * @file buzzer_morse.h
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the declarations for the Morse code encoder. Text is sent by the callback engine
+ * (buzzer_sound_play_morse), which encodes one character at a time straight from a string or a callback, so no
+ * buffer is ever filled.
+ *
+ * @details Each character is encoded in a single byte: its elements are stored from the least significant bit (1 for
+ * a dah, 0 for a dit), followed by a sentinel bit marking the end. For example, A (.-) is 0b110.
+ */
+
+#ifndef GYRO_READER_BUZZER_MORSE_H
+#define GYRO_READER_BUZZER_MORSE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Callback providing the characters to send, one at a time. Called from the esp_timer task, so it mustn't block.
+ * @param arg User argument provided in the Morse configuration
+ * @return Next character to send, or '\0' once there are no characters left
+ */
+typedef char (*buzzer_morse_source_t)(void *arg);
+
+/**
+ * Structure describing a Morse transmission
+ */
+typedef struct _buzzer_morse_t {
+    const char *text; ///< Text to send, or NULL to take the characters from source
+    buzzer_morse_source_t source; ///< Callback providing the characters to send when there is no text
+    void *source_arg; ///< User argument passed to source
+    uint8_t wpm; ///< Character speed in words per minute, which sets the length of the dits and dahs
+    uint8_t farnsworth_wpm; ///< Overall speed with Farnsworth spacing (lower than wpm), or 0 to use standard spacing
+    uint16_t freq_hz; ///< Frequency of the tone in Hz, or 0 to keep the buzzer's current frequency
+} buzzer_morse_t;
+
+/**
+ * Elements and spaces of a Morse transmission
+ */
+typedef enum {
+    BUZZER_MORSE_DIT, ///< Short element, one unit long
+    BUZZER_MORSE_DAH, ///< Long element, three units long
+    BUZZER_MORSE_ELEMENT_GAP, ///< Silence between the elements of a character, one unit long
+    BUZZER_MORSE_CHAR_GAP, ///< Silence between characters, three units long unless Farnsworth spacing is used
+    BUZZER_MORSE_WORD_GAP, ///< Silence between words, seven units long unless Farnsworth spacing is used
+} buzzer_morse_timing_t;
+
+/**
+ * Encodes a character. Letters are case insensitive.
+ * @param c Character to encode
+ * @return The elements of the character followed by a sentinel bit, or 0 if the character has no Morse code
+ */
+uint8_t buzzer_morse_encode(char c);
+
+/**
+ * Returns the duration of an element or space of the provided transmission. With Farnsworth spacing, the elements
+ * keep their speed and the extra time needed to lower the overall speed is spread over the spaces between
+ * characters and words, in the usual 3:7 ratio.
+ * @param morse Transmission whose timing is calculated
+ * @param timing Element or space whose duration is calculated
+ * @return The duration in microseconds
+ */
+uint32_t buzzer_morse_duration_us(const buzzer_morse_t *morse, buzzer_morse_timing_t timing);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //GYRO_READER_BUZZER_MORSE_H
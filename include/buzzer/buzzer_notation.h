@@ -0,0 +1,94 @@
+/**
+ * @file buzzer_notation.h
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the declarations for the text notation parser, which turns melodies typed as text (for
+ * example, into the console) into notes queued in a player as soon as each of them is complete.
+ *
+ * @details The parser is incremental: bytes can be fed as they arrive, in chunks of any size, and no line is
+ * buffered. Each note is written as:
+ * - Its pitch, as an upper case letter from A to G, or R for a rest.
+ * - Optionally, an accidental: # (sharp) or b (flat).
+ * - Optionally, its octave, as a single digit. Otherwise, the octave of the previous note is used (4 at first).
+ * - Optionally after some spaces, its duration, as a lower case letter: w (semibreve), h (minim), q (crotchet),
+ *   e (quaver) or s (semiquaver), followed by a dot if it's dotted. Otherwise, the duration of the previous note is
+ *   used (a crotchet at first).
+ *
+ * Notes are separated by spaces, commas, bars (|) or new lines, so "C4q D4e R q" is a crotchet C, a quaver D and a
+ * crotchet rest. A note is queued once a character which can't extend it arrives: the one after its duration, or
+ * the separator or pitch following it. New lines always complete the pending note. Invalid notes are skipped up to
+ * the next separator.
+ */
+
+#ifndef GYRO_READER_BUZZER_NOTATION_H
+#define GYRO_READER_BUZZER_NOTATION_H
+
+#include <stdio.h>
+#include <esp_err.h>
+#include "buzzer/buzzer_player.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BUZZER_NOTATION_DEFAULT_OCTAVE 4 ///< Octave of the notes until one is given
+
+typedef struct _buzzer_notation_t buzzer_notation_t;
+
+/**
+ * Creates a parser which queues the notes it reads into the provided player.
+ *
+ * @details The parser pushes events into the player, so it must be the player's only producer, and it must be fed
+ * from a single task.
+ * @param player Player to queue the notes in
+ * @param bpm Speed to play the notes at (in beats per minute)
+ * @return Pointer to the created parser, or NULL if it couldn't be created
+ */
+buzzer_notation_t *buzzer_notation_create(buzzer_player_t *player, uint32_t bpm);
+
+/**
+ * Frees the memory associated with the parser. A pending note is discarded, so call buzzer_notation_flush first to
+ * play it. The player is left untouched.
+ * @param parser Parser to destroy
+ */
+void buzzer_notation_destroy(buzzer_notation_t *parser);
+
+/**
+ * Feeds the provided bytes to the parser, queueing every note they complete. Never blocks.
+ * @param parser Parser to feed
+ * @param data Bytes to parse
+ * @param length Amount of bytes to parse
+ * @return ESP_OK if every completed note was queued, ESP_FAIL if a note was invalid, the player's ring buffer was
+ * full or the arguments are invalid
+ */
+esp_err_t buzzer_notation_feed(buzzer_notation_t *parser, const char *data, size_t length);
+
+/**
+ * Feeds the parser with the bytes read from a stream until it ends, and then queues the pending note, if any. On the
+ * device, stdin reads from the console UART, so melodies can be typed in.
+ *
+ * @details Blocks for as long as reading the stream does. As notes are queued without blocking, streams should be
+ * read at about the speed they're played (like a human typing); faster sources should use buzzer_notation_feed and
+ * watch the player's level. On the device, stdin only blocks once the UART driver is installed for the console UART
+ * and the VFS is told to use it (uart_driver_install and esp_vfs_dev_uart_use_driver). Otherwise reads don't wait for
+ * data, so fgetc returns EOF as soon as nothing has been typed, and this function returns right away.
+ * @param parser Parser to feed
+ * @param stream Stream to read from, such as stdin
+ * @return ESP_OK if every note was queued, ESP_FAIL if a note was invalid, the player's ring buffer was full, the
+ * stream failed or the arguments are invalid
+ */
+esp_err_t buzzer_notation_feed_stream(buzzer_notation_t *parser, FILE *stream);
+
+/**
+ * Queues the pending note, if any, which is waiting for a character to tell whether it's complete.
+ * @param parser Parser to flush
+ * @return ESP_OK if there was no pending note or it was queued, ESP_FAIL if the note was invalid, the player's ring
+ * buffer was full or the arguments are invalid
+ */
+esp_err_t buzzer_notation_flush(buzzer_notation_t *parser);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //GYRO_READER_BUZZER_NOTATION_H
@@ -0,0 +1,88 @@
+/**
+ * @file buzzer_packed.h
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the declarations for packed melodies, a compressed format meant to be stored in flash, and
+ * the streaming decoder that unpacks them one note at a time.
+ *
+ * @details A packed melody is a sequence of byte operations applied to a small decoder state (current pitch and
+ * current note type). Pitches are stored as deltas from the previous note, note types are only stored when they
+ * change, and repeated phrases are stored as back-references that replay earlier operations:
+ *
+ * | Byte(s)                 | Operation                                                                  |
+ * |-------------------------|----------------------------------------------------------------------------|
+ * | `0x00`-`0x3F`           | Note with the current type, `byte - 32` semitones from the previous note   |
+ * | `0x40`-`0x49`           | Sets the current type (index in the order of buzzer_note_type_t)           |
+ * | `0x50`-`0x59`           | Rest of the given type index. The current type isn't changed               |
+ * | `0x60` `p`              | Note with the current type and absolute pitch `p` (`octave * 12 + note`)  |
+ * | `0x80`-`0xFF` `lo` `hi` | Replays `(byte & 0x7F) + 1` operations starting `lo + hi * 256` bytes back |
+ *
+ * Back-references can't point into another back-reference. The packer in tools/buzzer_pack.py generates this format
+ * from regular melodies.
+ */
+
+#ifndef GYRO_READER_BUZZER_PACKED_H
+#define GYRO_READER_BUZZER_PACKED_H
+
+#include <esp_err.h>
+#include "buzzer/buzzer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BUZZER_PACKED_INITIAL_PITCH 48 ///< Pitch the decoder starts at (C4), which the first delta is relative to
+
+/**
+ * Structure with a packed melody, which can be declared const so it stays in flash
+ */
+typedef struct _buzzer_packed_melody_t {
+    const uint8_t *data; ///< Pointer to the packed operations
+    uint32_t size; ///< Size of the packed operations in bytes
+} buzzer_packed_melody_t;
+
+/**
+ * Structure with the state of the streaming decoder. It has a fixed size regardless of the melody being unpacked.
+ */
+typedef struct _buzzer_unpacker_t {
+    const uint8_t *data; ///< Packed operations being decoded
+    uint32_t size; ///< Size of the packed operations in bytes
+    uint32_t pos; ///< Offset of the next operation in the main stream
+    uint32_t ref_pos; ///< Offset of the next operation inside the back-reference being replayed
+    uint8_t ref_left; ///< Operations left to replay from the back-reference, 0 if not replaying one
+    uint8_t pitch; ///< Pitch of the last note (octave * 12 + note)
+    uint8_t type_idx; ///< Index of the current note type
+    bool malformed; ///< Set when the decoder stopped at malformed data instead of at the end of the melody
+} buzzer_unpacker_t;
+
+/**
+ * Prepares a decoder to unpack the provided melody from its beginning.
+ * @param unpacker Decoder to prepare
+ * @param melody Packed melody to unpack
+ */
+void buzzer_unpacker_init(buzzer_unpacker_t *unpacker, const buzzer_packed_melody_t *melody);
+
+/**
+ * Unpacks the next note of the melody.
+ * @param unpacker Decoder to take the note from
+ * @param note Where the unpacked note is stored
+ * @return true if a note was unpacked, false when the melody is over or the data is malformed (which sets
+ * unpacker->malformed)
+ */
+bool buzzer_unpacker_next(buzzer_unpacker_t *unpacker, buzzer_musical_note_t *note);
+
+/**
+ * Plays the provided packed melody in the buzzer, unpacking it note by note, at the given speed in beats per minute.
+ * @param buzzer Buzzer to play the melody on
+ * @param melody Packed melody to play
+ * @param bpm Speed to play the melody at (in beats per minute)
+ * @return ESP_OK if the whole melody was played, ESP_FAIL if something went wrong or the data is malformed (the notes
+ * before the malformed operation are played)
+ */
+esp_err_t buzzer_play_packed_melody(buzzer_t *buzzer, const buzzer_packed_melody_t *melody, uint32_t bpm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //GYRO_READER_BUZZER_PACKED_H
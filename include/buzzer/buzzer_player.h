@@ -0,0 +1,247 @@
+/**
+ * @file buzzer_player.h
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the declarations for the asynchronous buzzer player, which plays note events from a
+ * lock-free single-producer/single-consumer ring buffer in a background task. Whole melodies can also be loaded into
+ * the player, which then plays them with pause, resume, seek and stop controls.
+ */
+
+#ifndef GYRO_READER_BUZZER_PLAYER_H
+#define GYRO_READER_BUZZER_PLAYER_H
+
+#include <esp_err.h>
+#include "buzzer/buzzer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BUZZER_PLAYER_DEFAULT_QUEUE_LEN 32 ///< Default amount of events the player's ring buffer can hold
+#define BUZZER_PLAYER_MAX_QUEUE_LEN 65536 ///< Largest amount of events the player's ring buffer can hold
+#define BUZZER_PLAYER_TASK_STACK 2048 ///< Default stack size of the player task, in bytes
+#define BUZZER_PLAYER_TASK_PRIORITY 5 ///< Default FreeRTOS priority of the player task
+
+/**
+ * Structure describing a single event to be played by the player: a frequency held during some time, optionally
+ * followed by silence (articulation).
+ */
+typedef struct _buzzer_event_t {
+    uint32_t freq_hz; ///< Frequency to play in Hz, or 0 to rest (silence) during the event
+    uint32_t duration_ms; ///< Duration of the event in milliseconds
+    uint32_t gate_ms; ///< Time the frequency sounds for before the buzzer is silenced for the rest of the event. 0 (or
+                      ///< anything from duration_ms up) sounds for the whole event.
+} buzzer_event_t;
+
+typedef struct _buzzer_player_t buzzer_player_t;
+
+/**
+ * Enumeration containing the states of the melody playback of a player
+ */
+typedef enum _buzzer_player_state_t {
+    BUZZER_PLAYER_IDLE,    ///< No melody is loaded, so queued events are played
+    BUZZER_PLAYER_PLAYING, ///< A melody is being played
+    BUZZER_PLAYER_PAUSED,  ///< A melody is loaded, but paused
+} buzzer_player_state_t;
+
+/**
+ * Callback invoked from the player task when the amount of queued events drops to the low watermark. It mustn't
+ * destroy the player, which is refused from the player task.
+ * @param player Player whose ring buffer reached the low watermark
+ * @param arg User argument provided in the player configuration
+ */
+typedef void (*buzzer_player_watermark_cb_t)(buzzer_player_t *player, void *arg);
+
+/**
+ * Structure with the configuration used when creating a player
+ */
+typedef struct _buzzer_player_config_t {
+    uint32_t queue_len; ///< Capacity of the ring buffer in events, up to BUZZER_PLAYER_MAX_QUEUE_LEN. Rounded up to
+                        ///< a power of two, 0 means default
+    uint32_t low_watermark; ///< Amount of queued events at which on_low_watermark is called
+    buzzer_player_watermark_cb_t on_low_watermark; ///< Optional callback to request more events from the producer
+    void *arg; ///< User argument passed to on_low_watermark
+    uint32_t task_stack; ///< Stack size of the player task in bytes, 0 means BUZZER_PLAYER_TASK_STACK
+    uint8_t task_priority; ///< FreeRTOS priority of the player task, 0 means BUZZER_PLAYER_TASK_PRIORITY
+    bool task_pinned; ///< Whether the player task is pinned to task_core. Otherwise it can run on any core.
+    uint8_t task_core; ///< Core the player task is pinned to, if task_pinned is set. Must be below portNUM_PROCESSORS.
+} buzzer_player_config_t;
+
+/**
+ * Structure with the counters kept by the player. They're only updated by the player task and the producer, so
+ * reading them from another task gives a snapshot which may be slightly out of date.
+ */
+typedef struct _buzzer_player_stats_t {
+    uint32_t pushed; ///< Events successfully pushed into the ring buffer
+    uint32_t played; ///< Events taken from the ring buffer and played
+    uint32_t overruns; ///< Pushes rejected because the ring buffer was full
+    uint32_t underruns; ///< Times the ring buffer ran empty while events were being played
+    uint32_t high_watermark; ///< Maximum amount of events that have been queued at the same time
+    uint32_t wakeups; ///< Times the player task has been woken up to start a new event
+    uint64_t sound_us; ///< Total time the buzzer has been sounding, which is when the chip is kept awake (with power
+                       ///< management enabled) and most of the current is drawn
+    uint32_t run_us; ///< Duration of the last run of events (played back to back until the ring buffer ran empty, or
+                     ///< until the melody ended or was paused)
+    uint32_t run_sound_us; ///< Time the buzzer was sounding during the last run
+    uint32_t run_wakeups; ///< Wakeups of the player task during the last run
+    uint64_t awake_us; ///< Total time the player task has been awake, measured between its wakeups and sleeps. It
+                       ///< includes the time it was preempted while awake, so it's an upper bound of its CPU time.
+    uint32_t run_awake_us; ///< Time the player task was awake during the last run (a whole melody, if it wasn't
+                           ///< paused)
+    uint32_t max_late_us; ///< Largest delay between the end of an event and the player task starting the next one
+    uint32_t run_max_late_us; ///< Largest delay between the end of an event and the start of the next one during the
+                              ///< last run
+    uint32_t stack_free_min; ///< Least stack the player task has had left, in bytes, as FreeRTOS's high-water mark.
+                             ///< Use it to size task_stack.
+} buzzer_player_stats_t;
+
+/**
+ * Creates a player for the provided buzzer and starts its background task.
+ *
+ * @details The player takes ownership of the buzzer's output while it exists, so the blocking functions shouldn't be
+ * used on the same buzzer at the same time.
+ * @param buzzer Buzzer the events will be played on
+ * @param config Player configuration, or NULL to use the defaults
+ * @return Pointer to the created player, or NULL if it couldn't be created (or the queue length is above
+ * BUZZER_PLAYER_MAX_QUEUE_LEN, or the task is pinned to a core which doesn't exist)
+ */
+buzzer_player_t *buzzer_player_create(buzzer_t *buzzer, const buzzer_player_config_t *config);
+
+/**
+ * Stops the player task, silences the buzzer and frees the associated memory with the player.
+ *
+ * @details Must not be called from the player task (that is, from on_low_watermark), as it waits for the task to
+ * finish. Such calls are refused, leaving the player as it was.
+ * @param player Player to destroy
+ */
+void buzzer_player_destroy(buzzer_player_t *player);
+
+/**
+ * Queues an event to be played after the ones already queued. Never blocks.
+ *
+ * @details Only one task may push events into a given player (single producer). Must not be called from an ISR.
+ * @param player Player to queue the event in
+ * @param event Event to queue
+ * @return ESP_OK if the event was queued, ESP_FAIL if the ring buffer was full or the arguments are invalid
+ */
+esp_err_t buzzer_player_push(buzzer_player_t *player, const buzzer_event_t *event);
+
+/**
+ * Queues a musical note to be played at the given speed, converting it into an event. Never blocks.
+ *
+ * @details The note is transposed and tuned for the buzzer's timer like with buzzer_set_transposed_note. Same
+ * restrictions as buzzer_player_push apply.
+ * @param player Player to queue the note in
+ * @param note Musical note to queue
+ * @param bpm Speed to play the note at (in beats per minute)
+ * @return ESP_OK if the note was queued, ESP_FAIL if the ring buffer was full or the arguments are invalid
+ */
+esp_err_t buzzer_player_push_note(buzzer_player_t *player, const buzzer_musical_note_t *note, uint32_t bpm);
+
+/**
+ * Returns the amount of events currently waiting in the player's ring buffer.
+ * @param player Player to check
+ * @return Amount of queued events
+ */
+uint32_t buzzer_player_get_level(buzzer_player_t *player);
+
+/**
+ * Copies the player's counters into the provided structure.
+ * @param player Player whose counters must be read
+ * @param stats Structure where the counters are copied
+ * @return ESP_OK if the counters were copied, ESP_FAIL if the arguments are invalid
+ */
+esp_err_t buzzer_player_get_stats(buzzer_player_t *player, buzzer_player_stats_t *stats);
+
+/**
+ * Loads a melody into the player and starts playing it from the beginning, replacing the melody being played, if any.
+ * Returns right away.
+ *
+ * @details A time index with the start of every note is built when the melody is loaded, so seeking doesn't have to go
+ * through the notes. The looped section of the melody is repeated with the same timing as any other note, and
+ * positions are always relative to the start of the melody, so they go back when the loop wraps around. The melody
+ * must stay valid until it ends or is stopped. A melody with a duty sets it when it's loaded, and the previous duty is
+ * set back once it ends or is stopped. While a melody is loaded, queued events wait in the ring buffer, and they're
+ * played after it. Control functions can be called from any task, but not from an ISR.
+ * @param player Player to play the melody on
+ * @param melody Melody to play
+ * @param bpm Speed to play the melody at (in beats per minute)
+ * @return ESP_OK if the melody was loaded, ESP_FAIL if the time index couldn't be allocated or the arguments (including
+ * the melody, see buzzer_check_melody) are invalid
+ */
+esp_err_t buzzer_player_play_melody(buzzer_player_t *player, const buzzer_melody_t *melody, uint32_t bpm);
+
+/**
+ * Pauses the melody being played, silencing the buzzer. Resuming continues from the same point, even in the middle of
+ * a note.
+ * @param player Player whose melody must be paused
+ * @return ESP_OK if the request was sent, ESP_FAIL if no melody is loaded or the arguments are invalid
+ */
+esp_err_t buzzer_player_pause(buzzer_player_t *player);
+
+/**
+ * Resumes the melody after buzzer_player_pause.
+ * @param player Player whose melody must be resumed
+ * @return ESP_OK if the request was sent, ESP_FAIL if no melody is loaded or the arguments are invalid
+ */
+esp_err_t buzzer_player_resume(buzzer_player_t *player);
+
+/**
+ * Moves the melody to the given position, keeping it paused or playing. Positions past the end finish the melody.
+ * Positions are the same in every pass of the looped section, so seeking counts its repetitions again from the start,
+ * as if the position was reached for the first time.
+ * @param player Player whose melody must be moved
+ * @param position_ms Position to move to, in milliseconds from the start of the melody
+ * @return ESP_OK if the request was sent, ESP_FAIL if no melody is loaded or the arguments are invalid
+ */
+esp_err_t buzzer_player_seek(buzzer_player_t *player, uint32_t position_ms);
+
+/**
+ * Stops and unloads the melody, silencing the buzzer. Queued events are played afterwards.
+ * @param player Player whose melody must be stopped
+ * @return ESP_OK if the request was sent (or there was nothing to stop), ESP_FAIL if the arguments are invalid
+ */
+esp_err_t buzzer_player_stop(buzzer_player_t *player);
+
+/**
+ * Returns the state of the melody playback. Requests which haven't been handled by the player task yet aren't
+ * reflected.
+ * @param player Player to check
+ * @return State of the melody playback
+ */
+buzzer_player_state_t buzzer_player_get_state(buzzer_player_t *player);
+
+/**
+ * Returns the position of the melody being played.
+ * @param player Player to check
+ * @return Position in milliseconds from the start of the melody, or 0 if no melody is loaded
+ */
+uint32_t buzzer_player_get_position_ms(buzzer_player_t *player);
+
+/**
+ * Transposes the notes played from now on, without modifying the melody, so a single melody stored in flash can be
+ * played in any key. The melody being played changes at its next note, and notes pushed with buzzer_player_push_note
+ * afterwards are transposed too. Events pushed with buzzer_player_push aren't.
+ * @param player Player whose notes must be transposed
+ * @param cents Interval to transpose by, in cents (100 per semitone), or 0 to play the notes as written
+ * @return ESP_OK if the transposition was set, ESP_FAIL if the interval is larger than BUZZER_TRANSPOSE_MAX_CENTS or
+ * the arguments are invalid
+ */
+esp_err_t buzzer_player_set_transpose(buzzer_player_t *player, int32_t cents);
+
+/**
+ * Scales the speed of the melodies played from now on, without modifying them or rebuilding their time index. The
+ * melody being played changes at its next note. Positions (as used by buzzer_player_seek and
+ * buzzer_player_get_position_ms) stay in the time of the melody at the bpm it was loaded with, so they don't jump when
+ * the tempo changes.
+ * @param player Player whose melodies must be scaled
+ * @param percent Speed in percent of the bpm melodies are loaded with, where BUZZER_TEMPO_NORMAL plays them as loaded
+ * @return ESP_OK if the tempo was set, ESP_FAIL if the arguments are invalid
+ */
+esp_err_t buzzer_player_set_tempo(buzzer_player_t *player, uint16_t percent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //GYRO_READER_BUZZER_PLAYER_H
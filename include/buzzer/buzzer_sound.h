@@ -0,0 +1,157 @@
+/**
+ * @file buzzer_sound.h
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the declarations for the callback engine, which plays melodies, beep patterns and Morse code
+ * without a task: every note boundary is handled by an esp_timer callback, so each sound only costs its small state
+ * and one esp_timer.
+ *
+ * @details All the callbacks run in the esp_timer task, one after another, so dozens of sounds can play at once
+ * without their own stacks. In exchange, their callbacks change frequencies (which takes the buzzer's frequency mutex)
+ * in the esp_timer task, delaying other esp_timer users by that long. Use the player (buzzer_player.h) instead when
+ * events must be streamed or melodies need seeking.
+ */
+
+#ifndef GYRO_READER_BUZZER_SOUND_H
+#define GYRO_READER_BUZZER_SOUND_H
+
+#include <esp_err.h>
+#include "buzzer/buzzer.h"
+#include "buzzer/buzzer_morse.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BUZZER_PATTERN_MAX_UNITS 32 ///< Maximum amount of units in a beep pattern
+#define BUZZER_PATTERN_FOREVER 0 ///< Repeat count which plays a beep pattern until it's stopped
+
+/**
+ * Structure describing a beep pattern (like a diagnostic beep code) as a bitmask of equally long units. For example,
+ * three short beeps and a long one, with a unit of 100 ms, are {0x1D5, 100, 12, 1, 2000}: the units, from the least
+ * significant bit, are 1 0 1 0 1 0 1 1 1 0 0 0.
+ */
+typedef struct _buzzer_pattern_t {
+    uint32_t bits; ///< One bit per unit, the first one in the least significant bit. Set bits sound, clear bits don't.
+    uint16_t unit_ms; ///< Duration of each unit in milliseconds
+    uint8_t length; ///< Amount of units, up to BUZZER_PATTERN_MAX_UNITS. Trailing clear units separate repetitions.
+    uint8_t repeat; ///< Times the pattern is played, or BUZZER_PATTERN_FOREVER
+    uint16_t freq_hz; ///< Frequency of the beeps in Hz, or 0 to keep the buzzer's current frequency
+} buzzer_pattern_t;
+
+typedef struct _buzzer_sound_t buzzer_sound_t;
+
+/**
+ * Callback invoked from the esp_timer task when a melody or pattern finishes by itself (not when it's stopped).
+ * @param sound Sound whose melody or pattern finished
+ * @param arg User argument provided when the melody was started
+ */
+typedef void (*buzzer_sound_done_cb_t)(buzzer_sound_t *sound, void *arg);
+
+/**
+ * Creates a sound for the provided buzzer. No task is created.
+ *
+ * @details The sound takes ownership of the buzzer's output while it plays, so the blocking functions and players
+ * shouldn't be used on the same buzzer at the same time.
+ * @param buzzer Buzzer the melodies will be played on
+ * @return Pointer to the created sound, or NULL if it couldn't be created
+ */
+buzzer_sound_t *buzzer_sound_create(buzzer_t *buzzer);
+
+/**
+ * Stops the sound, waits until its callback has finished using it, and frees the associated memory.
+ *
+ * @details Waiting for the callback blocks the calling task, so this must not be called from an esp_timer callback
+ * (including the done callbacks of any sound): the callback would never get to run. Such calls are detected, logged
+ * and ignored, leaving the sound alive.
+ * @param sound Sound to destroy
+ */
+void buzzer_sound_destroy(buzzer_sound_t *sound);
+
+/**
+ * Starts playing a melody, replacing the one being played, if any. Returns right away.
+ *
+ * @details Gates, loops and the duty are honored like in the player, which sets the previous duty back once the
+ * melody ends or is stopped. The melody must stay valid until it ends or is stopped.
+ * Only one task may control a given sound.
+ * @param sound Sound to play the melody on
+ * @param melody Melody to play
+ * @param bpm Speed to play the melody at (in beats per minute)
+ * @param done Optional callback invoked when the melody ends
+ * @param arg User argument passed to done
+ * @return ESP_OK if the melody was started, ESP_FAIL if the arguments (including the melody, see
+ * buzzer_check_melody) are invalid
+ */
+esp_err_t buzzer_sound_play_melody(buzzer_sound_t *sound, const buzzer_melody_t *melody, uint32_t bpm,
+                                   buzzer_sound_done_cb_t done, void *arg);
+
+/**
+ * Starts playing a beep pattern, replacing the melody or pattern being played, if any. Returns right away, and takes
+ * the same time no matter the pattern: the timer only fires when the output changes, at the end of each run of equal
+ * units.
+ *
+ * @details The pattern must stay valid until it ends or is stopped. Only one task may control a given sound.
+ * @param sound Sound to play the pattern on
+ * @param pattern Pattern to play
+ * @param done Optional callback invoked when the pattern ends
+ * @param arg User argument passed to done
+ * @return ESP_OK if the pattern was started, ESP_FAIL if the arguments are invalid
+ */
+esp_err_t buzzer_sound_play_pattern(buzzer_sound_t *sound, const buzzer_pattern_t *pattern,
+                                    buzzer_sound_done_cb_t done, void *arg);
+
+/**
+ * Starts sending Morse code, replacing the melody or pattern being played, if any. Returns right away. Characters are
+ * read and encoded one at a time as they're sent, so the text can be produced on the fly by the source callback.
+ *
+ * @details Characters without a Morse code are skipped, and runs of spaces are sent as a single word gap. The
+ * configuration (and its text) must stay valid until the transmission ends or is stopped. Only one task may control a
+ * given sound.
+ * @param sound Sound to send the Morse code on
+ * @param morse Transmission to send
+ * @param done Optional callback invoked when there are no characters left
+ * @param arg User argument passed to done
+ * @return ESP_OK if the transmission was started, ESP_FAIL if the arguments are invalid
+ */
+esp_err_t buzzer_sound_play_morse(buzzer_sound_t *sound, const buzzer_morse_t *morse, buzzer_sound_done_cb_t done,
+                                  void *arg);
+
+/**
+ * Transposes the melody notes played from now on, without modifying the melody. The melody being played changes at
+ * its next note. Beep patterns and Morse code keep their frequency.
+ * @param sound Sound whose notes must be transposed
+ * @param cents Interval to transpose by, in cents (100 per semitone), or 0 to play the notes as written
+ * @return ESP_OK if the transposition was set, ESP_FAIL if the interval is larger than BUZZER_TRANSPOSE_MAX_CENTS or
+ * the arguments are invalid
+ */
+esp_err_t buzzer_sound_set_transpose(buzzer_sound_t *sound, int32_t cents);
+
+/**
+ * Scales the speed of the melodies played from now on, without modifying them. The melody being played changes at
+ * its next note. Beep patterns and Morse code keep their timing.
+ * @param sound Sound whose melodies must be scaled
+ * @param percent Speed in percent of the bpm melodies are started with, where BUZZER_TEMPO_NORMAL plays them as started
+ * @return ESP_OK if the tempo was set, ESP_FAIL if the arguments are invalid
+ */
+esp_err_t buzzer_sound_set_tempo(buzzer_sound_t *sound, uint16_t percent);
+
+/**
+ * Stops the melody or pattern being played, if any, and silences the buzzer. Returns right away: the buzzer is
+ * silenced by the next callback, which runs as soon as the esp_timer task is free.
+ * @param sound Sound to stop
+ * @return ESP_OK if the request was sent, ESP_FAIL if the arguments are invalid
+ */
+esp_err_t buzzer_sound_stop(buzzer_sound_t *sound);
+
+/**
+ * Returns whether the sound is playing a melody or a pattern.
+ * @param sound Sound to check
+ * @return true if a melody or a pattern is being played (or is about to start), false otherwise
+ */
+bool buzzer_sound_is_playing(buzzer_sound_t *sound);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //GYRO_READER_BUZZER_SOUND_H
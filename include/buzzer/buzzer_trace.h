@@ -0,0 +1,125 @@
+/**
+ * @file buzzer_trace.h
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the declarations for the trace recorder, which keeps the last buzzer events (frequency
+ * changes, plays, pauses and player deadlines) with CPU cycle timestamps in a ring buffer, so they can be dumped as
+ * CSV or as VCD for waveform viewers like GTKWave.
+ *
+ * @details Tracing is disabled by default, and then every BUZZER_TRACE call compiles to nothing. Build with
+ * -DBUZZER_TRACE_ENABLE=1 to enable it.
+ */
+
+#ifndef GYRO_READER_BUZZER_TRACE_H
+#define GYRO_READER_BUZZER_TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef BUZZER_TRACE_ENABLE
+#define BUZZER_TRACE_ENABLE 0 ///< Set to 1 at compile time to record buzzer events
+#endif
+
+#ifndef BUZZER_TRACE_LEN
+#define BUZZER_TRACE_LEN 256 ///< Amount of events kept by the recorder. Older events are overwritten.
+#endif
+
+#define BUZZER_TRACE_MAX_SOURCES 8 ///< Amount of different buzzers that can appear in a VCD dump
+
+/**
+ * Enumeration containing the kinds of events that can be recorded
+ */
+typedef enum _buzzer_trace_event_t {
+    BUZZER_TRACE_FREQ,     ///< The frequency was changed. The value is the new frequency in Hz.
+    BUZZER_TRACE_PLAY,     ///< The buzzer started sounding
+    BUZZER_TRACE_PAUSE,    ///< The buzzer stopped sounding
+    BUZZER_TRACE_DEADLINE, ///< A player scheduled the end of an event. The value is the deadline in microseconds.
+} buzzer_trace_event_t;
+
+/**
+ * Structure with a recorded event
+ */
+typedef struct _buzzer_trace_record_t {
+    uint32_t cycles; ///< CPU cycle counter when the event was recorded
+    uint32_t time_us; ///< Low bits of esp_timer_get_time() when the event was recorded, used to unwrap the cycles
+    const void *source; ///< Buzzer the event belongs to
+    uint32_t value; ///< Value associated to the event, depending on its kind
+    uint8_t event; ///< Kind of event, as a buzzer_trace_event_t
+    uint8_t core; ///< Core that recorded the event. Cycle counters of different cores aren't synchronized.
+} buzzer_trace_record_t;
+
+#if BUZZER_TRACE_ENABLE
+
+/// Records an event
+#define BUZZER_TRACE(event, source, value) buzzer_trace_record((event), (source), (uint32_t) (value))
+
+/**
+ * Records an event in the trace. Can be called from any task or ISR.
+ * @param event Kind of event
+ * @param source Buzzer the event belongs to
+ * @param value Value associated to the event
+ */
+void buzzer_trace_record(buzzer_trace_event_t event, const void *source, uint32_t value);
+
+/**
+ * Discards every recorded event.
+ */
+void buzzer_trace_clear(void);
+
+/**
+ * Copies the recorded events, from the oldest to the newest, into the provided array.
+ * @param records Array where the events are copied
+ * @param max Length of the array
+ * @return Amount of events copied
+ */
+uint32_t buzzer_trace_get(buzzer_trace_record_t *records, uint32_t max);
+
+/**
+ * Writes the recorded events as CSV, with one line per event. Not reentrant.
+ * @param out Stream to write to
+ * @return ESP_OK if the events were written, ESP_FAIL if something went wrong
+ */
+esp_err_t buzzer_trace_dump_csv(FILE *out);
+
+/**
+ * Writes the recorded events as a Value Change Dump, with a playing wire, a frequency value and a deadline event per
+ * buzzer. Timestamps are in nanoseconds, converted from the cycles of the default CPU frequency. Not reentrant.
+ * @param out Stream to write to
+ * @return ESP_OK if the events were written, ESP_FAIL if something went wrong
+ */
+esp_err_t buzzer_trace_dump_vcd(FILE *out);
+
+#else
+
+#define BUZZER_TRACE(event, source, value) do {} while (0) ///< Tracing is disabled, so events aren't recorded
+
+static inline void buzzer_trace_clear(void) {}
+
+static inline uint32_t buzzer_trace_get(buzzer_trace_record_t *records, uint32_t max) {
+    (void) records;
+    (void) max;
+    return 0;
+}
+
+static inline esp_err_t buzzer_trace_dump_csv(FILE *out) {
+    (void) out;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static inline esp_err_t buzzer_trace_dump_vcd(FILE *out) {
+    (void) out;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //GYRO_READER_BUZZER_TRACE_H
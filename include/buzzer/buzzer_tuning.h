@@ -0,0 +1,167 @@
+/**
+ * @file buzzer_tuning.h
+ * @author Diego Ortín Fernández
+ * @date 16-10-2026
+ * @brief File containing the declarations for the tuning functions, which model the LEDC timer divider to find out
+ * the frequency actually output for each requested frequency, and how far (in cents) it is from the intended note.
+ *
+ * @details The LEDC timer divides its source clock by a fixed point divider with 8 fractional bits, and then by
+ * 2^resolution. Requested frequencies are rounded to the nearest divider, and notes are first rounded to whole
+ * Hertzs by buzzer_set_freq, so most notes aren't output exactly. tools/buzzer_tuning.py prints the same per-note
+ * error table on the host.
+ */
+
+#ifndef GYRO_READER_BUZZER_TUNING_H
+#define GYRO_READER_BUZZER_TUNING_H
+
+#include <esp_err.h>
+#include <esp_idf_version.h>
+#include <driver/ledc.h>
+#include "buzzer/buzzer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BUZZER_TUNING_APB_CLK_HZ 80000000u ///< Frequency of the APB clock
+#define BUZZER_TUNING_REF_TICK_HZ 1000000u ///< Frequency of the REF_TICK clock
+#define BUZZER_TUNING_RTC8M_HZ 8000000u ///< Nominal frequency of the RTC8M clock
+#define BUZZER_TUNING_RTC8M_TOLERANCE 0.01 ///< Assumed error of the RTC8M clock, which the driver calibrates at boot
+                                           ///< but drifts with temperature
+#define BUZZER_TUNING_DIV_FRAC_BITS 8u ///< Fractional bits of the LEDC timer divider
+#define BUZZER_TUNING_DIV_MIN (1u << BUZZER_TUNING_DIV_FRAC_BITS) ///< Smallest divider (1.0)
+#define BUZZER_TUNING_DIV_MAX 0x3FFFFu ///< Largest divider (18 bits)
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#define BUZZER_TUNING_RTC8M_CLK LEDC_USE_RC_FAST_CLK ///< LEDC clock source of the RTC8M clock
+#else
+#define BUZZER_TUNING_RTC8M_CLK LEDC_USE_RTC8M_CLK ///< LEDC clock source of the RTC8M clock
+#endif
+
+/**
+ * Structure with the evaluation of a clock source and duty resolution over a range of notes
+ */
+typedef struct _buzzer_tuning_result_t {
+    ledc_clk_cfg_t clk_cfg; ///< Clock source evaluated
+    uint8_t duty_res_bits; ///< Duty resolution evaluated, in bits
+    double max_error_cents; ///< Largest absolute error among the notes, in cents
+    double mean_error_cents; ///< Mean absolute error of the notes, in cents
+} buzzer_tuning_result_t;
+
+/**
+ * Structure with the characterization of a clock source, describing what it can play, how accurately, and whether it
+ * lets dynamic frequency scaling (DFS) lower the APB clock while sound is on
+ */
+typedef struct _buzzer_tuning_source_t {
+    ledc_clk_cfg_t clk_cfg; ///< Clock source characterized
+    uint8_t duty_res_bits; ///< Duty resolution characterized, in bits
+    double min_freq_hz; ///< Lowest frequency the timer can output
+    double max_freq_hz; ///< Highest frequency the timer can output
+    double max_error_cents; ///< Largest absolute error among the notes, including the clock tolerance, in cents
+    double mean_error_cents; ///< Mean absolute quantization error of the notes, in cents
+    double clk_error_cents; ///< Worst error of the clock itself, in cents (0 for crystal derived clocks)
+    bool dfs_stable; ///< Whether the clock keeps its frequency when DFS lowers the APB clock, so buzzers using it
+                     ///< don't have to hold the APB clock at its maximum
+} buzzer_tuning_source_t;
+
+/**
+ * Returns the frequency of the given LEDC clock source. The automatic clock is taken as the APB clock, which is the
+ * one the driver picks for the resolutions the buzzer uses, and the RTC8M clock as its nominal frequency.
+ * @param clk_cfg Clock source
+ * @return Frequency of the clock source in Hz, or 0 if it isn't supported
+ */
+uint32_t buzzer_tuning_clk_hz(ledc_clk_cfg_t clk_cfg);
+
+/**
+ * Calculates the divider the LEDC driver sets for the requested frequency.
+ * @param clk_hz Frequency of the timer's clock source in Hz
+ * @param duty_res_bits Duty resolution of the timer, in bits
+ * @param freq_hz Requested frequency in Hz
+ * @return Divider with BUZZER_TUNING_DIV_FRAC_BITS fractional bits, or 0 if the frequency can't be achieved
+ */
+uint32_t buzzer_tuning_divider(uint32_t clk_hz, uint8_t duty_res_bits, uint32_t freq_hz);
+
+/**
+ * Calculates the frequency actually output when the provided frequency is requested.
+ * @param clk_cfg Clock source of the timer
+ * @param duty_res_bits Duty resolution of the timer, in bits
+ * @param freq_hz Requested frequency in Hz
+ * @return Output frequency in Hz, or 0 if the requested frequency can't be achieved
+ */
+double buzzer_tuning_actual_freq(ledc_clk_cfg_t clk_cfg, uint8_t duty_res_bits, uint32_t freq_hz);
+
+/**
+ * Returns the difference between two frequencies in cents (hundredths of a semitone).
+ * @param target_hz Intended frequency
+ * @param actual_hz Output frequency
+ * @return Error in cents, positive if the output is sharp and negative if it's flat
+ */
+double buzzer_tuning_error_cents(double target_hz, double actual_hz);
+
+/**
+ * Finds the whole frequency in Hz that, once quantized by the timer, gets closest to the target frequency. This isn't
+ * always the rounded target, as the divider quantization can be coarser than 1 Hz.
+ * @param clk_cfg Clock source of the timer
+ * @param duty_res_bits Duty resolution of the timer, in bits
+ * @param target_hz Intended frequency
+ * @return Frequency to request in Hz, or 0 if the target can't be achieved
+ */
+uint32_t buzzer_tuning_best_request(ledc_clk_cfg_t clk_cfg, uint8_t duty_res_bits, double target_hz);
+
+/**
+ * Evaluates the tuning error of every note within a range of octaves for a clock source and duty resolution.
+ * @param clk_cfg Clock source of the timer
+ * @param duty_res_bits Duty resolution of the timer, in bits
+ * @param min_octave Lowest octave to evaluate (from 0 to 8)
+ * @param max_octave Highest octave to evaluate (from 0 to 8)
+ * @param result Where the evaluation is stored
+ * @return ESP_OK if every note can be output, ESP_FAIL if some can't or the arguments are invalid
+ */
+esp_err_t buzzer_tuning_evaluate(ledc_clk_cfg_t clk_cfg, uint8_t duty_res_bits, uint8_t min_octave,
+                                 uint8_t max_octave, buzzer_tuning_result_t *result);
+
+/**
+ * Finds the clock source and duty resolution that minimize the largest note error within a range of octaves. Among
+ * equally accurate combinations the highest resolution is picked.
+ * @param min_octave Lowest octave that must be playable (from 0 to 8)
+ * @param max_octave Highest octave that must be playable (from 0 to 8)
+ * @param min_duty_res_bits Lowest duty resolution acceptable, in bits
+ * @param best Where the best combination is stored
+ * @return ESP_OK if a combination was found, ESP_FAIL if none can play the whole range
+ */
+esp_err_t buzzer_tuning_find_best(uint8_t min_octave, uint8_t max_octave, uint8_t min_duty_res_bits,
+                                  buzzer_tuning_result_t *best);
+
+/**
+ * Characterizes a clock source and duty resolution over a range of notes: the frequency range of the timer, the
+ * tuning error (adding the tolerance of the clock itself) and whether it's affected by DFS. Runs the same model as
+ * buzzer_tuning_evaluate, so it works without the hardware.
+ * @param clk_cfg Clock source to characterize
+ * @param duty_res_bits Duty resolution of the timer, in bits
+ * @param min_octave Lowest octave to evaluate (from 0 to 8)
+ * @param max_octave Highest octave to evaluate (from 0 to 8)
+ * @param report Where the characterization is stored. The frequency range is filled in even if some note can't be
+ * played.
+ * @return ESP_OK if every note can be output, ESP_FAIL if some can't or the arguments are invalid
+ */
+esp_err_t buzzer_tuning_characterize(ledc_clk_cfg_t clk_cfg, uint8_t duty_res_bits, uint8_t min_octave,
+                                     uint8_t max_octave, buzzer_tuning_source_t *report);
+
+/**
+ * Finds the cheapest clock source (and its most accurate duty resolution) whose largest note error stays within the
+ * tolerance over a range of octaves. Sources unaffected by DFS are cheaper, as they let the APB clock be lowered while
+ * sound is on: RTC8M is tried first, then REF_TICK and finally APB.
+ * @param min_octave Lowest octave that must be playable (from 0 to 8)
+ * @param max_octave Highest octave that must be playable (from 0 to 8)
+ * @param max_error_cents Largest error acceptable, in cents
+ * @param cheapest Where the characterization of the chosen source is stored
+ * @return ESP_OK if a source was found, ESP_FAIL if none meets the tolerance
+ */
+esp_err_t buzzer_tuning_find_cheapest(uint8_t min_octave, uint8_t max_octave, double max_error_cents,
+                                      buzzer_tuning_source_t *cheapest);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //GYRO_READER_BUZZER_TUNING_H
@@ -0,0 +1,293 @@
+#!/usr/bin/env python3
+"""
+Compiles the melody of a MIDI or MusicXML file into a C array ready to be linked, packed in the format decoded by
+buzzer_packed.c (or as plain buzzer_musical_note_t notes with --notes).
+
+A single monophonic line is extracted: the highest sounding note at any time across every track (drums excluded),
+or only the notes of the track (MIDI) or part (MusicXML) chosen with --track. Onsets are quantized to a grid, and the
+time until the next onset is split into the note types of the library: a note longer than a dotted semibreve is
+held for the longest type that fits and followed by rests. The quantization error is reported to stderr.
+
+Usage: buzzer_import.py song.mid --name song > song_packed.c
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+import xml.etree.ElementTree as ElementTree
+import zipfile
+from fractions import Fraction
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import buzzer_pack  # noqa: E402
+
+# Length of each note type in 1/8 beats, in the order of buzzer_pack.TYPES
+TYPE_UNITS = [48, 32, 24, 16, 12, 8, 6, 4, 3, 2]
+UNITS_PER_BEAT = 8
+GRIDS = {"crotchet": 8, "quaver": 4, "semiquaver": 2}
+DRUM_CHANNEL = 9
+MIDI_PITCH_OFFSET = 12  # MIDI note of C0, which is pitch 0 for the library
+MAX_PITCH = 8 * 12 + 11  # B8
+DEFAULT_TEMPO_US = 500000  # 120 bpm, as assumed by the MIDI standard
+XML_STEPS = {"C": 0, "D": 2, "E": 4, "F": 5, "G": 7, "A": 9, "B": 11}
+
+
+class Note:
+    """Note of the source, timed in beats (crotchets) as fractions so no rounding happens before quantization."""
+
+    def __init__(self, start, end, pitch, track):
+        self.start, self.end, self.pitch, self.track = start, end, pitch, track
+
+
+def read_varlen(data, pos):
+    value = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value = value << 7 | byte & 0x7F
+        if not byte & 0x80:
+            return value, pos
+
+
+def parse_midi(data):
+    """Returns (notes, bpm, tempo changes) from a standard MIDI file."""
+    if data[:4] != b"MThd":
+        sys.exit("Not a MIDI file")
+    header_len, _, tracks, division = struct.unpack(">IHHH", data[4:14])
+    if division & 0x8000:
+        sys.exit("SMPTE time division isn't supported")
+
+    notes, tempos = [], []
+    pos = 8 + header_len
+    for track in range(tracks):
+        if data[pos:pos + 4] != b"MTrk":
+            sys.exit("Track %d is corrupted" % track)
+        end = pos + 8 + struct.unpack(">I", data[pos + 4:pos + 8])[0]
+        pos += 8
+        tick, status, sounding = 0, 0, {}
+        while pos < end:
+            delta, pos = read_varlen(data, pos)
+            tick += delta
+            if data[pos] & 0x80:
+                status = data[pos]
+                pos += 1
+            if status == 0xFF:
+                meta = data[pos]
+                length, pos = read_varlen(data, pos + 1)
+                if meta == 0x51:
+                    tempos.append((tick, int.from_bytes(data[pos:pos + 3], "big")))
+                pos += length
+                status = 0  # Meta events and system exclusives cancel the running status
+                continue
+            if status in (0xF0, 0xF7):
+                length, pos = read_varlen(data, pos)
+                pos += length
+                status = 0
+                continue
+            kind, channel = status & 0xF0, status & 0x0F
+            if kind in (0xC0, 0xD0):
+                pos += 1
+                continue
+            key, velocity = data[pos], data[pos + 1]
+            pos += 2
+            if channel == DRUM_CHANNEL or kind not in (0x80, 0x90):
+                continue
+            beat = Fraction(tick, division)
+            started = sounding.pop((channel, key), None)
+            if started is not None:
+                notes.append(Note(started, beat, key - MIDI_PITCH_OFFSET, track))
+            if kind == 0x90 and velocity > 0:
+                sounding[(channel, key)] = beat
+        pos = end
+
+    tempos.sort()
+    bpm = round(60000000 / (tempos[0][1] if tempos else DEFAULT_TEMPO_US))
+    return notes, bpm, len(set(t for _, t in tempos)) > 1
+
+
+def parse_musicxml(path):
+    """Returns (notes, bpm, tempo changes) from a partwise MusicXML file, compressed (.mxl) or not."""
+    if zipfile.is_zipfile(path):
+        with zipfile.ZipFile(path) as archive:
+            container = ElementTree.fromstring(archive.read("META-INF/container.xml"))
+            rootfile = next(e for e in container.iter() if e.tag.endswith("rootfile")).get("full-path")
+            root = ElementTree.fromstring(archive.read(rootfile))
+    else:
+        root = ElementTree.parse(path).getroot()
+    if root.tag != "score-partwise":
+        sys.exit("Only partwise MusicXML scores are supported")
+
+    notes, tempos = [], []
+    for track, part in enumerate(root.findall("part")):
+        beat, last_start, divisions, tied = Fraction(0), Fraction(0), 1, {}
+        for measure in part.findall("measure"):
+            for element in measure:
+                if element.tag == "attributes" and element.find("divisions") is not None:
+                    divisions = int(element.find("divisions").text)
+                elif element.tag in ("backup", "forward"):
+                    duration = Fraction(int(element.find("duration").text), divisions)
+                    beat += duration if element.tag == "forward" else -duration
+                elif element.tag in ("sound", "direction"):
+                    sound = element if element.tag == "sound" else element.find("sound")
+                    if sound is not None and sound.get("tempo"):
+                        tempos.append((beat, float(sound.get("tempo"))))
+                elif element.tag == "note":
+                    if element.find("grace") is not None:
+                        continue
+                    duration = Fraction(int(element.find("duration").text), divisions)
+                    start = last_start if element.find("chord") is not None else beat
+                    if element.find("chord") is None:
+                        last_start, beat = beat, beat + duration
+                    pitch = element.find("pitch")
+                    if pitch is None:
+                        continue  # Rests are just the gaps between notes
+                    key = (int(pitch.find("octave").text) * 12 + XML_STEPS[pitch.find("step").text]
+                           + int(float(pitch.findtext("alter", "0"))))
+                    ties = [tie.get("type") for tie in element.findall("tie")]
+                    if "stop" in ties and key in tied:
+                        tied[key].end = start + duration
+                        note = tied[key]
+                    else:
+                        note = Note(start, start + duration, key, track)
+                        notes.append(note)
+                    if "start" in ties:
+                        tied[key] = note
+                    else:
+                        tied.pop(key, None)
+
+    tempos.sort()
+    bpm = round(tempos[0][1]) if tempos else 120
+    return notes, bpm, len(set(t for _, t in tempos)) > 1
+
+
+def skyline(notes):
+    """Keeps the highest sounding note at any time: higher notes cut the ones below, lower ones are dropped."""
+    line = []
+    for note in sorted(notes, key=lambda n: (n.start, -n.pitch)):
+        if note.end <= note.start:
+            continue
+        if line and note.start < line[-1].end:
+            if note.pitch <= line[-1].pitch:
+                continue
+            line[-1].end = note.start
+            if line[-1].end <= line[-1].start:
+                line.pop()
+        line.append(note)
+    return line
+
+
+def split_units(units):
+    """Splits a length in 1/8 beats, which must be even, into note types (as indices), longest first."""
+    types = []
+    for type_idx, length in enumerate(TYPE_UNITS):
+        while units >= length:
+            types.append(type_idx)
+            units -= length
+    return types
+
+
+def quantize(line, grid):
+    """Converts the line into (pitch or REST, type index) notes. Returns (notes, statistics)."""
+    def snap(beat):
+        return round(beat * UNITS_PER_BEAT / grid) * grid
+
+    stats = {"onset_errors": [], "length_errors": [], "dropped": 0, "split": 0}
+    notes, cursor = [], snap(line[0].start) if line else 0
+    for i, note in enumerate(line):
+        start = snap(note.start)
+        # A note ends where the next one starts, unless there's a gap before it, which becomes a rest
+        end = snap(note.end)
+        if i + 1 < len(line):
+            end = min(max(end, start + grid), snap(line[i + 1].start))
+        else:
+            end = max(end, start + grid)
+        if end <= start or start < cursor:
+            stats["dropped"] += 1  # Snapped onto the onset of the previous note
+            continue
+        stats["onset_errors"].append(abs(Fraction(start, UNITS_PER_BEAT) - note.start))
+        stats["length_errors"].append(abs(Fraction(end - start, UNITS_PER_BEAT) - (note.end - note.start)))
+
+        notes += [(buzzer_pack.REST, t) for t in split_units(start - cursor)]
+        if not 0 <= note.pitch <= MAX_PITCH:
+            sys.exit("Note %d (MIDI key %d) is out of the C0-B8 range, use --transpose" %
+                     (i, note.pitch + MIDI_PITCH_OFFSET))
+        held = split_units(end - start)
+        notes.append((note.pitch, held[0]))
+        notes += [(buzzer_pack.REST, t) for t in held[1:]]
+        stats["split"] += len(held) > 1
+        cursor = end
+    return notes, stats
+
+
+def emit_notes(name, notes):
+    """Emits the notes with designated initializers, so they keep compiling if fields are added to the note. The gate
+    is left at 0, so every note takes the gate of the melody."""
+    lines = ["static const buzzer_musical_note_t %s_notes[] = {" % name]
+    for pitch, type_idx in notes:
+        if pitch is buzzer_pack.REST:
+            note, octave = "REST", 0
+        else:
+            note, octave = buzzer_pack.NOTES[pitch % 12], pitch // 12
+        lines.append("        {.note = BUZZER_NOTE_%s, .octave = %d, .type = BUZZER_NTYPE_%s, .gate = 0},"
+                     % (note, octave, buzzer_pack.TYPES[type_idx]))
+    lines.append("};")
+    lines.append("const buzzer_melody_t %s = BUZZER_MELODY_INIT(%s_notes, sizeof(%s_notes) / sizeof(%s_notes[0]));"
+                 % (name, name, name, name))
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", help="MIDI (.mid) or MusicXML (.xml, .musicxml, .mxl) file")
+    parser.add_argument("--name", help="name of the generated melody (default: from the file name)")
+    parser.add_argument("--track", type=int, help="only take the notes of this track or part (0-based)")
+    parser.add_argument("--grid", choices=sorted(GRIDS), default="semiquaver",
+                        help="shortest step onsets are quantized to (default: semiquaver)")
+    parser.add_argument("--transpose", type=int, default=0, help="semitones to transpose the melody by")
+    parser.add_argument("--notes", action="store_true",
+                        help="emit a const buzzer_melody_t with plain notes instead of a packed melody")
+    args = parser.parse_args()
+
+    if args.input.lower().endswith((".mid", ".midi")):
+        with open(args.input, "rb") as f:
+            notes, bpm, tempo_changes = parse_midi(f.read())
+    else:
+        notes, bpm, tempo_changes = parse_musicxml(args.input)
+    if args.track is not None:
+        notes = [n for n in notes if n.track == args.track]
+    for note in notes:
+        note.pitch += args.transpose
+    line = skyline(notes)
+    if not line:
+        sys.exit("No notes found in the input")
+
+    name = args.name or re.sub(r"\W", "_", os.path.splitext(os.path.basename(args.input))[0])
+    melody, stats = quantize(line, GRIDS[args.grid])
+
+    print("#include \"buzzer/buzzer%s.h\"\n" % ("" if args.notes else "_packed"))
+    print("// Generated from %s, to be played at %d bpm\n" % (os.path.basename(args.input), bpm))
+    if args.notes:
+        print(emit_notes(name, melody))
+    else:
+        data = buzzer_pack.compress(buzzer_pack.tokenize(melody))
+        if buzzer_pack.unpack(data) != melody:
+            sys.exit("Internal error: %s doesn't unpack to the original melody" % name)
+        print(buzzer_pack.emit(name, data))
+        sys.stderr.write("%s: %d notes packed into %d bytes\n" % (name, len(melody), len(data)))
+
+    ms_per_beat = 60000 / bpm
+    errors, length_errors = stats["onset_errors"], stats["length_errors"]
+    sys.stderr.write("%s: %d of %d source notes kept at %d bpm%s\n" %
+                     (name, len(errors), len(line), bpm, " (tempo changes ignored)" if tempo_changes else ""))
+    sys.stderr.write("onset error: mean %.1f ms, max %.1f ms (%s grid)\n" %
+                     (float(sum(errors)) / len(errors) * ms_per_beat, float(max(errors)) * ms_per_beat, args.grid))
+    sys.stderr.write("length error: mean %.1f ms, max %.1f ms\n" %
+                     (float(sum(length_errors)) / len(length_errors) * ms_per_beat,
+                      float(max(length_errors)) * ms_per_beat))
+    sys.stderr.write("%d notes dropped on collisions, %d held with rests\n" % (stats["dropped"], stats["split"]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+"""
+Packs melodies written as buzzer_musical_note_t initializers into the compressed format decoded by buzzer_packed.c.
+
+Every array of notes found in the input (e.g. ``{BUZZER_NOTE_C, 4, BUZZER_NTYPE_CROTCHET}, ...``, or the same notes
+with designated initializers) is packed into a const buzzer_packed_melody_t with the same name, and a compression report
+is written to stderr.
+
+Usage: buzzer_pack.py melodies.c > melodies_packed.c
+"""
+
+import argparse
+import re
+import sys
+
+NOTES = ["C", "Cs", "D", "Ds", "E", "F", "Fs", "G", "Gs", "A", "As", "B"]
+TYPES = ["SEMIBREVE_DOTTED", "SEMIBREVE", "MINIM_DOTTED", "MINIM", "CROTCHET_DOTTED", "CROTCHET", "QUAVER_DOTTED",
+         "QUAVER", "SEMIQUAVER_DOTTED", "SEMIQUAVER"]
+REST = None
+
+INITIAL_PITCH = 48  # BUZZER_PACKED_INITIAL_PITCH
+INITIAL_TYPE = TYPES.index("CROTCHET")
+DELTA_BIAS = 32
+OP_TYPE, OP_REST, OP_ABS, OP_REF = 0x40, 0x50, 0x60, 0x80
+MAX_REF_OPS = 128
+MAX_REF_DISTANCE = 0xFFFF
+UNPACKED_NOTE_SIZE = 16  # sizeof(buzzer_musical_note_t) with int-sized enums
+COMPACT_NOTE_SIZE = 4  # sizeof(buzzer_musical_note_t) with BUZZER_COMPACT
+
+ARRAY_RE = re.compile(r"(\w+)\s*\[\s*\]\s*=\s*\{(.*?)\}\s*;", re.S)
+NOTE_RE = re.compile(r"\{\s*BUZZER_NOTE_(\w+)\s*,\s*(\d+)\s*,\s*BUZZER_NTYPE_(\w+)\s*(?:,\s*(\w+)\s*)?\}")
+DESIGNATED_RE = re.compile(r"\{\s*(\.\w+\s*=\s*\w+\s*(?:,\s*\.\w+\s*=\s*\w+\s*)*),?\s*\}")
+FIELD_RE = re.compile(r"\.(\w+)\s*=\s*(\w+)")
+
+
+def find_notes(body):
+    """Returns the notes initialized in an array body as (note, octave, type, gate) strings, without the BUZZER_NOTE_
+    and BUZZER_NTYPE_ prefixes. Both positional and designated initializers are recognized, in the order they appear."""
+    found = [(m.start(), m.groups("")) for m in NOTE_RE.finditer(body)]
+    for m in DESIGNATED_RE.finditer(body):
+        fields = dict(FIELD_RE.findall(m.group(1)))
+        note, ntype = fields.get("note", ""), fields.get("type", "")
+        if not note.startswith("BUZZER_NOTE_") or not ntype.startswith("BUZZER_NTYPE_"):
+            continue
+        found.append((m.start(), (note[len("BUZZER_NOTE_"):], fields.get("octave", "0"), ntype[len("BUZZER_NTYPE_"):],
+                                  fields.get("gate", ""))))
+    return [note for _, note in sorted(found)]
+
+
+def parse(source):
+    """Returns a list of (name, notes) with notes as (pitch or REST, type index) tuples."""
+    melodies = []
+    for name, body in ARRAY_RE.findall(source):
+        notes = []
+        for note, octave, ntype, gate in find_notes(body + "}"):
+            if gate not in ("", "0"):
+                sys.exit("%s: the packed format doesn't store articulation (gate %s)" % (name, gate))
+            pitch = REST if note == "REST" else int(octave) * 12 + NOTES.index(note)
+            notes.append((pitch, TYPES.index(ntype)))
+        if notes:
+            melodies.append((name, notes))
+    return melodies
+
+
+def tokenize(notes):
+    """Converts notes into operations (as tuples of bytes) without back-references."""
+    ops = []
+    pitch, type_idx = INITIAL_PITCH, INITIAL_TYPE
+    for note_pitch, note_type in notes:
+        if note_pitch is REST:
+            ops.append((OP_REST + note_type,))
+            continue
+        if note_type != type_idx:
+            ops.append((OP_TYPE + note_type,))
+            type_idx = note_type
+        delta = note_pitch - pitch
+        if -DELTA_BIAS <= delta < DELTA_BIAS:
+            ops.append((delta + DELTA_BIAS,))
+        else:
+            ops.append((OP_ABS, note_pitch))
+        pitch = note_pitch
+    return ops
+
+
+def compress(ops):
+    """Greedily replaces repeated runs of operations with back-references to earlier literal operations."""
+    out = bytearray()
+    literal_at = []  # (op index, byte offset) of each operation emitted literally, in order
+    i = 0
+    while i < len(ops):
+        best_len, best_start = 0, None
+        for j, (src, offset) in enumerate(literal_at):
+            # Back-references can only replay operations that were emitted literally and contiguously
+            length = 0
+            while (i + length < len(ops) and j + length < len(literal_at) and length < MAX_REF_OPS
+                   and literal_at[j + length][0] == src + length and ops[src + length] == ops[i + length]):
+                length += 1
+            if length > best_len and len(out) - offset <= MAX_REF_DISTANCE:
+                best_len, best_start = length, offset
+        saved = sum(len(op) for op in ops[i:i + best_len])
+        if best_start is not None and saved > 3:
+            distance = len(out) - best_start
+            out += bytes((OP_REF | (best_len - 1), distance & 0xFF, distance >> 8))
+            i += best_len
+        else:
+            literal_at.append((i, len(out)))
+            out += bytes(ops[i])
+            i += 1
+    return bytes(out)
+
+
+def unpack(data):
+    """Python mirror of buzzer_unpacker_next, used to verify the packed output."""
+    notes = []
+    pitch, type_idx = INITIAL_PITCH, INITIAL_TYPE
+    pos, ref_pos, ref_left = 0, 0, 0
+    while True:
+        replaying = ref_left > 0
+        cur = ref_pos if replaying else pos
+        if cur >= len(data):
+            return notes
+        if replaying:
+            ref_left -= 1
+        op = data[cur]
+        cur += 1
+        if op & OP_REF:
+            assert not replaying
+            distance = data[cur] | data[cur + 1] << 8
+            ref_pos, ref_left = cur - 1 - distance, (op & 0x7F) + 1
+            cur += 2
+        elif op < OP_TYPE:
+            pitch += op - DELTA_BIAS
+            notes.append((pitch, type_idx))
+        elif op == OP_ABS:
+            pitch = data[cur]
+            cur += 1
+            notes.append((pitch, type_idx))
+        elif op < OP_REST:
+            type_idx = op - OP_TYPE
+        else:
+            notes.append((REST, op - OP_REST))
+        if replaying:
+            ref_pos = cur
+        else:
+            pos = cur
+
+
+def emit(name, data):
+    lines = ["static const uint8_t %s_data[] = {" % name]
+    for k in range(0, len(data), 12):
+        lines.append("        " + ", ".join("0x%02X" % b for b in data[k:k + 12]) + ",")
+    lines.append("};")
+    lines.append("const buzzer_packed_melody_t %s = {%s_data, sizeof(%s_data)};" % (name, name, name))
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", nargs="?", type=argparse.FileType("r"), default=sys.stdin,
+                        help="C source with buzzer_musical_note_t arrays (default: stdin)")
+    parser.add_argument("--compact", action="store_true",
+                        help="report the ratio against notes built with BUZZER_COMPACT (4 bytes each)")
+    args = parser.parse_args()
+
+    melodies = parse(args.input.read())
+    if not melodies:
+        sys.exit("No melodies found in the input")
+
+    print("#include \"buzzer/buzzer_packed.h\"\n")
+    total_raw = total_packed = 0
+    for name, notes in melodies:
+        data = compress(tokenize(notes))
+        if unpack(data) != notes:
+            sys.exit("Internal error: %s doesn't unpack to the original melody" % name)
+        raw = len(notes) * (COMPACT_NOTE_SIZE if args.compact else UNPACKED_NOTE_SIZE)
+        total_raw += raw
+        total_packed += len(data)
+        print(emit(name, data) + "\n")
+        sys.stderr.write("%-24s %5d notes %6d -> %5d bytes (%.1fx)\n" % (name, len(notes), raw, len(data),
+                                                                          raw / len(data)))
+    sys.stderr.write("%-24s %5s       %6d -> %5d bytes (%.1fx)\n" % ("total", "", total_raw, total_packed,
+                                                                       total_raw / total_packed))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""
+Prints the per-note tuning error table of the buzzer for a LEDC clock source and duty resolution, using the same
+divider model as buzzer_tuning.c.
+
+Usage: buzzer_tuning.py [--clk apb|ref_tick|rtc8m] [--res BITS] [--octaves MIN MAX] [--best]
+       buzzer_tuning.py --characterize [--tolerance CENTS] [--octaves MIN MAX]
+"""
+
+import argparse
+import math
+
+NOTE_NAMES = ["C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"]
+NOTE_BASE_FREQ = [4186, 4435, 4699, 4978, 5274, 5588, 5920, 6272, 6645, 7040, 7459, 7902]  # BUZZER_NOTE_BASE_FREQS
+CLOCKS = {"apb": 80000000, "ref_tick": 1000000, "rtc8m": 8000000}  # RTC8M at its nominal frequency
+CLOCK_ERROR_CENTS = {"rtc8m": 1200.0 * math.log2(1.01)}  # BUZZER_TUNING_RTC8M_TOLERANCE
+DFS_STABLE = {"apb": False, "ref_tick": True, "rtc8m": True}
+COST_ORDER = ["rtc8m", "ref_tick", "apb"]  # Cheapest first, as in buzzer_tuning_find_cheapest
+DIV_FRAC_BITS = 8
+DIV_MIN, DIV_MAX = 1 << DIV_FRAC_BITS, 0x3FFFF
+MAX_RES_BITS = 20
+SEARCH_SPAN = 2
+
+
+def divider(clk_hz, res_bits, freq_hz):
+    precision = freq_hz << res_bits
+    div = ((clk_hz << DIV_FRAC_BITS) + precision // 2) // precision
+    return div if DIV_MIN <= div <= DIV_MAX else 0
+
+
+def actual_freq(clk_hz, res_bits, freq_hz):
+    div = divider(clk_hz, res_bits, freq_hz)
+    return clk_hz * DIV_MIN / (div * (1 << res_bits)) if div else 0.0
+
+
+def cents(target_hz, actual_hz):
+    return 1200.0 * math.log2(actual_hz / target_hz)
+
+
+def best_request(clk_hz, res_bits, target_hz):
+    center = int(target_hz + 0.5)
+    candidates = [f for f in range(center - SEARCH_SPAN, center + SEARCH_SPAN + 1)
+                  if f > 0 and actual_freq(clk_hz, res_bits, f)]
+    return min(candidates, key=lambda f: abs(actual_freq(clk_hz, res_bits, f) - target_hz), default=0)
+
+
+def note_freq(note, octave):
+    return NOTE_BASE_FREQ[note] / (1 << (8 - octave))
+
+
+def evaluate(clk_hz, res_bits, octaves):
+    errors = []
+    for octave in octaves:
+        for note in range(12):
+            target = note_freq(note, octave)
+            request = best_request(clk_hz, res_bits, target)
+            if not request:
+                return None
+            errors.append(abs(cents(target, actual_freq(clk_hz, res_bits, request))))
+    return max(errors), sum(errors) / len(errors)
+
+
+def characterize(octaves, tolerance):
+    """Prints the most accurate resolution of each clock source, and picks the cheapest one within the tolerance."""
+    print("%-9s %4s %12s %12s %11s %11s %10s" % ("Clock", "Bits", "Min Hz", "Max Hz", "Max cents", "Mean cents",
+                                                 "DFS stable"))
+    cheapest = None
+    for clk_name in COST_ORDER:
+        clk_hz = CLOCKS[clk_name]
+        best = None
+        for bits in range(1, MAX_RES_BITS + 1):
+            result = evaluate(clk_hz, bits, octaves)
+            if result and (best is None or result[0] <= best[1]):
+                best = (bits, result[0], result[1])
+        if best is None:
+            print("%-9s %4s" % (clk_name, "none"))
+            continue
+        bits, max_err, mean_err = best
+        max_err += CLOCK_ERROR_CENTS.get(clk_name, 0.0)
+        print("%-9s %4d %12.3f %12.1f %11.2f %11.2f %10s" % (
+            clk_name, bits, clk_hz * DIV_MIN / (DIV_MAX * (1 << bits)), clk_hz / (1 << bits), max_err, mean_err,
+            "yes" if DFS_STABLE[clk_name] else "no"))
+        if cheapest is None and max_err <= tolerance:
+            cheapest = (clk_name, bits)
+    if cheapest:
+        print("\nCheapest within %.1f cents: clock %s, %d bits" % ((tolerance,) + cheapest))
+    else:
+        print("\nNo clock stays within %.1f cents" % tolerance)
+
+
+def print_table(clk_name, res_bits, octaves):
+    clk_hz = CLOCKS[clk_name]
+    print("Clock %s (%d Hz), %d bit duty resolution" % (clk_name, clk_hz, res_bits))
+    print("%-5s %10s %8s %10s %12s %10s %12s" % ("Note", "Target Hz", "Trunc Hz", "Trunc out", "Trunc cents",
+                                                 "Best Hz", "Best cents"))
+    for octave in octaves:
+        for note in range(12):
+            target = note_freq(note, octave)
+            name = "%s%d" % (NOTE_NAMES[note], octave)
+            # Truncation is what buzzer_set_freq got before buzzer_set_note picked the best request
+            truncated = int(target)
+            trunc_out = actual_freq(clk_hz, res_bits, truncated) if truncated else 0.0
+            request = best_request(clk_hz, res_bits, target)
+            if not request:
+                print("%-5s %10.3f %8s" % (name, target, "unreachable"))
+                continue
+            best_out = actual_freq(clk_hz, res_bits, request)
+            print("%-5s %10.3f %8d %10.3f %+12.2f %10d %+12.2f" % (
+                name, target, truncated, trunc_out, cents(target, trunc_out) if trunc_out else float("nan"),
+                request, cents(target, best_out)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--clk", choices=sorted(CLOCKS), default="apb", help="LEDC clock source (default: apb)")
+    parser.add_argument("--res", type=int, default=15, help="duty resolution in bits (default: 15, as in buzzer.c)")
+    parser.add_argument("--octaves", type=int, nargs=2, default=[0, 8], metavar=("MIN", "MAX"),
+                        help="range of octaves to evaluate (default: 0 8)")
+    parser.add_argument("--best", action="store_true",
+                        help="pick the clock and resolution minimizing the largest error over the octaves")
+    parser.add_argument("--characterize", action="store_true",
+                        help="compare the clock sources and pick the cheapest one within the tolerance")
+    parser.add_argument("--tolerance", type=float, default=10.0, metavar="CENTS",
+                        help="largest note error accepted by --characterize, in cents (default: 10)")
+    args = parser.parse_args()
+    octaves = range(args.octaves[0], args.octaves[1] + 1)
+
+    if args.characterize:
+        characterize(octaves, args.tolerance)
+        return
+
+    if args.best:
+        results = []
+        for clk_name, clk_hz in CLOCKS.items():
+            for bits in range(1, MAX_RES_BITS + 1):
+                result = evaluate(clk_hz, bits, octaves)
+                if result:
+                    results.append((result[0], -bits, clk_name, bits, result[1]))
+        if not results:
+            parser.exit(1, "No combination can play octaves %d to %d\n" % tuple(args.octaves))
+        max_err, _, clk_name, bits, mean_err = min(results)
+        print("Best: clock %s, %d bits (max error %.2f cents, mean %.2f cents)\n" % (clk_name, bits, max_err,
+                                                                                   mean_err))
+        args.clk, args.res = clk_name, bits
+
+    print_table(args.clk, args.res, octaves)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+"""
+Compares the notes of a rendered melody against a golden render. Both files must be square wave WAV files like the
+ones written by the host renderer (host/render): the notes (onset, duration and pitch) are recovered from the rising
+edges of the wave, and matched in order. Consecutive notes of the same pitch can't be told apart, as the buzzer itself
+doesn't separate them.
+
+Usage: buzzer_wavdiff.py golden.wav test.wav [--onset-tolerance MS] [--pitch-tolerance CENTS]
+       buzzer_wavdiff.py --list file.wav
+"""
+
+import argparse
+import array
+import math
+import sys
+import wave
+
+SILENCE_MS = 1.0  # Silent runs at least this long separate notes
+JITTER_SAMPLES = 1.5  # Periods are measured in whole samples, so they jitter by about one sample
+MIN_CHANGE = 0.03  # Smallest relative period change taken as a new pitch
+CHANGE_INTERVALS = 3  # Consecutive periods that must agree on the new pitch
+
+
+def read_samples(path):
+    with wave.open(path, "rb") as wav:
+        if wav.getnchannels() != 1 or wav.getsampwidth() != 2:
+            sys.exit("%s: only 16 bit mono files are supported" % path)
+        rate = wav.getframerate()
+        samples = array.array("h", wav.readframes(wav.getnframes()))
+    if sys.byteorder == "big":
+        samples.byteswap()
+    return rate, samples
+
+
+def find_notes(rate, samples):
+    """Returns the notes in the samples as (onset ms, duration ms, frequency Hz) tuples."""
+    silence = int(rate * SILENCE_MS / 1000) or 1
+    edges, gaps_before = [], []
+    zeros = silence  # The file starts in silence, so a wave starting high has an edge at the first sample
+    for i in range(len(samples)):
+        if samples[i] == 0:
+            zeros += 1
+            continue
+        if samples[i] > 0 and (zeros >= silence or samples[i - 1] < 0):
+            edges.append(i)
+            gaps_before.append(zeros >= silence)
+        zeros = 0
+
+    notes = []
+    start = 0
+    while start < len(edges):
+        # Grow the note while the periods stay at the same pitch and there's no silence in between
+        end = start + 1
+        periods = []
+        while end < len(edges) and not gaps_before[end]:
+            period = edges[end] - edges[end - 1]
+            if len(periods) >= CHANGE_INTERVALS:
+                ref = sum(periods) / len(periods)
+                tol = max(MIN_CHANGE, JITTER_SAMPLES / ref)
+                upcoming = [edges[k] - edges[k - 1] for k in range(end, min(end + CHANGE_INTERVALS, len(edges)))
+                            if not any(gaps_before[end:k + 1])]
+                if len(upcoming) == CHANGE_INTERVALS and all(abs(p - ref) / ref > tol for p in upcoming):
+                    break
+            periods.append(period)
+            end += 1
+        if periods:
+            freq = rate * len(periods) / (edges[end - 1] - edges[start])
+            last = edges[end - 1] + sum(periods) / len(periods)
+            notes.append((1000.0 * edges[start] / rate, 1000.0 * (last - edges[start]) / rate, freq))
+        start = end
+    return notes
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("files", nargs="+", help="golden and test WAV files, or a single file with --list")
+    parser.add_argument("--list", action="store_true", help="print the notes found in a file")
+    parser.add_argument("--onset-tolerance", type=float, default=5.0, metavar="MS",
+                        help="largest onset difference accepted, in milliseconds (default: 5)")
+    parser.add_argument("--pitch-tolerance", type=float, default=10.0, metavar="CENTS",
+                        help="largest pitch difference accepted, in cents (default: 10)")
+    args = parser.parse_args()
+
+    if args.list:
+        for path in args.files:
+            print(path)
+            for onset, duration, freq in find_notes(*read_samples(path)):
+                print("  %10.2f ms %9.2f ms %9.2f Hz" % (onset, duration, freq))
+        return
+    if len(args.files) != 2:
+        parser.error("two files are required to compare")
+
+    golden, test = (find_notes(*read_samples(path)) for path in args.files)
+    errors = 0
+    for index, (expected, actual) in enumerate(zip(golden, test)):
+        onset_diff = actual[0] - expected[0]
+        cents = 1200.0 * math.log2(actual[2] / expected[2])
+        if abs(onset_diff) > args.onset_tolerance or abs(cents) > args.pitch_tolerance:
+            errors += 1
+            print("note %d: onset %.2f ms (expected %.2f ms, %+.2f ms), pitch %.2f Hz (expected %.2f Hz, %+.1f cents)"
+                  % (index, actual[0], expected[0], onset_diff, actual[2], expected[2], cents))
+    if len(golden) != len(test):
+        errors += 1
+        print("note count differs: %d in golden, %d in test" % (len(golden), len(test)))
+
+    print("%d notes compared, %d differences" % (min(len(golden), len(test)), errors))
+    sys.exit(1 if errors else 0)
+
+
+if __name__ == "__main__":
+    main()